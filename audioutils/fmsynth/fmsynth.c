@@ -24,21 +24,11 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <audioutils/fmsynth.h>
 
-/****************************************************************************
- * Pre-processor Definitions
- ****************************************************************************/
-
-#define WRAP_ROUND_TIME_SEC (10)
-
-/****************************************************************************
- * Private Data
- ****************************************************************************/
-
-static int max_phase_time;
-
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -62,11 +52,11 @@ static void fetch_feedback(FAR fmsynth_op_t *ops)
 
 static void update_phase(FAR fmsynth_sound_t *snd)
 {
-  snd->phase_time++;
-  if (snd->phase_time >= max_phase_time)
-    {
-      snd->phase_time = 0;
-    }
+  /* The operator phases only restart at the first sample of the sound.
+   * The integer phase accumulators wrap around by themselves.
+   */
+
+  snd->phase_time = 1;
 }
 
 /****************************************************************************
@@ -95,6 +85,71 @@ static int sound_modulate(FAR fmsynth_sound_t *snd)
   return out * snd->volume / FMSYNTH_MAX_VOLUME;
 }
 
+/****************************************************************************
+ * name: ops_blockable
+ *
+ * Description:
+ *   Operators can be rendered in blocks unless one of them takes feedback
+ *   from another operator.  That needs the other output of the previous
+ *   sample, so such sounds are rendered sample by sample.
+ *
+ ****************************************************************************/
+
+static bool ops_blockable(FAR fmsynth_op_t *ops)
+{
+  for (; ops != NULL; ops = ops->parallelop)
+    {
+      if ((ops->feedback_ref != NULL &&
+           ops->feedback_ref != &ops->last_sigval) ||
+          !ops_blockable(ops->cascadeop))
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * name: sound_render
+ ****************************************************************************/
+
+static void sound_render(FAR fmsynth_sound_t *snd, FAR int *mix,
+                         int nsamples)
+{
+  int out[FMSYNTH_BLOCKSIZE];
+  FAR fmsynth_op_t *op;
+  int i;
+
+  if (snd->operators == NULL)
+    {
+      return;
+    }
+
+  if (nsamples == 1 || !ops_blockable(snd->operators))
+    {
+      for (i = 0; i < nsamples; i++)
+        {
+          mix[i] += sound_modulate(snd);
+        }
+
+      return;
+    }
+
+  memset(out, 0, nsamples * sizeof(int));
+  for (op = snd->operators; op != NULL; op = op->parallelop)
+    {
+      fmsynthop_render(op, out, nsamples, snd->phase_time);
+    }
+
+  for (i = 0; i < nsamples; i++)
+    {
+      mix[i] += out[i] * snd->volume / FMSYNTH_MAX_VOLUME;
+    }
+
+  update_phase(snd);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -105,7 +160,6 @@ static int sound_modulate(FAR fmsynth_sound_t *snd)
 
 int fmsynth_initialize(int fs)
 {
-  max_phase_time = fs * WRAP_ROUND_TIME_SEC;
   return fmsynthop_set_samplerate(fs);
 }
 
@@ -235,36 +289,51 @@ int fmsynth_rendering(FAR fmsynth_sound_t *snd,
                       FAR int16_t *sample, int sample_num, int chnum,
                       fmsynth_tickcb_t cb, unsigned long cbarg)
 {
+  int mix[FMSYNTH_BLOCKSIZE];
+  int nframes;
+  int blksize;
+  int nsamples;
   int i;
+  int j;
   int ch;
-  int out;
   FAR fmsynth_sound_t *itr;
 
-  for (i = 0; i < sample_num; i += chnum)
+  /* The tick callback may change the sounds after any frame, so they are
+   * rendered one frame at a time when there is one.
+   */
+
+  nframes = sample_num / chnum;
+  blksize = cb != NULL ? 1 : FMSYNTH_BLOCKSIZE;
+
+  for (i = 0; i < nframes; i += nsamples)
     {
-      out = 0;
-      for (itr = snd; itr != NULL; itr = itr->next_sound)
+      nsamples = nframes - i;
+      if (nsamples > blksize)
         {
-          out = out + sound_modulate(itr);
+          nsamples = blksize;
         }
 
-      for (ch = 0; ch < chnum; ch++)
+      memset(mix, 0, nsamples * sizeof(int));
+      for (itr = snd; itr != NULL; itr = itr->next_sound)
         {
-          *sample++ = (int16_t)out;
+          sound_render(itr, mix, nsamples);
         }
 
-      if (cb != NULL)
+      for (j = 0; j < nsamples; j++)
         {
-          cb(cbarg);
+          for (ch = 0; ch < chnum; ch++)
+            {
+              *sample++ = (int16_t)mix[j];
+            }
+
+          if (cb != NULL)
+            {
+              cb(cbarg);
+            }
         }
     }
 
-  if (i > sample_num)
-    {
-      i -= chnum;
-    }
-
   /* Return total bytes stored in the buffer */
 
-  return i * sizeof(int16_t);
+  return nframes * chnum * sizeof(int16_t);
 }
@@ -26,6 +26,7 @@
 
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
 
 #include <audioutils/fmsynth_eg.h>
 
@@ -207,3 +208,91 @@ int fmsyntheg_operate(FAR fmsynth_eg_t *eg)
 
   return val;
 }
+
+/****************************************************************************
+ * name: fmsyntheg_render
+ *
+ * Description:
+ *   Produce the next nsamples envelope values, the same values as that
+ *   many calls of fmsyntheg_operate().  Within a state, the division of
+ *   the linear ramp is replaced by stepping the quotient and remainder.
+ *
+ ****************************************************************************/
+
+void fmsyntheg_render(FAR fmsynth_eg_t *eg, FAR int *out, int nsamples)
+{
+  FAR fmsynth_egparam_t *param;
+  int64_t acc;
+  int period;
+  int stepq;
+  int stepr;
+  int carry;
+  int run;
+  int q;
+  int r;
+  int i;
+
+  while (nsamples > 0)
+    {
+      param = &eg->state_params[eg->state];
+
+      if (eg->state == EGSTATE_RELEASED)
+        {
+          for (i = 0; i < nsamples; i++)
+            {
+              out[i] = param->initval;
+            }
+
+          return;
+        }
+
+      if (eg->state_counter >= param->period)
+        {
+          /* State transition, handled as a single sample */
+
+          *out++ = fmsyntheg_operate(eg);
+          nsamples--;
+          continue;
+        }
+
+      run = param->period - eg->state_counter;
+      if (run > nsamples)
+        {
+          run = nsamples;
+        }
+
+      /* initval + diff2next * counter / period, with the product kept as
+       * q * period + r and the sign of diff2next applied to q.
+       */
+
+      period = param->period;
+      acc    = (int64_t)param->diff2next * eg->state_counter;
+      q      = (int)(acc / period);
+      r      = (int)(acc % period);
+      stepq  = param->diff2next / period;
+      stepr  = param->diff2next % period;
+      carry  = param->diff2next < 0 ? -1 : 1;
+      if (carry < 0)
+        {
+          r     = -r;
+          stepr = -stepr;
+        }
+
+      for (i = 0; i < run; i++)
+        {
+          out[i] = param->initval + q;
+
+          q += stepq;
+          r += stepr;
+          if (r >= period)
+            {
+              r -= period;
+              q += carry;
+            }
+        }
+
+      eg->state_counter += run;
+      out += run;
+      nsamples -= run;
+    }
+}
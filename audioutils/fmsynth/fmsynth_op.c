@@ -24,7 +24,9 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <audioutils/fmsynth_op.h>
 
 /****************************************************************************
@@ -34,6 +36,12 @@
 #define PHASE_ADJUST(th) \
         (((th) < 0 ? (FMSYNTH_PI) - (th) : (th)) % (FMSYNTH_PI * 2))
 
+/* The phase accumulator runs over 2^32 per turn, the wave generators take
+ * 2 * FMSYNTH_PI (2^17) per turn.
+ */
+
+#define PHASE_SHIFT (15)
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -122,7 +130,7 @@ static int local_fs;
  * name: pseudo_sin256
  ****************************************************************************/
 
-static int pseudo_sin256(int theta)
+static inline int pseudo_sin256(int theta)
 {
   int short_sin;
   int rest;
@@ -156,7 +164,7 @@ static int pseudo_sin256(int theta)
  * name: triangle_wave
  ****************************************************************************/
 
-static int triangle_wave(int theta)
+static inline int triangle_wave(int theta)
 {
   int ret = 0;
   int phase;
@@ -198,7 +206,7 @@ static int triangle_wave(int theta)
  * name: sawtooth_wave
  ****************************************************************************/
 
-static int sawtooth_wave(int theta)
+static inline int sawtooth_wave(int theta)
 {
   theta = PHASE_ADJUST(theta);
   return (theta >> 1) - SHRT_MAX;
@@ -208,7 +216,7 @@ static int sawtooth_wave(int theta)
  * name: square_wave
  ****************************************************************************/
 
-static int square_wave(int theta)
+static inline int square_wave(int theta)
 {
   theta = PHASE_ADJUST(theta);
   return theta < FMSYNTH_PI ? SHRT_MAX : -SHRT_MAX;
@@ -220,14 +228,91 @@ static int square_wave(int theta)
 
 static void update_parameters(FAR fmsynth_op_t *op)
 {
+  float turns;
+
   if (local_fs != 0)
     {
-      op->delta_phase = 2 * FMSYNTH_PI * op->sound_freq * op->freq_rate
-                        / (float)local_fs;
+      /* Fraction of a turn per sample, as a 0.32 fixed point value */
+
+      turns = op->sound_freq * op->freq_rate / (float)local_fs;
+      turns = turns - (float)(int)turns;
+      op->delta_phase = (uint32_t)(turns * 4294967296.f);
     }
   else
     {
-      op->delta_phase = 0.f;
+      op->delta_phase = 0;
+    }
+}
+
+/****************************************************************************
+ * name: render_wave
+ *
+ * Description:
+ *   Add nsamples of an operator output to out.  env holds the envelope and
+ *   mod the phase modulation by the cascaded operators.  An operator that
+ *   feeds back its own output depends on the previous sample, as in
+ *   fmsynthop_operate().  Being inline, the wave generator is expanded
+ *   into the loop for each of the callers.
+ *
+ ****************************************************************************/
+
+static inline void render_wave(FAR fmsynth_op_t *op, opfunc_t wavegen,
+                               bool feedback, FAR int *out,
+                               FAR const int *env, FAR const int *mod,
+                               int nsamples)
+{
+  uint32_t phase = op->current_phase;
+  uint32_t delta = op->delta_phase;
+  int fbval = op->feedback_val;
+  int val = op->last_sigval;
+  int i;
+
+  for (i = 0; i < nsamples; i++)
+    {
+      if (feedback)
+        {
+          fbval = val * op->feedbackrate / FMSYNTH_MAX_EGLEVEL;
+        }
+
+      val = env[i] * wavegen((int)(phase >> PHASE_SHIFT) + fbval + mod[i])
+          / FMSYNTH_MAX_EGLEVEL;
+      phase += delta;
+      out[i] += val;
+    }
+
+  op->current_phase = phase;
+  op->feedback_val  = fbval;
+  op->last_sigval   = val;
+}
+
+/****************************************************************************
+ * name: render_op
+ ****************************************************************************/
+
+static void render_op(FAR fmsynth_op_t *op, bool feedback, FAR int *out,
+                      FAR const int *env, FAR const int *mod, int nsamples)
+{
+  switch (op->wavetype)
+    {
+      case FMSYNTH_OPFUNC_SIN:
+        render_wave(op, pseudo_sin256, feedback, out, env, mod, nsamples);
+        break;
+
+      case FMSYNTH_OPFUNC_TRIANGLE:
+        render_wave(op, triangle_wave, feedback, out, env, mod, nsamples);
+        break;
+
+      case FMSYNTH_OPFUNC_SAWTOOTH:
+        render_wave(op, sawtooth_wave, feedback, out, env, mod, nsamples);
+        break;
+
+      case FMSYNTH_OPFUNC_SQUARE:
+        render_wave(op, square_wave, feedback, out, env, mod, nsamples);
+        break;
+
+      default:
+        render_wave(op, op->wavegen, feedback, out, env, mod, nsamples);
+        break;
     }
 }
 
@@ -263,6 +348,7 @@ FAR fmsynth_op_t *create_fmsynthop(FAR fmsynth_op_t *op,
 
       op->own_allocate  = 0;
       op->wavegen       = NULL;
+      op->wavetype      = -1;
       op->cascadeop     = NULL;
       op->parallelop    = NULL;
       op->feedback_ref  = NULL;
@@ -271,8 +357,8 @@ FAR fmsynth_op_t *create_fmsynthop(FAR fmsynth_op_t *op,
       op->last_sigval   = 0;
       op->freq_rate     = 1.f;
       op->sound_freq    = 0.f;
-      op->delta_phase   = 0.f;
-      op->current_phase = 0.f;
+      op->delta_phase   = 0;
+      op->current_phase = 0;
     }
 
   return op;
@@ -331,6 +417,7 @@ int fmsynthop_select_opfunc(FAR fmsynth_op_t *op, int type)
 
   if (op != NULL)
     {
+      op->wavetype = type;
       switch (type)
         {
           case FMSYNTH_OPFUNC_SIN:
@@ -520,18 +607,16 @@ void fmsynthop_stop(FAR fmsynth_op_t *op)
 
 int fmsynthop_operate(FAR fmsynth_op_t *op, int phase_time)
 {
-  int val;
-  int val2;
   int phase;
   FAR fmsynth_op_t *subop;
 
-  op->current_phase = phase_time ? op->current_phase + op->delta_phase : 0.f;
-
-  val = (int)op->current_phase;
-  val2 = (val / (2 * FMSYNTH_PI));
+  if (phase_time == 0)
+    {
+      op->current_phase = 0;
+    }
 
-  phase = (int)val + op->feedback_val;
-  op->current_phase = op->current_phase - (float)(val2 * (2 * FMSYNTH_PI));
+  phase = (int)(op->current_phase >> PHASE_SHIFT) + op->feedback_val;
+  op->current_phase += op->delta_phase;
 
   subop = op->cascadeop;
 
@@ -546,3 +631,52 @@ int fmsynthop_operate(FAR fmsynth_op_t *op, int phase_time)
 
   return op->last_sigval;
 }
+
+/****************************************************************************
+ * name: fmsynthop_render
+ *
+ * Description:
+ *   Add the next nsamples (up to FMSYNTH_BLOCKSIZE) of the operator output
+ *   to out.  The result is the same as that of nsamples calls of
+ *   fmsynthop_operate(), but each operator is walked once per block and
+ *   the inner loops only use integer arithmetic.  An operator may only
+ *   take feedback from its own output.
+ *
+ ****************************************************************************/
+
+int fmsynthop_render(FAR fmsynth_op_t *op, FAR int *out, int nsamples,
+                     int phase_time)
+{
+  int env[FMSYNTH_BLOCKSIZE];
+  int mod[FMSYNTH_BLOCKSIZE];
+  FAR fmsynth_op_t *subop;
+  int ret;
+
+  if (nsamples > FMSYNTH_BLOCKSIZE ||
+      (op->feedback_ref != NULL && op->feedback_ref != &op->last_sigval))
+    {
+      return ERROR;
+    }
+
+  if (phase_time == 0)
+    {
+      op->current_phase = 0;
+    }
+
+  /* The cascaded operators modulate the phase of this one */
+
+  memset(mod, 0, nsamples * sizeof(int));
+  for (subop = op->cascadeop; subop != NULL; subop = subop->parallelop)
+    {
+      ret = fmsynthop_render(subop, mod, nsamples, phase_time);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  fmsyntheg_render(op->eg, env, nsamples);
+  render_op(op, op->feedback_ref != NULL, out, env, mod, nsamples);
+
+  return OK;
+}
@@ -0,0 +1,261 @@
+/****************************************************************************
+ * apps/benchmarks/fmbench/fmbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <audioutils/fmsynth.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FMBENCH_MAX_VOICES   64
+#define FMBENCH_DEFAULT_VOICES 8
+#define FMBENCH_DEFAULT_FS   48000
+#define FMBENCH_DEFAULT_SEC  1
+#define FMBENCH_BUFFER       480
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One voice: a sine carrier modulated by a sine at twice its frequency,
+ * plus a self-feedback operator, as in examples/fmsynth.
+ */
+
+struct fmbench_voice_s
+{
+  fmsynth_sound_t sound;
+  fmsynth_op_t carrier;
+  fmsynth_op_t modulator;
+  fmsynth_op_t feedback;
+  fmsynth_eg_t eg[3];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct fmbench_voice_s g_voices[FMBENCH_MAX_VOICES];
+static int16_t g_buffer[FMBENCH_BUFFER];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint64_t fmbench_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* An empty tick callback makes fmsynth_rendering() work frame by frame */
+
+static void fmbench_tick(unsigned long arg)
+{
+}
+
+static void fmbench_setlevel(FAR struct fmsynth_eglevel_s *level,
+                             float val, int period_ms)
+{
+  level->level     = val;
+  level->period_ms = period_ms;
+}
+
+static FAR fmsynth_sound_t *fmbench_setup(int nvoices)
+{
+  FAR struct fmbench_voice_s *voice;
+  fmsynth_eglevels_t levels;
+  int i;
+
+  fmbench_setlevel(&levels.attack, 1.0f, 10);
+  fmbench_setlevel(&levels.decaybrk, 0.6f, 100);
+  fmbench_setlevel(&levels.decay, 0.4f, 300);
+  fmbench_setlevel(&levels.sustain, 0.4f, 2000);
+  fmbench_setlevel(&levels.release, 0.f, 300);
+
+  for (i = 0; i < nvoices; i++)
+    {
+      voice = &g_voices[i];
+
+      create_fmsynthop(&voice->carrier,
+                       create_fmsyntheg(&voice->eg[0]));
+      create_fmsynthop(&voice->modulator,
+                       create_fmsyntheg(&voice->eg[1]));
+      create_fmsynthop(&voice->feedback,
+                       create_fmsyntheg(&voice->eg[2]));
+
+      fmsynthop_select_opfunc(&voice->carrier, FMSYNTH_OPFUNC_SIN);
+      fmsynthop_select_opfunc(&voice->modulator, FMSYNTH_OPFUNC_SIN);
+      fmsynthop_select_opfunc(&voice->feedback, FMSYNTH_OPFUNC_SIN);
+      fmsynthop_set_envelope(&voice->carrier, &levels);
+      fmsynthop_set_envelope(&voice->modulator, &levels);
+      fmsynthop_set_envelope(&voice->feedback, &levels);
+
+      fmsynthop_set_soundfreqrate(&voice->modulator, 2.f);
+      fmsynthop_cascade_subop(&voice->carrier, &voice->modulator);
+      fmsynthop_bind_feedback(&voice->feedback, &voice->feedback, 0.6f);
+      fmsynthop_parallel_subop(&voice->carrier, &voice->feedback);
+
+      create_fmsynthsnd(&voice->sound);
+      fmsynthsnd_set_operator(&voice->sound, &voice->carrier);
+      fmsynthsnd_set_volume(&voice->sound, 1.f / nvoices);
+      if (i > 0)
+        {
+          fmsynthsnd_add_subsound(&g_voices[0].sound, &voice->sound);
+        }
+    }
+
+  return &g_voices[0].sound;
+}
+
+/* Restart all voices and render nframes of mono audio.  Returns the time
+ * taken in microseconds.
+ */
+
+static uint64_t fmbench_run(FAR fmsynth_sound_t *snd, int nframes,
+                            fmsynth_tickcb_t cb)
+{
+  FAR fmsynth_sound_t *itr;
+  uint64_t start;
+  int i = 0;
+  int n;
+
+  for (itr = snd; itr != NULL; itr = itr->next_sound)
+    {
+      fmsynthsnd_set_soundfreq(itr, 220.f + 55.f * i++);
+    }
+
+  start = fmbench_now_us();
+  for (i = 0; i < nframes; i += n)
+    {
+      n = nframes - i;
+      if (n > FMBENCH_BUFFER)
+        {
+          n = FMBENCH_BUFFER;
+        }
+
+      fmsynth_rendering(snd, g_buffer, n, 1, cb, 0);
+    }
+
+  return fmbench_now_us() - start;
+}
+
+static void fmbench_report(FAR const char *name, uint64_t elapsed,
+                           int nvoices, int seconds)
+{
+  uint64_t us_per_sec = elapsed / seconds;
+
+  /* Load of one voice in 1/100 %, and voices one CPU renders in real
+   * time.
+   */
+
+  uint32_t load = (uint32_t)(us_per_sec * 100 * 100 / 1000000 / nvoices);
+  uint32_t voices = us_per_sec ? (uint32_t)((uint64_t)nvoices * 1000000 /
+                                            us_per_sec) : 0;
+
+  printf("%-6s %14" PRIu64 " %8" PRIu32 ".%02" PRIu32 "%% %12" PRIu32 "\n",
+         name, us_per_sec, load / 100, load % 100, voices);
+}
+
+static void fmbench_usage(FAR const char *progname)
+{
+  printf("Usage: %s [-v <voices>] [-r <rate>] [-t <seconds>]\n", progname);
+  printf("  -v <voices>   Number of voices rendered together (default %d, "
+         "max %d)\n", FMBENCH_DEFAULT_VOICES, FMBENCH_MAX_VOICES);
+  printf("  -r <rate>     Sample rate (default %d)\n", FMBENCH_DEFAULT_FS);
+  printf("  -t <seconds>  Seconds of audio per measurement (default %d)\n",
+         FMBENCH_DEFAULT_SEC);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR fmsynth_sound_t *snd;
+  int nvoices = FMBENCH_DEFAULT_VOICES;
+  int fs = FMBENCH_DEFAULT_FS;
+  int seconds = FMBENCH_DEFAULT_SEC;
+  uint64_t frame_us;
+  uint64_t block_us;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "v:r:t:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'v':
+            nvoices = atoi(optarg);
+            break;
+
+          case 'r':
+            fs = atoi(optarg);
+            break;
+
+          case 't':
+            seconds = atoi(optarg);
+            break;
+
+          default:
+            fmbench_usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (nvoices <= 0 || nvoices > FMBENCH_MAX_VOICES || fs <= 0 ||
+      seconds <= 0)
+    {
+      fmbench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  fmsynth_initialize(fs);
+  snd = fmbench_setup(nvoices);
+
+  printf("FM synth: %d voices of 3 operators, %d Hz, block size %d\n",
+         nvoices, fs, FMSYNTH_BLOCKSIZE);
+  printf("%-6s %14s %10s %12s\n", "mode", "us per sec", "per voice",
+         "voices/CPU");
+
+  frame_us = fmbench_run(snd, fs * seconds, fmbench_tick);
+  fmbench_report("frame", frame_us, nvoices, seconds);
+
+  block_us = fmbench_run(snd, fs * seconds, NULL);
+  fmbench_report("block", block_us, nvoices, seconds);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,1118 @@
+/****************************************************************************
+ * apps/benchmarks/focbench/focbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/clock.h>
+
+#include "industry/foc/foc_common.h"
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+#  include "industry/foc/float/foc_angle.h"
+#  include "industry/foc/float/foc_handler.h"
+#  include "industry/foc/float/foc_model.h"
+#endif
+
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+#  include "industry/foc/float/foc_multi.h"
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+#  include "industry/foc/fixed16/foc_angle.h"
+#  include "industry/foc/fixed16/foc_handler.h"
+#  include "industry/foc/fixed16/foc_model.h"
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MOTOR_FOC_PHASES != 3
+#  error The FOC benchmark supports only 3-phase motors
+#endif
+
+#define FOCBENCH_DEFAULT_FREQ   10000
+#define FOCBENCH_DEFAULT_ITERS  20000
+#define FOCBENCH_DEFAULT_IQ     5000     /* mA */
+#define FOCBENCH_VBUS           (24.0f)
+
+/* Motor and load used by the benchmark.  The values are chosen so that the
+ * fixed16 model can still represent them: inertia and friction give a
+ * mechanical time constant of 0.2 s and about 100 rad/s steady state
+ * velocity at the default current.
+ */
+
+#define FOCBENCH_POLES          7
+#define FOCBENCH_RES            (0.11f)
+#define FOCBENCH_IND            (0.0002f)
+#define FOCBENCH_FLUX           (0.01f)
+#define FOCBENCH_INER           (0.001f)
+#define FOCBENCH_FRICTION       (0.005f)   /* Nm per rad/s */
+
+/* Current controller bandwidth in rad/s */
+
+#define FOCBENCH_PI_BW          (1000.0f)
+
+/* Simulated quadrature encoder resolution (counts per mechanical turn) */
+
+#define FOCBENCH_ENC_CPR        4096
+
+#define FOCBENCH_2PI            (6.28318530717959f)
+#define FOCBENCH_PI             (3.14159265358979f)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum focbench_angle_e
+{
+  FOCBENCH_ANGLE_ENCODER = 0,
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_OSMO
+  FOCBENCH_ANGLE_OSMO,
+#endif
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_ONFO
+  FOCBENCH_ANGLE_ONFO,
+#endif
+  FOCBENCH_ANGLE_NUM
+};
+
+struct focbench_cfg_s
+{
+  uint32_t freq;                /* Control loop frequency */
+  uint32_t iters;               /* Control loop iterations per run */
+  uint32_t spinup;              /* Iterations with the reference angle */
+  float    per;                 /* Control loop period */
+  float    iq;                  /* Q current reference */
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+  int      nmotors;             /* Motors served by the multi handler */
+#endif
+};
+
+struct focbench_result_s
+{
+  uint32_t exec_max;            /* Max controller ticks per iteration */
+  uint64_t exec_sum;            /* Controller ticks sum */
+  uint32_t samples;             /* Samples in the tracking statistics */
+  float    ang_sq;              /* Sum of squared angle errors */
+  float    ang_max;             /* Max angle error */
+  float    iq_sq;               /* Sum of squared Q current errors */
+  float    vel;                 /* Final mechanical velocity */
+};
+
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+struct focbench_stat_s
+{
+  uint32_t min;                 /* Min ticks */
+  uint32_t max;                 /* Max ticks */
+  uint64_t sum;                 /* Ticks sum */
+};
+
+/* Timing of the multi-motor handler for one run.  The stage-wise run only
+ * times the whole pass, the motor-wise run also times each motor's slice.
+ */
+
+struct focbench_multi_s
+{
+  struct focbench_stat_s pass;
+  struct focbench_stat_s motor[FOC_MULTI_MOTORS_MAX];
+};
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const char *g_angle_name[FOCBENCH_ANGLE_NUM] =
+{
+  "encoder",
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_OSMO
+  "osmo",
+#endif
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_ONFO
+  "onfo",
+#endif
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: focbench_encoder
+ *
+ * Description:
+ *   Quantize the reference electrical angle as a quadrature encoder would.
+ *
+ ****************************************************************************/
+
+static float focbench_encoder(float angle)
+{
+  const float step = FOCBENCH_2PI * FOCBENCH_POLES / FOCBENCH_ENC_CPR;
+
+  return floorf(angle / step) * step;
+}
+
+/****************************************************************************
+ * Name: focbench_angle_wrap
+ ****************************************************************************/
+
+static float focbench_angle_wrap(float angle)
+{
+  angle = fmodf(angle, FOCBENCH_2PI);
+
+  if (angle < 0.0f)
+    {
+      angle += FOCBENCH_2PI;
+    }
+
+  return angle;
+}
+
+/****************************************************************************
+ * Name: focbench_update
+ *
+ * Description:
+ *   Account one control loop iteration.  The tracking error is only
+ *   collected once the spin-up phase is over.
+ *
+ ****************************************************************************/
+
+static void focbench_update(FAR const struct focbench_cfg_s *cfg,
+                            FAR struct focbench_result_s *res,
+                            uint32_t iter, uint32_t exec,
+                            float angle, float angle_ref, float iq)
+{
+  float err;
+
+  res->exec_sum += exec;
+  if (exec > res->exec_max)
+    {
+      res->exec_max = exec;
+    }
+
+  if (iter < cfg->spinup)
+    {
+      return;
+    }
+
+  /* Electrical angle error wrapped to <-PI, PI> */
+
+  err = focbench_angle_wrap(angle - angle_ref);
+  if (err > FOCBENCH_PI)
+    {
+      err -= FOCBENCH_2PI;
+    }
+
+  err = fabsf(err);
+
+  res->ang_sq += err * err;
+  if (err > res->ang_max)
+    {
+      res->ang_max = err;
+    }
+
+  res->iq_sq += (cfg->iq - iq) * (cfg->iq - iq);
+  res->samples += 1;
+}
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+/****************************************************************************
+ * Name: focbench_run_f32
+ ****************************************************************************/
+
+static int focbench_run_f32(FAR const struct focbench_cfg_s *cfg,
+                            int source,
+                            FAR struct focbench_result_s *res)
+{
+  struct foc_model_pmsm_cfg_f32_s pmsm_cfg;
+  struct foc_initdata_f32_s       ctrl_cfg;
+  struct foc_mod_cfg_f32_s        mod_cfg;
+  struct foc_handler_input_f32_s  in;
+  struct foc_handler_output_f32_s out;
+  struct foc_model_state_f32_s    model_state;
+  struct foc_state_f32_s          foc_state;
+  struct foc_angle_in_f32_s       ain;
+  struct foc_angle_out_f32_s      aout;
+  struct motor_phy_params_f32_s   phy;
+  foc_handler_f32_t               handler;
+  foc_model_f32_t                 model;
+  foc_angle_f32_t                 obs;
+  dq_frame_f32_t                  dq_ref;
+  dq_frame_f32_t                  vdq_comp;
+  float                           current[CONFIG_MOTOR_FOC_PHASES];
+  float                           angle_ref = 0.0f;
+  float                           angle     = 0.0f;
+  uint32_t                        start;
+  uint32_t                        i;
+  int                             ret;
+
+  memset(&foc_state, 0, sizeof(foc_state));
+  memset(&obs, 0, sizeof(obs));
+
+  motor_phy_params_init(&phy, FOCBENCH_POLES, FOCBENCH_RES, FOCBENCH_IND,
+                        FOCBENCH_FLUX);
+
+  /* FOC handler with the PI current controller and SVM3 */
+
+  ret = foc_handler_init_f32(&handler, &g_foc_control_pi_f32,
+                             &g_foc_mod_svm3_f32);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ctrl_cfg.id_kp = FOCBENCH_IND * FOCBENCH_PI_BW;
+  ctrl_cfg.id_ki = FOCBENCH_RES * FOCBENCH_PI_BW * cfg->per;
+  ctrl_cfg.iq_kp = ctrl_cfg.id_kp;
+  ctrl_cfg.iq_ki = ctrl_cfg.id_ki;
+  mod_cfg.pwm_duty_max = 0.95f;
+
+  foc_handler_cfg_f32(&handler, &ctrl_cfg, &mod_cfg);
+
+  /* PMSM model */
+
+  ret = foc_model_init_f32(&model, &g_foc_model_pmsm_ops_f32);
+  if (ret < 0)
+    {
+      goto errout_handler;
+    }
+
+  pmsm_cfg.poles      = FOCBENCH_POLES;
+  pmsm_cfg.res        = FOCBENCH_RES;
+  pmsm_cfg.ind        = FOCBENCH_IND;
+  pmsm_cfg.iner       = FOCBENCH_INER;
+  pmsm_cfg.flux_link  = FOCBENCH_FLUX;
+  pmsm_cfg.ind_d      = FOCBENCH_IND;
+  pmsm_cfg.ind_q      = FOCBENCH_IND;
+  pmsm_cfg.per        = cfg->per;
+  pmsm_cfg.iphase_adc = 0.001f;
+
+  foc_model_cfg_f32(&model, &pmsm_cfg);
+
+  /* Angle observer */
+
+  switch (source)
+    {
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_OSMO
+      case FOCBENCH_ANGLE_OSMO:
+        {
+          struct foc_angle_osmo_cfg_f32_s smo_cfg;
+
+          ret = foc_angle_init_f32(&obs, &g_foc_angle_osmo_f32);
+          if (ret < 0)
+            {
+              goto errout_obs;
+            }
+
+          smo_cfg.per     = cfg->per;
+          smo_cfg.k_slide =
+            CONFIG_BENCHMARK_FOCBENCH_SMO_KSLIDE / 1000.0f;
+          smo_cfg.err_max =
+            CONFIG_BENCHMARK_FOCBENCH_SMO_ERRMAX / 1000.0f;
+          memcpy(&smo_cfg.phy, &phy, sizeof(phy));
+
+          ret = foc_angle_cfg_f32(&obs, &smo_cfg);
+          break;
+        }
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_ONFO
+      case FOCBENCH_ANGLE_ONFO:
+        {
+          struct foc_angle_onfo_cfg_f32_s nfo_cfg;
+
+          ret = foc_angle_init_f32(&obs, &g_foc_angle_onfo_f32);
+          if (ret < 0)
+            {
+              goto errout_obs;
+            }
+
+          nfo_cfg.per       = cfg->per;
+          nfo_cfg.gain      = CONFIG_BENCHMARK_FOCBENCH_NFO_GAIN / 1.0f;
+          nfo_cfg.gain_slow =
+            CONFIG_BENCHMARK_FOCBENCH_NFO_GAINSLOW / 1000.0f;
+          memcpy(&nfo_cfg.phy, &phy, sizeof(phy));
+
+          ret = foc_angle_cfg_f32(&obs, &nfo_cfg);
+          break;
+        }
+#endif
+
+      default:
+        {
+          break;
+        }
+    }
+
+  if (ret < 0)
+    {
+      goto errout_obs;
+    }
+
+  dq_ref.d   = 0.0f;
+  dq_ref.q   = cfg->iq;
+  vdq_comp.d = 0.0f;
+  vdq_comp.q = 0.0f;
+
+  in.current  = current;
+  in.dq_ref   = &dq_ref;
+  in.vdq_comp = &vdq_comp;
+  in.vbus     = FOCBENCH_VBUS;
+  in.mode     = FOC_HANDLER_MODE_CURRENT;
+
+  for (i = 0; i < cfg->iters; i++)
+    {
+      /* Sample the plant */
+
+      foc_model_state_f32(&model, &model_state);
+
+      current[0] = model_state.curr[0];
+      current[1] = model_state.curr[1];
+      current[2] = model_state.curr[2];
+
+      angle_ref = focbench_angle_wrap(angle_ref +
+                                      model_state.omega_e * cfg->per);
+
+      /* Controller: angle handler, FOC handler and its state */
+
+      start = perf_gettime();
+
+      angle = focbench_encoder(angle_ref);
+
+      if (obs.ops != NULL)
+        {
+          ain.state = &foc_state;
+          ain.angle = angle;
+          ain.vel   = model_state.omega_e;
+          ain.dir   = DIR_CW;
+
+          foc_angle_run_f32(&obs, &ain, &aout);
+
+          /* Close the loop with the observer after spin-up */
+
+          if (i >= cfg->spinup)
+            {
+              angle = focbench_angle_wrap(aout.angle);
+            }
+        }
+
+      in.angle = angle;
+
+      foc_handler_run_f32(&handler, &in, &out);
+      foc_handler_state_f32(&handler, &foc_state, NULL);
+
+      focbench_update(cfg, res, i, perf_gettime() - start,
+                      angle, angle_ref, model_state.idq.q);
+
+      /* Feed the plant with the new voltage and a viscous load */
+
+      foc_model_run_f32(&model, FOCBENCH_FRICTION * model_state.omega_m,
+                        &foc_state.vab);
+    }
+
+  res->vel = model_state.omega_m;
+
+errout_obs:
+  if (obs.ops != NULL)
+    {
+      foc_angle_deinit_f32(&obs);
+    }
+
+  foc_model_deinit_f32(&model);
+
+errout_handler:
+  foc_handler_deinit_f32(&handler);
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+/****************************************************************************
+ * Name: focbench_stat_update
+ ****************************************************************************/
+
+static void focbench_stat_update(FAR struct focbench_stat_s *s,
+                                 uint32_t val)
+{
+  if (s->sum == 0 || val < s->min)
+    {
+      s->min = val;
+    }
+
+  if (val > s->max)
+    {
+      s->max = val;
+    }
+
+  s->sum += val;
+}
+
+/****************************************************************************
+ * Name: focbench_run_multi_f32
+ *
+ * Description:
+ *   Close the loop for nmotors identical PMSM models served by the
+ *   multi-motor handler in one thread, with the encoder angle.  The
+ *   stage-wise run does one foc_multi_run_f32() pass per iteration and
+ *   times the whole pass.  The motor-wise run serves the motors one after
+ *   another with foc_multi_run_motor_f32() and times each motor's slice,
+ *   the pass is the sum of the slices.
+ *
+ ****************************************************************************/
+
+static int focbench_run_multi_f32(FAR const struct focbench_cfg_s *cfg,
+                                  bool sliced,
+                                  FAR struct focbench_result_s *res,
+                                  FAR struct focbench_multi_s *multi)
+{
+  struct foc_model_pmsm_cfg_f32_s pmsm_cfg;
+  struct foc_initdata_f32_s       ctrl_cfg;
+  struct foc_mod_cfg_f32_s        mod_cfg;
+  struct foc_multi_input_f32_s    in;
+  struct foc_multi_output_f32_s   out;
+  struct foc_model_state_f32_s    model_state[FOC_MULTI_MOTORS_MAX];
+  struct foc_state_f32_s          foc_state[FOC_MULTI_MOTORS_MAX];
+  foc_model_f32_t                 model[FOC_MULTI_MOTORS_MAX];
+  foc_multi_f32_t                 handler;
+  float                           angle_ref[FOC_MULTI_MOTORS_MAX];
+  uint32_t                        start;
+  uint32_t                        exec;
+  uint32_t                        slice;
+  uint32_t                        i;
+  int                             ret;
+  int                             m;
+  int                             n = 0;
+
+  ret = foc_multi_init_f32(&handler, cfg->nmotors);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ctrl_cfg.id_kp = FOCBENCH_IND * FOCBENCH_PI_BW;
+  ctrl_cfg.id_ki = FOCBENCH_RES * FOCBENCH_PI_BW * cfg->per;
+  ctrl_cfg.iq_kp = ctrl_cfg.id_kp;
+  ctrl_cfg.iq_ki = ctrl_cfg.id_ki;
+  mod_cfg.pwm_duty_max = 0.95f;
+
+  pmsm_cfg.poles      = FOCBENCH_POLES;
+  pmsm_cfg.res        = FOCBENCH_RES;
+  pmsm_cfg.ind        = FOCBENCH_IND;
+  pmsm_cfg.iner       = FOCBENCH_INER;
+  pmsm_cfg.flux_link  = FOCBENCH_FLUX;
+  pmsm_cfg.ind_d      = FOCBENCH_IND;
+  pmsm_cfg.ind_q      = FOCBENCH_IND;
+  pmsm_cfg.per        = cfg->per;
+  pmsm_cfg.iphase_adc = 0.001f;
+
+  for (n = 0; n < cfg->nmotors; n++)
+    {
+      ret = foc_model_init_f32(&model[n], &g_foc_model_pmsm_ops_f32);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+
+      foc_model_cfg_f32(&model[n], &pmsm_cfg);
+      foc_multi_cfg_f32(&handler, n, &ctrl_cfg, &mod_cfg);
+
+      in.d_ref[n]   = 0.0f;
+      in.q_ref[n]   = cfg->iq;
+      in.vd_comp[n] = 0.0f;
+      in.vq_comp[n] = 0.0f;
+      in.vbus[n]    = FOCBENCH_VBUS;
+      in.mode[n]    = FOC_HANDLER_MODE_CURRENT;
+      angle_ref[n]  = 0.0f;
+    }
+
+  for (i = 0; i < cfg->iters; i++)
+    {
+      /* Sample the plants */
+
+      for (m = 0; m < cfg->nmotors; m++)
+        {
+          foc_model_state_f32(&model[m], &model_state[m]);
+
+          in.curr[0][m] = model_state[m].curr[0];
+          in.curr[1][m] = model_state[m].curr[1];
+          in.curr[2][m] = model_state[m].curr[2];
+
+          angle_ref[m] = focbench_angle_wrap(angle_ref[m] +
+                                             model_state[m].omega_e *
+                                             cfg->per);
+        }
+
+      /* Controller: angle, handler and state for all motors */
+
+      if (sliced)
+        {
+          exec = 0;
+
+          for (m = 0; m < cfg->nmotors; m++)
+            {
+              start = perf_gettime();
+
+              in.angle[m] = focbench_encoder(angle_ref[m]);
+              foc_multi_run_motor_f32(&handler, m, &in, &out);
+              foc_multi_state_f32(&handler, m, &foc_state[m]);
+
+              slice = perf_gettime() - start;
+              focbench_stat_update(&multi->motor[m], slice);
+              exec += slice;
+            }
+        }
+      else
+        {
+          start = perf_gettime();
+
+          for (m = 0; m < cfg->nmotors; m++)
+            {
+              in.angle[m] = focbench_encoder(angle_ref[m]);
+            }
+
+          foc_multi_run_f32(&handler, &in, &out);
+
+          for (m = 0; m < cfg->nmotors; m++)
+            {
+              foc_multi_state_f32(&handler, m, &foc_state[m]);
+            }
+
+          exec = perf_gettime() - start;
+        }
+
+      focbench_stat_update(&multi->pass, exec);
+
+      /* The pass is accounted once, the tracking error for every motor */
+
+      for (m = 0; m < cfg->nmotors; m++)
+        {
+          focbench_update(cfg, res, i, m == 0 ? exec : 0, in.angle[m],
+                          angle_ref[m], model_state[m].idq.q);
+
+          /* Feed the plant with the new voltage and a viscous load */
+
+          foc_model_run_f32(&model[m],
+                            FOCBENCH_FRICTION * model_state[m].omega_m,
+                            &foc_state[m].vab);
+        }
+    }
+
+  res->vel = model_state[0].omega_m;
+
+errout:
+  while (n-- > 0)
+    {
+      foc_model_deinit_f32(&model[n]);
+    }
+
+  return ret;
+}
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+/****************************************************************************
+ * Name: focbench_run_b16
+ ****************************************************************************/
+
+static int focbench_run_b16(FAR const struct focbench_cfg_s *cfg,
+                            int source,
+                            FAR struct focbench_result_s *res)
+{
+  struct foc_model_pmsm_cfg_b16_s pmsm_cfg;
+  struct foc_initdata_b16_s       ctrl_cfg;
+  struct foc_mod_cfg_b16_s        mod_cfg;
+  struct foc_handler_input_b16_s  in;
+  struct foc_handler_output_b16_s out;
+  struct foc_model_state_b16_s    model_state;
+  struct foc_state_b16_s          foc_state;
+  struct foc_angle_in_b16_s       ain;
+  struct foc_angle_out_b16_s      aout;
+  struct motor_phy_params_b16_s   phy;
+  foc_handler_b16_t               handler;
+  foc_model_b16_t                 model;
+  foc_angle_b16_t                 obs;
+  dq_frame_b16_t                  dq_ref;
+  dq_frame_b16_t                  vdq_comp;
+  b16_t                           current[CONFIG_MOTOR_FOC_PHASES];
+  float                           angle_ref = 0.0f;
+  float                           angle     = 0.0f;
+  uint32_t                        start;
+  uint32_t                        i;
+  int                             ret;
+
+  memset(&foc_state, 0, sizeof(foc_state));
+  memset(&obs, 0, sizeof(obs));
+
+  motor_phy_params_init_b16(&phy, FOCBENCH_POLES, ftob16(FOCBENCH_RES),
+                            ftob16(FOCBENCH_IND), ftob16(FOCBENCH_FLUX));
+
+  /* FOC handler with the PI current controller and SVM3 */
+
+  ret = foc_handler_init_b16(&handler, &g_foc_control_pi_b16,
+                             &g_foc_mod_svm3_b16);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  ctrl_cfg.id_kp = ftob16(FOCBENCH_IND * FOCBENCH_PI_BW);
+  ctrl_cfg.id_ki = ftob16(FOCBENCH_RES * FOCBENCH_PI_BW * cfg->per);
+  ctrl_cfg.iq_kp = ctrl_cfg.id_kp;
+  ctrl_cfg.iq_ki = ctrl_cfg.id_ki;
+  mod_cfg.pwm_duty_max = ftob16(0.95f);
+
+  foc_handler_cfg_b16(&handler, &ctrl_cfg, &mod_cfg);
+
+  /* PMSM model */
+
+  ret = foc_model_init_b16(&model, &g_foc_model_pmsm_ops_b16);
+  if (ret < 0)
+    {
+      goto errout_handler;
+    }
+
+  pmsm_cfg.poles      = FOCBENCH_POLES;
+  pmsm_cfg.res        = ftob16(FOCBENCH_RES);
+  pmsm_cfg.ind        = ftob16(FOCBENCH_IND);
+  pmsm_cfg.iner       = ftob16(FOCBENCH_INER);
+  pmsm_cfg.flux_link  = ftob16(FOCBENCH_FLUX);
+  pmsm_cfg.ind_d      = ftob16(FOCBENCH_IND);
+  pmsm_cfg.ind_q      = ftob16(FOCBENCH_IND);
+  pmsm_cfg.per        = ftob16(cfg->per);
+  pmsm_cfg.iphase_adc = ftob16(0.001f);
+
+  foc_model_cfg_b16(&model, &pmsm_cfg);
+
+  /* Angle observer */
+
+  switch (source)
+    {
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_OSMO
+      case FOCBENCH_ANGLE_OSMO:
+        {
+          struct foc_angle_osmo_cfg_b16_s smo_cfg;
+
+          ret = foc_angle_init_b16(&obs, &g_foc_angle_osmo_b16);
+          if (ret < 0)
+            {
+              goto errout_obs;
+            }
+
+          smo_cfg.per     = ftob16(cfg->per);
+          smo_cfg.k_slide =
+            ftob16(CONFIG_BENCHMARK_FOCBENCH_SMO_KSLIDE / 1000.0f);
+          smo_cfg.err_max =
+            ftob16(CONFIG_BENCHMARK_FOCBENCH_SMO_ERRMAX / 1000.0f);
+          memcpy(&smo_cfg.phy, &phy, sizeof(phy));
+
+          ret = foc_angle_cfg_b16(&obs, &smo_cfg);
+          break;
+        }
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_ANGLE_ONFO
+      case FOCBENCH_ANGLE_ONFO:
+        {
+          struct foc_angle_onfo_cfg_b16_s nfo_cfg;
+
+          ret = foc_angle_init_b16(&obs, &g_foc_angle_onfo_b16);
+          if (ret < 0)
+            {
+              goto errout_obs;
+            }
+
+          nfo_cfg.per       = ftob16(cfg->per);
+          nfo_cfg.gain      =
+            ftob16(CONFIG_BENCHMARK_FOCBENCH_NFO_GAIN / 1.0f);
+          nfo_cfg.gain_slow =
+            ftob16(CONFIG_BENCHMARK_FOCBENCH_NFO_GAINSLOW / 1000.0f);
+          memcpy(&nfo_cfg.phy, &phy, sizeof(phy));
+
+          ret = foc_angle_cfg_b16(&obs, &nfo_cfg);
+          break;
+        }
+#endif
+
+      default:
+        {
+          break;
+        }
+    }
+
+  if (ret < 0)
+    {
+      goto errout_obs;
+    }
+
+  dq_ref.d   = 0;
+  dq_ref.q   = ftob16(cfg->iq);
+  vdq_comp.d = 0;
+  vdq_comp.q = 0;
+
+  in.current  = current;
+  in.dq_ref   = &dq_ref;
+  in.vdq_comp = &vdq_comp;
+  in.vbus     = ftob16(FOCBENCH_VBUS);
+  in.mode     = FOC_HANDLER_MODE_CURRENT;
+
+  for (i = 0; i < cfg->iters; i++)
+    {
+      /* Sample the plant */
+
+      foc_model_state_b16(&model, &model_state);
+
+      current[0] = model_state.curr[0];
+      current[1] = model_state.curr[1];
+      current[2] = model_state.curr[2];
+
+      angle_ref = focbench_angle_wrap(angle_ref +
+                                      b16tof(model_state.omega_e) *
+                                      cfg->per);
+
+      /* Controller: angle handler, FOC handler and its state */
+
+      start = perf_gettime();
+
+      angle = focbench_encoder(angle_ref);
+
+      if (obs.ops != NULL)
+        {
+          ain.state = &foc_state;
+          ain.angle = ftob16(angle);
+          ain.vel   = model_state.omega_e;
+          ain.dir   = DIR_CW_B16;
+
+          foc_angle_run_b16(&obs, &ain, &aout);
+
+          /* Close the loop with the observer after spin-up */
+
+          if (i >= cfg->spinup)
+            {
+              angle = focbench_angle_wrap(b16tof(aout.angle));
+            }
+        }
+
+      in.angle = ftob16(angle);
+
+      foc_handler_run_b16(&handler, &in, &out);
+      foc_handler_state_b16(&handler, &foc_state, NULL);
+
+      focbench_update(cfg, res, i, perf_gettime() - start,
+                      angle, angle_ref, b16tof(model_state.idq.q));
+
+      /* Feed the plant with the new voltage and a viscous load */
+
+      foc_model_run_b16(&model,
+                        b16mulb16(ftob16(FOCBENCH_FRICTION),
+                                  model_state.omega_m),
+                        &foc_state.vab);
+    }
+
+  res->vel = b16tof(model_state.omega_m);
+
+errout_obs:
+  if (obs.ops != NULL)
+    {
+      foc_angle_deinit_b16(&obs);
+    }
+
+  foc_model_deinit_b16(&model);
+
+errout_handler:
+  foc_handler_deinit_b16(&handler);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: focbench_report
+ *
+ * Description:
+ *   Print one result row, return false if the RMS angle error is above
+ *   the limit (in electrical degrees, 0 disables the check).
+ *
+ ****************************************************************************/
+
+static bool focbench_report(FAR const char *type, FAR const char *source,
+                            FAR const struct focbench_cfg_s *cfg,
+                            FAR const struct focbench_result_s *res,
+                            float limit)
+{
+  struct timespec ts;
+  uint32_t        avg;
+  float           ang_rms = 0.0f;
+  float           iq_rms  = 0.0f;
+
+  avg = (uint32_t)(res->exec_sum / cfg->iters);
+  perf_convert(avg, &ts);
+
+  if (res->samples > 0)
+    {
+      ang_rms = sqrtf(res->ang_sq / res->samples) * 180.0f / FOCBENCH_PI;
+      iq_rms  = sqrtf(res->iq_sq / res->samples);
+    }
+
+  printf("%-7s %-8s %9" PRIu32 " %9" PRIu32 " %8ld %8.2f %8.2f %7.3f "
+         "%8.1f\n", type, source, avg, res->exec_max, ts.tv_nsec,
+         ang_rms, res->ang_max * 180.0f / FOCBENCH_PI, iq_rms, res->vel);
+
+  return limit <= 0.0f || ang_rms <= limit;
+}
+
+static void focbench_usage(FAR const char *progname)
+{
+  printf("Usage: %s [-f <hz>] [-n <iters>] [-i <mA>] [-e <deg>]"
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+         " [-m <num>]"
+#endif
+         "\n", progname);
+  printf("  -f <hz>     Control loop frequency (default %d)\n",
+         FOCBENCH_DEFAULT_FREQ);
+  printf("  -n <iters>  Control loop iterations per run (default %d)\n",
+         FOCBENCH_DEFAULT_ITERS);
+  printf("  -i <mA>     Q current reference (default %d)\n",
+         FOCBENCH_DEFAULT_IQ);
+  printf("  -e <deg>    Fail if the RMS angle error exceeds this limit\n");
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+  printf("  -m <num>    Motors for the multi-motor handler (default %d)\n",
+         CONFIG_INDUSTRY_FOC_MULTI_MOTORS);
+#endif
+}
+
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+/****************************************************************************
+ * Name: focbench_stat_print
+ ****************************************************************************/
+
+static void focbench_stat_print(FAR const char *name,
+                                FAR const struct focbench_stat_s *s,
+                                uint32_t cnt)
+{
+  struct timespec ts;
+  uint32_t        avg;
+
+  avg = (uint32_t)(s->sum / cnt);
+  perf_convert(avg, &ts);
+
+  printf("%-16s %9" PRIu32 " %9" PRIu32 " %9" PRIu32 " %8ld\n", name,
+         s->min, avg, s->max, ts.tv_nsec);
+}
+
+/****************************************************************************
+ * Name: focbench_multi
+ *
+ * Description:
+ *   Run the multi-motor handler for cfg->nmotors motors, once stage-wise
+ *   and once motor-wise, and print the min/avg/max time of the whole pass
+ *   and of each motor's slice.  A stage-wise pass cannot be split between
+ *   the motors, so the slices come from the motor-wise run.
+ *
+ ****************************************************************************/
+
+static int focbench_multi(FAR const struct focbench_cfg_s *cfg,
+                          float limit, FAR bool *pass)
+{
+  struct focbench_result_s res;
+  struct focbench_multi_s  stage;
+  struct focbench_multi_s  motor;
+  char                     name[24];
+  int                      ret;
+  int                      m;
+
+  memset(&res, 0, sizeof(res));
+  memset(&stage, 0, sizeof(stage));
+  ret = focbench_run_multi_f32(cfg, false, &res, &stage);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  snprintf(name, sizeof(name), "stage x%d", cfg->nmotors);
+  *pass &= focbench_report("multi", name, cfg, &res, limit);
+
+  memset(&res, 0, sizeof(res));
+  memset(&motor, 0, sizeof(motor));
+  ret = focbench_run_multi_f32(cfg, true, &res, &motor);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  snprintf(name, sizeof(name), "motor x%d", cfg->nmotors);
+  *pass &= focbench_report("multi", name, cfg, &res, limit);
+
+  printf("%-16s %9s %9s %9s %8s\n", "multi ticks", "min", "avg", "max",
+         "ns avg");
+  focbench_stat_print("stage-wise pass", &stage.pass, cfg->iters);
+  focbench_stat_print("motor-wise pass", &motor.pass, cfg->iters);
+
+  for (m = 0; m < cfg->nmotors; m++)
+    {
+      snprintf(name, sizeof(name), "motor %d slice", m);
+      focbench_stat_print(name, &motor.motor[m], cfg->iters);
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct focbench_result_s res;
+  struct focbench_cfg_s    cfg;
+  float                    limit = 0.0f;
+  bool                     pass  = true;
+  int                      opt;
+  int                      ret;
+  int                      i;
+
+  cfg.freq  = FOCBENCH_DEFAULT_FREQ;
+  cfg.iters = FOCBENCH_DEFAULT_ITERS;
+  cfg.iq    = FOCBENCH_DEFAULT_IQ / 1000.0f;
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+  cfg.nmotors = CONFIG_INDUSTRY_FOC_MULTI_MOTORS;
+#endif
+
+  while ((opt = getopt(argc, argv, "f:n:i:e:m:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 'f':
+            cfg.freq = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'n':
+            cfg.iters = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'i':
+            cfg.iq = strtol(optarg, NULL, 0) / 1000.0f;
+            break;
+
+          case 'e':
+            limit = strtof(optarg, NULL);
+            break;
+
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+          case 'm':
+            cfg.nmotors = atoi(optarg);
+            break;
+#endif
+
+          default:
+            focbench_usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (cfg.freq == 0 || cfg.iters < 2)
+    {
+      focbench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+  if (cfg.nmotors < 1 || cfg.nmotors > CONFIG_INDUSTRY_FOC_MULTI_MOTORS)
+    {
+      focbench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+#endif
+
+  /* The first half of each run spins the motor up with the reference
+   * angle, the second half is closed with the selected angle source.
+   */
+
+  cfg.per    = 1.0f / cfg.freq;
+  cfg.spinup = cfg.iters / 2;
+
+  printf("FOC control loop: %" PRIu32 " Hz, %" PRIu32 " iterations, "
+         "iq %.3f A, encoder %d CPR\n", cfg.freq, cfg.iters, cfg.iq,
+         FOCBENCH_ENC_CPR);
+  printf("%-7s %-8s %9s %9s %8s %8s %8s %7s %8s\n", "type", "angle",
+         "ticks/it", "max", "ns/it", "ang rms", "ang max", "iq rms",
+         "vel");
+
+  for (i = 0; i < FOCBENCH_ANGLE_NUM; i++)
+    {
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+      memset(&res, 0, sizeof(res));
+      ret = focbench_run_f32(&cfg, i, &res);
+      if (ret < 0)
+        {
+          printf("ERROR: float run failed %d\n", ret);
+          return EXIT_FAILURE;
+        }
+
+      pass &= focbench_report("float", g_angle_name[i], &cfg, &res,
+                              limit);
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+      memset(&res, 0, sizeof(res));
+      ret = focbench_run_b16(&cfg, i, &res);
+      if (ret < 0)
+        {
+          printf("ERROR: fixed16 run failed %d\n", ret);
+          return EXIT_FAILURE;
+        }
+
+      pass &= focbench_report("fixed16", g_angle_name[i], &cfg, &res,
+                              limit);
+#endif
+    }
+
+#ifdef CONFIG_BENCHMARK_FOCBENCH_MULTI
+  ret = focbench_multi(&cfg, limit, &pass);
+  if (ret < 0)
+    {
+      printf("ERROR: multi-motor run failed %d\n", ret);
+      return EXIT_FAILURE;
+    }
+#endif
+
+  if (!pass)
+    {
+      printf("FAIL: RMS angle error above %.2f deg\n", limit);
+      return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
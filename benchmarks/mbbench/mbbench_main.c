@@ -0,0 +1,243 @@
+/****************************************************************************
+ * apps/benchmarks/mbbench/mbbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "mbcrc.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MBBENCH_FRAME_MAX     256
+#define MBBENCH_DEFAULT_MS    1000
+#define MBBENCH_DEFAULT_BAUD  921600
+
+#if defined(CONFIG_MB_CRC16_SLICE_BY_8)
+#  define MBBENCH_CRC_NAME    "slice-by-8"
+#elif defined(CONFIG_MB_CRC16_SLICE_BY_4)
+#  define MBBENCH_CRC_NAME    "slice-by-4"
+#else
+#  define MBBENCH_CRC_NAME    "byte-wise"
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+typedef uint16_t (*mbbench_crc_t)(FAR uint8_t *buf, uint16_t len);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint16_t g_crc_table[256];
+static const uint16_t g_frame_sizes[] =
+{
+  8, 16, 64, 128, 256
+};
+
+/* Keep the compiler from dropping the benchmarked calls */
+
+static volatile uint16_t g_sink;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void mbbench_init_table(void)
+{
+  uint16_t crc;
+  int i;
+  int j;
+
+  for (i = 0; i < 256; i++)
+    {
+      crc = i;
+      for (j = 0; j < 8; j++)
+        {
+          crc = (crc & 1) ? (crc >> 1) ^ 0xa001 : crc >> 1;
+        }
+
+      g_crc_table[i] = crc;
+    }
+}
+
+/* Reference byte-at-a-time table walk, equivalent to the original
+ * usMBCRC16() implementation.
+ */
+
+static uint16_t mbbench_crc_ref(FAR uint8_t *buf, uint16_t len)
+{
+  uint16_t crc = 0xffff;
+
+  while (len--)
+    {
+      crc = (crc >> 8) ^ g_crc_table[(crc ^ *buf++) & 0xff];
+    }
+
+  return crc;
+}
+
+static uint64_t mbbench_now_us(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* Validate complete frames (CRC over address, PDU and CRC must be zero)
+ * for about duration_ms and return the rate in frames per second.
+ */
+
+static uint32_t mbbench_run(mbbench_crc_t crc, FAR uint8_t *frame,
+                            uint16_t size, uint32_t duration_ms)
+{
+  uint64_t start;
+  uint64_t elapsed;
+  uint32_t frames = 0;
+  int i;
+
+  start = mbbench_now_us();
+  do
+    {
+      for (i = 0; i < 256; i++)
+        {
+          g_sink = crc(frame, size);
+        }
+
+      frames += 256;
+      elapsed = mbbench_now_us() - start;
+    }
+  while (elapsed < (uint64_t)duration_ms * 1000);
+
+  return (uint32_t)((uint64_t)frames * 1000000 / elapsed);
+}
+
+static void mbbench_usage(FAR const char *progname)
+{
+  printf("Usage: %s [-t <ms>] [-b <baud>]\n", progname);
+  printf("  -t <ms>    Duration of each measurement (default %d)\n",
+         MBBENCH_DEFAULT_MS);
+  printf("  -b <baud>  Line rate used for the headroom column "
+         "(default %d)\n", MBBENCH_DEFAULT_BAUD);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  uint8_t frame[MBBENCH_FRAME_MAX];
+  uint32_t duration_ms = MBBENCH_DEFAULT_MS;
+  uint32_t baud = MBBENCH_DEFAULT_BAUD;
+  uint32_t ref_fps;
+  uint32_t cur_fps;
+  uint32_t line_fps;
+  uint16_t crc;
+  uint16_t size;
+  size_t n;
+  int opt;
+  int i;
+
+  while ((opt = getopt(argc, argv, "t:b:h")) != -1)
+    {
+      switch (opt)
+        {
+          case 't':
+            duration_ms = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'b':
+            baud = strtoul(optarg, NULL, 0);
+            break;
+
+          default:
+            mbbench_usage(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (duration_ms == 0 || baud == 0)
+    {
+      mbbench_usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  mbbench_init_table();
+  srand(1);
+
+  printf("Modbus RTU CRC16: %s, %" PRIu32 " ms per run, line %" PRIu32
+         " baud\n", MBBENCH_CRC_NAME, duration_ms, baud);
+  printf("%6s %14s %14s %8s %12s %9s\n", "bytes", "ref frames/s",
+         "frames/s", "speedup", "line fr/s", "headroom");
+
+  for (n = 0; n < sizeof(g_frame_sizes) / sizeof(g_frame_sizes[0]); n++)
+    {
+      size = g_frame_sizes[n];
+
+      for (i = 0; i < size - 2; i++)
+        {
+          frame[i] = (uint8_t)rand();
+        }
+
+      crc = mbbench_crc_ref(frame, size - 2);
+      frame[size - 2] = (uint8_t)(crc & 0xff);
+      frame[size - 1] = (uint8_t)(crc >> 8);
+
+      if (usMBCRC16(frame, size) != 0 ||
+          usMBCRC16(frame, size - 2) != crc)
+        {
+          printf("CRC mismatch for %u byte frame\n", size);
+          return EXIT_FAILURE;
+        }
+
+      ref_fps = mbbench_run(mbbench_crc_ref, frame, size, duration_ms);
+      cur_fps = mbbench_run(usMBCRC16, frame, size, duration_ms);
+
+      /* 11 bits per character plus the 3.5 character inter-frame gap */
+
+      line_fps = (uint32_t)((uint64_t)baud * 2 / (11 * (2 * size + 7)));
+
+      printf("%6u %14" PRIu32 " %14" PRIu32 " %7" PRIu32 ".%02" PRIu32
+             "x %12" PRIu32 " %8" PRIu32 "x\n",
+             size, ref_fps, cur_fps,
+             (uint32_t)((uint64_t)cur_fps * 100 / ref_fps) / 100,
+             (uint32_t)((uint64_t)cur_fps * 100 / ref_fps) % 100,
+             line_fps, line_fps ? cur_fps / line_fps : 0);
+    }
+
+  return EXIT_SUCCESS;
+}
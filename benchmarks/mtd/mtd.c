@@ -27,6 +27,10 @@
 #include <nuttx/config.h>
 
 #include <sys/stat.h>
+#include <errno.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <unistd.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,171 +41,731 @@
 #include <nuttx/fs/smart.h>
 #include <nuttx/fs/ioctl.h>
 
+#include "inode/inode.h"
+#include "driver/driver.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* Latency histogram: bucket 0 is [0, 1) us, bucket n is [2^(n-1), 2^n) us.
+ * The last bucket also collects everything slower than ~8 s.
+ */
+
+#define MTD_BENCH_NBUCKETS  25
+#define MTD_BENCH_BARWIDTH  40
+
 /****************************************************************************
- * Private data
+ * Private Types
  ****************************************************************************/
 
+struct mtd_hist_s
+{
+  FAR const char *name;
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint32_t bucket[MTD_BENCH_NBUCKETS];
+};
+
+struct mtd_bench_s
+{
+  FAR struct inode *inode;
+  bool ismtd;              /* Raw MTD driver, not a block driver */
+  uint32_t blocksize;      /* Read/program unit: page or sector */
+  uint32_t erasesize;      /* Erase block size reported by the device */
+  uint32_t blkper;         /* Blocks per erase unit */
+  uint32_t unitsize;       /* blkper * blocksize */
+  uint32_t firstunit;      /* First erase unit under test */
+  uint32_t nunits;         /* Number of erase units under test */
+  uint32_t npasses;
+  uint32_t nrandom;
+  uint32_t nerrors;
+  FAR uint8_t *wbuf;
+  FAR uint8_t *rbuf;
+
+  struct mtd_hist_s erase;
+  struct mtd_hist_s program;
+  struct mtd_hist_s bwrite;
+  struct mtd_hist_s bread;
+  struct mtd_hist_s rread;
+};
+
 /****************************************************************************
- * Public Functions
+ * Private Functions
  ****************************************************************************/
 
-int main(int argc, FAR char *argv[])
+/****************************************************************************
+ * Name: mtd_bench_now
+ ****************************************************************************/
+
+static uint64_t mtd_bench_now(void)
 {
-  struct inode            *inode;
-  struct timespec         start;
-  struct timespec         end;
-  struct mtd_geometry_s   geo;
-  struct partition_info_s info;
-  int                     ret;
-  int                     x;
-  double                  elapsed_time;
-  double                  transfer_rate;
-  size_t                  total_bytes_written = 0;
-  size_t                  total_bytes_read = 0;
-  char                    *buffer;
+  struct timespec ts;
 
-  /* Argument given? */
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: mtd_hist_add
+ ****************************************************************************/
+
+static void mtd_hist_add(FAR struct mtd_hist_s *hist, uint64_t start)
+{
+  uint64_t elapsed = mtd_bench_now() - start;
+  uint32_t us = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+  int idx = 0;
+
+  while (idx < MTD_BENCH_NBUCKETS - 1 && (us >> idx) != 0)
+    {
+      idx++;
+    }
+
+  hist->bucket[idx]++;
+  hist->sum += us;
+  if (hist->count == 0 || us < hist->min)
+    {
+      hist->min = us;
+    }
+
+  if (us > hist->max)
+    {
+      hist->max = us;
+    }
+
+  hist->count++;
+}
+
+/****************************************************************************
+ * Name: mtd_hist_show
+ ****************************************************************************/
+
+static void mtd_hist_show(FAR const struct mtd_hist_s *hist)
+{
+  uint32_t peak = 0;
+  int bar;
+  int i;
+
+  if (hist->count == 0)
+    {
+      return;
+    }
+
+  printf("\n%s latency: count %" PRIu32 " min %" PRIu32 " avg %" PRIu64
+         " max %" PRIu32 " us\n", hist->name, hist->count, hist->min,
+         hist->sum / hist->count, hist->max);
 
-  if (argc < 2)
+  for (i = 0; i < MTD_BENCH_NBUCKETS; i++)
     {
-      fprintf(stderr, "usage: mtd flash_block_device\n");
-      return -1;
+      if (hist->bucket[i] > peak)
+        {
+          peak = hist->bucket[i];
+        }
     }
 
-  /* Find the inode of the block driver identified by 'source' */
+  for (i = 0; i < MTD_BENCH_NBUCKETS; i++)
+    {
+      if (hist->bucket[i] == 0)
+        {
+          continue;
+        }
+
+      printf("  %8" PRIu32 " - %8" PRIu32 " us %8" PRIu32 " ",
+             i == 0 ? 0 : UINT32_C(1) << (i - 1), UINT32_C(1) << i,
+             hist->bucket[i]);
+
+      for (bar = (uint64_t)hist->bucket[i] * MTD_BENCH_BARWIDTH / peak;
+           bar > 0; bar--)
+        {
+          putchar('#');
+        }
+
+      putchar('\n');
+    }
+}
+
+/****************************************************************************
+ * Name: mtd_bench_rate
+ ****************************************************************************/
+
+static void mtd_bench_rate(FAR const char *name, uint64_t nbytes,
+                           uint64_t start)
+{
+  double elapsed_time = (mtd_bench_now() - start) / 1e6;
+
+  printf("  %-8s %10" PRIu64 " bytes in %8.3f s: %10.2f KiB/s\n",
+         name, nbytes, elapsed_time,
+         elapsed_time > 0 ? nbytes / elapsed_time / 1024 : 0.0);
+}
+
+/****************************************************************************
+ * Name: mtd_bench_fill
+ *
+ * Description:
+ *   Fill one erase unit with a pattern that differs per unit and per pass,
+ *   so stale data or address aliasing is caught by the verification.
+ *
+ ****************************************************************************/
+
+static void mtd_bench_fill(FAR uint8_t *buffer, uint32_t len,
+                           uint32_t seed)
+{
+  uint32_t x = seed * 2654435761u + 1;
+  uint32_t i;
+
+  for (i = 0; i < len; i++)
+    {
+      x ^= x << 13;
+      x ^= x >> 17;
+      x ^= x << 5;
+      buffer[i] = (uint8_t)x;
+    }
+}
+
+/****************************************************************************
+ * Name: mtd_bench_erase / mtd_bench_write / mtd_bench_read
+ *
+ * Description:
+ *   Device access in erase units and blocks.  Block drivers have no
+ *   erase operation; the FTL below them erases on demand during write.
+ *
+ ****************************************************************************/
+
+static int mtd_bench_erase(FAR struct mtd_bench_s *bench, uint32_t unit)
+{
+  int ret;
+
+  if (!bench->ismtd)
+    {
+      return OK;
+    }
+
+  ret = MTD_ERASE(bench->inode->u.i_mtd,
+                  (off_t)unit * bench->unitsize / bench->erasesize,
+                  bench->unitsize / bench->erasesize);
+  return ret < 0 ? ret : OK;
+}
+
+static int mtd_bench_write(FAR struct mtd_bench_s *bench, off_t block,
+                           uint32_t nblocks, FAR const uint8_t *buffer)
+{
+  ssize_t ret;
+
+  if (bench->ismtd)
+    {
+      ret = MTD_BWRITE(bench->inode->u.i_mtd, block, nblocks, buffer);
+    }
+  else
+    {
+      ret = bench->inode->u.i_bops->write(bench->inode, buffer, block,
+                                          nblocks);
+    }
 
-  ret = open_blockdriver(argv[1], 0, &inode);
   if (ret < 0)
     {
-      fprintf(stderr, "Failed to open %s\n", argv[1]);
       return ret;
     }
 
-  /* Get the low-level format from the device. */
+  return ret == (ssize_t)nblocks ? OK : -EIO;
+}
 
-  ret = inode->u.i_bops->ioctl(inode, BIOC_PARTINFO, (unsigned long) &info);
-  if (ret != OK)
+static int mtd_bench_read(FAR struct mtd_bench_s *bench, off_t block,
+                          uint32_t nblocks, FAR uint8_t *buffer)
+{
+  ssize_t ret;
+
+  if (bench->ismtd)
     {
-      fprintf(stderr, "Device is not a block device\n");
-      goto errout_with_driver;
+      ret = MTD_BREAD(bench->inode->u.i_mtd, block, nblocks, buffer);
+    }
+  else
+    {
+      ret = bench->inode->u.i_bops->read(bench->inode, buffer, block,
+                                         nblocks);
+    }
+
+  if (ret < 0)
+    {
+      return ret;
     }
 
-  /* Get the MTD geometry */
+  return ret == (ssize_t)nblocks ? OK : -EIO;
+}
 
-  ret = inode->u.i_bops->ioctl(inode, MTDIOC_GEOMETRY, (unsigned long) &geo);
-  if (ret != OK)
+/****************************************************************************
+ * Name: mtd_bench_erase_all
+ ****************************************************************************/
+
+static int mtd_bench_erase_all(FAR struct mtd_bench_s *bench)
+{
+  uint64_t start;
+  uint64_t t0;
+  uint32_t unit;
+  int ret;
+
+  if (!bench->ismtd)
     {
-      fprintf(stderr, "Device is not a MTD device");
-      goto errout_with_driver;
+      return OK;
+    }
+
+  start = mtd_bench_now();
+  for (unit = 0; unit < bench->nunits; unit++)
+    {
+      t0 = mtd_bench_now();
+      ret = mtd_bench_erase(bench, bench->firstunit + unit);
+      if (ret < 0)
+        {
+          fprintf(stderr, "Erase of unit %" PRIu32 " failed: %d\n",
+                  bench->firstunit + unit, ret);
+          return ret;
+        }
+
+      mtd_hist_add(&bench->erase, t0);
     }
 
-  /* Report the device structure */
+  mtd_bench_rate("erase", (uint64_t)bench->nunits * bench->unitsize,
+                 start);
+  return OK;
+}
 
-  printf("FLASH device parameters:\n");
-  printf("   Sector size:  %10d\n", info.sectorsize);
-  printf("   Sector count: %10d\n", info.numsectors);
-  printf("   Erase block:  %10" PRIx32 "\n", geo.erasesize);
-  printf("   Total size:   %10d\n", info.sectorsize * info.numsectors);
+/****************************************************************************
+ * Name: mtd_bench_write_all
+ *
+ * Description:
+ *   Write every erase unit under test, either one block (page) per call or
+ *   the whole unit in one call.
+ *
+ ****************************************************************************/
 
-  if (info.sectorsize != geo.erasesize)
+static int mtd_bench_write_all(FAR struct mtd_bench_s *bench,
+                               uint32_t pass, bool bulk)
+{
+  uint64_t start;
+  uint64_t t0;
+  uint32_t unit;
+  uint32_t i;
+  off_t block;
+  int ret;
+
+  start = mtd_bench_now();
+  for (unit = 0; unit < bench->nunits; unit++)
     {
-      fprintf(stderr, "Sector size does not match the erase block size.\n"
-             "Please adjust the sector size to enable erasing and writing "
-             "without using an intermediary read buffer.\n");
-      goto errout_with_driver;
+      block = (off_t)(bench->firstunit + unit) * bench->blkper;
+      mtd_bench_fill(bench->wbuf, bench->unitsize,
+                     pass * bench->nunits + unit);
+
+      if (bulk)
+        {
+          t0 = mtd_bench_now();
+          ret = mtd_bench_write(bench, block, bench->blkper, bench->wbuf);
+          mtd_hist_add(&bench->bwrite, t0);
+        }
+      else
+        {
+          for (i = 0, ret = OK; i < bench->blkper && ret >= 0; i++)
+            {
+              t0 = mtd_bench_now();
+              ret = mtd_bench_write(bench, block + i, 1,
+                                    bench->wbuf + i * bench->blocksize);
+              mtd_hist_add(&bench->program, t0);
+            }
+        }
+
+      if (ret < 0)
+        {
+          fprintf(stderr, "Write of unit %" PRIu32 " failed: %d\n",
+                  bench->firstunit + unit, ret);
+          return ret;
+        }
     }
 
-  /* Allocate buffers to use */
+  mtd_bench_rate(bulk ? "bwrite" : "program",
+                 (uint64_t)bench->nunits * bench->unitsize, start);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: mtd_bench_verify_all
+ *
+ * Description:
+ *   Read every erase unit back in one call and compare it with the
+ *   pattern written in this pass.
+ *
+ ****************************************************************************/
 
-  buffer = (char *)malloc(info.sectorsize);
-  if (buffer == NULL)
+static int mtd_bench_verify_all(FAR struct mtd_bench_s *bench,
+                                uint32_t pass)
+{
+  uint64_t start;
+  uint64_t t0;
+  uint32_t unit;
+  off_t block;
+  int ret;
+
+  start = mtd_bench_now();
+  for (unit = 0; unit < bench->nunits; unit++)
     {
-      fprintf(stderr, "Error allocating buffer\n");
-      goto errout_with_driver;
+      block = (off_t)(bench->firstunit + unit) * bench->blkper;
+
+      t0 = mtd_bench_now();
+      ret = mtd_bench_read(bench, block, bench->blkper, bench->rbuf);
+      mtd_hist_add(&bench->bread, t0);
+      if (ret < 0)
+        {
+          fprintf(stderr, "Read of unit %" PRIu32 " failed: %d\n",
+                  bench->firstunit + unit, ret);
+          return ret;
+        }
+
+      mtd_bench_fill(bench->wbuf, bench->unitsize,
+                     pass * bench->nunits + unit);
+      if (memcmp(bench->wbuf, bench->rbuf, bench->unitsize) != 0)
+        {
+          fprintf(stderr, "Data mismatch in unit %" PRIu32 "\n",
+                  bench->firstunit + unit);
+          bench->nerrors++;
+        }
     }
 
-  /* Fill the buffer with known data and print it in hex format */
+  mtd_bench_rate("read", (uint64_t)bench->nunits * bench->unitsize,
+                 start);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: mtd_bench_random_read
+ ****************************************************************************/
 
-  for (int i = 0; i < info.sectorsize; i++)
+static int mtd_bench_random_read(FAR struct mtd_bench_s *bench)
+{
+  uint32_t nblocks = bench->nunits * bench->blkper;
+  uint64_t start;
+  uint64_t t0;
+  uint32_t i;
+  off_t block;
+  int ret;
+
+  start = mtd_bench_now();
+  for (i = 0; i < bench->nrandom; i++)
     {
-      buffer[i] = (char)(i & 0xff);
+      block = (off_t)bench->firstunit * bench->blkper +
+              (uint32_t)rand() % nblocks;
+
+      t0 = mtd_bench_now();
+      ret = mtd_bench_read(bench, block, 1, bench->rbuf);
+      mtd_hist_add(&bench->rread, t0);
+      if (ret < 0)
+        {
+          fprintf(stderr, "Read of block %jd failed: %d\n",
+                  (intmax_t)block, ret);
+          return ret;
+        }
     }
 
-  /* Now write some data to the sector */
+  mtd_bench_rate("rread", (uint64_t)bench->nrandom * bench->blocksize,
+                 start);
+  return OK;
+}
 
-  printf("\nStarting write operation...\n");
+/****************************************************************************
+ * Name: mtd_bench_geometry
+ ****************************************************************************/
 
-  clock_gettime(CLOCK_MONOTONIC, &start);
-  for (x = 0; x < info.numsectors; x++)
+static int mtd_bench_geometry(FAR struct mtd_bench_s *bench,
+                              FAR uint32_t *nunits)
+{
+  struct partition_info_s info;
+  struct mtd_geometry_s geo;
+  uint32_t nblocks;
+  int ret;
+
+  if (bench->ismtd)
     {
-      inode->u.i_bops->write(inode, (const unsigned char *)buffer, x, 1);
+      ret = MTD_IOCTL(bench->inode->u.i_mtd, MTDIOC_GEOMETRY,
+                      (unsigned long)((uintptr_t)&geo));
+      if (ret < 0)
+        {
+          fprintf(stderr, "Device is not a MTD device\n");
+          return ret;
+        }
 
-      total_bytes_written += info.sectorsize;
+      bench->blocksize = geo.blocksize;
+      nblocks = (uint64_t)geo.neraseblocks * geo.erasesize /
+                geo.blocksize;
     }
+  else
+    {
+      ret = bench->inode->u.i_bops->ioctl(bench->inode, BIOC_PARTINFO,
+                                          (unsigned long)&info);
+      if (ret != OK)
+        {
+          fprintf(stderr, "Device is not a block device\n");
+          return ret;
+        }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+      /* The erase size is only used to size the bulk transfers here, so
+       * a block driver not backed by MTD is measured in single sectors.
+       */
 
-  elapsed_time = (end.tv_sec - start.tv_sec) + \
-                 (end.tv_nsec - start.tv_nsec) / 1e9;
-  transfer_rate = (total_bytes_written / elapsed_time) / 1024;
+      ret = bench->inode->u.i_bops->ioctl(bench->inode, MTDIOC_GEOMETRY,
+                                          (unsigned long)&geo);
+      if (ret != OK)
+        {
+          geo.erasesize = info.sectorsize;
+        }
 
-  printf("\nWrite operation completed in %.2f seconds\n", elapsed_time);
-  printf("Total bytes written: %zu\n", total_bytes_written);
-  printf("Transfer rate [write]: %.2f KiB/s\n", transfer_rate);
+      bench->blocksize = info.sectorsize;
+      nblocks = info.numsectors;
+    }
 
-  /* Now read the data back to validate everything was written and can
-   * be read.
+  /* An erase unit is the larger of the erase block and the read/write
+   * block, so pages smaller than the erase block (NOR, NAND, or an FTL
+   * with small sectors) are programmed blkper at a time.
    */
 
-  printf("\nStarting read operation...\n");
+  bench->erasesize = geo.erasesize;
+  bench->blkper = geo.erasesize > bench->blocksize ?
+                  geo.erasesize / bench->blocksize : 1;
+  bench->unitsize = bench->blkper * bench->blocksize;
+  *nunits = nblocks / bench->blkper;
+
+  if (bench->ismtd && bench->unitsize % bench->erasesize != 0)
+    {
+      fprintf(stderr, "Block size %" PRIu32 " is not a multiple of the "
+              "erase size %" PRIu32 "\n", bench->blocksize,
+              bench->erasesize);
+      return -EINVAL;
+    }
+
+  printf("FLASH device parameters:\n");
+  printf("   Driver:       %10s\n", bench->ismtd ? "MTD" : "block");
+  printf("   Block size:   %10" PRIu32 "\n", bench->blocksize);
+  printf("   Erase size:   %10" PRIu32 "\n", bench->erasesize);
+  printf("   Blocks/unit:  %10" PRIu32 "\n", bench->blkper);
+  printf("   Erase units:  %10" PRIu32 "\n", *nunits);
+  printf("   Total size:   %10" PRIu64 "\n",
+         (uint64_t)*nunits * bench->unitsize);
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  fprintf(stderr, "usage: %s [-p passes] [-s first] [-n count] "
+          "[-r reads] flash_device\n", progname);
+  fprintf(stderr, "  -p  Number of passes, default %d\n",
+          CONFIG_BENCHMARK_MTD_PASSES);
+  fprintf(stderr, "  -s  First erase unit to test, default 0\n");
+  fprintf(stderr, "  -n  Number of erase units to test, default all\n");
+  fprintf(stderr, "  -r  Random single-block reads per pass, default %d\n",
+          CONFIG_BENCHMARK_MTD_RANDREADS);
+  fprintf(stderr, "flash_device is an MTD driver (raw erase/program) "
+          "or a block driver on top of one.\n"
+          "All data in the tested range is destroyed.\n");
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR struct mtd_bench_s *bench;
+  uint32_t nunits;
+  uint32_t count = 0;
+  uint32_t pass;
+  int option;
+  int ret;
+
+  bench = zalloc(sizeof(struct mtd_bench_s));
+  if (bench == NULL)
+    {
+      fprintf(stderr, "Error allocating benchmark state\n");
+      return EXIT_FAILURE;
+    }
+
+  bench->npasses = CONFIG_BENCHMARK_MTD_PASSES;
+  bench->nrandom = CONFIG_BENCHMARK_MTD_RANDREADS;
+  bench->erase.name = "erase";
+  bench->program.name = "program";
+  bench->bwrite.name = "bwrite";
+  bench->bread.name = "read";
+  bench->rread.name = "rread";
+
+  while ((option = getopt(argc, argv, "p:s:n:r:h")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'p':
+            bench->npasses = strtoul(optarg, NULL, 0);
+            break;
+          case 's':
+            bench->firstunit = strtoul(optarg, NULL, 0);
+            break;
+          case 'n':
+            count = strtoul(optarg, NULL, 0);
+            break;
+          case 'r':
+            bench->nrandom = strtoul(optarg, NULL, 0);
+            break;
+          default:
+            show_usage(argv[0]);
+            free(bench);
+            return EXIT_FAILURE;
+        }
+    }
 
-  clock_gettime(CLOCK_MONOTONIC, &start);
+  /* Argument given? */
 
-  for (x = 0; x < info.numsectors; x++)
+  if (optind >= argc)
     {
-      inode->u.i_bops->read(inode, (unsigned char *)buffer, x, 1);
+      show_usage(argv[0]);
+      free(bench);
+      return EXIT_FAILURE;
+    }
 
-      total_bytes_read += info.sectorsize;
+  /* Prefer the raw MTD driver, fall back to a block driver (FTL) */
+
+  ret = find_mtddriver(argv[optind], &bench->inode);
+  if (ret >= 0)
+    {
+      bench->ismtd = true;
+    }
+  else
+    {
+      ret = open_blockdriver(argv[optind], 0, &bench->inode);
+      if (ret < 0)
+        {
+          fprintf(stderr, "Failed to open %s\n", argv[optind]);
+          free(bench);
+          return EXIT_FAILURE;
+        }
     }
 
-  clock_gettime(CLOCK_MONOTONIC, &end);
+  ret = mtd_bench_geometry(bench, &nunits);
+  if (ret < 0)
+    {
+      goto errout_with_driver;
+    }
 
-  elapsed_time = (end.tv_sec - start.tv_sec) + \
-                 (end.tv_nsec - start.tv_nsec) / 1e9;
-  transfer_rate = (total_bytes_written / elapsed_time) / 1024;
+  if (bench->firstunit >= nunits)
+    {
+      fprintf(stderr, "First unit %" PRIu32 " out of range\n",
+              bench->firstunit);
+      ret = -EINVAL;
+      goto errout_with_driver;
+    }
 
-  printf("\nRead operation completed in %.2f seconds\n", elapsed_time);
-  printf("Total bytes read: %zu\n", total_bytes_read);
-  printf("Transfer rate [read]: %.2f KiB/s\n", transfer_rate);
+  bench->nunits = nunits - bench->firstunit;
+  if (count > 0 && count < bench->nunits)
+    {
+      bench->nunits = count;
+    }
 
-  /* Compare the read data with the written data */
+  /* Allocate buffers to use */
 
-  for (int i = 0; i < info.sectorsize; i++)
+  bench->wbuf = malloc(bench->unitsize);
+  bench->rbuf = malloc(bench->unitsize);
+  if (bench->wbuf == NULL || bench->rbuf == NULL)
     {
-      if (buffer[i] != (char)(i & 0xff))
+      fprintf(stderr, "Error allocating buffers\n");
+      ret = -ENOMEM;
+      goto errout_with_buffers;
+    }
+
+  printf("Testing erase units %" PRIu32 "-%" PRIu32 ", %" PRIu32
+         " pass(es)\n", bench->firstunit,
+         bench->firstunit + bench->nunits - 1, bench->npasses);
+
+  for (pass = 0; pass < bench->npasses; pass++)
+    {
+      printf("\nPass %" PRIu32 ":\n", pass + 1);
+
+      /* Page-by-page program of freshly erased units */
+
+      ret = mtd_bench_erase_all(bench);
+      if (ret >= 0)
+        {
+          ret = mtd_bench_write_all(bench, 2 * pass, false);
+        }
+
+      if (ret >= 0)
+        {
+          ret = mtd_bench_verify_all(bench, 2 * pass);
+        }
+
+      /* Whole-unit writes with a new pattern */
+
+      if (ret >= 0)
+        {
+          ret = mtd_bench_erase_all(bench);
+        }
+
+      if (ret >= 0)
+        {
+          ret = mtd_bench_write_all(bench, 2 * pass + 1, true);
+        }
+
+      if (ret >= 0)
+        {
+          ret = mtd_bench_verify_all(bench, 2 * pass + 1);
+        }
+
+      if (ret >= 0 && bench->nrandom > 0)
+        {
+          ret = mtd_bench_random_read(bench);
+        }
+
+      if (ret < 0)
         {
-          printf("\nData mismatch at byte %d: expected %02X, got %02X\n",
-                 i, (unsigned char)(i & 0xff), (unsigned char)buffer[i]);
           goto errout_with_buffers;
         }
     }
 
-  printf("\nData verification successful: read data matches written data\n");
+  mtd_hist_show(&bench->erase);
+  mtd_hist_show(&bench->program);
+  mtd_hist_show(&bench->bwrite);
+  mtd_hist_show(&bench->bread);
+  mtd_hist_show(&bench->rread);
+
+  if (bench->nerrors > 0)
+    {
+      printf("\nData verification FAILED: %" PRIu32 " unit(s) differ\n",
+             bench->nerrors);
+      ret = -EIO;
+    }
+  else
+    {
+      printf("\nData verification successful: read data matches "
+             "written data\n");
+    }
 
 errout_with_buffers:
 
   /* Free the allocated buffers */
 
-  free(buffer);
+  free(bench->wbuf);
+  free(bench->rbuf);
 
 errout_with_driver:
 
-  /* Now close the block device and exit */
+  /* Now close the device and exit */
+
+  if (bench->ismtd)
+    {
+      inode_release(bench->inode);
+    }
+  else
+    {
+      close_blockdriver(bench->inode);
+    }
 
-  close_blockdriver(inode);
-  return 0;
+  free(bench);
+  return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
 }
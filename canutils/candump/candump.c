@@ -94,6 +94,23 @@
 #define SILENT_ANI 1  /* silent mode with animation */
 #define SILENT_ON  2  /* silent mode (completely silent) */
 
+/* frames drained from one socket per select() wakeup */
+#ifdef CONFIG_CANUTILS_CANDUMP_BATCH
+#define RXBATCH CONFIG_CANUTILS_CANDUMP_BATCH
+#else
+#define RXBATCH 32
+#endif
+
+/* binary log records buffered before they are written to the log file */
+#ifdef CONFIG_CANUTILS_CANDUMP_BINLOG_RECORDS
+#define BINRECS CONFIG_CANUTILS_CANDUMP_BINLOG_RECORDS
+#else
+#define BINRECS 128
+#endif
+
+#define BINMAGIC "CANDUMP"
+#define BINVERSION 1
+
 #define BOLD    ATTBOLD
 #define RED     ATTBOLD FGRED
 #define GREEN   ATTBOLD FGGREEN
@@ -109,8 +126,37 @@ const char col_off [] = ATTRESET;
  * Public Functions
  ****************************************************************************/
 
+/*
+ * Binary log file format (-B): a struct binhdr followed by struct binrec
+ * records, all fields in host byte order. Records have a fixed size so the
+ * log can be written in large chunks and indexed without parsing.
+ */
+struct binhdr {
+	char magic[8];        /* BINMAGIC */
+	uint16_t version;     /* BINVERSION */
+	uint16_t recsize;     /* sizeof(struct binrec) */
+	uint32_t reserved;
+};
+
+struct binrec {
+	uint32_t tv_sec;      /* reception timestamp */
+	uint32_t tv_usec;
+	uint32_t can_id;      /* CAN ID with EFF/RTR/ERR flags */
+	uint8_t len;          /* payload length */
+	uint8_t flags;        /* CAN FD flags (BRS/ESI) */
+	uint8_t fd;           /* 1 for a CAN FD frame, 0 for classic CAN */
+	uint8_t reserved;
+	char ifname[IFNAMSIZ];
+	uint8_t data[CANFD_MAX_DLEN];
+};
+
 static __u32 dropcnt[MAXSOCK];
 static __u32 last_dropcnt[MAXSOCK];
+static unsigned char dropmon[MAXSOCK];
+static unsigned long rxcnt[MAXSOCK];
+static char sockname[MAXSOCK][IFNAMSIZ];
+static struct binrec binbuf[BINRECS];
+static int binlen;
 static char devname[MAXIFNAMES][IFNAMSIZ+1];
 static int  dindex[MAXIFNAMES];
 static int  max_devname_len; /* to prevent frazzled device name output */
@@ -136,6 +182,7 @@ static void print_usage(char *prg)
 	fprintf(stderr, "         -S          (swap byte order in printed CAN data[] - marked with '%c' )\n", SWAP_DELIMITER);
 	fprintf(stderr, "         -s <level>  (silent mode - %d: off (default) %d: animation %d: silent)\n", SILENT_OFF, SILENT_ANI, SILENT_ON);
 	fprintf(stderr, "         -l          (log CAN-frames into file. Sets '-s %d' by default)\n", SILENT_ON);
+	fprintf(stderr, "         -B          (log CAN-frames into binary file. Implies '-l')\n");
 	fprintf(stderr, "         -L          (use log file format on stdout)\n");
 	fprintf(stderr, "         -n <count>  (terminate after reception of <count> CAN frames)\n");
 	fprintf(stderr, "         -r <size>   (set socket receive buffer to <size>)\n");
@@ -167,6 +214,58 @@ static void print_usage(char *prg)
 	fprintf(stderr, "\n");
 }
 
+static int binlog_flush(FILE *logfile)
+{
+	if (binlen && fwrite(binbuf, sizeof(binbuf[0]), binlen, logfile) !=
+	    (size_t)binlen) {
+		perror("binlog");
+		return -1;
+	}
+
+	binlen = 0;
+	return 0;
+}
+
+static int binlog_frame(FILE *logfile, struct canfd_frame *frame,
+			struct timeval *tv, char *ifname, int maxdlen)
+{
+	struct binrec *rec = &binbuf[binlen];
+
+	rec->tv_sec = (uint32_t)tv->tv_sec;
+	rec->tv_usec = (uint32_t)tv->tv_usec;
+	rec->can_id = frame->can_id;
+	rec->len = frame->len;
+	rec->flags = frame->flags;
+	rec->fd = (maxdlen == CANFD_MAX_DLEN);
+	rec->reserved = 0;
+	strncpy(rec->ifname, ifname, sizeof(rec->ifname) - 1);
+	rec->ifname[sizeof(rec->ifname) - 1] = '\0';
+	memcpy(rec->data, frame->data, frame->len);
+	memset(rec->data + frame->len, 0, sizeof(rec->data) - frame->len);
+
+	if (++binlen == BINRECS)
+		return binlog_flush(logfile);
+
+	return 0;
+}
+
+static void print_summary(int currmax)
+{
+	int i;
+
+	for (i = 0; i < currmax; i++) {
+		fprintf(stderr, "%s: %lu CAN frame%s received", sockname[i],
+			rxcnt[i], (rxcnt[i] == 1) ? "" : "s");
+
+		/* the socket drop counter needs SO_RXQ_OVFL */
+		if (dropmon[i])
+			fprintf(stderr, ", %" PRIu32 " dropped\n",
+				(uint32_t)dropcnt[i]);
+		else
+			fprintf(stderr, ", drops unknown\n");
+	}
+}
+
 void sigterm(int signo)
 {
 	running = 0;
@@ -235,9 +334,11 @@ int main(int argc, char **argv)
 	unsigned char color = 0;
 	unsigned char view = 0;
 	unsigned char log = 0;
+	unsigned char binlog = 0;
 	unsigned char logfrmt = 0;
 	int count = 0;
 	int rcvbuf_size = 0;
+	int ret = 0;
 	int opt;
 	int currmax, numfilter;
 	int join_filter;
@@ -250,7 +351,7 @@ int main(int argc, char **argv)
 	struct can_filter *rfilter;
 	can_err_mask_t err_mask;
 	struct canfd_frame frame;
-	int nbytes, i, maxdlen;
+	int nbytes, i, n, maxdlen;
 	struct ifreq ifr;
 	struct timeval tv, last_tv;
 	struct timeval timeout, timeout_config = { 0, 0 }, *timeout_current = NULL;
@@ -265,7 +366,7 @@ int main(int argc, char **argv)
 	last_tv.tv_sec  = 0;
 	last_tv.tv_usec = 0;
 
-	while ((opt = getopt(argc, argv, "t:HciaSs:lDdxLn:r:heT:?")) != -1) {
+	while ((opt = getopt(argc, argv, "t:HciaSs:lBDdxLn:r:heT:?")) != -1) {
 		switch (opt) {
 		case 't':
 			timestamp = optarg[0];
@@ -313,6 +414,11 @@ int main(int argc, char **argv)
 			log = 1;
 			break;
 
+		case 'B':
+			log = 1;
+			binlog = 1;
+			break;
+
 		case 'D':
 			down_causes_exit = 0;
 			break;
@@ -420,6 +526,7 @@ int main(int argc, char **argv)
 
 		memset(&ifr.ifr_name, 0, sizeof(ifr.ifr_name));
 		strncpy(ifr.ifr_name, ptr, nbytes);
+		strlcpy(sockname[i], ifr.ifr_name, sizeof(sockname[i]));
 
 #ifdef DEBUG
 		printf("using interface name '%s'.\n", ifr.ifr_name);
@@ -560,12 +667,14 @@ int main(int argc, char **argv)
 			}
 		}
 
-		if (dropmonitor) {
-
+		{
 			const int dropmonitor_on = 1;
 
+			/* always try to count drops for the summary on exit */
 			if (setsockopt(s[i], SOL_SOCKET, SO_RXQ_OVFL,
-				       &dropmonitor_on, sizeof(dropmonitor_on)) < 0) {
+				       &dropmonitor_on, sizeof(dropmonitor_on)) == 0) {
+				dropmon[i] = 1;
+			} else if (dropmonitor) {
 				perror("setsockopt SO_RXQ_OVFL not supported by your Linux Kernel");
 				return 1;
 			}
@@ -589,24 +698,39 @@ int main(int argc, char **argv)
 
 		localtime_r(&currtime, &now);
 
-		sprintf(fname, "candump-%04d-%02d-%02d_%02d%02d%02d.log",
+		sprintf(fname, "candump-%04d-%02d-%02d_%02d%02d%02d.%s",
 			now.tm_year + 1900,
 			now.tm_mon + 1,
 			now.tm_mday,
 			now.tm_hour,
 			now.tm_min,
-			now.tm_sec);
+			now.tm_sec,
+			binlog ? "bin" : "log");
 
 		if (silent != SILENT_ON)
 			fprintf(stderr, "Warning: Console output active while logging!\n");
 
 		fprintf(stderr, "Enabling Logfile '%s'\n", fname);
 
-		logfile = fopen(fname, "w");
+		logfile = fopen(fname, binlog ? "wb" : "w");
 		if (!logfile) {
 			perror("logfile");
 			return 1;
 		}
+
+		if (binlog) {
+			struct binhdr hdr;
+
+			memset(&hdr, 0, sizeof(hdr));
+			memcpy(hdr.magic, BINMAGIC, sizeof(BINMAGIC));
+			hdr.version = BINVERSION;
+			hdr.recsize = sizeof(struct binrec);
+
+			if (fwrite(&hdr, sizeof(hdr), 1, logfile) != 1) {
+				perror("logfile");
+				return 1;
+			}
+		}
 	}
 
 	/* these settings are static and can be held out of the hot path */
@@ -633,7 +757,11 @@ int main(int argc, char **argv)
 
 		for (i=0; i<currmax; i++) {  /* check all CAN RAW sockets */
 
-			if (FD_ISSET(s[i], &rdfs)) {
+			if (!FD_ISSET(s[i], &rdfs))
+				continue;
+
+			/* drain all pending frames, up to RXBATCH per wakeup */
+			for (n = 0; n < RXBATCH && running; n++) {
 
 				int idx;
 
@@ -643,16 +771,21 @@ int main(int argc, char **argv)
 				msg.msg_controllen = sizeof(ctrlmsg);
 				msg.msg_flags = 0;
 
-				nbytes = recvmsg(s[i], &msg, 0);
+				nbytes = recvmsg(s[i], &msg, n ? MSG_DONTWAIT : 0);
+				if (nbytes < 0 && n &&
+				    (errno == EAGAIN || errno == EWOULDBLOCK))
+					break; /* socket queue drained */
+
 				idx = idx2dindex(addr.can_ifindex, s[i]);
 
 				if (nbytes < 0) {
 					if ((errno == ENETDOWN) && !down_causes_exit) {
 						fprintf(stderr, "%s: interface down\n", devname[idx]);
-						continue;
+						break;
 					}
 					perror("read");
-					return 1;
+					ret = 1;
+					goto out;
 				}
 
 				if ((size_t)nbytes == CAN_MTU)
@@ -661,9 +794,12 @@ int main(int argc, char **argv)
 					maxdlen = CANFD_MAX_DLEN;
 				else {
 					fprintf(stderr, "read: incomplete CAN frame\n");
-					return 1;
+					ret = 1;
+					goto out;
 				}
 
+				rxcnt[i]++;
+
 				if (count && (--count == 0))
 					running = 0;
 
@@ -690,7 +826,7 @@ int main(int argc, char **argv)
 				}
 
 				/* check for (unlikely) dropped frames on this specific socket */
-				if (dropcnt[i] != last_dropcnt[i]) {
+				if (dropmonitor && dropcnt[i] != last_dropcnt[i]) {
 
 					__u32 frames = dropcnt[i] - last_dropcnt[i];
 
@@ -698,7 +834,7 @@ int main(int argc, char **argv)
 						printf("DROPCOUNT: dropped %" PRId32 " CAN frame%s on '%s' socket (total drops %" PRId32 ")\n",
 						       (uint32_t)frames, (frames > 1)?"s":"", devname[idx], (uint32_t)dropcnt[i]);
 
-					if (log)
+					if (log && !binlog)
 						fprintf(logfile, "DROPCOUNT: dropped %" PRId32 " CAN frame%s on '%s' socket (total drops %" PRId32 ")\n",
 							(uint32_t)frames, (frames > 1)?"s":"", devname[idx], (uint32_t)dropcnt[i]);
 
@@ -709,7 +845,13 @@ int main(int argc, char **argv)
 				if (frame.can_id & CAN_EFF_FLAG)
 					view |= CANLIB_VIEW_INDENT_SFF;
 
-				if (log) {
+				if (binlog) {
+					if (binlog_frame(logfile, &frame, &tv,
+							 devname[idx], maxdlen) < 0) {
+						ret = 1;
+						goto out;
+					}
+				} else if (log) {
 					char buf[CL_CFSZ]; /* max length */
 
 					/* log CAN frame with absolute timestamp & device */
@@ -727,7 +869,7 @@ int main(int argc, char **argv)
 					printf("(%010ju.%06ld) %*s %s\n",
 					       (uintmax_t)tv.tv_sec, tv.tv_usec,
 					       max_devname_len, devname[idx], buf);
-					goto out_fflush; /* no other output to stdout */
+					continue; /* no other output to stdout */
 				}
 
 				if (silent != SILENT_OFF){
@@ -735,7 +877,7 @@ int main(int argc, char **argv)
 						printf("%c\b", anichar[silentani%=MAXANI]);
 						silentani++;
 					}
-					goto out_fflush; /* no other output to stdout */
+					continue; /* no other output to stdout */
 				}
 
 				printf(" %s", (color>2)?col_on[idx%MAXCOL]:"");
@@ -801,17 +943,25 @@ int main(int argc, char **argv)
 				printf("%s", (color>1)?col_off:"");
 				printf("\n");
 			}
-
-		out_fflush:
-			fflush(stdout);
 		}
+
+		/* one flush per wakeup instead of one per frame */
+		fflush(stdout);
 	}
 
+out:
+	/* also reached on a receive or log error, so nothing is lost */
+	fflush(stdout);
+	print_summary(currmax);
+
 	for (i=0; i<currmax; i++)
 		close(s[i]);
 
-	if (log)
+	if (log) {
+		if (binlog)
+			binlog_flush(logfile);
 		fclose(logfile);
+	}
 
-	return 0;
+	return ret;
 }
@@ -359,6 +359,30 @@ int mkfatfs(FAR const char *pathname, FAR struct fat_format_s *fmt)
   if (!var.fv_sect)
     {
       ferr("ERROR: Failed to allocate working buffers\n");
+      ret = -ENOMEM;
+      goto errout_with_driver;
+    }
+
+  /* Allocate the zero buffer used for the batched writes, settling for
+   * fewer sectors if memory is short.
+   */
+
+  for (var.fv_nzerosects = CONFIG_MKFATFS_BATCH_SECTORS;
+       var.fv_nzerosects > 0; var.fv_nzerosects >>= 1)
+    {
+      var.fv_zero = (FAR uint8_t *)
+        fat_buffer_alloc(var.fv_nzerosects * var.fv_sectorsize);
+      if (var.fv_zero)
+        {
+          memset(var.fv_zero, 0, var.fv_nzerosects * var.fv_sectorsize);
+          break;
+        }
+    }
+
+  if (!var.fv_zero)
+    {
+      ferr("ERROR: Failed to allocate working buffers\n");
+      ret = -ENOMEM;
       goto errout_with_driver;
     }
 
@@ -381,6 +405,11 @@ errout:
       free(var.fv_sect);
     }
 
+  if (var.fv_zero)
+    {
+      free(var.fv_zero);
+    }
+
   /* Return any reported errors */
 
   if (ret < 0)
@@ -51,6 +51,12 @@
 
 #define FAT32_DEFAULT_ROOT_CLUSTER     2
 
+/* Sectors written by one write() when zeroing the FAT and directory areas */
+
+#ifndef CONFIG_MKFATFS_BATCH_SECTORS
+#  define CONFIG_MKFATFS_BATCH_SECTORS 64
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -74,6 +80,11 @@ struct fat_var_s
   uint32_t       fv_nfatsects;      /* Number of sectors in each FAT */
   uint32_t       fv_nclusters;      /* Number of clusters */
   uint8_t       *fv_sect;           /* Allocated working sector buffer */
+  uint8_t       *fv_zero;           /* Zeroed buffer of fv_nzerosects sectors */
+  uint32_t       fv_nzerosects;     /* Sectors per batched zero write */
+  uint32_t       fv_nwrites;        /* Number of write() calls issued */
+  uint32_t       fv_nwritten;       /* Number of sectors written */
+  uint32_t       fv_ntotal;         /* Number of sectors to be written */
   uint8_t        fv_bootcodepatch;  /* FAT16/FAT32 Bootcode offset patch */
   const uint8_t *fv_bootcodeblob;   /* Points to boot code to put into MBR */
 };
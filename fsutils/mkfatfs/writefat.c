@@ -32,6 +32,8 @@
 #include <string.h>
 #include <errno.h>
 #include <debug.h>
+#include <stdio.h>
+#include <time.h>
 #include <unistd.h>
 
 #include <nuttx/fs/fat.h>
@@ -45,38 +47,79 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: mkfatfs_devwrite
+ * Name: mkfatfs_progress
  *
  * Description:
- *   Write the content of the dedicate sector buffer beginning to the
- *   specified sector
+ *   Account for nsectors more sectors written and, if enabled, update the
+ *   progress indicator whenever the percentage changes.
+ *
+ ****************************************************************************/
+
+static void mkfatfs_progress(FAR struct fat_var_s *var, uint32_t nsectors)
+{
+#ifdef CONFIG_MKFATFS_PROGRESS
+  uint32_t before = var->fv_ntotal ?
+    (uint64_t)var->fv_nwritten * 100 / var->fv_ntotal : 0;
+#endif
+
+  var->fv_nwrites++;
+  var->fv_nwritten += nsectors;
+
+#ifdef CONFIG_MKFATFS_PROGRESS
+  if (var->fv_ntotal > 0)
+    {
+      uint32_t after = (uint64_t)var->fv_nwritten * 100 / var->fv_ntotal;
+
+      if (after != before)
+        {
+          printf("\rmkfatfs: %3" PRIu32 "%%", after > 100 ? 100 : after);
+          fflush(stdout);
+        }
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: mkfatfs_devwritev
+ *
+ * Description:
+ *   Write nsectors sectors from buffer beginning at the specified sector
+ *   with a single write().
  *
  * Input:
  *    fmt  - User specified format parameters
  *    var  - Other format parameters that are not user specifiable
+ *    sector   - First sector to write
+ *    buffer   - Data for nsectors sectors
+ *    nsectors - Number of sectors to write
  *
  * Return:
- *    None; caller is responsible for providing valid parameters.
+ *    Zero on success; negated errno on failure
  *
  ****************************************************************************/
 
-static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
-                            FAR const struct fat_var_s *var, off_t sector)
+static int mkfatfs_devwritev(FAR const struct fat_format_s *fmt,
+                             FAR struct fat_var_s *var, off_t sector,
+                             FAR const uint8_t *buffer, uint32_t nsectors)
 {
   ssize_t nwritten;
+  size_t nbytes;
   off_t seekpos;
   off_t fpos;
   int ret;
 
   /* Convert the sector number to a byte offset */
 
-  if (sector < 0 || sector >= (off_t)fmt->ff_nsectors)
+  if (sector < 0 || nsectors == 0 ||
+      sector + nsectors > (off_t)fmt->ff_nsectors)
     {
-      ferr("sector out of range: %ju\n", (intmax_t)sector);
+      ferr("sector out of range: %ju+%" PRIu32 "\n",
+           (intmax_t)sector, nsectors);
       return -ESPIPE;
     }
 
   fpos = sector << var->fv_sectshift;
+  nbytes = (size_t)nsectors << var->fv_sectshift;
 
   /* Seek to that offset */
 
@@ -94,23 +137,89 @@ static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
       return -EINVAL;
     }
 
-  /* Write the sector to that offset.  Partial writes are not expected. */
+  /* Write the sectors to that offset.  Partial writes are not expected. */
 
-  nwritten = write(var->fv_fd, var->fv_sect, var->fv_sectorsize);
+  nwritten = write(var->fv_fd, buffer, nbytes);
   if (nwritten < 0)
     {
       ret = -errno;
-      ferr("ERROR:  write failed: size=%" PRIu32 " pos=%jd error=%d\n",
-           var->fv_sectorsize, (intmax_t)fpos, ret);
+      ferr("ERROR:  write failed: size=%zu pos=%jd error=%d\n",
+           nbytes, (intmax_t)fpos, ret);
       return ret;
     }
-  else if (nwritten != (ssize_t)var->fv_sectorsize)
+  else if (nwritten != (ssize_t)nbytes)
     {
-      ferr("ERROR:  Partial write: size=%" PRIu32 " written=%zd\n",
-           var->fv_sectorsize, nwritten);
+      ferr("ERROR:  Partial write: size=%zu written=%zd\n",
+           nbytes, nwritten);
       return -ENODATA;
     }
 
+  mkfatfs_progress(var, nsectors);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: mkfatfs_devwrite
+ *
+ * Description:
+ *   Write the content of the dedicate sector buffer beginning to the
+ *   specified sector
+ *
+ * Input:
+ *    fmt  - User specified format parameters
+ *    var  - Other format parameters that are not user specifiable
+ *
+ * Return:
+ *    Zero on success; negated errno on failure
+ *
+ ****************************************************************************/
+
+static int mkfatfs_devwrite(FAR const struct fat_format_s *fmt,
+                            FAR struct fat_var_s *var, off_t sector)
+{
+  return mkfatfs_devwritev(fmt, var, sector, var->fv_sect, 1);
+}
+
+/****************************************************************************
+ * Name: mkfatfs_devzero
+ *
+ * Description:
+ *   Zero nsectors sectors beginning at the specified sector, using writes
+ *   of up to fv_nzerosects sectors each.
+ *
+ * Input:
+ *    fmt  - User specified format parameters
+ *    var  - Other format parameters that are not user specifiable
+ *    sector   - First sector to zero
+ *    nsectors - Number of sectors to zero (may be zero)
+ *
+ * Return:
+ *    Zero on success; negated errno on failure
+ *
+ ****************************************************************************/
+
+static int mkfatfs_devzero(FAR const struct fat_format_s *fmt,
+                           FAR struct fat_var_s *var, off_t sector,
+                           uint32_t nsectors)
+{
+  uint32_t nbatch;
+  int ret;
+
+  while (nsectors > 0)
+    {
+      nbatch = nsectors < var->fv_nzerosects ?
+               nsectors : var->fv_nzerosects;
+
+      ret = mkfatfs_devwritev(fmt, var, sector, var->fv_zero, nbatch);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      sector   += nbatch;
+      nsectors -= nbatch;
+    }
+
   return OK;
 }
 
@@ -412,7 +521,6 @@ static inline void mkfatfs_initrootdir(FAR struct fat_format_s *fmt,
 static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
                                    FAR struct fat_var_s *var)
 {
-  int sectno;
   int ret;
 
   /* Create an image of the configured master boot record */
@@ -425,10 +533,9 @@ static inline int mkfatfs_writembr(FAR struct fat_format_s *fmt,
 
   /* Write all of the reserved sectors */
 
-  memset(var->fv_sect, 0, var->fv_sectorsize);
-  for (sectno = 1; sectno < fmt->ff_rsvdseccount && ret >= 0; sectno++)
+  if (ret >= 0 && fmt->ff_rsvdseccount > 1)
     {
-      ret = mkfatfs_devwrite(fmt, var, sectno);
+      ret = mkfatfs_devzero(fmt, var, 1, fmt->ff_rsvdseccount - 1);
     }
 
   /* Write FAT32-specific sectors */
@@ -487,75 +594,72 @@ static inline int mkfatfs_writefat(FAR struct fat_format_s *fmt,
 {
   off_t offset = fmt->ff_rsvdseccount;
   uint8_t fatno;
-  uint32_t sectno;
   int ret;
 
   /* Loop for each FAT copy */
 
   for (fatno = 0; fatno < fmt->ff_nfats; fatno++)
     {
-      /* Loop for each sector in the FAT */
+      /* Mark cluster allocations in sector one of each FAT */
 
-      for (sectno = 0; sectno < var->fv_nfatsects; sectno++)
+      memset(var->fv_sect, 0, var->fv_sectorsize);
+      switch (fmt->ff_fattype)
         {
-          memset(var->fv_sect, 0, var->fv_sectorsize);
-
-          /* Mark cluster allocations in sector one of each FAT */
+          case 12:
+            /* Mark the first two full FAT entries -- 24 bits,
+             * 3 bytes total
+             */
 
-          if (sectno == 0)
-            {
-              memset(var->fv_sect, 0, var->fv_sectorsize);
-              switch (fmt->ff_fattype)
-                {
-                  case 12:
-                    /* Mark the first two full FAT entries -- 24 bits,
-                     * 3 bytes total
-                     */
+            memset(var->fv_sect, 0xff, 3);
+            break;
 
-                    memset(var->fv_sect, 0xff, 3);
-                    break;
+          case 16:
+            /* Mark the first two full FAT entries -- 32 bits,
+             * 4 bytes total
+             */
 
-                  case 16:
-                    /* Mark the first two full FAT entries -- 32 bits,
-                     * 4 bytes total
-                     */
+            memset(var->fv_sect, 0xff, 4);
+            break;
 
-                    memset(var->fv_sect, 0xff, 4);
-                    break;
+          case 32:
+          default: /* Shouldn't happen */
 
-                  case 32:
-                  default: /* Shouldn't happen */
+            /* Mark the first two full FAT entries -- 64 bits,
+             * 8 bytes total
+             */
 
-                    /* Mark the first two full FAT entries -- 64 bits,
-                     * 8 bytes total
-                     */
+            memset(var->fv_sect, 0xff, 8);
 
-                    memset(var->fv_sect, 0xff, 8);
+            /* Cluster 2 is used as the root directory.
+             * Mark as EOF
+             */
 
-                    /* Cluster 2 is used as the root directory.
-                     * Mark as EOF
-                     */
+            var->fv_sect[8] =  0xf8;
+            memset(&var->fv_sect[9], 0xff, 3);
+            break;
+        }
 
-                    var->fv_sect[8] =  0xf8;
-                    memset(&var->fv_sect[9], 0xff, 3);
-                    break;
-                }
+      /* Save the media type in the first byte of the FAT */
 
-              /* Save the media type in the first byte of the FAT */
+      var->fv_sect[0] = FAT_DEFAULT_MEDIA_TYPE;
 
-              var->fv_sect[0] = FAT_DEFAULT_MEDIA_TYPE;
-            }
+      /* Write the first FAT sector */
 
-          /* Write the FAT sector */
+      ret = mkfatfs_devwrite(fmt, var, offset);
+      if (ret < 0)
+        {
+          return ret;
+        }
 
-          ret = mkfatfs_devwrite(fmt, var, offset);
-          if (ret < 0)
-            {
-              return ret;
-            }
+      /* The rest of the FAT is free clusters, i.e. zero */
 
-          offset++;
+      ret = mkfatfs_devzero(fmt, var, offset + 1, var->fv_nfatsects - 1);
+      if (ret < 0)
+        {
+          return ret;
         }
+
+      offset += var->fv_nfatsects;
     }
 
   return OK;
@@ -581,30 +685,25 @@ static inline int mkfatfs_writerootdir(FAR struct fat_format_s *fmt,
 {
   off_t offset = fmt->ff_rsvdseccount + fmt->ff_nfats * var->fv_nfatsects;
   int ret;
-  int i;
 
   /* Write the root directory after the last FAT. This is the root directory
-   * area for FAT12/16, and the first cluster on FAT32.
+   * area for FAT12/16, and the first cluster on FAT32.  Only the first
+   * sector holds data (the volume label), the rest is zeroed.
    */
 
-  for (i = 0; i < var->fv_nrootdirsects; i++)
+  if (var->fv_nrootdirsects == 0)
     {
-      /* Format the next sector of the root directory */
-
-      mkfatfs_initrootdir(fmt, var, i);
-
-      /* Write the next sector of the root directory */
-
-      ret = mkfatfs_devwrite(fmt, var, offset);
-      if (ret < 0)
-        {
-          return ret;
-        }
+      return OK;
+    }
 
-      offset++;
+  mkfatfs_initrootdir(fmt, var, 0);
+  ret = mkfatfs_devwrite(fmt, var, offset);
+  if (ret < 0)
+    {
+      return ret;
     }
 
-  return 0;
+  return mkfatfs_devzero(fmt, var, offset + 1, var->fv_nrootdirsects - 1);
 }
 
 /****************************************************************************
@@ -630,8 +729,23 @@ static inline int mkfatfs_writerootdir(FAR struct fat_format_s *fmt,
 int mkfatfs_writefatfs(FAR struct fat_format_s *fmt,
                        FAR struct fat_var_s *var)
 {
+#ifdef CONFIG_MKFATFS_PROGRESS
+  struct timespec start;
+  struct timespec end;
+  uint32_t elapsed;
+#endif
   int ret;
 
+  var->fv_nwrites  = 0;
+  var->fv_nwritten = 0;
+  var->fv_ntotal   = fmt->ff_rsvdseccount +
+                     fmt->ff_nfats * var->fv_nfatsects +
+                     var->fv_nrootdirsects;
+
+#ifdef CONFIG_MKFATFS_PROGRESS
+  clock_gettime(CLOCK_MONOTONIC, &start);
+#endif
+
   /* Write the master boot record (also the backup and fsinfo sectors) */
 
   ret = mkfatfs_writembr(fmt, var);
@@ -650,5 +764,14 @@ int mkfatfs_writefatfs(FAR struct fat_format_s *fmt,
       ret = mkfatfs_writerootdir(fmt, var);
     }
 
+#ifdef CONFIG_MKFATFS_PROGRESS
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  elapsed = (end.tv_sec - start.tv_sec) * 1000 +
+            (end.tv_nsec - start.tv_nsec) / 1000000;
+
+  printf("\nmkfatfs: %" PRIu32 " sectors in %" PRIu32 " writes, "
+         "%" PRIu32 " ms\n", var->fv_nwritten, var->fv_nwrites, elapsed);
+#endif
+
   return ret;
 }
@@ -0,0 +1,287 @@
+/////////////////////////////////////////////////////////////////////////////
+// apps/graphics/nxwidgets/UnitTests/TNxArray/tnxarray_main.cxx
+//
+// SPDX-License-Identifier: Apache-2.0
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Included Files
+/////////////////////////////////////////////////////////////////////////////
+
+#include <nuttx/config.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include "graphics/nxwidgets/tnxarray.hxx"
+#include "graphics/nxwidgets/cnxstring.hxx"
+#include "graphics/nxwidgets/clistdata.hxx"
+#include "graphics/nxwidgets/clistdataitem.hxx"
+
+/////////////////////////////////////////////////////////////////////////////
+// Definitions
+/////////////////////////////////////////////////////////////////////////////
+
+#define MIN_ITEMS     1000
+#define DEFAULT_ITEMS 8000
+#define NSIZES        4
+
+/////////////////////////////////////////////////////////////////////////////
+// Private Data
+/////////////////////////////////////////////////////////////////////////////
+
+static bool g_failed;
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Function Prototypes
+/////////////////////////////////////////////////////////////////////////////
+
+// Suppress name-mangling
+
+extern "C" int main(int argc, char *argv[]);
+
+/////////////////////////////////////////////////////////////////////////////
+// Private Functions
+/////////////////////////////////////////////////////////////////////////////
+
+using namespace NXWidgets;
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: now
+/////////////////////////////////////////////////////////////////////////////
+
+static unsigned long now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: check
+/////////////////////////////////////////////////////////////////////////////
+
+static void check(bool ok, FAR const char *what, int nitems)
+{
+  if (!ok)
+    {
+      printf("tnxarray_main: FAILED: %s with %d items\n", what, nitems);
+      g_failed = true;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: report
+/////////////////////////////////////////////////////////////////////////////
+
+static void report(FAR const char *what, int nitems, unsigned long usec)
+{
+  printf("%-24s %7d %10lu %8lu\n", what, nitems, usec,
+         usec * 1000 / nitems);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: benchPushBack
+//
+// Appending one item at a time must take constant amortized time.
+/////////////////////////////////////////////////////////////////////////////
+
+static void benchPushBack(int nitems)
+{
+  TNxArray<int> array;
+  unsigned long start = now();
+
+  for (int i = 0; i < nitems; i++)
+    {
+      array.push_back(i);
+    }
+
+  report("push_back", nitems, now() - start);
+
+  bool ok = array.size() == nitems && array.capacity() < 4 * nitems;
+  for (int i = 0; ok && i < nitems; i++)
+    {
+      ok = array[i] == i;
+    }
+
+  check(ok, "push_back", nitems);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: benchReserve
+/////////////////////////////////////////////////////////////////////////////
+
+static void benchReserve(int nitems)
+{
+  TNxArray<int> array;
+  unsigned long start = now();
+
+  array.reserve(nitems);
+  FAR int *data = &array.emplace_back();
+  for (int i = 1; i < nitems; i++)
+    {
+      array.emplace_back() = i;
+    }
+
+  report("reserve+emplace_back", nitems, now() - start);
+  check(array.capacity() == nitems && &array[0] == data &&
+        array[nitems - 1] == nitems - 1, "reserve", nitems);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: benchBulk
+//
+// Compare inserting and erasing a block at the front of the array one item
+// at a time with the bulk operations.
+/////////////////////////////////////////////////////////////////////////////
+
+static void benchBulk(int nitems)
+{
+  TNxArray<int> single;
+  TNxArray<int> bulk;
+  FAR int *block = new int[nitems];
+
+  for (int i = 0; i < nitems; i++)
+    {
+      block[i] = i;
+      single.push_back(-1);
+      bulk.push_back(-1);
+    }
+
+  unsigned long start = now();
+  for (int i = nitems - 1; i >= 0; i--)
+    {
+      single.insert(0, block[i]);
+    }
+
+  report("insert one by one", nitems, now() - start);
+
+  start = now();
+  bulk.insert(0, block, nitems);
+  report("insert block", nitems, now() - start);
+
+  bool ok = single.size() == 2 * nitems && bulk.size() == 2 * nitems;
+  for (int i = 0; ok && i < 2 * nitems; i++)
+    {
+      int expected = i < nitems ? i : -1;
+      ok = single[i] == expected && bulk[i] == expected;
+    }
+
+  check(ok, "insert", nitems);
+
+  start = now();
+  for (int i = 0; i < nitems; i++)
+    {
+      single.erase(0);
+    }
+
+  report("erase one by one", nitems, now() - start);
+
+  start = now();
+  bulk.erase(0, nitems);
+  report("erase block", nitems, now() - start);
+
+  ok = single.size() == nitems && bulk.size() == nitems &&
+       single[0] == -1 && bulk[nitems - 1] == -1;
+  check(ok, "erase", nitems);
+
+  delete[] block;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: benchSortedList
+//
+// Fill a sorted CListData the way a CListBox with many rows is filled.
+/////////////////////////////////////////////////////////////////////////////
+
+static void benchSortedList(int nitems)
+{
+  CListData list;
+  char text[16];
+
+  list.setSortInsertedItems(true);
+  srand(nitems);
+
+  unsigned long start = now();
+  for (int i = 0; i < nitems; i++)
+    {
+      snprintf(text, sizeof(text), "%08x", rand());
+      list.addItem(CNxString(text), i);
+    }
+
+  report("sorted CListData add", nitems, now() - start);
+
+  bool ok = list.getItemCount() == nitems;
+  for (int i = 1; ok && i < nitems; i++)
+    {
+      ok = list.getItem(i - 1)->compareTo(list.getItem(i)) <= 0;
+    }
+
+  check(ok, "sorted CListData", nitems);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Public Functions
+/////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+// Name: tnxarray_main
+/////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+  int maxItems = DEFAULT_ITEMS;
+
+  if (argc > 1)
+    {
+      maxItems = atoi(argv[1]);
+      if (maxItems < MIN_ITEMS)
+        {
+          printf("Usage: %s [<max items, at least %d>]\n",
+                 argv[0], MIN_ITEMS);
+          return EXIT_FAILURE;
+        }
+    }
+
+  // Each size is twice the previous one.  With linear behavior the time
+  // per item (last column) stays about the same as the size grows.
+
+  int nitems = maxItems >> (NSIZES - 1);
+  if (nitems < 1)
+    {
+      nitems = 1;
+    }
+
+  printf("%-24s %7s %10s %8s\n", "operation", "items", "usec",
+         "nsec/item");
+
+  for (int i = 0; i < NSIZES; i++, nitems <<= 1)
+    {
+      benchPushBack(nitems);
+      benchReserve(nitems);
+      benchBulk(nitems);
+      benchSortedList(nitems);
+    }
+
+  printf("tnxarray_main: %s\n", g_failed ? "FAILED" : "PASSED");
+  return g_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -740,6 +740,15 @@ void CGraphicsPort::_drawText(struct nxgl_point_s *pos, CRect *bound,
   bitmap.fmt    = CONFIG_NXWIDGETS_FMT;
   bitmap.data   = (FAR const nxgl_mxpixel_t*)glyph;
 
+#if CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+  // Cached glyphs are rendered on the background color or, when drawing
+  // transparently, on the font's transparent color which then serves as
+  // the color key.  A font color equal to the key cannot be keyed out.
+
+  nxgl_mxpixel_t key = transparent ? font->getTransparentColor() : background;
+  bool useCache      = !transparent || font->getColor() != key;
+#endif
+
   // Loop for each letter in the sub-string
 
   for (int i = startIndex; i < endIndex; i++)
@@ -748,6 +757,69 @@ void CGraphicsPort::_drawText(struct nxgl_point_s *pos, CRect *bound,
 
       const nxwidget_char_t letter = string.getCharAt(i);
 
+#if CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+      struct SBitmap cached;
+      bool blank;
+
+      if (useCache && font->getGlyph(letter, key, &cached, &blank))
+        {
+          nxgl_coord_t fontWidth = cached.width;
+
+          if (!blank || !transparent)
+            {
+              struct nxgl_rect_s dest;
+              dest.pt1.x = pos->x;
+              dest.pt1.y = pos->y;
+              dest.pt2.x = pos->x + fontWidth - 1;
+              dest.pt2.y = pos->y + bmHeight - 1;
+
+              struct nxgl_rect_s intersection;
+              nxgl_rectintersect(&intersection, &dest, &boundingBox);
+
+              if (!nxgl_nullrect(&intersection))
+                {
+                  FAR const void *src = cached.data;
+
+                  if (transparent)
+                    {
+                      // Read the destination and copy the glyph's
+                      // foreground pixels over it
+
+                      bitmap.width  = fontWidth;
+                      bitmap.height = bmHeight;
+                      bitmap.stride = cached.stride;
+                      m_pNxWnd->getRectangle(&dest, &bitmap);
+
+                      FAR nxwidget_pixel_t *dst =
+                        (FAR nxwidget_pixel_t *)bitmap.data;
+                      FAR const nxwidget_pixel_t *fg =
+                        (FAR const nxwidget_pixel_t *)cached.data;
+                      unsigned int npixels = fontWidth * bmHeight;
+
+                      for (unsigned int j = 0; j < npixels; j++)
+                        {
+                          if (fg[j] != key)
+                            {
+                              dst[j] = fg[j];
+                            }
+                        }
+
+                      src = bitmap.data;
+                    }
+
+                  if (!m_pNxWnd->bitmap(&intersection, src, pos,
+                                        cached.stride))
+                    {
+                      ginfo("nx_bitmapwindow failed: %d\n", errno);
+                    }
+                }
+            }
+
+          pos->x += fontWidth;
+          continue;
+        }
+#endif
+
       // Get the font metrics for this letter
 
       struct nx_fontmetric_s metrics;
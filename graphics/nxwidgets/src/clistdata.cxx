@@ -409,15 +409,27 @@ void CListData::swapItems(const int index1, const int index2)
 
 const int CListData::getSortedInsertionIndex(const CListDataItem *item) const
 {
-  int i = 0;
+  int low  = 0;
+  int high = m_items.size();
 
-  // Locate slot where new option should go
+  // Binary search for the first item that does not sort before the new
+  // one.  A linear scan makes filling a sorted list quadratic.
 
-  while ((i < m_items.size()) && (item->compareTo(m_items[i]) > 0))
+  while (low < high)
     {
-      i++;
+      int mid = (low + high) >> 1;
+
+      if (item->compareTo(m_items[mid]) > 0)
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
     }
-  return i;
+
+  return low;
 }
 
 /**
@@ -67,6 +67,44 @@ CNxFont::CNxFont(enum nx_fontid_e fontid, nxgl_mxpixel_t fontColor,
   m_pFontSet         = nxf_getfontset(m_fontHandle);
   m_fontColor        = fontColor;
   m_transparentColor = transparentColor;
+
+  // Measure the ASCII glyphs once; strings are measured over and over
+  // again during layout
+
+  for (int i = 0; i < NXWIDGETS_FONT_NWIDTHS; i++)
+    {
+      FAR const struct nx_fontbitmap_s *fbm;
+
+      fbm = nxf_getbitmap(m_fontHandle, (uint16_t)i);
+      if (fbm)
+        {
+          m_charWidth[i] = fbm->metric.width + fbm->metric.xoffset;
+        }
+      else
+        {
+          m_charWidth[i] = m_pFontSet->spwidth;
+        }
+    }
+
+#if CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+  for (int i = 0; i < NXWIDGETS_GLYPH_NBUCKETS; i++)
+    {
+      m_glyphHash[i] = NULL;
+    }
+
+  m_lruHead          = NULL;
+  m_lruTail          = NULL;
+  m_glyphCacheUsed   = 0;
+#endif
+}
+
+/**
+ * CNxFont Destructor.
+ */
+
+CNxFont::~CNxFont(void)
+{
+  flushGlyphCache();
 }
 
 /**
@@ -119,6 +157,191 @@ void CNxFont::drawChar(FAR SBitmap *bitmap, nxwidget_char_t letter)
     }
 }
 
+/**
+ * Get a character rendered in the current font color on the supplied
+ * background color.
+ *
+ * @param letter The character to get.
+ * @param background The color of the pixels not covered by the glyph.
+ * @param bitmap The location to return the rendered glyph.
+ * @param blank The location to return true if the glyph has no
+ *   foreground pixels.
+ * @return True if the glyph was found or rendered into the cache.
+ */
+
+bool CNxFont::getGlyph(nxwidget_char_t letter, nxgl_mxpixel_t background,
+                       FAR struct SBitmap *bitmap, FAR bool *blank)
+{
+#if CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+  unsigned int bucket = (letter ^ m_fontColor ^ background) %
+                        NXWIDGETS_GLYPH_NBUCKETS;
+  FAR struct SGlyph *glyph;
+
+  for (glyph = m_glyphHash[bucket]; glyph != NULL; glyph = glyph->hashNext)
+    {
+      if (glyph->letter == letter && glyph->color == m_fontColor &&
+          glyph->background == background)
+        {
+          break;
+        }
+    }
+
+  if (glyph == NULL)
+    {
+      // Not cached.  Render the glyph on its background.
+
+      struct nx_fontmetric_s metrics;
+      getCharMetrics(letter, &metrics);
+
+      uint8_t width      = metrics.width + metrics.xoffset;
+      unsigned int npixels = (unsigned int)width * getHeight();
+      size_t size        = sizeof(struct SGlyph) +
+                           npixels * sizeof(nxwidget_pixel_t);
+
+      if (size > CONFIG_NXWIDGETS_GLYPHCACHE_SIZE)
+        {
+          return false;
+        }
+
+      while (m_glyphCacheUsed + size > CONFIG_NXWIDGETS_GLYPHCACHE_SIZE)
+        {
+          evictGlyph();
+        }
+
+      glyph = (FAR struct SGlyph *)new uint8_t[size];
+      if (glyph == NULL)
+        {
+          return false;
+        }
+
+      glyph->color      = m_fontColor;
+      glyph->background = background;
+      glyph->size       = size;
+      glyph->letter     = letter;
+      glyph->width      = width;
+      glyph->blank      = (metrics.height == 0);
+
+      FAR nxwidget_pixel_t *pixels = (FAR nxwidget_pixel_t *)(glyph + 1);
+      for (unsigned int i = 0; i < npixels; i++)
+        {
+          pixels[i] = background;
+        }
+
+      struct SBitmap render;
+      render.bpp    = CONFIG_NXWIDGETS_BPP;
+      render.fmt    = CONFIG_NXWIDGETS_FMT;
+      render.width  = width;
+      render.height = getHeight();
+      render.stride = width * sizeof(nxwidget_pixel_t);
+      render.data   = (FAR const void *)pixels;
+      drawChar(&render, letter);
+
+      glyph->hashNext     = m_glyphHash[bucket];
+      m_glyphHash[bucket] = glyph;
+      m_glyphCacheUsed   += size;
+    }
+  else
+    {
+      unlinkGlyph(glyph);
+    }
+
+  // Make the glyph the most recently used one
+
+  glyph->lruPrev = NULL;
+  glyph->lruNext = m_lruHead;
+  if (m_lruHead != NULL)
+    {
+      m_lruHead->lruPrev = glyph;
+    }
+  else
+    {
+      m_lruTail = glyph;
+    }
+
+  m_lruHead = glyph;
+
+  bitmap->bpp    = CONFIG_NXWIDGETS_BPP;
+  bitmap->fmt    = CONFIG_NXWIDGETS_FMT;
+  bitmap->width  = glyph->width;
+  bitmap->height = getHeight();
+  bitmap->stride = glyph->width * sizeof(nxwidget_pixel_t);
+  bitmap->data   = (FAR const void *)(glyph + 1);
+  *blank         = glyph->blank;
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Discard all rendered glyphs.
+ */
+
+void CNxFont::flushGlyphCache(void)
+{
+#if CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+  while (m_lruTail != NULL)
+    {
+      evictGlyph();
+    }
+#endif
+}
+
+#if CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+/**
+ * Unlink a glyph from the LRU list.
+ *
+ * @param glyph The glyph to unlink.
+ */
+
+void CNxFont::unlinkGlyph(FAR struct SGlyph *glyph)
+{
+  if (glyph->lruPrev != NULL)
+    {
+      glyph->lruPrev->lruNext = glyph->lruNext;
+    }
+  else
+    {
+      m_lruHead = glyph->lruNext;
+    }
+
+  if (glyph->lruNext != NULL)
+    {
+      glyph->lruNext->lruPrev = glyph->lruPrev;
+    }
+  else
+    {
+      m_lruTail = glyph->lruPrev;
+    }
+}
+
+/**
+ * Remove the least recently used glyph from the cache and free it.
+ */
+
+void CNxFont::evictGlyph(void)
+{
+  FAR struct SGlyph *glyph = m_lruTail;
+  unlinkGlyph(glyph);
+
+  // Remove it from its hash bucket
+
+  unsigned int bucket = (glyph->letter ^ glyph->color ^ glyph->background) %
+                        NXWIDGETS_GLYPH_NBUCKETS;
+  FAR struct SGlyph **prev = &m_glyphHash[bucket];
+
+  while (*prev != glyph)
+    {
+      prev = &(*prev)->hashNext;
+    }
+
+  *prev = glyph->hashNext;
+
+  m_glyphCacheUsed -= glyph->size;
+  delete[] (FAR uint8_t *)glyph;
+}
+#endif
+
 /**
  * Get the width of a string in pixels when drawn with this font.
  *
@@ -243,6 +466,11 @@ nxgl_coord_t CNxFont::getCharWidth(nxwidget_char_t letter) const
   FAR const struct nx_fontbitmap_s *fbm;
   nxgl_coord_t width;
 
+  if (letter < NXWIDGETS_FONT_NWIDTHS)
+    {
+      return m_charWidth[letter];
+    }
+
   /* Get the font bitmap for this character */
 
   fbm = nxf_getbitmap(m_fontHandle, letter);
@@ -160,6 +160,7 @@ CNxWidget::CNxWidget(CWidgetControl *pWidgetControl,
   m_flags.enabled         = true;
   m_flags.erased          = true;
   m_flags.hidden          = false;
+  m_flags.invalidated     = false;
 
   // Set hierarchy pointers
 
@@ -465,9 +466,48 @@ void CNxWidget::setFont(CNxFont *font)
 
 /**
  * Draws the visible regions of the widget and the widget's child widgets.
+ *
+ * With CONFIG_NXWIDGETS_DEFERRED_REDRAW this only invalidates the
+ * widget; the repaint happens on the next CWidgetControl::flushRedraw().
  */
 
 void CNxWidget::redraw(void)
+{
+  invalidate();
+}
+
+/**
+ * Mark the widget as needing a repaint.  Without
+ * CONFIG_NXWIDGETS_DEFERRED_REDRAW this is the same as redraw().
+ */
+
+void CNxWidget::invalidate(void)
+{
+  if (isDrawingEnabled())
+    {
+      m_widgetControl->countRedrawRequest();
+
+#ifdef CONFIG_NXWIDGETS_DEFERRED_REDRAW
+      // Nothing to do if a repaint is already pending; the widget will be
+      // drawn once however many times it changed since the last flush
+
+      if (!m_flags.invalidated)
+        {
+          m_flags.invalidated = true;
+          m_widgetControl->scheduleRedraw();
+        }
+#else
+      paint();
+#endif
+    }
+}
+
+/**
+ * Immediately draw the widget and all of its children, clearing any
+ * pending invalidation.
+ */
+
+void CNxWidget::paint(void)
 {
   if (isDrawingEnabled())
     {
@@ -479,10 +519,12 @@ void CNxWidget::redraw(void)
 
       drawBorder(port);
       drawContents(port);
+      m_widgetControl->countPaint();
 
-      // Remember that the widget is no longer erased
+      // Remember that the widget is no longer erased nor invalid
 
-      m_flags.erased = false;
+      m_flags.erased      = false;
+      m_flags.invalidated = false;
 
       // Draw the children of the widget
 
@@ -490,6 +532,116 @@ void CNxWidget::redraw(void)
     }
 }
 
+/**
+ * Paint every invalidated widget in this widget's subtree together
+ * with any later sibling it overlaps.
+ *
+ * @param area Set to the bounding rectangle of everything painted.
+ * @return True if anything was painted.
+ */
+
+bool CNxWidget::paintInvalidated(CRect &area)
+{
+  if (!isDrawingEnabled())
+    {
+      // Hidden widgets are invalidated again when they are shown
+
+      m_flags.invalidated = false;
+      return false;
+    }
+
+  if (m_flags.invalidated)
+    {
+      paint();
+      area = CRect(getX(), getY(), getWidth(), getHeight());
+      return true;
+    }
+
+  // Children are drawn in stacking order, so a repainted child must be
+  // followed by every later sibling that overlaps what was repainted.
+
+  CRect dirty;
+  bool painted = false;
+
+  for (int i = 0; i < m_children.size(); i++)
+    {
+      CNxWidget *child = m_children[i];
+      CRect childArea(child->getX(), child->getY(),
+                      child->getWidth(), child->getHeight());
+
+      if (painted && child->isDrawingEnabled() &&
+          dirty.intersects(childArea))
+        {
+          child->paint();
+        }
+      else if (!child->paintInvalidated(childArea))
+        {
+          continue;
+        }
+
+      if (painted)
+        {
+          dirty.expandToInclude(childArea);
+        }
+      else
+        {
+          dirty   = childArea;
+          painted = true;
+        }
+    }
+
+  area = dirty;
+  return painted;
+}
+
+/**
+ * Find the deepest visible widget in this subtree that completely
+ * covers the supplied rectangle.
+ *
+ * @param rect The exposed rectangle.
+ * @return The covering widget, or NULL if this widget does not cover
+ *   the rectangle.
+ */
+
+CNxWidget *CNxWidget::findCoveringWidget(const CRect &rect)
+{
+  if (isHidden())
+    {
+      return NULL;
+    }
+
+  CRect bounds(getX(), getY(), getWidth(), getHeight());
+  if (!bounds.contains(rect.getX(), rect.getY()) ||
+      !bounds.contains(rect.getX2(), rect.getY2()))
+    {
+      return NULL;
+    }
+
+  // Check the topmost children first.  A child that only partially covers
+  // the area does not help: it would be overdrawn by anything painted
+  // underneath it, so this widget must repaint the whole stack.
+
+  for (int i = m_children.size() - 1; i > -1; i--)
+    {
+      CNxWidget *child = m_children[i];
+      CNxWidget *widget = child->findCoveringWidget(rect);
+      if (widget != NULL)
+        {
+          return widget;
+        }
+
+      CRect childBounds(child->getX(), child->getY(),
+                        child->getWidth(), child->getHeight());
+
+      if (!child->isHidden() && childBounds.intersects(rect))
+        {
+          break;
+        }
+    }
+
+  return this;
+}
+
 /**
  * Enables the widget.
  *
@@ -595,6 +747,7 @@ bool CNxWidget::hide(void)
 {
   if (!m_flags.hidden)
     {
+      exposeBounds();
       m_flags.hidden = true;
       m_widgetEventHandlers->raiseHideEvent();
       return true;
@@ -1044,6 +1197,7 @@ bool CNxWidget::moveTo(nxgl_coord_t x, nxgl_coord_t y)
       nxgl_coord_t oldX = m_rect.getX();
       nxgl_coord_t oldY = m_rect.getY();
 
+      exposeBounds();
       m_rect.setX(x);
       m_rect.setY(y);
 
@@ -1099,6 +1253,7 @@ bool CNxWidget::resize(nxgl_coord_t width, nxgl_coord_t height)
 
       bool wasDrawEnabled = m_flags.drawingEnabled;
 
+      exposeBounds();
       m_flags.permeable = true;
       disableDrawing();
 
@@ -1136,6 +1291,10 @@ bool CNxWidget::resize(nxgl_coord_t width, nxgl_coord_t height)
 bool CNxWidget::changeDimensions(nxgl_coord_t x, nxgl_coord_t y,
                                  nxgl_coord_t width, nxgl_coord_t height)
 {
+  // Expose the old area here: drawing is disabled during the move
+
+  exposeBounds();
+
   bool wasDrawing = m_flags.drawingEnabled;
   m_flags.drawingEnabled = false;
   bool moved = moveTo(x, y);
@@ -1454,8 +1613,24 @@ void CNxWidget::drawChildren(void)
 {
   for (int i = 0; i < m_children.size(); i++)
     {
-      m_children[i]->redraw();
+      m_children[i]->paint();
+    }
+}
+
+/**
+ * Tell the widget control that the area currently occupied by this widget
+ * must be repainted by whatever lies underneath it.
+ */
+
+void CNxWidget::exposeBounds(void)
+{
+#ifdef CONFIG_NXWIDGETS_DEFERRED_REDRAW
+  if (isDrawingEnabled())
+    {
+      m_widgetControl->invalidateRect(CRect(getX(), getY(),
+                                            getWidth(), getHeight()));
     }
+#endif
 }
 
 /**
@@ -161,6 +161,24 @@ void CRlePaletteBitmap::setSelected(bool selected)
   m_lut = m_bitmap->lut[selected ? 1 : 0];
 }
 
+/**
+ * Get a value that uniquely identifies the image content.
+ *
+ * @return The image key.
+ */
+
+FAR const void *CRlePaletteBitmap::getCacheKey(void) const
+{
+  // The same RLE data with a different LUT is a different image
+
+  if (m_lut == m_bitmap->lut[0])
+    {
+      return (FAR const void *)&m_bitmap->lut[0];
+    }
+
+  return (FAR const void *)&m_bitmap->lut[1];
+}
+
 /**
  * Get one row from the bit map image using the selected LUT.
  *
@@ -29,6 +29,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <cstring>
+#include <pthread.h>
 #include <debug.h>
 
 #include <nuttx/nx/nxglib.h>
@@ -39,6 +40,127 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
+// Bytes per pixel of the supported color formats
+
+#if CONFIG_NXWIDGETS_FMT == FB_FMT_RGB8_332
+#  define SCALED_BYTESPP 1
+#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB16_565
+#  define SCALED_BYTESPP 2
+#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB24
+#  define SCALED_BYTESPP 3
+#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB32
+#  define SCALED_BYTESPP 4
+#else
+#  error Unsupported, invalid, or undefined color format
+#endif
+
+// RGB565 pixels are spread into 16-bit lanes of a 64-bit word so that all
+// three components can be interpolated with one multiplication:
+// 0000 0000 000R RRRR 0000 0000 00GG GGGG 0000 0000 000B BBBB
+
+#define RGB565_SPREAD_MASK UINT64_C(0x0000001f003f001f)
+#define RGB565_SPREAD_HALF UINT64_C(0x0000008000800080)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
+namespace NXWidgets
+{
+  /**
+   * A fully scaled image, shared by all CScaledBitmap instances that
+   * scale the same source to the same size.
+   */
+
+  struct SScaledImage
+  {
+    FAR struct SScaledImage *flink;  /**< Next shared image */
+    FAR const void          *key;    /**< Source image key */
+    struct nxgl_size_s       size;   /**< Scaled size of the image */
+    unsigned int             refs;   /**< Number of users */
+    size_t                   stride; /**< Width of a row in bytes */
+    FAR uint8_t             *data;   /**< Scaled image data */
+  };
+}
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
+static FAR struct NXWidgets::SScaledImage *g_scaledImages;
+static pthread_mutex_t g_scaledLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+#if CONFIG_NXWIDGETS_FMT == FB_FMT_RGB16_565
+/**
+ * Interpolate between two spread RGB565 pixels.
+ *
+ * @param a The spread pixel for a weight of zero
+ * @param b The spread pixel for a weight of 256
+ * @param weight The weight of b in the range 0-255
+ */
+
+static inline uint64_t lerp565(uint64_t a, uint64_t b, uint32_t weight)
+{
+  return ((a * (256 - weight) + b * weight + RGB565_SPREAD_HALF) >> 8) &
+         RGB565_SPREAD_MASK;
+}
+
+static inline uint64_t spread565(uint16_t pixel)
+{
+  return (uint64_t)(pixel & 0x001f) |
+         ((uint64_t)(pixel & 0x07e0) << 11) |
+         ((uint64_t)(pixel & 0xf800) << 21);
+}
+
+static inline uint16_t pack565(uint64_t spread)
+{
+  return (uint16_t)((spread & 0x001f) | ((spread >> 11) & 0x07e0) |
+                    ((spread >> 21) & 0xf800));
+}
+
+#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB24 || \
+      CONFIG_NXWIDGETS_FMT == FB_FMT_RGB32
+/**
+ * Interpolate between two 0x00RRGGBB pixels, red and blue in parallel.
+ *
+ * @param a The pixel for a weight of zero
+ * @param b The pixel for a weight of 256
+ * @param weight The weight of b in the range 0-255
+ */
+
+static inline uint32_t lerp888(uint32_t a, uint32_t b, uint32_t weight)
+{
+  uint32_t rb = (a & 0x00ff00ff) * (256 - weight) +
+                (b & 0x00ff00ff) * weight + 0x00800080;
+  uint32_t g  = (a & 0x0000ff00) * (256 - weight) +
+                (b & 0x0000ff00) * weight + 0x00008000;
+
+  return ((rb >> 8) & 0x00ff00ff) | ((g >> 8) & 0x0000ff00);
+}
+
+#else
+/**
+ * Interpolate one color component.
+ *
+ * @param a The component value for a weight of zero
+ * @param b The component value for a weight of 256
+ * @param weight The weight of b in the range 0-255
+ */
+
+static inline int lerpComponent(int a, int b, int weight)
+{
+  return (a * (256 - weight) + b * weight + 128) >> 8;
+}
+#endif
+
 /****************************************************************************
  * Method Implementations
  ****************************************************************************/
@@ -71,16 +193,24 @@ CScaledBitmap::CScaledBitmap(IBitmap *bitmap, struct nxgl_size_s &newSize)
 
   m_yScale = itob16((uint32_t)m_bitmap->getHeight()) / newSize.h;
 
-  // Allocate and initialize the row cache
+  m_rowCache[0] = (FAR uint8_t *)0;
+  m_rowCache[1] = (FAR uint8_t *)0;
+  m_colIndex    = (FAR uint16_t *)0;
+  m_colFrac     = (FAR uint8_t *)0;
 
-  size_t stride = bitmap->getStride();
-  m_rowCache[0] = new uint8_t[stride];
-  m_rowCache[1] = new uint8_t[stride];
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
+  // Scale the whole image once, or reuse an identical one.  Keep the
+  // streaming scaler if the image cannot be shared or that fails.
 
-  // Read the first two rows into the cache
+  m_image = (FAR struct SScaledImage *)0;
+  attachImage();
+  if (m_image)
+    {
+      return;
+    }
+#endif
 
-  m_row = m_bitmap->getWidth(); // Set to an impossible value
-  cacheRows(0);
+  initScaler();
 }
 
 /**
@@ -89,17 +219,13 @@ CScaledBitmap::CScaledBitmap(IBitmap *bitmap, struct nxgl_size_s &newSize)
 
 CScaledBitmap::~CScaledBitmap(void)
 {
-  // Delete the allocated row cache memory
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
+  detachImage();
+#endif
 
-  if (m_rowCache[0])
-    {
-      delete m_rowCache[0];
-    }
+  // Delete the allocated row cache memory
 
-  if (m_rowCache[1])
-    {
-      delete m_rowCache[1];
-   }
+  releaseScaler();
 
   // We are also responsible for deleting the contained IBitmap
 
@@ -185,21 +311,101 @@ const size_t CScaledBitmap::getStride(void) const
 bool CScaledBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y,
                            nxgl_coord_t width, FAR void *data)
 {
-#if CONFIG_NXWIDGETS_FMT == FB_FMT_RGB8_332 || CONFIG_NXWIDGETS_FMT == FB_FMT_RGB24
-  FAR uint8_t  *dest = (FAR uint8_t *)data;
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB16_565
-  FAR uint16_t *dest = (FAR uint16_t *)data;
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB32
-  FAR uint32_t *dest = (FAR uint32_t *)data;
-#else
-#  error Unsupported, invalid, or undefined color format
+  // Check ranges.  Casts to unsigned int are ugly but permit one-sided
+  // comparisons
+
+  if (((unsigned int)x           >= (unsigned int)m_size.w) ||
+      ((unsigned int)(x + width) >  (unsigned int)m_size.w) ||
+      ((unsigned int)y           >= (unsigned int)m_size.h))
+    {
+      return false;
+    }
+
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
+  // Just copy from the scaled image if we have one
+
+  if (m_image)
+    {
+      memcpy(data, &m_image->data[y * m_image->stride + x * SCALED_BYTESPP],
+             width * SCALED_BYTESPP);
+      return true;
+    }
 #endif
 
-  // Check ranges.  Casts to unsigned int are ugly but permit one-sided comparisons
+  return scaleRun(x, y, width, data);
+}
+
+/**
+ * Allocate the row cache and the column tables and read the first
+ * two rows of the contained bitmap.
+ *
+ * @return True if the scaler is ready for use.
+ */
+
+bool CScaledBitmap::initScaler(void)
+{
+  // Allocate the row cache with room to repeat the last pixel
+
+  size_t stride = m_bitmap->getStride() + SCALED_BYTESPP;
+  m_rowCache[0] = new uint8_t[stride];
+  m_rowCache[1] = new uint8_t[stride];
+
+  // Build the column step tables: the source column at or just before
+  // each scaled column and the 8-bit weight of the column after it
+
+  m_colIndex    = new uint16_t[m_size.w];
+  m_colFrac     = new uint8_t[m_size.w];
+
+  if (!m_rowCache[0] || !m_rowCache[1] || !m_colIndex || !m_colFrac)
+    {
+      gerr("ERROR: Failed to allocate the scaler\n");
+      releaseScaler();
+      return false;
+    }
+
+  for (nxgl_coord_t x = 0; x < m_size.w; x++)
+    {
+      uint32_t column = (uint32_t)x * (uint32_t)m_xScale;
+      m_colIndex[x]   = (uint16_t)(column >> 16);
+      m_colFrac[x]    = (uint8_t)(column >> 8);
+    }
+
+  // Read the first two rows into the cache
+
+  m_row = m_bitmap->getWidth(); // Set to an impossible value
+  return cacheRows(0);
+}
+
+/**
+ * Free the row cache and the column tables.
+ */
+
+void CScaledBitmap::releaseScaler(void)
+{
+  delete[] m_rowCache[0];
+  delete[] m_rowCache[1];
+  delete[] m_colIndex;
+  delete[] m_colFrac;
+
+  m_rowCache[0] = (FAR uint8_t *)0;
+  m_rowCache[1] = (FAR uint8_t *)0;
+  m_colIndex    = (FAR uint16_t *)0;
+  m_colFrac     = (FAR uint8_t *)0;
+}
 
-  if (((unsigned int)x           >=  (unsigned int)m_size.w) &&
-      ((unsigned int)(x + width) > (unsigned int)m_size.w) &&
-      ((unsigned int)y           <= (unsigned int)m_size.h))
+/**
+ * Scale a run of one row using only integer arithmetic.
+ *
+ * @param x The offset into the scaled row
+ * @param y The scaled row number
+ * @param width The number of pixels to produce
+ * @param data The memory location in which to return the data
+ */
+
+bool CScaledBitmap::scaleRun(nxgl_coord_t x, nxgl_coord_t y,
+                             nxgl_coord_t width, FAR void *data)
+{
+  if (!m_colIndex)
     {
       return false;
     }
@@ -208,8 +414,7 @@ bool CScaledBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y,
   // requested y position.  This must be either the exact row or the
   // closest row just before the requested position
 
-  b16_t row16      = y * m_yScale;
-  nxgl_coord_t row = b16toi(row16);
+  uint32_t row16 = (uint32_t)y * (uint32_t)m_yScale;
 
   // Get that row and the one after it into the row cache. We know that
   // the pixel value that we want is one between the two rows.  This
@@ -217,128 +422,187 @@ bool CScaledBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y,
   // we will be traversal each image from top-left to bottom-right in
   // order.  In that case, the caching is most efficient.
 
-  if (!cacheRows(row))
+  if (!cacheRows(row16 >> 16))
     {
       return false;
     }
 
-  // Now scale and copy the data from the cached row data
-
-  for (int i = 0; i < width; i++, x++)
-    {
-      // Get the column number in the unscaled row corresponding to the
-      // requested x position.  This must be either the exact column or the
-      // closest column just before the requested position
-
-      b16_t column = x * m_xScale;
-
-      // Get the color at the position on the first row
+  // Weight of the second row.  Pixels next to a transparent pixel are not
+  // interpolated; the closest of the four source pixels is used instead
+  // so that the transparent color does not bleed into the image.
 
-      struct rgbcolor_s color1;
-      if (!rowColor(m_rowCache[0], column, color1))
-        {
-          gerr("ERROR: rowColor failed for the first row\n");
-          return false;
-        }
+  uint32_t fy = (row16 >> 8) & 0xff;
+  FAR const uint16_t *colIndex = &m_colIndex[x];
+  FAR const uint8_t  *colFrac  = &m_colFrac[x];
 
-      // Get the color at the position on the first row
+#if CONFIG_NXWIDGETS_FMT == FB_FMT_RGB16_565
+  FAR const uint16_t *row0 = (FAR const uint16_t *)m_rowCache[0];
+  FAR const uint16_t *row1 = (FAR const uint16_t *)m_rowCache[1];
+  FAR uint16_t       *dest = (FAR uint16_t *)data;
 
-      struct rgbcolor_s color2;
-      if (!rowColor(m_rowCache[1], column, color2))
+  for (int i = 0; i < width; i++)
+    {
+      unsigned int col = colIndex[i];
+      uint32_t fx      = colFrac[i];
+      uint16_t p00     = row0[col];
+      uint16_t p01     = row0[col + 1];
+      uint16_t p10     = row1[col];
+      uint16_t p11     = row1[col + 1];
+
+      if (p00 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p01 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p10 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p11 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR)
         {
-          gerr("ERROR: rowColor failed for the second row\n");
-          return false;
+          FAR const uint16_t *nearest = fy < 128 ? row0 : row1;
+          dest[i] = nearest[fx < 128 ? col : col + 1];
+          continue;
         }
 
-      // Check for transparent colors
-
-      bool transparent1;
-      bool transparent2;
-
-#if CONFIG_NXWIDGETS_FMT == FB_FMT_RGB8_332
-      uint8_t color = RGBTO8(color1.r, color1.g, color1.b);
-      transparent1 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
-
-      color = RGBTO8(color2.r, color2.g, color2.b);
-      transparent2 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
-
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB16_565
-      uint16_t color = RGBTO16(color1.r, color1.g, color1.b);
-      transparent1 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
-
-      color = RGBTO16(color2.r, color2.g, color2.b);
-      transparent2 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+      uint64_t top    = lerp565(spread565(p00), spread565(p01), fx);
+      uint64_t bottom = lerp565(spread565(p10), spread565(p11), fx);
 
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB24 || CONFIG_NXWIDGETS_FMT == FB_FMT_RGB32
-      uint32_t color = RGBTO24(color1.r, color1.g, color1.b);
-      transparent1 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+      dest[i] = pack565(lerp565(top, bottom, fy));
+    }
 
-      color = RGBTO24(color2.r, color2.g, color2.b);
-      transparent2 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB32
+  FAR const uint32_t *row0 = (FAR const uint32_t *)m_rowCache[0];
+  FAR const uint32_t *row1 = (FAR const uint32_t *)m_rowCache[1];
+  FAR uint32_t       *dest = (FAR uint32_t *)data;
 
-#else
-#  error Unsupported, invalid, or undefined color format
-#endif
+  for (int i = 0; i < width; i++)
+    {
+      unsigned int col = colIndex[i];
+      uint32_t fx      = colFrac[i];
+      uint32_t p00     = row0[col];
+      uint32_t p01     = row0[col + 1];
+      uint32_t p10     = row1[col];
+      uint32_t p11     = row1[col + 1];
+
+      if (p00 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p01 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p10 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p11 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR)
+        {
+          FAR const uint32_t *nearest = fy < 128 ? row0 : row1;
+          dest[i] = nearest[fx < 128 ? col : col + 1];
+          continue;
+        }
 
-      // Is one of the colors transparent?
+      dest[i] = lerp888(lerp888(p00, p01, fx), lerp888(p10, p11, fx), fy);
+    }
 
-      struct rgbcolor_s scaledColor;
-      b16_t fraction b16frac(row16);
+#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB24
+  FAR const uint8_t *row0 = m_rowCache[0];
+  FAR const uint8_t *row1 = m_rowCache[1];
+  FAR uint8_t       *dest = (FAR uint8_t *)data;
 
-      if (transparent1 || transparent2)
+  for (int i = 0; i < width; i++, dest += 3)
+    {
+      unsigned int ndx = 3 * colIndex[i];
+      uint32_t fx      = colFrac[i];
+      uint32_t p00     = RGBTO24(row0[ndx + 2], row0[ndx + 1], row0[ndx]);
+      uint32_t p01     = RGBTO24(row0[ndx + 5], row0[ndx + 4], row0[ndx + 3]);
+      uint32_t p10     = RGBTO24(row1[ndx + 2], row1[ndx + 1], row1[ndx]);
+      uint32_t p11     = RGBTO24(row1[ndx + 5], row1[ndx + 4], row1[ndx + 3]);
+      uint32_t color;
+
+      if (p00 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p01 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p10 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p11 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR)
         {
-          // Yes.. don't interpolate within transparent regions or
-          // between transparent and opaque regions.
-
-          // Get the color closest to the requested position
-
-          if (fraction < b16HALF)
+          if (fy < 128)
             {
-              scaledColor.r = color1.r;
-              scaledColor.g = color1.g;
-              scaledColor.b = color1.b;
+              color = fx < 128 ? p00 : p01;
             }
           else
             {
-              scaledColor.r = color2.r;
-              scaledColor.g = color2.g;
-              scaledColor.b = color2.b;
+              color = fx < 128 ? p10 : p11;
             }
         }
       else
         {
-          // No.. both colors are opaque
+          color = lerp888(lerp888(p00, p01, fx), lerp888(p10, p11, fx), fy);
+        }
 
-          if (!scaleColor(color1, color2, fraction, scaledColor))
-            {
-              return false;
-            }
+      dest[0] = RGB24BLUE(color);
+      dest[1] = RGB24GREEN(color);
+      dest[2] = RGB24RED(color);
+    }
+
+#else /* FB_FMT_RGB8_332 */
+  FAR const uint8_t *row0 = m_rowCache[0];
+  FAR const uint8_t *row1 = m_rowCache[1];
+  FAR uint8_t       *dest = (FAR uint8_t *)data;
+
+  for (int i = 0; i < width; i++)
+    {
+      unsigned int col = colIndex[i];
+      int fx           = colFrac[i];
+      uint8_t p00      = row0[col];
+      uint8_t p01      = row0[col + 1];
+      uint8_t p10      = row1[col];
+      uint8_t p11      = row1[col + 1];
+
+      if (p00 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p01 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p10 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR ||
+          p11 == CONFIG_NXWIDGETS_TRANSPARENT_COLOR)
+        {
+          FAR const uint8_t *nearest = fy < 128 ? row0 : row1;
+          dest[i] = nearest[fx < 128 ? col : col + 1];
+          continue;
         }
 
-      // Write the interpolated data to the user buffer
+      // Interpolate the 3-bit red, 3-bit green and 2-bit blue components
 
-#if CONFIG_NXWIDGETS_FMT == FB_FMT_RGB8_332
-      color = RGBTO8(scaledColor.r, scaledColor.g, scaledColor.b);
-      *dest++ = color;
+      int top;
+      int bottom;
+      int r;
+      int g;
+      int b;
 
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB16_565
-      color = RGBTO16(scaledColor.r, scaledColor.g, scaledColor.b);
-      *dest++ = color;
+      top    = lerpComponent(p00 >> 5, p01 >> 5, fx);
+      bottom = lerpComponent(p10 >> 5, p11 >> 5, fx);
+      r      = lerpComponent(top, bottom, fy);
 
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB24
-      *dest++ = color2.b;
-      *dest++ = color2.r;
-      *dest++ = color2.g;
+      top    = lerpComponent((p00 >> 2) & 7, (p01 >> 2) & 7, fx);
+      bottom = lerpComponent((p10 >> 2) & 7, (p11 >> 2) & 7, fx);
+      g      = lerpComponent(top, bottom, fy);
 
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB32
-      color = RGBTO24(scaledColor.r, scaledColor.g, scaledColor.b);
-      *dest++ = color;
+      top    = lerpComponent(p00 & 3, p01 & 3, fx);
+      bottom = lerpComponent(p10 & 3, p11 & 3, fx);
+      b      = lerpComponent(top, bottom, fy);
 
-#else
-#  error Unsupported, invalid, or undefined color format
+      dest[i] = (uint8_t)((r << 5) | (g << 2) | b);
+    }
 #endif
+
+  return true;
+}
+
+/**
+ * Read one row of the contained bitmap into a row cache buffer.
+ *
+ * @param row - The row number to read
+ * @param buffer - The row cache buffer
+ */
+
+bool CScaledBitmap::readRow(unsigned int row, FAR uint8_t *buffer)
+{
+  nxgl_coord_t bitmapWidth  = m_bitmap->getWidth();
+
+  if (!m_bitmap->getRun(0, row, bitmapWidth, buffer))
+    {
+      gerr("ERROR: Failed to read bitmap row %d\n", row);
+      return false;
     }
 
+  // Repeat the last pixel so that column + 1 is always valid
+
+  memcpy(&buffer[bitmapWidth * SCALED_BYTESPP],
+         &buffer[(bitmapWidth - 1) * SCALED_BYTESPP], SCALED_BYTESPP);
   return true;
 }
 
@@ -350,7 +614,6 @@ bool CScaledBitmap::getRun(nxgl_coord_t x, nxgl_coord_t y,
 
 bool CScaledBitmap::cacheRows(unsigned int row)
 {
-  nxgl_coord_t bitmapWidth  = m_bitmap->getWidth();
   nxgl_coord_t bitmapHeight = m_bitmap->getHeight();
 
   // A common case is to advance by one row.  In this case, we only
@@ -375,9 +638,8 @@ bool CScaledBitmap::cacheRows(unsigned int row)
           row = bitmapHeight - 1;
         }
 
-      if (!m_bitmap->getRun(0, row, bitmapWidth, m_rowCache[1]))
+      if (!readRow(row, m_rowCache[1]))
         {
-          gerr("ERROR: Failed to read bitmap row %d\n", row);
           return false;
         }
     }
@@ -394,9 +656,8 @@ bool CScaledBitmap::cacheRows(unsigned int row)
           row = bitmapHeight - 1;
         }
 
-      if (!m_bitmap->getRun(0, row, bitmapWidth, m_rowCache[0]))
+      if (!readRow(row, m_rowCache[0]))
         {
-          gerr("ERROR: Failed to read bitmap row %d\n", row);
           return false;
         }
 
@@ -411,9 +672,8 @@ bool CScaledBitmap::cacheRows(unsigned int row)
           row = bitmapHeight - 1;
         }
 
-      if (!m_bitmap->getRun(0, row, bitmapWidth, m_rowCache[1]))
+      if (!readRow(row, m_rowCache[1]))
         {
-          gerr("ERROR: Failed to read bitmap row %d\n", row);
           return false;
         }
     }
@@ -421,181 +681,121 @@ bool CScaledBitmap::cacheRows(unsigned int row)
   return true;
 }
 
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
 /**
- * Given an two RGB colors and a fractional value, return the scaled
- * value between the two colors.
- *
- * @param incolor1 - The first color to be used
- * @param incolor2 - The second color to be used
- * @param fraction - The fractional value
- * @param outcolor - The returned, scaled color
+ * Find or create the fully scaled image, sharing it with any other
+ * CScaledBitmap that scales the same source image to the same size.
+ * Images without a cache key could never be shared, so they are left
+ * to the streaming scaler rather than costing a private full-size copy.
  */
 
-bool CScaledBitmap::scaleColor(FAR const struct rgbcolor_s &incolor1,
-                               FAR const struct rgbcolor_s &incolor2,
-                               b16_t fraction, FAR struct rgbcolor_s &outcolor)
+void CScaledBitmap::attachImage(void)
 {
-  uint32_t component;
-  b16_t red;
-  b16_t green;
-  b16_t blue;
-
-  // A fraction of < 0.5 would mean to use use mostly color1; a fraction
-  // greater than 0.5 would men to use mostly color2
-
-  b16_t remainder = b16ONE - fraction;
-
-  // Interpolate each color value  (converting to b15)
-
-  red   = (b16_t)incolor1.r * remainder + (b16_t)incolor2.r * fraction;
-  green = (b16_t)incolor1.g * remainder + (b16_t)incolor2.g * fraction;
-  blue  = (b16_t)incolor1.b * remainder + (b16_t)incolor2.b * fraction;
-
-  // Return the integer, interpolated values, clipping to the range of
-  // uint8_t
+  FAR const void *key = m_bitmap->getCacheKey();
+  FAR struct SScaledImage *image;
 
-  component  = b16toi(red);
-  outcolor.r = component < 256 ? component : 255;
-
-  component  = b16toi(green);
-  outcolor.g = component < 256 ? component : 255;
-
-  component  = b16toi(blue);
-  outcolor.b = component < 256 ? component : 255;
-  return true;
-}
-
-/**
- * Given an image row and a non-integer column offset, return the
- * interpolated RGB color value corresponding to that position
- *
- * @param row - The pointer to the row in the row cache to use
- * @param column - The non-integer column offset
- * @param outcolor - The returned, interpolated color
- *
- */
-
-bool CScaledBitmap::rowColor(FAR uint8_t *row, b16_t column,
-                             FAR struct rgbcolor_s &outcolor)
-{
-  // This is the col at or just before the pixel of interest
-
-  nxgl_coord_t col1 = b16toi(column);
-  nxgl_coord_t col2 = col1 + 1;
-
-  nxgl_coord_t bitmapWidth  = m_bitmap->getWidth();
-  if (col2 >= bitmapWidth)
+  if (!key)
     {
-      col2 = bitmapWidth - 1;
+      return;
     }
 
-  b16_t fraction = b16frac(column);
-
-  struct rgbcolor_s color1;
-  struct rgbcolor_s color2;
-
-  bool transparent1;
-  bool transparent2;
-
-#if CONFIG_NXWIDGETS_FMT == FB_FMT_RGB8_332
-  uint8_t color = row[col1];
-  color1.r = RGB8RED(color);
-  color1.g = RGB8GREEN(color);
-  color1.b = RGB8BLUE(color);
-
-  transparent1 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
-
-  color = row[col2];
-  color2.r = RGB8RED(color);
-  color2.g = RGB8GREEN(color);
-  color2.b = RGB8BLUE(color);
-
-  transparent2 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+  pthread_mutex_lock(&g_scaledLock);
+  for (image = g_scaledImages; image; image = image->flink)
+    {
+      if (image->key == key && image->size.w == m_size.w &&
+          image->size.h == m_size.h)
+        {
+          image->refs++;
+          m_image = image;
+          break;
+        }
+    }
 
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB16_565
-  FAR uint16_t *row16 = (FAR uint16_t*)row;
-  uint16_t color = row16[col1];
-  color1.r = RGB16RED(color);
-  color1.g = RGB16GREEN(color);
-  color1.b = RGB16BLUE(color);
+  pthread_mutex_unlock(&g_scaledLock);
+  if (m_image)
+    {
+      return;
+    }
 
-  transparent1 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+  // Not found.  Scale the image row by row.
 
-  color = row16[col2];
-  color2.r = RGB16RED(color);
-  color2.g = RGB16GREEN(color);
-  color2.b = RGB16BLUE(color);
+  image = new SScaledImage;
+  if (!image)
+    {
+      return;
+    }
 
-  transparent2 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+  image->key    = key;
+  image->size   = m_size;
+  image->refs   = 1;
+  image->stride = m_size.w * SCALED_BYTESPP;
+  image->data   = new uint8_t[image->stride * m_size.h];
 
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB24
-  unsigned int ndx = 3*col1;
-  color1.r = row[ndx+2];
-  color1.g = row[ndx+1];
-  color1.b = row[ndx];
+  if (!image->data || !initScaler())
+    {
+      delete[] image->data;
+      delete image;
+      releaseScaler();
+      return;
+    }
 
-  uint32_t color = RGBTO24(color1.r, color1.g, color1.b);
-  transparent1 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+  for (nxgl_coord_t y = 0; y < m_size.h; y++)
+    {
+      if (!scaleRun(0, y, m_size.w, &image->data[y * image->stride]))
+        {
+          delete[] image->data;
+          delete image;
+          releaseScaler();
+          return;
+        }
+    }
 
-  ndx      = 3*col2;
-  color2.r = row[ndx+2];
-  color2.g = row[ndx+1];
-  color2.b = row[ndx];
+  // The streaming scaler is no longer needed
 
-  color = RGBTO24(color2.r, color2.g, color2.b);
-  transparent2 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+  releaseScaler();
 
-#elif CONFIG_NXWIDGETS_FMT == FB_FMT_RGB32
-  FAR uint32_t *row32 = (FAR uint32_t*)row;
-  uint32_t color = row32[col1];
-  color1.r = RGB24RED(color);
-  color1.g = RGB24GREEN(color);
-  color1.b = RGB24BLUE(color);
+  pthread_mutex_lock(&g_scaledLock);
+  image->flink   = g_scaledImages;
+  g_scaledImages = image;
+  pthread_mutex_unlock(&g_scaledLock);
 
-  transparent1 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+  m_image = image;
+}
 
-  color    = row32[col2];
-  color2.r = RGB24RED(color);
-  color2.g = RGB24GREEN(color);
-  color2.b = RGB24BLUE(color);
+/**
+ * Release the reference to the scaled image.
+ */
 
-  transparent2 = (color == CONFIG_NXWIDGETS_TRANSPARENT_COLOR);
+void CScaledBitmap::detachImage(void)
+{
+  FAR struct SScaledImage *image = m_image;
 
-#else
-#  error Unsupported, invalid, or undefined color format
-#endif
+  if (!image)
+    {
+      return;
+    }
 
-  // Is one of the colors transparent?
+  m_image = (FAR struct SScaledImage *)0;
 
-  if (transparent1 || transparent2)
+  pthread_mutex_lock(&g_scaledLock);
+  if (--image->refs > 0)
     {
-      // Yes.. don't interpolate within transparent regions or
-      // between transparent and opaque regions.
+      pthread_mutex_unlock(&g_scaledLock);
+      return;
+    }
 
-      // Return the color closest to the requested position
-      //
-      // A fraction of < 0.5 would mean to use use mostly color1; a fraction
-      // greater than 0.5 would men to use mostly color2
+  // Last user: remove it from the shared list
 
-      if (fraction < b16HALF)
-        {
-          outcolor.r = color1.r;
-          outcolor.g = color1.b;
-          outcolor.g = color1.g;
-        }
-      else
-        {
-          outcolor.r = color2.r;
-          outcolor.g = color2.b;
-          outcolor.g = color2.g;
-        }
-
-      return true;
-    }
-  else
+  FAR struct SScaledImage **prev = &g_scaledImages;
+  while (*prev != image)
     {
-      // No.. both colors are opaque
-
-      return scaleColor(color1, color2, fraction, outcolor);
+      prev = &(*prev)->flink;
     }
+
+  *prev = image->flink;
+  pthread_mutex_unlock(&g_scaledLock);
+
+  delete[] image->data;
+  delete image;
 }
+#endif
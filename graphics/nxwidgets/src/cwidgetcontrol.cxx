@@ -76,6 +76,16 @@ CWidgetControl::CWidgetControl(FAR const CWidgetStyle *style)
   m_clickedWidget      = NULL;
   m_focusedWidget      = NULL;
 
+  // Initialize repaint state
+
+  m_redrawStats.requests = 0;
+  m_redrawStats.flushes  = 0;
+  m_redrawStats.paints   = 0;
+#ifdef CONFIG_NXWIDGETS_DEFERRED_REDRAW
+  m_redrawPending      = false;
+  m_nDirty             = 0;
+#endif
+
   // Initialize data that we will get from the position callback
 
   m_hWindow            = NULL;
@@ -220,6 +230,7 @@ void CWidgetControl::postWindowEvent(void)
  *   pollMouseEvents(widget)
  *   pollKeyboardEvents()
  *   pollCursorControlEvents()
+ *   flushRedraw()
  *
  * @param widget.  Specific widget to poll.  Use NULL to run the
  *    all widgets in the window.
@@ -243,9 +254,172 @@ bool CWidgetControl::pollEvents(CNxWidget *widget)
   // Handle cursor control input
 
   bool cursorControlEvent = pollCursorControlEvents();
+
+  // Paint everything the events above invalidated
+
+  flushRedraw();
   return mouseEvent || keyboardEvent || cursorControlEvent;
 }
 
+/**
+ * Repaint everything that has been invalidated since the last flush.
+ *
+ * @return True if anything was painted.
+ */
+
+bool CWidgetControl::flushRedraw(void)
+{
+#ifdef CONFIG_NXWIDGETS_DEFERRED_REDRAW
+  if (!m_redrawPending)
+    {
+      return false;
+    }
+
+  // Hand each exposed area to the deepest widget that covers all of it,
+  // or to every top-level widget it touches if no single widget does.
+
+  for (int i = 0; i < m_nDirty; i++)
+    {
+      for (int j = 0; j < m_widgets.size(); j++)
+        {
+          CNxWidget *root = m_widgets[j];
+          if (root->getParent() != NULL || !root->isDrawingEnabled())
+            {
+              continue;
+            }
+
+          CRect bounds(root->getX(), root->getY(),
+                       root->getWidth(), root->getHeight());
+          if (!bounds.intersects(m_dirtyRects[i]))
+            {
+              continue;
+            }
+
+          CNxWidget *widget = root->findCoveringWidget(m_dirtyRects[i]);
+          if (widget == NULL)
+            {
+              widget = root;
+            }
+
+          widget->invalidate();
+        }
+    }
+
+  m_nDirty        = 0;
+  m_redrawPending = false;
+
+  // Then paint the invalidated widgets, top-level widgets in the order
+  // they were created
+
+  CRect dirty;
+  bool painted = false;
+
+  for (int i = 0; i < m_widgets.size(); i++)
+    {
+      CNxWidget *root = m_widgets[i];
+      if (root->getParent() != NULL)
+        {
+          continue;
+        }
+
+      CRect area(root->getX(), root->getY(),
+                 root->getWidth(), root->getHeight());
+
+      if (painted && root->isDrawingEnabled() && dirty.intersects(area))
+        {
+          root->paint();
+        }
+      else if (!root->paintInvalidated(area))
+        {
+          continue;
+        }
+
+      if (painted)
+        {
+          dirty.expandToInclude(area);
+        }
+      else
+        {
+          dirty   = area;
+          painted = true;
+        }
+    }
+
+  if (painted)
+    {
+      m_redrawStats.flushes++;
+    }
+
+  return painted;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Note that an invalidated widget awaits a repaint.
+ */
+
+void CWidgetControl::scheduleRedraw(void)
+{
+#ifdef CONFIG_NXWIDGETS_DEFERRED_REDRAW
+  m_redrawPending = true;
+
+  // Wake up an event loop that may be waiting so that it flushes
+
+#ifdef CONFIG_NXWIDGET_EVENTWAIT
+  postWindowEvent();
+#endif
+#endif
+}
+
+/**
+ * Mark an area of the window as needing to be repainted by the widgets
+ * underneath it.
+ *
+ * @param rect The exposed area.
+ */
+
+void CWidgetControl::invalidateRect(const CRect &rect)
+{
+#ifdef CONFIG_NXWIDGETS_DEFERRED_REDRAW
+  CRect area(rect);
+
+  // Merge with every overlapping area.  Merging can make the result
+  // overlap areas that were checked earlier, so start over after each
+  // merge.
+
+  for (int i = 0; i < m_nDirty; )
+    {
+      if (m_dirtyRects[i].intersects(area))
+        {
+          area.expandToInclude(m_dirtyRects[i]);
+          m_dirtyRects[i] = m_dirtyRects[--m_nDirty];
+          i = 0;
+        }
+      else
+        {
+          i++;
+        }
+    }
+
+  // If the list is full, fold everything into one area
+
+  if (m_nDirty >= CONFIG_NXWIDGETS_DIRTY_RECTS)
+    {
+      for (int i = 0; i < m_nDirty; i++)
+        {
+          area.expandToInclude(m_dirtyRects[i]);
+        }
+
+      m_nDirty = 0;
+    }
+
+  m_dirtyRects[m_nDirty++] = area;
+  scheduleRedraw();
+#endif
+}
+
 /**
  * Get the index of the specified controlled widget.
  *
@@ -27,17 +27,22 @@
 #include <nuttx/config.h>
 
 #include <sys/boardctl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <string.h>
 #include <semaphore.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <errno.h>
 
 #include "graphics/tiff.h"
 
 #include <nuttx/nx/nx.h>
+#include <nuttx/video/fb.h>
 
 /****************************************************************************
  * Pre-Processor Definitions
@@ -55,6 +60,14 @@
 #  define CONFIG_SCREENSHOT_FORMAT FB_FMT_RGB16_565
 #endif
 
+#ifndef CONFIG_SCREENSHOT_BLOCKROWS
+#  define CONFIG_SCREENSHOT_BLOCKROWS 16
+#endif
+
+#ifndef CONFIG_SCREENSHOT_IOSIZE
+#  define CONFIG_SCREENSHOT_IOSIZE 2048
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -71,26 +84,229 @@
  * Private Functions
  ****************************************************************************/
 
-static void replace_extension(FAR const char *filename,
-                              FAR const char *newext,
-                              FAR char *dest, size_t size)
+/****************************************************************************
+ * Name: screenshot_bpp
+ *
+ * Description:
+ *   Return the number of bits per pixel of the color formats supported by
+ *   the TIFF library or zero for any other format.
+ *
+ ****************************************************************************/
+
+static int screenshot_bpp(uint8_t colorfmt)
+{
+  switch (colorfmt)
+    {
+      case FB_FMT_Y1:
+        return 1;
+
+      case FB_FMT_Y4:
+        return 4;
+
+      case FB_FMT_Y8:
+        return 8;
+
+      case FB_FMT_RGB16_565:
+        return 16;
+
+      case FB_FMT_RGB24:
+        return 24;
+
+      default:
+        return 0;
+    }
+}
+
+/****************************************************************************
+ * Name: screenshot_start
+ *
+ * Description:
+ *   Prepare the TIFF structure and start the output file.  The file is
+ *   written in a single pass, so no temporary files are needed.  Images
+ *   with whole bytes per pixel are written in strips of up to
+ *   CONFIG_SCREENSHOT_BLOCKROWS rows, all others one row per strip.
+ *
+ ****************************************************************************/
+
+static int screenshot_start(FAR struct tiff_info_s *info,
+                            FAR const char *filename, uint8_t colorfmt,
+                            nxgl_coord_t width, nxgl_coord_t height)
+{
+  int bpp = screenshot_bpp(colorfmt);
+  int ret;
+
+  if (bpp == 0)
+    {
+      fprintf(stderr, "Unsupported color format: %d\n", colorfmt);
+      return -ENOSYS;
+    }
+
+  memset(info, 0, sizeof(struct tiff_info_s));
+  info->outfile   = filename;
+  info->colorfmt  = colorfmt;
+  info->rps       = bpp < 8 ? 1 : CONFIG_SCREENSHOT_BLOCKROWS;
+  info->imgwidth  = width;
+  info->imgheight = height;
+  info->iobuffer  = malloc(CONFIG_SCREENSHOT_IOSIZE);
+  info->iosize    = CONFIG_SCREENSHOT_IOSIZE;
+
+  if (info->rps > height)
+    {
+      info->rps = height;
+    }
+
+  if (info->iobuffer == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ret = tiff_initialize(info);
+  if (ret < 0)
+    {
+      printf("tiff_initialize() failed: %d\n", ret);
+      free(info->iobuffer);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: screenshot_finish
+ *
+ * Description:
+ *   Complete the output file and release the TIFF resources.
+ *
+ ****************************************************************************/
+
+static int screenshot_finish(FAR struct tiff_info_s *info)
+{
+  int ret;
+
+  ret = tiff_finalize(info);
+  if (ret < 0)
+    {
+      printf("tiff_finalize() failed: %d\n", ret);
+    }
+
+  free(info->iobuffer);
+  return ret;
+}
+
+#ifdef CONFIG_VIDEO_FB
+/****************************************************************************
+ * Name: save_fbscreenshot
+ *
+ * Description:
+ *   Save the content of a framebuffer device to a tif file.  The
+ *   framebuffer is memory mapped and each strip is handed to the TIFF
+ *   library directly from the framebuffer memory when the rows are
+ *   contiguous.
+ *
+ ****************************************************************************/
+
+static int save_fbscreenshot(FAR const char *filename,
+                             FAR const char *fbdev)
 {
-  FAR char *p = strrchr(filename, '.');
-  int len = strlen(filename);
+  struct fb_videoinfo_s vinfo;
+  struct fb_planeinfo_s pinfo;
+  struct tiff_info_s info;
+  FAR uint8_t *strip = NULL;
+  FAR uint8_t *fbmem;
+  size_t rowsize;
+  int row;
+  int ret;
+  int fd;
+
+  fd = open(fbdev, O_RDONLY);
+  if (fd < 0)
+    {
+      perror("open");
+      return 1;
+    }
 
-  if (p != NULL)
+  memset(&pinfo, 0, sizeof(pinfo));
+  if (ioctl(fd, FBIOGET_VIDEOINFO, (unsigned long)((uintptr_t)&vinfo)) < 0 ||
+      ioctl(fd, FBIOGET_PLANEINFO, (unsigned long)((uintptr_t)&pinfo)) < 0)
     {
-      len = p - filename;
+      perror("ioctl");
+      close(fd);
+      return 1;
     }
 
-  if (len > size)
+  fbmem = mmap(NULL, pinfo.fblen, PROT_READ, MAP_SHARED | MAP_FILE, fd, 0);
+  if (fbmem == MAP_FAILED)
     {
-      len = size - strlen(newext);
+      perror("mmap");
+      close(fd);
+      return 1;
     }
 
-  strlcpy(dest, filename, size);
-  strlcpy(dest + len, newext, size - len);
+  fbmem += pinfo.yoffset * pinfo.stride;
+
+  ret = screenshot_start(&info, filename, vinfo.fmt, vinfo.xres,
+                         vinfo.yres);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  /* The framebuffer rows can only be passed on as they are if there is no
+   * padding between them.  Otherwise, each strip is gathered first.
+   */
+
+  rowsize = (vinfo.xres * screenshot_bpp(vinfo.fmt) + 7) >> 3;
+  if (pinfo.stride != rowsize && info.rps > 1)
+    {
+      strip = malloc(rowsize * info.rps);
+      if (strip == NULL)
+        {
+          tiff_abort(&info);
+          free(info.iobuffer);
+          ret = -ENOMEM;
+          goto errout;
+        }
+    }
+
+  for (row = 0; row < vinfo.yres; row += info.rps)
+    {
+      FAR const uint8_t *src = fbmem + row * pinfo.stride;
+
+      if (strip != NULL)
+        {
+          int nrows = vinfo.yres - row;
+          int i;
+
+          if (nrows > info.rps)
+            {
+              nrows = info.rps;
+            }
+
+          for (i = 0; i < nrows; i++)
+            {
+              memcpy(strip + i * rowsize, src + i * pinfo.stride, rowsize);
+            }
+
+          src = strip;
+        }
+
+      ret = tiff_addstrip(&info, src);
+      if (ret < 0)
+        {
+          printf("tiff_addstrip() #%d failed: %d\n", row / info.rps, ret);
+          free(info.iobuffer);
+          goto errout;
+        }
+    }
+
+  ret = screenshot_finish(&info);
+
+errout:
+  free(strip);
+  munmap(fbmem - pinfo.yoffset * pinfo.stride, pinfo.fblen);
+  close(fd);
+  return ret < 0 ? 1 : 0;
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -122,14 +338,10 @@ int save_screenshot(FAR const char *filename)
   FAR uint8_t *strip;
   NXHANDLE server;
   NXWINDOW window;
-  char tempf1[64];
-  char tempf2[64];
+  size_t stride;
   int row;
   int ret;
 
-  replace_extension(filename, ".tm1", tempf1, sizeof(tempf1));
-  replace_extension(filename, ".tm2", tempf2, sizeof(tempf2));
-
   /* Connect to NX server */
 
   server = nx_connect();
@@ -175,33 +387,28 @@ int save_screenshot(FAR const char *filename)
 
   nx_setsize(window, &size);
 
-  /* Configure the TIFF structure */
-
-  memset(&info, 0, sizeof(struct tiff_info_s));
-  info.outfile   = filename;
-  info.tmpfile1  = tempf1;
-  info.tmpfile2  = tempf2;
-  info.colorfmt  = CONFIG_SCREENSHOT_FORMAT;
-  info.rps       = 1;
-  info.imgwidth  = size.w;
-  info.imgheight = size.h;
-  info.iobuffer  = (uint8_t *)malloc(300);
-  info.iosize    = 300;
-
-  /* Initialize the TIFF library */
+  /* Configure the TIFF structure and start the output file */
 
-  ret = tiff_initialize(&info);
+  ret = screenshot_start(&info, filename, CONFIG_SCREENSHOT_FORMAT,
+                         size.w, size.h);
   if (ret < 0)
     {
-      printf("tiff_initialize() failed: %d\n", ret);
-      return 1;
+      goto errout;
     }
 
-  /* Add each strip to the TIFF file */
+  /* Read a whole strip of rows at a time and add it to the TIFF file */
 
-  strip = malloc(size.w * 3);
+  stride = (size.w * screenshot_bpp(CONFIG_SCREENSHOT_FORMAT) + 7) >> 3;
+  strip  = malloc(stride * info.rps);
+  if (strip == NULL)
+    {
+      tiff_abort(&info);
+      free(info.iobuffer);
+      ret = -ENOMEM;
+      goto errout;
+    }
 
-  for (row = 0; row < size.h; row++)
+  for (row = 0; row < size.h; row += info.rps)
     {
       struct nxgl_rect_s rect =
       {
@@ -209,16 +416,21 @@ int save_screenshot(FAR const char *filename)
           0, row
         },
         {
-          size.w - 1, row
+          size.w - 1, row + info.rps - 1
         }
       };
 
-      nx_getrectangle(window, &rect, 0, strip, 0);
+      if (rect.pt2.y >= size.h)
+        {
+          rect.pt2.y = size.h - 1;
+        }
+
+      nx_getrectangle(window, &rect, 0, strip, stride);
 
       ret = tiff_addstrip(&info, strip);
       if (ret < 0)
         {
-          printf("tiff_addstrip() #%d failed: %d\n", row, ret);
+          printf("tiff_addstrip() #%d failed: %d\n", row / info.rps, ret);
           break;
         }
     }
@@ -227,17 +439,20 @@ int save_screenshot(FAR const char *filename)
 
   /* Then finalize the TIFF file */
 
-  ret = tiff_finalize(&info);
   if (ret < 0)
     {
-      printf("tiff_finalize() failed: %d\n", ret);
+      free(info.iobuffer);
+    }
+  else
+    {
+      ret = screenshot_finish(&info);
     }
 
-  free(info.iobuffer);
+errout:
   nx_closewindow(window);
   nx_disconnect(server);
 
-  return 0;
+  return ret < 0 ? 1 : 0;
 }
 
 /****************************************************************************
@@ -250,9 +465,20 @@ int save_screenshot(FAR const char *filename)
 
 int main(int argc, FAR char *argv[])
 {
+#ifdef CONFIG_VIDEO_FB
+  if (argc == 4 && strcmp(argv[1], "-d") == 0)
+    {
+      return save_fbscreenshot(argv[3], argv[2]);
+    }
+#endif
+
   if (argc != 2)
     {
+#ifdef CONFIG_VIDEO_FB
+      fprintf(stderr, "Usage: screenshot [-d /dev/fbN] file.tif\n");
+#else
       fprintf(stderr, "Usage: screenshot file.tif\n");
+#endif
       return 1;
     }
 
@@ -55,24 +55,25 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: tiff_addstrip
+ * Name: tiff_convstrip
  *
  * Description:
- *   Convert an RGB565 strip to an RGB888 strip and write it to tmpfile2.
- *
- *   Add an image data strip.  The size of the strip in pixels must be equal
- *   to the RowsPerStrip x ImageWidth values that were provided to
- *   tiff_initialize().
+ *   Convert an RGB565 strip to an RGB888 strip and write it to a file.
  *
  * Input Parameters:
- *   info    - A pointer to the caller allocated parameter passing/TIFF state instance.
- *   buffer  - A buffer containing a single row of data.
+ *   info    - A pointer to the caller allocated parameter passing/TIFF state
+ *             instance.
+ *   fd      - The file to write the strip data to.
+ *   strip   - A buffer containing the RGB565 strip data.
+ *   npixels - The number of pixels in the strip.
  *
  * Returned Value:
  *   Zero (OK) on success.  A negated errno value on failure.
  *
  ****************************************************************************/
-int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
+
+static int tiff_convstrip(FAR struct tiff_info_s *info, int fd,
+                          FAR const uint8_t *strip, size_t npixels)
 {
 #ifdef CONFIG_DEBUG_GRAPHICS
   size_t ntotal;
@@ -82,7 +83,7 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
   FAR uint8_t *dest;
   uint16_t rgb565;
   int ret;
-  int i;
+  size_t i;
 
   DEBUGASSERT(info->iobuffer != NULL);
 
@@ -95,7 +96,7 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
   ntotal = 0;
 #endif
 
-  for (i = 0; i < info->pps; i++)
+  for (i = 0; i < npixels; i++)
     {
       /* Convert RGB565 to RGB888 */
 
@@ -111,11 +112,11 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
       ntotal += 3;
 #endif
 
-      /* Flush the conversion buffer to tmpfile2 when it becomes full */
+      /* Flush the conversion buffer to the file when it becomes full */
 
       if (nbytes > (info->iosize-3))
         {
-          ret = tiff_write(info->tmp2fd, info->iobuffer, nbytes);
+          ret = tiff_write(fd, info->iobuffer, nbytes);
           if (ret < 0)
             {
               return ret;
@@ -128,15 +129,86 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
         }
     }
 
-  /* Flush any buffer data to tmpfile2 */
+  /* Flush any buffer data to the file */
 
-  ret = tiff_write(info->tmp2fd, info->iobuffer, nbytes);
+  ret = tiff_write(fd, info->iobuffer, nbytes);
 #ifdef CONFIG_DEBUG_GRAPHICS
-  DEBUGASSERT(ntotal == info->bps);
+  DEBUGASSERT(ntotal == 3 * npixels);
 #endif
   return ret;
 }
 
+/****************************************************************************
+ * Name: tiff_putstrip
+ *
+ * Description:
+ *   Write the strip data to a file, converting it if necessary.
+ *
+ ****************************************************************************/
+
+static int tiff_putstrip(FAR struct tiff_info_s *info, int fd,
+                         FAR const uint8_t *strip, size_t npixels)
+{
+  /* Add the new strip based on the color format.  For FB_FMT_RGB16_565,
+   * will have to perform a conversion to RGB888.
+   */
+
+  if (info->colorfmt == FB_FMT_RGB16_565)
+    {
+      return tiff_convstrip(info, fd, strip, npixels);
+    }
+
+  /* For other formats, it is a simple write using the number of bytes per
+   * strip
+   */
+
+  return tiff_write(fd, strip, tiff_stripbytes(info, npixels));
+}
+
+/****************************************************************************
+ * Name: tiff_addstrip_singlepass
+ *
+ * Description:
+ *   Add an image data strip directly to the output file.  The strip offsets
+ *   and byte counts were already written by tiff_initialize().
+ *
+ ****************************************************************************/
+
+static int tiff_addstrip_singlepass(FAR struct tiff_info_s *info,
+                                    FAR const uint8_t *strip)
+{
+  ssize_t newsize;
+  size_t npixels;
+  int ret;
+
+  if (info->nstrips >= tiff_nstrips(info))
+    {
+      gerr("ERROR: Too many strips\n");
+      return -E2BIG;
+    }
+
+  npixels = tiff_strippixels(info, info->nstrips);
+  ret = tiff_putstrip(info, info->outfd, strip, npixels);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  info->outsize += tiff_stripbytes(info, npixels);
+
+  /* Pad the outfile as necessary achieve word alignment */
+
+  newsize = tiff_wordalign(info->outfd, info->outsize);
+  if (newsize < 0)
+    {
+      return (int)newsize;
+    }
+
+  info->outsize = (size_t)newsize;
+  info->nstrips++;
+  return OK;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -147,7 +219,8 @@ int tiff_convstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
  * Description:
  *   Add an image data strip.  The size of the strip in pixels must be equal
  *   to the RowsPerStrip x ImageWidth values that were provided to
- *   tiff_initialize().
+ *   tiff_initialize().  When the file is written in a single pass, the last
+ *   strip only holds the remaining rows.
  *
  * Input Parameters:
  *   info    - A pointer to the caller allocated parameter passing/TIFF state instance.
@@ -163,22 +236,18 @@ int tiff_addstrip(FAR struct tiff_info_s *info, FAR const uint8_t *strip)
   ssize_t newsize;
   int ret;
 
-  /* Add the new strip based on the color format.  For FB_FMT_RGB16_565,
-   * will have to perform a conversion to RGB888.
-   */
-
-  if (info->colorfmt == FB_FMT_RGB16_565)
+  if (TIFF_ISSINGLEPASS(info))
     {
-      ret = tiff_convstrip(info, strip);
-    }
-
-  /* For other formats, it is a simple write using the number of bytes per strip */
+      ret = tiff_addstrip_singlepass(info, strip);
+      if (ret < 0)
+        {
+          goto errout;
+        }
 
-  else
-    {
-      ret = tiff_write(info->tmp2fd, strip, info->bps);
+      return OK;
     }
 
+  ret = tiff_putstrip(info, info->tmp2fd, strip, info->pps);
   if (ret < 0)
     {
       goto errout;
@@ -169,8 +169,11 @@ static void tiff_cleanup(FAR struct tiff_info_s *info)
 
   /* And remove the temporary files */
 
-  unlink(info->tmpfile1);
-  unlink(info->tmpfile2);
+  if (!TIFF_ISSINGLEPASS(info))
+    {
+      unlink(info->tmpfile1);
+      unlink(info->tmpfile2);
+    }
 }
 
 /****************************************************************************
@@ -218,8 +221,26 @@ int tiff_finalize(FAR struct tiff_info_s *info)
    *    no fixups are required.
    */
 
-  DEBUGASSERT(info && info->outfd >= 0 &&
-              info->tmp1fd >= 0 && info->tmp2fd >= 0);
+  /* A file written in a single pass is already complete, provided that all
+   * of the strips announced by tiff_initialize() were added.
+   */
+
+  DEBUGASSERT(info && info->outfd >= 0);
+  if (TIFF_ISSINGLEPASS(info))
+    {
+      if (info->nstrips != tiff_nstrips(info))
+        {
+          gerr("ERROR: Only %d of %d strips added\n",
+               info->nstrips, tiff_nstrips(info));
+          ret = -EINVAL;
+          goto errout;
+        }
+
+      tiff_cleanup(info);
+      return OK;
+    }
+
+  DEBUGASSERT(info->tmp1fd >= 0 && info->tmp2fd >= 0);
   DEBUGASSERT((info->outsize & 3) == 0 && (info->tmp1size & 3) == 0);
 
   /* Fix-up the count value in the StripByteCounts IFD entry in the outfile.
@@ -416,6 +416,69 @@ static int tiff_datetime(FAR char *timbuf, unsigned int buflen)
   return OK;
 }
 
+/****************************************************************************
+ * Name: tiff_putstripinfo
+ *
+ * Description:
+ *   Write the StripByteCounts and StripOffsets values of a file that is
+ *   written in a single pass.  The strip data follows immediately.
+ *
+ * Input Parameters:
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *
+ * Returned Value:
+ *   Zero (OK) on success.  A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static int tiff_putstripinfo(FAR struct tiff_info_s *info)
+{
+  nxgl_coord_t nstrips = tiff_nstrips(info);
+  size_t maxvalues = info->iosize >> 2;
+  uint32_t stripoff;
+  int pass;
+  int ret;
+  int i;
+  int j;
+
+  DEBUGASSERT(info->iobuffer != NULL && maxvalues > 0);
+
+  /* First pass: byte counts, second pass: offsets.  The values are
+   * gathered in the I/O buffer and written in blocks.
+   */
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      stripoff = info->filefmt->sbcoffset + 8 * nstrips;
+
+      for (i = 0; i < nstrips; )
+        {
+          for (j = 0; j < maxvalues && i < nstrips; j++, i++)
+            {
+              size_t nbytes = tiff_stripbytes(info,
+                                              tiff_strippixels(info, i));
+
+              tiff_put32(&info->iobuffer[j << 2],
+                         pass == 0 ? nbytes : stripoff);
+
+              /* Each strip is padded to word alignment */
+
+              stripoff += (nbytes + 3) & ~3;
+            }
+
+          ret = tiff_write(info->outfd, info->iobuffer, j << 2);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  info->outsize = info->filefmt->sbcoffset + 8 * nstrips;
+  return OK;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -436,6 +499,7 @@ static int tiff_datetime(FAR char *timbuf, unsigned int buflen)
 
 int tiff_initialize(FAR struct tiff_info_s *info)
 {
+  nxgl_coord_t nstrips = 0;
   uint16_t val16;
 #ifdef CONFIG_DEBUG_TIFFOFFSETS
   off_t offset = 0;
@@ -443,10 +507,14 @@ int tiff_initialize(FAR struct tiff_info_s *info)
   char timbuf[TIFF_DATETIME_STRLEN + 8];
   int ret = -EINVAL;
 
-  DEBUGASSERT(info && info->outfile && info->tmpfile1 && info->tmpfile2);
+  DEBUGASSERT(info && info->outfile &&
+              (info->tmpfile1 == NULL) == (info->tmpfile2 == NULL));
 
   /* Open all output files */
 
+  info->tmp1fd = -1;
+  info->tmp2fd = -1;
+
   info->outfd = open(info->outfile, O_RDWR|O_CREAT|O_TRUNC, 0666);
   if (info->outfd < 0)
     {
@@ -455,20 +523,25 @@ int tiff_initialize(FAR struct tiff_info_s *info)
       goto errout;
     }
 
-  info->tmp1fd = open(info->tmpfile1, O_RDWR|O_CREAT|O_TRUNC, 0666);
-  if (info->tmp1fd < 0)
-    {
-      gerr("ERROR: Failed to open %s for reading/writing: %d\n",
-           info->tmpfile1, errno);
-      goto errout;
-    }
+  /* A file written in a single pass needs no temporary files */
 
-  info->tmp2fd = open(info->tmpfile2, O_RDWR|O_CREAT|O_TRUNC, 0666);
-  if (info->tmp2fd < 0)
+  if (!TIFF_ISSINGLEPASS(info))
     {
-      gerr("ERROR: Failed to open %s for reading/writing: %d\n",
-           info->tmpfile2, errno);
-      goto errout;
+      info->tmp1fd = open(info->tmpfile1, O_RDWR|O_CREAT|O_TRUNC, 0666);
+      if (info->tmp1fd < 0)
+        {
+          gerr("ERROR: Failed to open %s for reading/writing: %d\n",
+               info->tmpfile1, errno);
+          goto errout;
+        }
+
+      info->tmp2fd = open(info->tmpfile2, O_RDWR|O_CREAT|O_TRUNC, 0666);
+      if (info->tmp2fd < 0)
+        {
+          gerr("ERROR: Failed to open %s for reading/writing: %d\n",
+               info->tmpfile2, errno);
+          goto errout;
+        }
     }
 
   /* Make some decisions using the color format.  Only the following are
@@ -651,7 +724,23 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    */
 
   tiff_checkoffs(offset, info->filefmt->soifdoffset);
-  ret = tiff_putifdentry(info, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG, 0, 0);
+  if (TIFF_ISSINGLEPASS(info))
+    {
+      /* The offsets follow the byte counts.  A single value is stored in
+       * the IFD entry itself.
+       */
+
+      nstrips = tiff_nstrips(info);
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG,
+                             nstrips, info->filefmt->sbcoffset +
+                             (nstrips > 1 ? 4 : 8) * nstrips);
+    }
+  else
+    {
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPOFFSETS, IFD_FIELD_LONG,
+                             0, 0);
+    }
+
   if (ret < 0)
     {
       goto errout;
@@ -697,7 +786,20 @@ int tiff_initialize(FAR struct tiff_info_s *info)
    */
 
   tiff_checkoffs(offset, info->filefmt->sbcifdoffset);
-  ret = tiff_putifdentry(info, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG, 0, info->filefmt->sbcoffset);
+  if (TIFF_ISSINGLEPASS(info))
+    {
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG,
+                             nstrips, nstrips > 1 ?
+                             info->filefmt->sbcoffset :
+                             tiff_stripbytes(info,
+                                             tiff_strippixels(info, 0)));
+    }
+  else
+    {
+      ret = tiff_putifdentry(info, IFD_TAG_STRIPCOUNTS, IFD_FIELD_LONG, 0,
+                             info->filefmt->sbcoffset);
+    }
+
   if (ret < 0)
     {
       goto errout;
@@ -891,6 +993,20 @@ int tiff_initialize(FAR struct tiff_info_s *info)
 
   tiff_checkoffs(offset, info->filefmt->sbcoffset);
   info->outsize = info->filefmt->sbcoffset;
+
+  /* In a single pass file, the strip byte counts and offsets are known
+   * now and the strip data follows them.
+   */
+
+  if (TIFF_ISSINGLEPASS(info))
+    {
+      ret = tiff_putstripinfo(info);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+    }
+
   return OK;
 
 errout:
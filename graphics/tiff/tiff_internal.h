@@ -64,6 +64,14 @@
 #define IMGFLAGS_ISRGB(f) \
   (((f) & IMGFLAGS_FMT_RGB24) != 0)
 
+/* Single pass output *******************************************************/
+
+/* Without temporary files the whole file layout is computed up front and
+ * strips are written directly to the output file.
+ */
+
+#define TIFF_ISSINGLEPASS(i)   ((i)->tmpfile1 == NULL)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -191,6 +199,62 @@ int tiff_putstring(int fd, FAR const char *string, int len);
 
 ssize_t tiff_wordalign(int fd, size_t size);
 
+/****************************************************************************
+ * Name: tiff_nstrips
+ *
+ * Description:
+ *  Return the number of strips needed to hold the whole image.
+ *
+ * Input Parameters:
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *
+ * Returned Value:
+ *   The number of strips.
+ *
+ ****************************************************************************/
+
+nxgl_coord_t tiff_nstrips(FAR const struct tiff_info_s *info);
+
+/****************************************************************************
+ * Name: tiff_strippixels
+ *
+ * Description:
+ *  Return the number of pixels in a strip.  This is the pixels per strip
+ *  value except for a short last strip.
+ *
+ * Input Parameters:
+ *   info  - A pointer to the caller allocated parameter passing/TIFF state
+ *           instance.
+ *   strip - The index of the strip
+ *
+ * Returned Value:
+ *   The number of pixels in the strip.
+ *
+ ****************************************************************************/
+
+size_t tiff_strippixels(FAR const struct tiff_info_s *info,
+                        nxgl_coord_t strip);
+
+/****************************************************************************
+ * Name: tiff_stripbytes
+ *
+ * Description:
+ *  Return the number of bytes in the output file needed for a number of
+ *  pixels in the image color format.
+ *
+ * Input Parameters:
+ *   info    - A pointer to the caller allocated parameter passing/TIFF state
+ *             instance.
+ *   npixels - The number of pixels
+ *
+ * Returned Value:
+ *   The number of bytes.
+ *
+ ****************************************************************************/
+
+size_t tiff_stripbytes(FAR const struct tiff_info_s *info, size_t npixels);
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
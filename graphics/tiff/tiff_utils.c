@@ -366,3 +366,90 @@ ssize_t tiff_wordalign(int fd, size_t size)
     }
   return size;
 }
+
+/****************************************************************************
+ * Name: tiff_nstrips
+ *
+ * Description:
+ *  Return the number of strips needed to hold the whole image.
+ *
+ * Input Parameters:
+ *   info - A pointer to the caller allocated parameter passing/TIFF state
+ *          instance.
+ *
+ * Returned Value:
+ *   The number of strips.
+ *
+ ****************************************************************************/
+
+nxgl_coord_t tiff_nstrips(FAR const struct tiff_info_s *info)
+{
+  return (info->imgheight + info->rps - 1) / info->rps;
+}
+
+/****************************************************************************
+ * Name: tiff_strippixels
+ *
+ * Description:
+ *  Return the number of pixels in a strip.  This is the pixels per strip
+ *  value except for a short last strip.
+ *
+ * Input Parameters:
+ *   info  - A pointer to the caller allocated parameter passing/TIFF state
+ *           instance.
+ *   strip - The index of the strip
+ *
+ * Returned Value:
+ *   The number of pixels in the strip.
+ *
+ ****************************************************************************/
+
+size_t tiff_strippixels(FAR const struct tiff_info_s *info,
+                        nxgl_coord_t strip)
+{
+  nxgl_coord_t nrows = info->imgheight - strip * info->rps;
+
+  if (nrows > info->rps)
+    {
+      nrows = info->rps;
+    }
+
+  return (size_t)nrows * info->imgwidth;
+}
+
+/****************************************************************************
+ * Name: tiff_stripbytes
+ *
+ * Description:
+ *  Return the number of bytes in the output file needed for a number of
+ *  pixels in the image color format.
+ *
+ * Input Parameters:
+ *   info    - A pointer to the caller allocated parameter passing/TIFF state
+ *             instance.
+ *   npixels - The number of pixels
+ *
+ * Returned Value:
+ *   The number of bytes.
+ *
+ ****************************************************************************/
+
+size_t tiff_stripbytes(FAR const struct tiff_info_s *info, size_t npixels)
+{
+  if (IMGFLAGS_ISBILEV(info->imgflags))
+    {
+      return (npixels + 7) >> 3;
+    }
+  else if (IMGFLAGS_ISGREY4(info->imgflags))
+    {
+      return (npixels + 1) >> 1;
+    }
+  else if (IMGFLAGS_ISGREY8(info->imgflags))
+    {
+      return npixels;
+    }
+  else
+    {
+      return 3 * npixels;
+    }
+}
@@ -27,6 +27,8 @@
  * Included Files
  ****************************************************************************/
 
+#include <stdint.h>
+
 #include <audioutils/fmsynth_eg.h>
 
 /****************************************************************************
@@ -41,6 +43,14 @@
 #define FMSYNTH_OPFUNC_SQUARE   (3)
 #define FMSYNTH_OPFUNC_NUM      (4)
 
+/* Number of samples an operator renders per call of fmsynthop_render() */
+
+#ifdef CONFIG_AUDIOUTILS_FMSYNTH_BLOCKSIZE
+#  define FMSYNTH_BLOCKSIZE CONFIG_AUDIOUTILS_FMSYNTH_BLOCKSIZE
+#else
+#  define FMSYNTH_BLOCKSIZE (32)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -51,6 +61,7 @@ typedef struct fmsynth_op_s
 {
   FAR fmsynth_eg_t *eg;
   opfunc_t wavegen;
+  int wavetype;
   struct fmsynth_op_s *cascadeop;
   struct fmsynth_op_s *parallelop;
 
@@ -62,8 +73,11 @@ typedef struct fmsynth_op_s
 
   float freq_rate;
   float sound_freq;
-  float delta_phase;
-  float current_phase;
+
+  /* Phase accumulator, a full turn is 2^32 */
+
+  uint32_t delta_phase;
+  uint32_t current_phase;
 } fmsynth_op_t;
 
 /****************************************************************************
@@ -96,6 +110,8 @@ void fmsynthop_set_soundfreqrate(FAR fmsynth_op_t *op, float rate);
 void fmsynthop_start(FAR fmsynth_op_t *op);
 void fmsynthop_stop(FAR fmsynth_op_t *op);
 int fmsynthop_operate(FAR fmsynth_op_t *op, int phase_time);
+int fmsynthop_render(FAR fmsynth_op_t *op, FAR int *out, int nsamples,
+                     int phase_time);
 
 #ifdef __cplusplus
 }
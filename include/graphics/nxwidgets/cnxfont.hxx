@@ -41,6 +41,18 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
+/**
+ * Glyph widths are cached in a flat table for the ASCII range.
+ */
+
+#define NXWIDGETS_FONT_NWIDTHS   128
+
+/**
+ * Number of hash buckets used to look up rendered glyphs.
+ */
+
+#define NXWIDGETS_GLYPH_NBUCKETS 32
+
 /****************************************************************************
  * Implementation Classes
  ****************************************************************************/
@@ -64,6 +76,46 @@ namespace NXWidgets
     FAR const struct nx_font_s *m_pFontSet; /** < The font set metrics */
     nxgl_mxpixel_t m_fontColor;             /**< Color to draw the font with when rendering. */
     nxgl_mxpixel_t m_transparentColor;      /**< Background color that should not be rendered. */
+    uint8_t m_charWidth[NXWIDGETS_FONT_NWIDTHS]; /**< ASCII glyph widths */
+
+#if CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+    /**
+     * A glyph rendered in the display pixel format.  The pixel data
+     * immediately follows the structure.
+     */
+
+    struct SGlyph
+    {
+      FAR struct SGlyph *hashNext;          /**< Next glyph in the bucket */
+      FAR struct SGlyph *lruPrev;           /**< More recently used glyph */
+      FAR struct SGlyph *lruNext;           /**< Less recently used glyph */
+      nxgl_mxpixel_t     color;             /**< Foreground color */
+      nxgl_mxpixel_t     background;        /**< Background color */
+      uint32_t           size;              /**< Allocation size in bytes */
+      nxwidget_char_t    letter;            /**< The character */
+      uint8_t            width;             /**< Width in pixels */
+      bool               blank;             /**< True: no foreground pixels */
+    };
+
+    FAR struct SGlyph *m_glyphHash[NXWIDGETS_GLYPH_NBUCKETS]; /**< Lookup */
+    FAR struct SGlyph *m_lruHead;           /**< Most recently used glyph */
+    FAR struct SGlyph *m_lruTail;           /**< Least recently used glyph */
+    size_t m_glyphCacheUsed;                /**< Bytes held by the cache */
+
+    /**
+     * Unlink a glyph from the LRU list.
+     *
+     * @param glyph The glyph to unlink.
+     */
+
+    void unlinkGlyph(FAR struct SGlyph *glyph);
+
+    /**
+     * Remove the least recently used glyph from the cache and free it.
+     */
+
+    void evictGlyph(void);
+#endif
 
   public:
 
@@ -83,7 +135,7 @@ namespace NXWidgets
      * CNxFont Destructor.
      */
 
-    ~CNxFont() { }
+    ~CNxFont(void);
 
     /**
      * Checks if supplied character is blank in the current font.
@@ -147,6 +199,31 @@ namespace NXWidgets
 
     void drawChar(FAR SBitmap *bitmap, nxwidget_char_t letter);
 
+    /**
+     * Get a character rendered in the current font color on the supplied
+     * background color.  Rendered glyphs are kept in a per-font cache of
+     * at most CONFIG_NXWIDGETS_GLYPHCACHE_SIZE bytes, least recently used
+     * glyphs being discarded first.  The returned bitmap is the height of
+     * the font and remains valid until the next call.
+     *
+     * @param letter The character to get.
+     * @param background The color of the pixels not covered by the glyph.
+     * @param bitmap The location to return the rendered glyph.
+     * @param blank The location to return true if the glyph has no
+     *   foreground pixels.
+     * @return True if the glyph was found or rendered into the cache.
+     *   False if the cache is disabled or the glyph does not fit.
+     */
+
+    bool getGlyph(nxwidget_char_t letter, nxgl_mxpixel_t background,
+                  FAR struct SBitmap *bitmap, FAR bool *blank);
+
+    /**
+     * Discard all rendered glyphs.
+     */
+
+    void flushGlyphCache(void);
+
     /**
      * Get the width of a string in pixels when drawn with this font.
      *
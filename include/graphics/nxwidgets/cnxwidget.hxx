@@ -137,6 +137,7 @@ namespace NXWidgets
       uint8_t erased          : 1;    /**< True if the widget is currently erased from the frame buffer. */
       uint8_t hidden          : 1;    /**< True if the widget is hidden. */
       uint8_t doubleClickable : 1;    /**< True if the widget can be double-clicked. */
+      uint8_t invalidated     : 1;    /**< True if the widget awaits a deferred repaint. */
     } Flags;
 
     /**
@@ -217,6 +218,15 @@ namespace NXWidgets
 
     void drawChildren(void);
 
+    /**
+     * Tell the widget control that the area currently occupied by this
+     * widget must be repainted by whatever lies underneath it.  Called
+     * before the widget is hidden, moved or resized.  Does nothing unless
+     * CONFIG_NXWIDGETS_DEFERRED_REDRAW is selected.
+     */
+
+    void exposeBounds(void);
+
     /**
      * Erase and remove the supplied child widget from this widget and
      * send it to the deletion queue.
@@ -1003,10 +1013,63 @@ namespace NXWidgets
 
     /**
      * Draws the visible regions of the widget and the widget's child widgets.
+     *
+     * With CONFIG_NXWIDGETS_DEFERRED_REDRAW this only invalidates the
+     * widget; the repaint happens on the next CWidgetControl::flushRedraw().
      */
 
     void redraw(void);
 
+    /**
+     * Mark the widget as needing a repaint.  Invalidations are coalesced
+     * by the CWidgetControl and painted on the next flushRedraw(), so a
+     * widget that changes several times per frame is painted once.
+     * Without CONFIG_NXWIDGETS_DEFERRED_REDRAW this is the same as
+     * redraw().
+     */
+
+    void invalidate(void);
+
+    /**
+     * Check if the widget is waiting for a deferred repaint.
+     *
+     * @return True if the widget has been invalidated.
+     */
+
+    inline bool isInvalidated(void) const
+    {
+      return m_flags.invalidated;
+    }
+
+    /**
+     * Immediately draw the widget and all of its children, clearing any
+     * pending invalidation.  For framework use only.
+     */
+
+    void paint(void);
+
+    /**
+     * Paint every invalidated widget in this widget's subtree together
+     * with any later sibling it overlaps.  For framework use only.
+     *
+     * @param area Set to the bounding rectangle of everything painted.
+     * @return True if anything was painted.
+     */
+
+    bool paintInvalidated(CRect &area);
+
+    /**
+     * Find the deepest visible widget in this subtree that completely
+     * covers the supplied rectangle, so that repainting it repaints the
+     * whole area.  For framework use only.
+     *
+     * @param rect The exposed rectangle.
+     * @return The covering widget, or NULL if this widget does not cover
+     *   the rectangle.
+     */
+
+    CNxWidget *findCoveringWidget(const CRect &rect);
+
     /**
      * Enables the widget.
      *
@@ -247,6 +247,16 @@ namespace NXWidgets
 
     bool getRun(nxgl_coord_t x, nxgl_coord_t y, nxgl_coord_t width,
                 FAR void *data);
+
+    /**
+     * Get a value that uniquely identifies the image content: the
+     * address of the LUT pointer in use within the constant bitmap
+     * description.
+     *
+     * @return The image key.
+     */
+
+    FAR const void *getCacheKey(void) const;
   };
 }
 
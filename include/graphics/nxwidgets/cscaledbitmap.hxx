@@ -52,6 +52,8 @@
 
 namespace NXWidgets
 {
+  struct SScaledImage;
+
   /**
    * Class for scaling layer for any bitmap that inherits from IBitMap
    */
@@ -65,6 +67,11 @@ namespace NXWidgets
     unsigned int       m_row;         /**< Row number of the first cached row */
     b16_t              m_xScale;      /**< X scale factor */
     b16_t              m_yScale;      /**< Y scale factor */
+    FAR uint16_t      *m_colIndex;    /**< Source column of each column */
+    FAR uint8_t       *m_colFrac;     /**< Weight of the next source column */
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
+    FAR struct SScaledImage *m_image; /**< The scaled image, may be shared */
+#endif
 
     /**
      * Read two rows into the row cache
@@ -75,31 +82,59 @@ namespace NXWidgets
     bool cacheRows(unsigned int row);
 
     /**
-     * Given an two RGB colors and a fractional value, return the scaled
-     * value between the two colors.
+     * Read one row of the contained bitmap into a row cache buffer.  The
+     * last pixel is repeated once past the end of the row so that the
+     * interpolation never has to check for the right edge.
      *
-     * @param incolor1 - The first color to be used
-     * @param incolor2 - The second color to be used
-     * @param fraction - The fractional value
-     * @param outcolor - The returned, scaled color
+     * @param row - The row number to read
+     * @param buffer - The row cache buffer
      */
 
-    bool scaleColor(FAR const struct rgbcolor_s &incolor1,
-                    FAR const struct rgbcolor_s &incolor2,
-                    b16_t fraction, FAR struct rgbcolor_s &outcolor);
+    bool readRow(unsigned int row, FAR uint8_t *buffer);
 
     /**
-     * Given an image row and a non-integer column offset, return the
-     * interpolated RGB color value corresponding to that position
+     * Scale a run of one row using only integer arithmetic.  Colors are
+     * interpolated between the two cached rows and between each column
+     * and the next, using the precomputed column tables.
      *
-     * @param row - The pointer to the row in the row cache to use
-     * @param column - The non-integer column offset
-     * @param outcolor - The returned, interpolated color
+     * @param x The offset into the scaled row
+     * @param y The scaled row number
+     * @param width The number of pixels to produce
+     * @param data The memory location in which to return the data
+     */
+
+    bool scaleRun(nxgl_coord_t x, nxgl_coord_t y, nxgl_coord_t width,
+                  FAR void *data);
+
+    /**
+     * Allocate the row cache and the column tables and read the first
+     * two rows of the contained bitmap.
      *
+     * @return True if the scaler is ready for use.
+     */
+
+    bool initScaler(void);
+
+    /**
+     * Free the row cache and the column tables.
+     */
+
+    void releaseScaler(void);
+
+#ifdef CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE
+    /**
+     * Find or create the fully scaled image, sharing it with any other
+     * CScaledBitmap that scales the same source image to the same size.
+     */
+
+    void attachImage(void);
+
+    /**
+     * Release the reference to the scaled image.
      */
 
-    bool rowColor(FAR uint8_t *row, b16_t column,
-                  FAR struct rgbcolor_s &outcolor);
+    void detachImage(void);
+#endif
 
     /**
      * Copy constructor is protected to prevent usage.
@@ -73,6 +73,19 @@ namespace NXWidgets
 
   class CWidgetControl
     {
+  public:
+    /**
+     * Repaint statistics.  Comparing paints against requests shows how
+     * much work CONFIG_NXWIDGETS_DEFERRED_REDRAW saves.
+     */
+
+    struct SRedrawStats
+    {
+      uint32_t requests;  /**< Number of redraw()/invalidate() calls */
+      uint32_t flushes;   /**< Number of flushRedraw() passes that painted */
+      uint32_t paints;    /**< Number of widgets actually drawn */
+    };
+
   protected:
     /**
      * Structure holding the status of the Mouse or Touchscreen.  There must
@@ -160,6 +173,15 @@ namespace NXWidgets
                                                        widgets. */
     volatile bool               m_haveGeometry;   /**< True: indicates that we
                                                        have valid geometry data. */
+    struct SRedrawStats         m_redrawStats;    /**< Repaint statistics */
+#ifdef CONFIG_NXWIDGETS_DEFERRED_REDRAW
+    bool                        m_redrawPending;  /**< True: invalidated widgets
+                                                       or areas await a flush */
+    uint8_t                     m_nDirty;         /**< Number of exposed areas */
+    CRect                       m_dirtyRects[CONFIG_NXWIDGETS_DIRTY_RECTS];
+                                                  /**< Exposed areas awaiting
+                                                       repaint */
+#endif
 #ifdef CONFIG_NXWIDGET_EVENTWAIT
     bool                        m_waiting;        /**< True: External logic waiting for
                                                        window event */
@@ -416,6 +438,7 @@ namespace NXWidgets
      *   pollMouseEvents(widget)
      *   pollKeyboardEvents()
      *   pollCursorControlEvents()
+     *   flushRedraw()
      *
      * @param widget.  Specific widget to poll.  Use NULL to run through
      *    of the widgets in the window.
@@ -424,6 +447,79 @@ namespace NXWidgets
 
     bool pollEvents(CNxWidget *widget = NULL);
 
+    /**
+     * Repaint everything that has been invalidated since the last flush.
+     * Invalidated widgets are drawn once however many times they changed,
+     * widgets that were not invalidated are skipped unless they overlap a
+     * repainted sibling.  pollEvents() calls this after processing input;
+     * logic that changes widgets outside of the event loop should call it
+     * once the changes for a frame are complete.  Does nothing unless
+     * CONFIG_NXWIDGETS_DEFERRED_REDRAW is selected.
+     *
+     * @return True if anything was painted.
+     */
+
+    bool flushRedraw(void);
+
+    /**
+     * Note that an invalidated widget awaits a repaint.  For framework
+     * use only.
+     */
+
+    void scheduleRedraw(void);
+
+    /**
+     * Mark an area of the window, in window coordinates, as needing to be
+     * repainted by the widgets underneath it, e.g. after a widget has been
+     * hidden or moved.  Overlapping areas are merged.  For framework use
+     * only.
+     *
+     * @param rect The exposed area.
+     */
+
+    void invalidateRect(const CRect &rect);
+
+    /**
+     * Count a redraw request.  For framework use only.
+     */
+
+    inline void countRedrawRequest(void)
+    {
+      m_redrawStats.requests++;
+    }
+
+    /**
+     * Count a widget paint.  For framework use only.
+     */
+
+    inline void countPaint(void)
+    {
+      m_redrawStats.paints++;
+    }
+
+    /**
+     * Get the repaint statistics collected since the control was created
+     * or since the last call to resetRedrawStats().
+     *
+     * @return The repaint statistics.
+     */
+
+    inline const struct SRedrawStats &getRedrawStats(void) const
+    {
+      return m_redrawStats;
+    }
+
+    /**
+     * Reset the repaint statistics.
+     */
+
+    inline void resetRedrawStats(void)
+    {
+      m_redrawStats.requests = 0;
+      m_redrawStats.flushes  = 0;
+      m_redrawStats.paints   = 0;
+    }
+
     /**
      * Swaps the depth of the supplied widget.
      * This function presumes that all child widgets are screens.
@@ -165,6 +165,20 @@ namespace NXWidgets
 
     virtual bool getRun(nxgl_coord_t x, nxgl_coord_t y, nxgl_coord_t width,
                         FAR void *data) = 0;
+
+    /**
+     * Get a value that uniquely identifies the image content, e.g. the
+     * address of a constant image description.  Bitmaps returning the
+     * same key must produce the same pixels, which allows derived images
+     * such as scaled copies to be shared.
+     *
+     * @return The image key or NULL if the content cannot be identified.
+     */
+
+    virtual FAR const void *getCacheKey(void) const
+    {
+      return (FAR const void *)0;
+    }
   };
 }
 
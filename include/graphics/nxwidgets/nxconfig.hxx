@@ -78,7 +78,8 @@
  *
  * CONFIG_NXWIDGETS_DEFAULT_FONTID - Default font ID.  Default: NXFONT_DEFAULT
  * CONFIG_NXWIDGETS_TNXARRAY_INITIALSIZE, CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT -
- *   Default dynamic array parameters.  Default: 16, 8
+ *   Initial dynamic array size and minimum growth increment.  Arrays grow
+ *   geometrically once they are larger than the increment.  Default: 16, 8
  *
  * CONFIG_NXWIDGETS_DEFAULT_BACKGROUNDCOLOR - Normal background color.  Default:
  *   MKRGB(148,189,215)
@@ -114,6 +115,24 @@
  * CONFIG_NXWIDGETS_CURSORCONTROL_SIZE - Size of incoming cursor control
  *   buffer, i.e., the maximum number of cursor controls that can between
  *   entered by NX polling cycles without losing data.  Default: 4
+ *
+ * Repaint behavior
+ *
+ * CONFIG_NXWIDGETS_DEFERRED_REDRAW - Widgets only invalidate themselves and
+ *   CWidgetControl::flushRedraw() repaints them once per frame.
+ * CONFIG_NXWIDGETS_DIRTY_RECTS - Number of exposed window areas tracked
+ *   between flushes before they are merged into one.  Default: 4
+ *
+ * Font behavior
+ *
+ * CONFIG_NXWIDGETS_GLYPHCACHE_SIZE - Per-font memory budget in bytes for
+ *   glyphs pre-rendered in the display pixel format.  Zero disables the
+ *   cache.  Not supported with 24 bpp.  Default: 0
+ *
+ * Bitmap behavior
+ *
+ * CONFIG_NXWIDGETS_SCALEDBITMAP_CACHE - Scale each CScaledBitmap once and
+ *   share the result between instances with the same source and size.
  */
 
 /* Prerequisites ************************************************************/
@@ -419,6 +438,29 @@
 #  define CONFIG_NXWIDGETS_CURSORCONTROL_SIZE 4
 #endif
 
+/**
+ * Number of exposed window areas tracked between repaint flushes.
+ */
+
+#ifndef CONFIG_NXWIDGETS_DIRTY_RECTS
+#  define CONFIG_NXWIDGETS_DIRTY_RECTS 4
+#endif
+
+/**
+ * Per-font memory budget for rendered glyphs.  The cache stores whole
+ * pixels, so packed 24 bpp displays are not supported.
+ */
+
+#ifndef CONFIG_NXWIDGETS_GLYPHCACHE_SIZE
+#  define CONFIG_NXWIDGETS_GLYPHCACHE_SIZE 0
+#endif
+
+#if CONFIG_NXWIDGETS_BPP == 24 && CONFIG_NXWIDGETS_GLYPHCACHE_SIZE > 0
+#  warning "The glyph cache does not support 24 bpp, disabling"
+#  undef CONFIG_NXWIDGETS_GLYPHCACHE_SIZE
+#  define CONFIG_NXWIDGETS_GLYPHCACHE_SIZE 0
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
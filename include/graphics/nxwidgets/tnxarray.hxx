@@ -74,6 +74,17 @@
  * Pre-Processor Definitions
  ****************************************************************************/
 
+/**
+ * Elements are moved rather than copied when the array is reallocated or
+ * shifted, if the compiler supports rvalue references.
+ */
+
+#if __cplusplus >= 201103L
+#  define TNXARRAY_MOVE(value) static_cast<T &&>(value)
+#else
+#  define TNXARRAY_MOVE(value) (value)
+#endif
+
 /****************************************************************************
  * Implementation Classes
  ****************************************************************************/
@@ -87,11 +98,9 @@
  * of the STL vector class without any of the overhead of including an STL
  * class.
  *
- * If the data to be stored will store a lot of data that will predominantly
- * be read sequentially, consider using the LinkedList class instead.  Resizing
- * the list is an expensive operation that will occur frequently when filling
- * the array with large amounts of data.  Adding new data to the linked list is
- * very inexpensive.
+ * The reserved size grows geometrically (it at least doubles when the array
+ * is full) so that adding n items one at a time costs O(n) in total.  Use
+ * reserve() when the final size is known in advance.
  */
 
 template <class T>
@@ -109,16 +118,24 @@ private:
   void reallocate(const int newSize);
 
   /**
-   * Resize the array if it is full.
+   * Make sure that there is room for count more items.
+   *
+   * @param count The number of items that will be added.
    */
 
-  void resize(void);
+  void resize(const int count = 1);
+
+  /**
+   * Move count items from src to dest.  The ranges may overlap.
+   */
+
+  static void moveItems(T *dest, T *src, const int count);
 
 public:
 
   /**
    * Constructor.  Creates an un-allocated array.  The array will
-   * be allocated when items are added to it or when preallocate()
+   * be allocated when items are added to it or when reserve()
    * is called.
    */
 
@@ -139,16 +156,13 @@ public:
   inline ~TNxArray();
 
   /**
-   * Set the initial size of the array.  Normally, the array is
-   * unallocated until the first data is pushed into the array.
-   * That works great for stacks and lists.  But if you want a
-   * array of uninitialized elements, then this method will
-   * preallocate the array for you.
+   * Make sure that the array can hold at least this many items without
+   * being reallocated.
    *
-   * @return The size of the array.
+   * @param reservedSize The number of items to allocate room for.
    */
 
-  void preallocate(void);
+  void reserve(const int reservedSize);
 
   /**
    * Get the size of the array.
@@ -158,6 +172,14 @@ public:
 
   inline const int size(void) const;
 
+  /**
+   * Get the number of items the array can hold without being reallocated.
+   *
+   * @return The reserved size of the array.
+   */
+
+  inline const int capacity(void) const;
+
   /**
    * Add a value to the end of the array.
    *
@@ -166,6 +188,25 @@ public:
 
   void push_back(const T &value);
 
+#if __cplusplus >= 201103L
+  /**
+   * Move a value to the end of the array.
+   *
+   * @param value The value to add to the array.
+   */
+
+  void push_back(T &&value);
+#endif
+
+  /**
+   * Add a default value to the end of the array and return it so that it
+   * can be filled in place instead of being copied into the array.
+   *
+   * @return The new value at the end of the array.
+   */
+
+  T &emplace_back(void);
+
   /**
    * Insert a value into the array.
    *
@@ -175,6 +216,18 @@ public:
 
   void insert(const int index, const T &value);
 
+  /**
+   * Insert several values into the array with a single shift of the
+   * following items.
+   *
+   * @param index The index to insert into.
+   * @param values The values to insert.  These must not be items of this
+   *   array.
+   * @param count The number of values to insert.
+   */
+
+  void insert(const int index, const T *values, const int count);
+
   /**
    * Remove the last element from the array.
    */
@@ -187,6 +240,16 @@ public:
 
   void erase(const int index);
 
+  /**
+   * Erase count values starting at the specified index with a single
+   * shift of the following items.
+   *
+   * @param index The index of the first value to erase.
+   * @param count The number of values to erase.
+   */
+
+  void erase(const int index, const int count);
+
   /**
    * Get a value at the specified location.  Does not perform bounds checking.
    * @param index The index of the desired value.
@@ -234,7 +297,7 @@ TNxArray<T>::TNxArray(int initialSize)
   m_size         = 0;       // Number of data items in use
   m_reservedSize = 0;       // Number of data items allocated
   m_data         = (T *)0;  // Allocated memory for data items
-  preallocate(initialSize); // Allocate the initial array
+  reserve(initialSize);     // Allocate the initial array
 }
 
 template <class T>
@@ -246,12 +309,24 @@ TNxArray<T>::~TNxArray()
     }
 }
 
+template <class T>
+void TNxArray<T>::reserve(const int reservedSize)
+{
+  reallocate(reservedSize);
+}
+
 template <class T>
 const int TNxArray<T>::size(void) const
 {
   return m_size;
 }
 
+template <class T>
+const int TNxArray<T>::capacity(void) const
+{
+  return m_reservedSize;
+}
+
 template <class T>
 void TNxArray<T>::push_back(const T &value)
 {
@@ -268,6 +343,27 @@ void TNxArray<T>::push_back(const T &value)
   m_size++;
 }
 
+#if __cplusplus >= 201103L
+template <class T>
+void TNxArray<T>::push_back(T &&value)
+{
+  resize();
+  m_data[m_size] = TNXARRAY_MOVE(value);
+  m_size++;
+}
+#endif
+
+template <class T>
+T &TNxArray<T>::emplace_back(void)
+{
+  resize();
+
+  // The slot may still hold a value that was popped or erased
+
+  m_data[m_size] = T();
+  return m_data[m_size++];
+}
+
 template <class T>
 void TNxArray<T>::pop_back(void)
 {
@@ -299,7 +395,7 @@ void TNxArray<T>::insert(const int index, const T &value)
 
   for (int i = m_size; i > index; i--)
     {
-      m_data[i] = m_data[i - 1];
+      m_data[i] = TNXARRAY_MOVE(m_data[i - 1]);
     }
 
   // Add data to array
@@ -311,12 +407,38 @@ void TNxArray<T>::insert(const int index, const T &value)
   m_size++;
 }
 
+template <class T>
+void TNxArray<T>::insert(const int index, const T *values, const int count)
+{
+  if (count <= 0)
+    {
+      return;
+    }
+
+  // Inserting past the end appends the values
+
+  int start = index < m_size ? index : m_size;
+
+  // Ensure the array is large enough, then open a gap for all of the new
+  // data at once
+
+  resize(count);
+  moveItems(&m_data[start + count], &m_data[start], m_size - start);
+
+  for (int i = 0; i < count; i++)
+    {
+      m_data[start + i] = values[i];
+    }
+
+  m_size += count;
+}
+
 template <class T>
 void TNxArray<T>::erase(const int index)
 {
   // Bounds check
 
-  if (index >= m_size)
+  if (index < 0 || index >= m_size)
     {
       return;
     }
@@ -325,7 +447,7 @@ void TNxArray<T>::erase(const int index)
 
   for (int i = index; i < m_size - 1; i++)
     {
-      m_data[i] = m_data[i + 1];
+      m_data[i] = TNXARRAY_MOVE(m_data[i + 1]);
     }
 
   // Remember we've removed a slot
@@ -333,6 +455,46 @@ void TNxArray<T>::erase(const int index)
   m_size--;
 }
 
+template <class T>
+void TNxArray<T>::erase(const int index, const int count)
+{
+  // Bounds check
+
+  if (index < 0 || index >= m_size || count <= 0)
+    {
+      return;
+    }
+
+  int end = m_size - index > count ? index + count : m_size;
+
+  // Shift all of the following data back over the erased values
+
+  moveItems(&m_data[index], &m_data[end], m_size - end);
+
+  // Remember we've removed the slots
+
+  m_size -= end - index;
+}
+
+template <class T>
+void TNxArray<T>::moveItems(T *dest, T *src, const int count)
+{
+  if (dest < src)
+    {
+      for (int i = 0; i < count; i++)
+        {
+          dest[i] = TNXARRAY_MOVE(src[i]);
+        }
+    }
+  else if (dest > src)
+    {
+      for (int i = count - 1; i >= 0; i--)
+        {
+          dest[i] = TNXARRAY_MOVE(src[i]);
+        }
+    }
+}
+
 template <class T>
 void TNxArray<T>::reallocate(const int newSize)
 {
@@ -344,17 +506,11 @@ void TNxArray<T>::reallocate(const int newSize)
 
       T *newData = new T[newSize];
 
-      // Copy old array contents to new the new array
-
-      for (int i = 0; i < m_reservedSize; i++)
-        {
-          newData[i] = m_data[i];
-        }
-
-      // Delete the old array (if there was one)
+      // Move the items in use to the new array
 
       if (m_data)
         {
+          moveItems(newData, m_data, m_size);
           delete [] m_data;
         }
 
@@ -366,22 +522,33 @@ void TNxArray<T>::reallocate(const int newSize)
 }
 
 template <class T>
-void TNxArray<T>::resize(void)
+void TNxArray<T>::resize(const int count)
 {
-  // Do we need to redim the array in order to add one more entry?
+  // Do we need to redim the array in order to add more entries?
 
-  if (m_reservedSize == m_size)
+  if (m_reservedSize - m_size < count)
     {
-      // We have filled the array, so resize it
+      // Grow geometrically so that repeated appends do not reallocate
+      // and move the whole array every few items
 
       int newSize = m_reservedSize;
-#if CONFIG_NXWIDGETS_TNXARRAY_INITIALSIZE != CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT
-      newSize += m_reservedSize ?
-                 CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT :
-                 CONFIG_NXWIDGETS_TNXARRAY_INITIALSIZE;
-#else
-      newSize += CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT;
-#endif
+      if (newSize == 0)
+        {
+          newSize = CONFIG_NXWIDGETS_TNXARRAY_INITIALSIZE;
+        }
+      else if (newSize < CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT)
+        {
+          newSize += CONFIG_NXWIDGETS_TNXARRAY_SIZEINCREMENT;
+        }
+      else
+        {
+          newSize *= 2;
+        }
+
+      if (newSize < m_size + count)
+        {
+          newSize = m_size + count;
+        }
 
       // Re-allocate the array
 
@@ -421,6 +588,8 @@ void TNxArray<T>::clear()
   m_size = 0;
 }
 
+#undef TNXARRAY_MOVE
+
 #endif // __cplusplus
 
 #endif // __APPS_INCLUDE_GRAPHICS_NXWIDGETS_TNXARRAY_HXX
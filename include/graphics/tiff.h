@@ -290,6 +290,14 @@ struct tiff_info_s
    * (tmpfile1) will be used to hold the strip image data and the other
    * (tmpfile2) will be used to hold strip offset and count information.
    *
+   * If both temporary file paths are NULL, the file is written in a single
+   * pass instead:  The strip offsets and byte counts are computed from
+   * imgheight and rps by tiff_initialize() and the strip data is written
+   * directly to the output file.  No temporary files and no extra file
+   * system space are needed, but exactly (imgheight + rps - 1) / rps strips
+   * must then be added.  The last strip holds the remaining rows and may
+   * be shorter than rps rows.
+   *
    * colorfmt  - Specifies the form of the color data that will be provided
    *             in the strip data.  These are the FB_FMT_* definitions
    *             provided in include/nuttx/video/fb.h.  Only the following
@@ -307,8 +315,8 @@ struct tiff_info_s
    */
 
   FAR const char *outfile;  /* Full path to the final output file name */
-  FAR const char *tmpfile1; /* Full path to first temporary file */
-  FAR const char *tmpfile2; /* Full path to second temporary file */
+  FAR const char *tmpfile1; /* Full path to first temporary file (or NULL) */
+  FAR const char *tmpfile2; /* Full path to second temporary file (or NULL) */
 
   uint8_t      colorfmt;    /* See FB_FMT_* definitions in include/nuttx/video/fb.h */
   nxgl_coord_t rps;         /* TIFF RowsPerStrip */
@@ -388,7 +396,8 @@ int tiff_initialize(FAR struct tiff_info_s *info);
  * Description:
  *   Add an image data strip.  The size of the strip in pixels
  *    must be equal to the RowsPerStrip x ImageWidth values
- *    that were provided to tiff_initialize().
+ *    that were provided to tiff_initialize().  When the file is written
+ *    in a single pass, the last strip only holds the remaining rows.
  *
  * Input Parameters:
  *   info    - A pointer to the caller allocated parameter passing/TIFF state
@@ -0,0 +1,150 @@
+/****************************************************************************
+ * apps/include/industry/foc/float/foc_multi.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INDUSTRY_FOC_FLOAT_FOC_MULTI_H
+#define __INDUSTRY_FOC_FLOAT_FOC_MULTI_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#include <dsp.h>
+
+#include "industry/foc/float/foc_handler.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Maximum number of motors served by one multi-motor handler */
+
+#define FOC_MULTI_MOTORS_MAX CONFIG_INDUSTRY_FOC_MULTI_MOTORS
+
+/****************************************************************************
+ * Public Type Definition
+ ****************************************************************************/
+
+/* Input to the multi-motor FOC controller.
+ *
+ * All data is kept as structure-of-arrays indexed by motor number, so one
+ * control pass walks each quantity for all motors sequentially.  Unlike
+ * struct foc_handler_input_f32_s the angle must be already normalized to
+ * the <0, 2*PI) range, as returned by the angle handlers.
+ */
+
+struct foc_multi_input_f32_s
+{
+  float   curr[CONFIG_MOTOR_FOC_PHASES][FOC_MULTI_MOTORS_MAX];
+  float   d_ref[FOC_MULTI_MOTORS_MAX];    /* D reference */
+  float   q_ref[FOC_MULTI_MOTORS_MAX];    /* Q reference */
+  float   vd_comp[FOC_MULTI_MOTORS_MAX];  /* D voltage compensation */
+  float   vq_comp[FOC_MULTI_MOTORS_MAX];  /* Q voltage compensation */
+  float   angle[FOC_MULTI_MOTORS_MAX];    /* Phase angle */
+  float   vbus[FOC_MULTI_MOTORS_MAX];     /* Bus voltage */
+  uint8_t mode[FOC_MULTI_MOTORS_MAX];     /* enum foc_handler_mode_e */
+};
+
+/* Output from the multi-motor FOC controller */
+
+struct foc_multi_output_f32_s
+{
+  float duty[CONFIG_MOTOR_FOC_PHASES][FOC_MULTI_MOTORS_MAX];
+};
+
+/* Multi-motor FOC handler data (PI current controller + SVM3) */
+
+struct foc_multi_f32_s
+{
+  uint8_t nmotors;                        /* Number of active motors */
+
+  /* Configuration */
+
+  float   id_kp[FOC_MULTI_MOTORS_MAX];
+  float   id_ki[FOC_MULTI_MOTORS_MAX];
+  float   iq_kp[FOC_MULTI_MOTORS_MAX];
+  float   iq_ki[FOC_MULTI_MOTORS_MAX];
+  float   duty_max[FOC_MULTI_MOTORS_MAX];
+
+  /* Controller state */
+
+  float   id_int[FOC_MULTI_MOTORS_MAX];   /* D PI integral part */
+  float   iq_int[FOC_MULTI_MOTORS_MAX];   /* Q PI integral part */
+  float   i_a[FOC_MULTI_MOTORS_MAX];      /* Alpha current */
+  float   i_b[FOC_MULTI_MOTORS_MAX];      /* Beta current */
+  float   i_d[FOC_MULTI_MOTORS_MAX];      /* D current */
+  float   i_q[FOC_MULTI_MOTORS_MAX];      /* Q current */
+  float   v_d[FOC_MULTI_MOTORS_MAX];      /* D voltage */
+  float   v_q[FOC_MULTI_MOTORS_MAX];      /* Q voltage */
+  float   v_a[FOC_MULTI_MOTORS_MAX];      /* Alpha voltage */
+  float   v_b[FOC_MULTI_MOTORS_MAX];      /* Beta voltage */
+  float   mod_scale[FOC_MULTI_MOTORS_MAX];
+  float   duty[CONFIG_MOTOR_FOC_PHASES][FOC_MULTI_MOTORS_MAX];
+};
+
+typedef struct foc_multi_f32_s foc_multi_f32_t;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_multi_init_f32
+ ****************************************************************************/
+
+int foc_multi_init_f32(FAR foc_multi_f32_t *h, int nmotors);
+
+/****************************************************************************
+ * Name: foc_multi_cfg_f32
+ ****************************************************************************/
+
+void foc_multi_cfg_f32(FAR foc_multi_f32_t *h, int motor,
+                       FAR struct foc_initdata_f32_s *ctrl_cfg,
+                       FAR struct foc_mod_cfg_f32_s *mod_cfg);
+
+/****************************************************************************
+ * Name: foc_multi_run_f32
+ ****************************************************************************/
+
+void foc_multi_run_f32(FAR foc_multi_f32_t *h,
+                       FAR struct foc_multi_input_f32_s *in,
+                       FAR struct foc_multi_output_f32_s *out);
+
+/****************************************************************************
+ * Name: foc_multi_run_motor_f32
+ ****************************************************************************/
+
+void foc_multi_run_motor_f32(FAR foc_multi_f32_t *h, int motor,
+                             FAR struct foc_multi_input_f32_s *in,
+                             FAR struct foc_multi_output_f32_s *out);
+
+/****************************************************************************
+ * Name: foc_multi_state_f32
+ ****************************************************************************/
+
+void foc_multi_state_f32(FAR foc_multi_f32_t *h, int motor,
+                         FAR struct foc_state_f32_s *state);
+
+#endif /* __INDUSTRY_FOC_FLOAT_FOC_MULTI_H */
@@ -0,0 +1,185 @@
+/****************************************************************************
+ * apps/include/modbus/mb_ctx.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_MODBUS_MB_CTX_H
+#define __APPS_INCLUDE_MODBUS_MB_CTX_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <poll.h>
+#include <termios.h>
+
+#include "modbus/mb.h"
+
+#ifdef CONFIG_MODBUS_CTX
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Number of pollfd entries a single context may need: the serial device for
+ * RTU, or the listening socket plus one entry per client for TCP.
+ */
+
+#define MB_CTX_POLLFDS_MAX  (CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS + 1)
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* Opaque slave instance.  Unlike eMBInit()/eMBPoll(), which keep all state
+ * in globals, every context owns its transport, buffers and callbacks so
+ * any number of RTU and TCP slaves can run in the same process.
+ */
+
+typedef struct xMBCtx xMBCtx;
+
+/* Register callbacks.  They have the same semantics as eMBRegInputCB() and
+ * friends (1-based addresses, big-endian registers, packed coil bits) but
+ * receive the user argument given in xMBCtxCallbacks.  A NULL callback
+ * makes the corresponding function codes answer with an ILLEGAL FUNCTION
+ * exception.
+ */
+
+typedef eMBErrorCode (*peMBCtxRegInputCB)(FAR void *pvArg,
+                                          FAR uint8_t *pucRegBuffer,
+                                          uint16_t usAddress,
+                                          uint16_t usNRegs);
+typedef eMBErrorCode (*peMBCtxRegHoldingCB)(FAR void *pvArg,
+                                            FAR uint8_t *pucRegBuffer,
+                                            uint16_t usAddress,
+                                            uint16_t usNRegs,
+                                            eMBRegisterMode eMode);
+typedef eMBErrorCode (*peMBCtxRegCoilsCB)(FAR void *pvArg,
+                                          FAR uint8_t *pucRegBuffer,
+                                          uint16_t usAddress,
+                                          uint16_t usNCoils,
+                                          eMBRegisterMode eMode);
+typedef eMBErrorCode (*peMBCtxRegDiscreteCB)(FAR void *pvArg,
+                                             FAR uint8_t *pucRegBuffer,
+                                             uint16_t usAddress,
+                                             uint16_t usNDiscrete);
+
+typedef struct
+{
+  peMBCtxRegInputCB    peRegInputCB;
+  peMBCtxRegHoldingCB  peRegHoldingCB;
+  peMBCtxRegCoilsCB    peRegCoilsCB;
+  peMBCtxRegDiscreteCB peRegDiscreteCB;
+  FAR void            *pvArg;
+} xMBCtxCallbacks;
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: eMBCtxRTUInit
+ *
+ * Description:
+ *   Create a Modbus RTU slave on the serial device pcDevice.  Frames are
+ *   delimited by the t3.5 character timeout derived from ulBaudRate.
+ *
+ ****************************************************************************/
+
+eMBErrorCode eMBCtxRTUInit(FAR xMBCtx **ppxCtx, uint8_t ucSlaveAddress,
+                           FAR const char *pcDevice, speed_t ulBaudRate,
+                           eMBParity eParity,
+                           FAR const xMBCtxCallbacks *pxCallbacks);
+
+/****************************************************************************
+ * Name: eMBCtxTCPInit
+ *
+ * Description:
+ *   Create a Modbus TCP slave listening on usTCPPort (or 502 if
+ *   MB_TCP_PORT_USE_DEFAULT) that serves up to
+ *   CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS masters concurrently.
+ *
+ ****************************************************************************/
+
+eMBErrorCode eMBCtxTCPInit(FAR xMBCtx **ppxCtx, uint16_t usTCPPort,
+                           FAR const xMBCtxCallbacks *pxCallbacks);
+
+/****************************************************************************
+ * Name: eMBCtxClose
+ *
+ * Description:
+ *   Close all descriptors of the context and free it.
+ *
+ ****************************************************************************/
+
+eMBErrorCode eMBCtxClose(FAR xMBCtx *pxCtx);
+
+/****************************************************************************
+ * Name: iMBCtxPollSetup
+ *
+ * Description:
+ *   Fill up to iMaxFds entries of pxFds with the descriptors the context
+ *   waits on and lower *piTimeoutMs if an RTU frame is pending completion.
+ *   Returns the number of entries used.  Together with eMBCtxPollHandle()
+ *   this lets one thread serve many contexts with a single poll() call.
+ *
+ ****************************************************************************/
+
+int iMBCtxPollSetup(FAR xMBCtx *pxCtx, FAR struct pollfd *pxFds,
+                    int iMaxFds, FAR int *piTimeoutMs);
+
+/****************************************************************************
+ * Name: eMBCtxPollHandle
+ *
+ * Description:
+ *   Process the poll() results for the entries previously filled in by
+ *   iMBCtxPollSetup(): accept connections, read data and answer every
+ *   complete request.
+ *
+ ****************************************************************************/
+
+eMBErrorCode eMBCtxPollHandle(FAR xMBCtx *pxCtx,
+                              FAR const struct pollfd *pxFds, int nFds);
+
+/****************************************************************************
+ * Name: eMBCtxPoll
+ *
+ * Description:
+ *   Convenience wrapper that waits at most iTimeoutMs for activity on a
+ *   single context and processes it.
+ *
+ ****************************************************************************/
+
+eMBErrorCode eMBCtxPoll(FAR xMBCtx *pxCtx, int iTimeoutMs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CONFIG_MODBUS_CTX */
+#endif /* __APPS_INCLUDE_MODBUS_MB_CTX_H */
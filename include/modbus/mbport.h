@@ -109,6 +109,14 @@ extern bool(*pxMBFrameCBByteReceived)(void);
 extern bool(*pxMBFrameCBTransmitterEmpty)(void);
 extern bool(*pxMBPortCBTimerExpired)(void);
 
+/* Optional block receive callback. If it is not NULL the porting layer
+ * may hand all characters received by one read to this function instead
+ * of calling pxMBFrameCBByteReceived() once per character.
+ */
+
+extern bool(*pxMBFrameCBBlockReceived)(const uint8_t *pucData,
+                                       uint16_t usLen);
+
 extern bool(*pxMBMasterFrameCBByteReceived)(void);
 extern bool(*pxMBMasterFrameCBTransmitterEmpty)(void);
 extern bool(*pxMBMasterPortCBTimerExpired)(void);
@@ -157,6 +157,15 @@ struct ntpc_status_s
     struct sockaddr_storage _srv_addr_store;
   }
   samples[CONFIG_NETUTILS_NTPCLIENT_NUM_SAMPLES];
+
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  /* Clock discipline state */
+
+  int64_t offset_ns;          /* Latest selected offset */
+  int64_t jitter_ns;          /* Averaged offset prediction error */
+  int64_t freq_ppb;           /* Estimated frequency error of local clock */
+  unsigned int poll_interval; /* Current poll interval (seconds) */
+#endif
 };
 
 int ntpc_status(struct ntpc_status_s *statusp);
@@ -33,6 +33,14 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* Path delay histogram: bin 0 counts delays below PTPD_PATH_DELAY_HIST_NS,
+ * each following bin doubles the upper limit and the last bin counts
+ * everything longer.
+ */
+
+#define PTPD_PATH_DELAY_HIST_BINS 16
+#define PTPD_PATH_DELAY_HIST_NS   64
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -94,6 +102,20 @@ struct ptpd_status_s
 
   long path_delay_ns;
 
+  /* Clock quality statistics.  Offset statistics restart whenever the
+   * clock is stepped.
+   */
+
+  int64_t offset_rms_ns;     /* Running RMS of the measured clock error */
+  int64_t offset_max_ns;     /* Largest absolute clock error since step */
+  uint32_t offset_samples;   /* Clock error measurements since step */
+  uint32_t offset_outliers;  /* Measurements rejected as outliers */
+  uint32_t clock_steps;      /* Times the clock was stepped */
+
+  /* Path delay measurements (before filtering) by magnitude */
+
+  uint32_t path_delay_hist[PTPD_PATH_DELAY_HIST_BINS];
+
   /* Timestamps of latest received packets (CLOCK_MONOTONIC) */
 
   struct timespec last_received_multicast; /* Any multicast packet */
@@ -33,6 +33,8 @@
 #include <nuttx/video/fb.h>
 #include <mqueue.h>
 #include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -47,6 +49,21 @@
  * Public Type Declarations
  ****************************************************************************/
 
+/* Per-stage timing of the frames streamed so far.  All times are in
+ * microseconds.
+ */
+
+struct nxcamera_stats_s
+{
+  uint32_t              frames;                      /* Frames shown */
+  uint32_t              skipped;                     /* Frames not panned in,
+                                                      * display was busy */
+  uint64_t              dequeue_us;                  /* Waiting for frames */
+  uint64_t              convert_us;                  /* Converting frames */
+  uint64_t              display_us;                  /* Panning the display */
+  uint32_t              max_frame_us;                /* Slowest frame */
+};
+
 /* This structure describes the internal state of the nxcamera */
 
 struct nxcamera_s
@@ -72,6 +89,13 @@ struct nxcamera_s
   size_t                nbuffers;                    /* Number of buffers */
   FAR size_t            *buf_sizes;                  /* Buffer lengths */
   FAR uint8_t           **bufs;                      /* Buffer pointers */
+  FAR uint8_t           *convbuf;                    /* Intermediate I420 frame,
+                                                      * allocated per stream */
+  uint32_t              display_yoffset;             /* Y offset of the buffer
+                                                      * being drawn */
+  bool                  display_dblbuf;              /* Draw into the hidden
+                                                      * framebuffer half */
+  struct nxcamera_stats_s stats;                     /* Per-stage timing */
 };
 
 struct video_msg_s
@@ -196,6 +220,23 @@ int nxcamera_stream(FAR struct nxcamera_s *pcam,
 
 int nxcamera_stop(FAR struct nxcamera_s *pcam);
 
+/****************************************************************************
+ * Name: nxcamera_getstats
+ *
+ *   Returns the per-stage timing of the current or last stream.
+ *
+ * Input Parameters:
+ *   pcam   - Pointer to the nxcamera context
+ *   stats  - Location to return the timing
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxcamera_getstats(FAR struct nxcamera_s *pcam,
+                       FAR struct nxcamera_stats_s *stats);
+
 /****************************************************************************
  * Name: nxcamera_setdevice
  *
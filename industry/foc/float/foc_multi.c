@@ -0,0 +1,454 @@
+/****************************************************************************
+ * apps/industry/foc/float/foc_multi.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "industry/foc/foc_common.h"
+#include "industry/foc/float/foc_multi.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MOTOR_FOC_PHASES != 3
+#  error The multi-motor FOC handler supports only 3-phase motors
+#endif
+
+/* Enable current samples correction if 3-shunts */
+
+#if CONFIG_MOTOR_FOC_SHUNTS == 3
+#  define FOC_CORRECT_CURRENT_SAMPLES 1
+#endif
+
+#define FOC_MULTI_PI       (3.14159265358979f)
+#define FOC_MULTI_2PI      (6.28318530717959f)
+#define FOC_MULTI_PI_2     (1.57079632679490f)
+#define FOC_MULTI_1_2PI    (0.15915494309190f)
+#define FOC_MULTI_1_SQRT3  (0.57735026918963f)
+#define FOC_MULTI_2_SQRT3  (1.15470053837925f)
+#define FOC_MULTI_SQRT3_2  (0.86602540378444f)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_multi_sin
+ *
+ * Description:
+ *   Branchless sine approximation for x in <-PI, PI> range. The argument is
+ *   folded to <-PI/2, PI/2> and evaluated with a 7th order polynomial
+ *   (max error ~1.6e-4), which lets the compiler vectorize the per-motor
+ *   loop instead of calling sinf()/cosf() for every motor.
+ *
+ ****************************************************************************/
+
+static inline float foc_multi_sin(float x)
+{
+  float x2;
+
+  x  = (x > FOC_MULTI_PI_2) ? (FOC_MULTI_PI - x) : x;
+  x  = (x < -FOC_MULTI_PI_2) ? (-FOC_MULTI_PI - x) : x;
+  x2 = x * x;
+
+  return x * (1.0f - x2 * (1.0f / 6.0f -
+                     x2 * (1.0f / 120.0f - x2 * (1.0f / 5040.0f))));
+}
+
+/****************************************************************************
+ * Name: foc_multi_saturate
+ ****************************************************************************/
+
+static inline float foc_multi_saturate(float x, float min, float max)
+{
+  x = (x > max) ? max : x;
+  x = (x < min) ? min : x;
+
+  return x;
+}
+
+/****************************************************************************
+ * Name: foc_multi_run_range
+ *
+ * Description:
+ *   Run every control stage for motors first..last-1, one stage after
+ *   another.
+ *
+ ****************************************************************************/
+
+static void foc_multi_run_range(FAR foc_multi_f32_t *h,
+                                FAR struct foc_multi_input_f32_s *in,
+                                int first, int last)
+{
+  float sin_a[FOC_MULTI_MOTORS_MAX];
+  float cos_a[FOC_MULTI_MOTORS_MAX];
+  float vmax[FOC_MULTI_MOTORS_MAX];
+  int   i = 0;
+
+#ifdef FOC_CORRECT_CURRENT_SAMPLES
+  /* Reconstruct the current of the phase with the highest duty in the
+   * previous cycle, its low-side shunt had the shortest sampling window.
+   */
+
+  for (i = first; i < last; i += 1)
+    {
+      float d0 = h->duty[0][i];
+      float d1 = h->duty[1][i];
+      float d2 = h->duty[2][i];
+      float c0 = in->curr[0][i];
+      float c1 = in->curr[1][i];
+      float c2 = in->curr[2][i];
+
+      if (d0 >= d1 && d0 >= d2)
+        {
+          c0 = -(c1 + c2);
+        }
+      else if (d1 >= d2)
+        {
+          c1 = -(c0 + c2);
+        }
+      else
+        {
+          c2 = -(c0 + c1);
+        }
+
+      in->curr[0][i] = c0;
+      in->curr[1][i] = c1;
+      in->curr[2][i] = c2;
+    }
+#endif
+
+  /* Phase angle and base voltage */
+
+  for (i = first; i < last; i += 1)
+    {
+      float x;
+      float y;
+      float vbase;
+
+      /* Shift the angle to <-PI, PI) so that sin(x + PI) = -sin(x) */
+
+      x = in->angle[i];
+      x = x - FOC_MULTI_2PI * floorf(x * FOC_MULTI_1_2PI) - FOC_MULTI_PI;
+      y = x + FOC_MULTI_PI_2;
+      y = (y > FOC_MULTI_PI) ? (y - FOC_MULTI_2PI) : y;
+
+      sin_a[i] = -foc_multi_sin(x);
+      cos_a[i] = -foc_multi_sin(y);
+
+      /* Maximum DQ voltage magnitude for SVM3 */
+
+      vbase           = in->vbus[i] * FOC_MULTI_1_SQRT3;
+      vmax[i]         = vbase;
+      h->mod_scale[i] = (vbase > 0.0f) ? (1.0f / vbase) : 0.0f;
+    }
+
+  /* Clarke and Park transformation */
+
+  for (i = first; i < last; i += 1)
+    {
+      float ia = in->curr[0][i];
+      float ib = (FOC_MULTI_1_SQRT3 * in->curr[0][i] +
+                  FOC_MULTI_2_SQRT3 * in->curr[1][i]);
+
+      h->i_a[i] = ia;
+      h->i_b[i] = ib;
+      h->i_d[i] = ia * cos_a[i] + ib * sin_a[i];
+      h->i_q[i] = ib * cos_a[i] - ia * sin_a[i];
+    }
+
+  /* Current PI controllers with anti-windup, voltage mode passes the
+   * reference through.
+   */
+
+  for (i = first; i < last; i += 1)
+    {
+      bool  cmode = (in->mode[i] == FOC_HANDLER_MODE_CURRENT);
+      float err;
+      float out_d;
+      float out_q;
+      float sat;
+
+      err    = in->d_ref[i] - h->i_d[i];
+      out_d  = h->id_int[i] + h->id_ki[i] * err;
+      out_d += h->id_kp[i] * err;
+      sat    = foc_multi_saturate(out_d, -vmax[i], vmax[i]);
+      h->id_int[i] += cmode ? (h->id_ki[i] * err - (out_d - sat)) : 0.0f;
+      out_d  = sat - in->vd_comp[i];
+
+      err    = in->q_ref[i] - h->i_q[i];
+      out_q  = h->iq_int[i] + h->iq_ki[i] * err;
+      out_q += h->iq_kp[i] * err;
+      sat    = foc_multi_saturate(out_q, -vmax[i], vmax[i]);
+      h->iq_int[i] += cmode ? (h->iq_ki[i] * err - (out_q - sat)) : 0.0f;
+      out_q  = sat - in->vq_comp[i];
+
+      h->v_d[i] = cmode ? out_d : in->d_ref[i];
+      h->v_q[i] = cmode ? out_q : in->q_ref[i];
+    }
+
+  /* Saturate DQ voltage vector and inverse Park transformation */
+
+  for (i = first; i < last; i += 1)
+    {
+      float mag = sqrtf(h->v_d[i] * h->v_d[i] + h->v_q[i] * h->v_q[i]);
+      float k   = (mag > vmax[i]) ? (vmax[i] / mag) : 1.0f;
+
+      h->v_d[i] *= k;
+      h->v_q[i] *= k;
+
+      h->v_a[i] = h->v_d[i] * cos_a[i] - h->v_q[i] * sin_a[i];
+      h->v_b[i] = h->v_d[i] * sin_a[i] + h->v_q[i] * cos_a[i];
+    }
+
+  /* 3-phase space vector modulation.
+   *
+   * Min-max zero sequence injection gives the same centered duty cycles
+   * as the sector based svm3() but without branches.  Modulation voltage
+   * of magnitude 1.0 corresponds to VBASE = VBUS/sqrt(3).
+   */
+
+  for (i = first; i < last; i += 1)
+    {
+      float on  = (in->mode[i] >= FOC_HANDLER_MODE_VOLTAGE) ? 1.0f : 0.0f;
+      float va  = h->v_a[i] * h->mod_scale[i] * FOC_MULTI_1_SQRT3;
+      float vb  = h->v_b[i] * h->mod_scale[i] * FOC_MULTI_1_SQRT3;
+      float u   = va;
+      float v   = -0.5f * va + FOC_MULTI_SQRT3_2 * vb;
+      float w   = -0.5f * va - FOC_MULTI_SQRT3_2 * vb;
+      float max = fmaxf(u, fmaxf(v, w));
+      float min = fminf(u, fminf(v, w));
+      float off = 0.5f - 0.5f * (max + min);
+
+      h->duty[0][i] = on * foc_multi_saturate(u + off, 0.0f,
+                                              h->duty_max[i]);
+      h->duty[1][i] = on * foc_multi_saturate(v + off, 0.0f,
+                                              h->duty_max[i]);
+      h->duty[2][i] = on * foc_multi_saturate(w + off, 0.0f,
+                                              h->duty_max[i]);
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_multi_init_f32
+ *
+ * Description:
+ *   Initialize the multi-motor FOC handler (float32)
+ *
+ * Input Parameter:
+ *   h       - pointer to multi-motor FOC handler
+ *   nmotors - number of motors handled in one control pass
+ *
+ ****************************************************************************/
+
+int foc_multi_init_f32(FAR foc_multi_f32_t *h, int nmotors)
+{
+  DEBUGASSERT(h);
+
+  if (nmotors <= 0 || nmotors > FOC_MULTI_MOTORS_MAX)
+    {
+      return -EINVAL;
+    }
+
+  /* Reset handler */
+
+  memset(h, 0, sizeof(foc_multi_f32_t));
+
+  h->nmotors = nmotors;
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: foc_multi_cfg_f32
+ *
+ * Description:
+ *   Configure one motor of the multi-motor FOC handler (float32)
+ *
+ * Input Parameter:
+ *   h        - pointer to multi-motor FOC handler
+ *   motor    - motor index
+ *   ctrl_cfg - pointer to PI controller configuration data
+ *   mod_cfg  - pointer to modulation configuration data
+ *
+ ****************************************************************************/
+
+void foc_multi_cfg_f32(FAR foc_multi_f32_t *h, int motor,
+                       FAR struct foc_initdata_f32_s *ctrl_cfg,
+                       FAR struct foc_mod_cfg_f32_s *mod_cfg)
+{
+  int i = 0;
+
+  DEBUGASSERT(h);
+  DEBUGASSERT(ctrl_cfg);
+  DEBUGASSERT(mod_cfg);
+  DEBUGASSERT(motor >= 0 && motor < h->nmotors);
+
+  h->id_kp[motor]    = ctrl_cfg->id_kp;
+  h->id_ki[motor]    = ctrl_cfg->id_ki;
+  h->iq_kp[motor]    = ctrl_cfg->iq_kp;
+  h->iq_ki[motor]    = ctrl_cfg->iq_ki;
+  h->duty_max[motor] = mod_cfg->pwm_duty_max;
+
+  /* Reset controller state */
+
+  h->id_int[motor] = 0.0f;
+  h->iq_int[motor] = 0.0f;
+
+  for (i = 0; i < CONFIG_MOTOR_FOC_PHASES; i += 1)
+    {
+      h->duty[i][motor] = 0.0f;
+    }
+}
+
+/****************************************************************************
+ * Name: foc_multi_run_f32
+ *
+ * Description:
+ *   Run one control pass for all motors (float32).
+ *
+ *   This is the batched equivalent of calling foc_handler_run_f32() with
+ *   the PI controller and the SVM3 modulation for every motor, but each
+ *   stage (current correction, Clarke/Park, PI, inverse Park, SVM3) is
+ *   done for all motors before the next one starts.  Motors in IDLE or
+ *   INIT mode get zero duty and keep their integrators untouched.
+ *
+ * Input Parameter:
+ *   h   - pointer to multi-motor FOC handler
+ *   in  - pointer to input data
+ *   out - (out) pointer to output data
+ *
+ ****************************************************************************/
+
+void foc_multi_run_f32(FAR foc_multi_f32_t *h,
+                       FAR struct foc_multi_input_f32_s *in,
+                       FAR struct foc_multi_output_f32_s *out)
+{
+  DEBUGASSERT(h);
+  DEBUGASSERT(in);
+  DEBUGASSERT(out);
+
+  foc_multi_run_range(h, in, 0, h->nmotors);
+  memcpy(out->duty, h->duty, sizeof(h->duty));
+}
+
+/****************************************************************************
+ * Name: foc_multi_run_motor_f32
+ *
+ * Description:
+ *   Run the control stages for a single motor (float32)
+ *
+ *   Serving every motor with this function gives the same result as one
+ *   foc_multi_run_f32() pass, but lets the caller time the slice of each
+ *   motor.  Only the duty cycles of this motor are updated in out.
+ *
+ * Input Parameter:
+ *   h     - pointer to multi-motor FOC handler
+ *   motor - motor index
+ *   in    - pointer to input data
+ *   out   - (out) pointer to output data
+ *
+ ****************************************************************************/
+
+void foc_multi_run_motor_f32(FAR foc_multi_f32_t *h, int motor,
+                             FAR struct foc_multi_input_f32_s *in,
+                             FAR struct foc_multi_output_f32_s *out)
+{
+  int i = 0;
+
+  DEBUGASSERT(h);
+  DEBUGASSERT(in);
+  DEBUGASSERT(out);
+  DEBUGASSERT(motor >= 0 && motor < h->nmotors);
+
+  foc_multi_run_range(h, in, motor, motor + 1);
+
+  for (i = 0; i < CONFIG_MOTOR_FOC_PHASES; i += 1)
+    {
+      out->duty[i][motor] = h->duty[i][motor];
+    }
+}
+
+/****************************************************************************
+ * Name: foc_multi_state_f32
+ *
+ * Description:
+ *   Get the controller state of one motor (float32)
+ *
+ * Input Parameter:
+ *   h     - pointer to multi-motor FOC handler
+ *   motor - motor index
+ *   state - (out) pointer to FOC state data
+ *
+ ****************************************************************************/
+
+void foc_multi_state_f32(FAR foc_multi_f32_t *h, int motor,
+                         FAR struct foc_state_f32_s *state)
+{
+  float va = 0.0f;
+  float vb = 0.0f;
+  float ia = 0.0f;
+  float ib = 0.0f;
+
+  DEBUGASSERT(h);
+  DEBUGASSERT(state);
+  DEBUGASSERT(motor >= 0 && motor < h->nmotors);
+
+  ia = h->i_a[motor];
+  ib = h->i_b[motor];
+  va = h->v_a[motor];
+  vb = h->v_b[motor];
+
+  state->idq.d = h->i_d[motor];
+  state->idq.q = h->i_q[motor];
+  state->vdq.d = h->v_d[motor];
+  state->vdq.q = h->v_q[motor];
+  state->iab.a = ia;
+  state->iab.b = ib;
+  state->vab.a = va;
+  state->vab.b = vb;
+
+  /* Inverse Clarke transformation */
+
+  state->curr[0] = ia;
+  state->curr[1] = -0.5f * ia + FOC_MULTI_SQRT3_2 * ib;
+  state->curr[2] = -0.5f * ia - FOC_MULTI_SQRT3_2 * ib;
+  state->volt[0] = va;
+  state->volt[1] = -0.5f * va + FOC_MULTI_SQRT3_2 * vb;
+  state->volt[2] = -0.5f * va - FOC_MULTI_SQRT3_2 * vb;
+
+  state->mod_scale = h->mod_scale[motor];
+}
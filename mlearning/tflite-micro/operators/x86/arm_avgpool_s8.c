@@ -0,0 +1,155 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_avgpool_s8.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "arm_nnfunctions.h"
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* s8 average pooling function.  The window sums of four channels are
+ * accumulated at once, the rounding division stays scalar so the result
+ * matches the reference.  Refer header file for details.
+ */
+
+arm_cmsis_nn_status arm_avgpool_s8(const cmsis_nn_context *ctx,
+                                   const cmsis_nn_pool_params *pool_params,
+                                   const cmsis_nn_dims *input_dims,
+                                   const int8_t *src,
+                                   const cmsis_nn_dims *filter_dims,
+                                   const cmsis_nn_dims *output_dims,
+                                   int8_t *dst)
+{
+  (void)ctx;
+
+  const int32_t input_y = input_dims->h;
+  const int32_t input_x = input_dims->w;
+  const int32_t output_y = output_dims->h;
+  const int32_t output_x = output_dims->w;
+  const int32_t stride_y = pool_params->stride.h;
+  const int32_t stride_x = pool_params->stride.w;
+  const int32_t kernel_y = filter_dims->h;
+  const int32_t kernel_x = filter_dims->w;
+  const int32_t pad_y = pool_params->padding.h;
+  const int32_t pad_x = pool_params->padding.w;
+  const int32_t act_min = pool_params->activation.min;
+  const int32_t act_max = pool_params->activation.max;
+  const int32_t ch_src = input_dims->c;
+  int32_t batch_cnt = input_dims->n;
+
+  while (batch_cnt)
+    {
+      for (int i_y = 0; i_y < output_y; i_y++)
+        {
+          const int32_t base_y = i_y * stride_y - pad_y;
+          const int32_t k_y_start = MAX(0, base_y);
+          const int32_t k_y_end = MIN(base_y + kernel_y, input_y);
+
+          for (int i_x = 0; i_x < output_x; i_x++)
+            {
+              const int32_t base_x = i_x * stride_x - pad_x;
+              const int32_t k_x_start = MAX(0, base_x);
+              const int32_t k_x_end = MIN(base_x + kernel_x, input_x);
+              const int32_t count = (k_y_end - k_y_start) *
+                                    (k_x_end - k_x_start);
+              int32_t ch = 0;
+
+              /* Prevent static code issue DIVIDE_BY_ZERO */
+
+              if (k_y_start >= k_y_end || k_x_start >= k_x_end)
+                {
+                  return ARM_CMSIS_NN_ARG_ERROR;
+                }
+
+              while (ch < ch_src)
+                {
+                  int32_t sum[4] =
+                    {
+                      0
+                    };
+
+                  int32_t n = MIN(4, ch_src - ch);
+
+                  if (n == 4)
+                    {
+                      __m128i acc = _mm_setzero_si128();
+
+                      for (int k_y = k_y_start; k_y < k_y_end; k_y++)
+                        {
+                          for (int k_x = k_x_start; k_x < k_x_end; k_x++)
+                            {
+                              const int8_t *in = src + ch_src *
+                                                 (k_x + k_y * input_x) + ch;
+
+                              acc = _mm_add_epi32(acc, _mm_cvtepi8_epi32(
+                                                  arm_nn_x86_load4(in)));
+                            }
+                        }
+
+                      _mm_storeu_si128((__m128i *)sum, acc);
+                    }
+                  else
+                    {
+                      for (int k_y = k_y_start; k_y < k_y_end; k_y++)
+                        {
+                          for (int k_x = k_x_start; k_x < k_x_end; k_x++)
+                            {
+                              const int8_t *in = src + ch_src *
+                                                 (k_x + k_y * input_x) + ch;
+
+                              for (int i = 0; i < n; i++)
+                                {
+                                  sum[i] += in[i];
+                                }
+                            }
+                        }
+                    }
+
+                  for (int i = 0; i < n; i++)
+                    {
+                      int32_t avg = sum[i] > 0 ?
+                                    (sum[i] + count / 2) / count :
+                                    (sum[i] - count / 2) / count;
+
+                      avg = MAX(avg, act_min);
+                      avg = MIN(avg, act_max);
+                      dst[ch + i] = (int8_t)avg;
+                    }
+
+                  ch += n;
+                }
+
+              dst += ch_src;
+            }
+        }
+
+      src += ch_src * input_y * input_x;
+      batch_cnt--;
+    }
+
+  return ARM_CMSIS_NN_SUCCESS;
+}
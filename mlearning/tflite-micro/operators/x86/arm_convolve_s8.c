@@ -0,0 +1,200 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_convolve_s8.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <string.h>
+
+#include "arm_nnfunctions.h"
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* Basic s8 convolution function.
+ *
+ * The input is expanded into two int16 im2col columns at a time, which are
+ * multiplied with all filters by arm_nn_mat_mult_kernel_s8_s16().  The
+ * buffer layout matches arm_convolve_s8_get_buffer_size().
+ */
+
+arm_cmsis_nn_status
+arm_convolve_s8(const cmsis_nn_context *ctx,
+                const cmsis_nn_conv_params *conv_params,
+                const cmsis_nn_per_channel_quant_params *quant_params,
+                const cmsis_nn_dims *input_dims,
+                const int8_t *input_data,
+                const cmsis_nn_dims *filter_dims,
+                const int8_t *filter_data,
+                const cmsis_nn_dims *bias_dims,
+                const int32_t *bias_data,
+                const cmsis_nn_dims *output_dims,
+                int8_t *output_data)
+{
+  (void)bias_dims;
+
+  if (ctx->buf == NULL)
+    {
+      return ARM_CMSIS_NN_ARG_ERROR;
+    }
+
+  int16_t *buffer_a = (int16_t *)ctx->buf;
+
+  const int32_t input_batches = input_dims->n;
+  const int32_t input_x = input_dims->w;
+  const int32_t input_y = input_dims->h;
+  const int32_t input_ch = input_dims->c;
+  const int32_t kernel_x = filter_dims->w;
+  const int32_t kernel_y = filter_dims->h;
+  const int32_t output_x = output_dims->w;
+  const int32_t output_y = output_dims->h;
+  const int32_t output_ch = output_dims->c;
+
+  const int32_t pad_x = conv_params->padding.w;
+  const int32_t pad_y = conv_params->padding.h;
+  const int32_t stride_x = conv_params->stride.w;
+  const int32_t stride_y = conv_params->stride.h;
+  const int32_t dilation_x = conv_params->dilation.w;
+  const int32_t dilation_y = conv_params->dilation.h;
+  const int32_t out_offset = conv_params->output_offset;
+  const int32_t out_activation_min = conv_params->activation.min;
+  const int32_t out_activation_max = conv_params->activation.max;
+  const int32_t rhs_cols = kernel_x * kernel_y * input_ch;
+  const int32_t input_offset = conv_params->input_offset;
+
+  int32_t *output_mult = quant_params->multiplier;
+  int32_t *output_shift = quant_params->shift;
+
+  int i_batch;
+  for (i_batch = 0; i_batch < input_batches; i_batch++)
+    {
+      int16_t *two_column_buf = buffer_a;
+      int8_t *out = output_data;
+
+      for (int i_out_y = 0; i_out_y < output_y; i_out_y++)
+        {
+          const int32_t base_idx_y = stride_y * i_out_y - pad_y;
+
+          for (int i_out_x = 0; i_out_x < output_x; i_out_x++)
+            {
+              const int32_t base_idx_x = stride_x * i_out_x - pad_x;
+
+              /* This part implements the im2col function, padding is
+               * zero after the input offset is applied.
+               */
+
+              for (int32_t i_ker_y = 0; i_ker_y < kernel_y; i_ker_y++)
+                {
+                  const int32_t k_y = base_idx_y + dilation_y * i_ker_y;
+
+                  for (int32_t i_ker_x = 0; i_ker_x < kernel_x; i_ker_x++)
+                    {
+                      const int32_t k_x = base_idx_x + dilation_x * i_ker_x;
+
+                      if (k_y < 0 || k_y >= input_y ||
+                          k_x < 0 || k_x >= input_x)
+                        {
+                          memset(two_column_buf, 0,
+                                 sizeof(int16_t) * input_ch);
+                        }
+                      else
+                        {
+                          arm_q7_to_q15_with_offset(input_data +
+                              (k_y * input_x + k_x) * input_ch,
+                              two_column_buf, input_ch,
+                              (int16_t)input_offset);
+                        }
+
+                      two_column_buf += input_ch;
+                    }
+                }
+
+              /* Computation is filed for every 2 columns */
+
+              if (two_column_buf == buffer_a + 2 * rhs_cols)
+                {
+                  out = arm_nn_mat_mult_kernel_s8_s16(filter_data,
+                                                      buffer_a,
+                                                      output_ch,
+                                                      output_shift,
+                                                      output_mult,
+                                                      out_offset,
+                                                      out_activation_min,
+                                                      out_activation_max,
+                                                      rhs_cols,
+                                                      rhs_cols,
+                                                      bias_data,
+                                                      out);
+
+                  two_column_buf = buffer_a;
+                }
+            }
+        }
+
+      /* Left-over because of odd number of output pixels */
+
+      if (two_column_buf != buffer_a)
+        {
+          const int8_t *ker_a = filter_data;
+          int i;
+
+          for (i = 0; i < output_ch; i++)
+            {
+              int32_t sum = 0;
+              int32_t dummy = 0;
+              int32_t col;
+
+              if (bias_data)
+                {
+                  sum = bias_data[i];
+                }
+
+              col = arm_nn_x86_dot2_s8_s16(ker_a, buffer_a, buffer_a,
+                                           rhs_cols, &sum, &dummy);
+              for (; col < rhs_cols; col++)
+                {
+                  sum += ker_a[col] * buffer_a[col];
+                }
+
+              ker_a += rhs_cols;
+
+              sum = arm_nn_requantize(sum, output_mult[i], output_shift[i]);
+              sum += out_offset;
+              sum = MAX(sum, out_activation_min);
+              sum = MIN(sum, out_activation_max);
+              *out++ = (int8_t)sum;
+            }
+        }
+
+      /* Advance to the next batch */
+
+      input_data += (input_x * input_y * input_ch);
+      output_data += (output_x * output_y * output_ch);
+    }
+
+  /* Return to application */
+
+  return ARM_CMSIS_NN_SUCCESS;
+}
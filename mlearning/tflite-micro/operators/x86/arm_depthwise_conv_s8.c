@@ -0,0 +1,306 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_depthwise_conv_s8.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "arm_nnfunctions.h"
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Requantize, clamp and store one output channel */
+
+static inline int8_t arm_dw_out_x86(int32_t acc, int32_t mult,
+                                    int32_t shift, int32_t offset,
+                                    int32_t act_min, int32_t act_max)
+{
+  acc = arm_nn_requantize(acc, mult, shift);
+  acc += offset;
+  acc = MAX(acc, act_min);
+  acc = MIN(acc, act_max);
+  return (int8_t)acc;
+}
+
+/* First and end kernel tap inside the input for one output position */
+
+static inline void arm_dw_range_x86(int32_t base, int32_t dilation,
+                                    int32_t kernel, int32_t input,
+                                    int32_t *start, int32_t *end)
+{
+  *start = MAX(0, (-base + dilation - 1) / dilation);
+  *end   = MIN(kernel, (input - base + dilation - 1) / dilation);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* Basic s8 depthwise convolution function.
+ *
+ * With a channel multiplier of one, the input and filter channels are
+ * contiguous and the accumulation runs over four (SSE4.1) or eight (AVX2)
+ * channels at once.  Other multipliers use the scalar loop.
+ */
+
+arm_cmsis_nn_status
+arm_depthwise_conv_s8(const cmsis_nn_context *ctx,
+                      const cmsis_nn_dw_conv_params *dw_conv_params,
+                      const cmsis_nn_per_channel_quant_params *quant_params,
+                      const cmsis_nn_dims *input_dims,
+                      const int8_t *input,
+                      const cmsis_nn_dims *filter_dims,
+                      const int8_t *kernel,
+                      const cmsis_nn_dims *bias_dims,
+                      const int32_t *bias,
+                      const cmsis_nn_dims *output_dims,
+                      int8_t *output)
+{
+  (void)ctx;
+  (void)bias_dims;
+
+  const int32_t input_batches = input_dims->n;
+  const int32_t input_x = input_dims->w;
+  const int32_t input_y = input_dims->h;
+  const int32_t input_ch = input_dims->c;
+  const int32_t kernel_x = filter_dims->w;
+  const int32_t kernel_y = filter_dims->h;
+  const int32_t output_x = output_dims->w;
+  const int32_t output_y = output_dims->h;
+  const int32_t ch_mult = dw_conv_params->ch_mult;
+  const int32_t output_ch = input_ch * ch_mult;
+  const int32_t pad_x = dw_conv_params->padding.w;
+  const int32_t pad_y = dw_conv_params->padding.h;
+  const int32_t stride_x = dw_conv_params->stride.w;
+  const int32_t stride_y = dw_conv_params->stride.h;
+  const int32_t dilation_x = dw_conv_params->dilation.w;
+  const int32_t dilation_y = dw_conv_params->dilation.h;
+  const int32_t input_offset = dw_conv_params->input_offset;
+  const int32_t output_offset = dw_conv_params->output_offset;
+  const int32_t act_min = dw_conv_params->activation.min;
+  const int32_t act_max = dw_conv_params->activation.max;
+  const int32_t *output_mult = quant_params->multiplier;
+  const int32_t *output_shift = quant_params->shift;
+
+  int i_batch;
+  for (i_batch = 0; i_batch < input_batches; i_batch++)
+    {
+      for (int i_out_y = 0; i_out_y < output_y; i_out_y++)
+        {
+          const int32_t base_idx_y = i_out_y * stride_y - pad_y;
+          int32_t ker_y_start;
+          int32_t ker_y_end;
+
+          arm_dw_range_x86(base_idx_y, dilation_y, kernel_y, input_y,
+                           &ker_y_start, &ker_y_end);
+
+          for (int i_out_x = 0; i_out_x < output_x; i_out_x++)
+            {
+              const int32_t base_idx_x = i_out_x * stride_x - pad_x;
+              int32_t ker_x_start;
+              int32_t ker_x_end;
+              int32_t ch = 0;
+
+              arm_dw_range_x86(base_idx_x, dilation_x, kernel_x, input_x,
+                               &ker_x_start, &ker_x_end);
+
+              if (ch_mult == 1)
+                {
+                  const __m128i off = _mm_set1_epi32(input_offset);
+#ifdef __AVX2__
+                  const __m256i off256 = _mm256_set1_epi32(input_offset);
+
+                  for (; ch + 8 <= output_ch; ch += 8)
+                    {
+                      __m256i acc = bias ?
+                        _mm256_loadu_si256((const __m256i *)(bias + ch)) :
+                        _mm256_setzero_si256();
+                      int32_t sum[8];
+
+                      for (int ky = ker_y_start; ky < ker_y_end; ky++)
+                        {
+                          const int32_t idx_y = base_idx_y + dilation_y * ky;
+
+                          for (int kx = ker_x_start; kx < ker_x_end; kx++)
+                            {
+                              const int32_t idx_x = base_idx_x +
+                                                    dilation_x * kx;
+                              const int8_t *in = input + (idx_y * input_x +
+                                                 idx_x) * input_ch + ch;
+                              const int8_t *ker = kernel + (ky * kernel_x +
+                                                  kx) * output_ch + ch;
+                              __m256i vi = _mm256_cvtepi8_epi32(
+                                _mm_loadl_epi64((const __m128i *)in));
+                              __m256i vk = _mm256_cvtepi8_epi32(
+                                _mm_loadl_epi64((const __m128i *)ker));
+
+                              vi  = _mm256_add_epi32(vi, off256);
+                              acc = _mm256_add_epi32(acc,
+                                      _mm256_mullo_epi32(vi, vk));
+                            }
+                        }
+
+                      _mm256_storeu_si256((__m256i *)sum, acc);
+                      for (int i = 0; i < 8; i++)
+                        {
+                          *output++ = arm_dw_out_x86(sum[i],
+                                        output_mult[ch + i],
+                                        output_shift[ch + i],
+                                        output_offset, act_min, act_max);
+                        }
+                    }
+#endif
+
+                  for (; ch + 4 <= output_ch; ch += 4)
+                    {
+                      __m128i acc = bias ?
+                        _mm_loadu_si128((const __m128i *)(bias + ch)) :
+                        _mm_setzero_si128();
+                      int32_t sum[4];
+
+                      for (int ky = ker_y_start; ky < ker_y_end; ky++)
+                        {
+                          const int32_t idx_y = base_idx_y + dilation_y * ky;
+
+                          for (int kx = ker_x_start; kx < ker_x_end; kx++)
+                            {
+                              const int32_t idx_x = base_idx_x +
+                                                    dilation_x * kx;
+                              const int8_t *in = input + (idx_y * input_x +
+                                                 idx_x) * input_ch + ch;
+                              const int8_t *ker = kernel + (ky * kernel_x +
+                                                  kx) * output_ch + ch;
+                              __m128i vi = _mm_cvtepi8_epi32(
+                                             arm_nn_x86_load4(in));
+                              __m128i vk = _mm_cvtepi8_epi32(
+                                             arm_nn_x86_load4(ker));
+
+                              vi  = _mm_add_epi32(vi, off);
+                              acc = _mm_add_epi32(acc,
+                                                  _mm_mullo_epi32(vi, vk));
+                            }
+                        }
+
+                      _mm_storeu_si128((__m128i *)sum, acc);
+                      for (int i = 0; i < 4; i++)
+                        {
+                          *output++ = arm_dw_out_x86(sum[i],
+                                        output_mult[ch + i],
+                                        output_shift[ch + i],
+                                        output_offset, act_min, act_max);
+                        }
+                    }
+                }
+
+              /* Channel multiplier above one and the last channels */
+
+              for (; ch < output_ch; ch++)
+                {
+                  const int32_t in_ch = ch / ch_mult;
+                  int32_t acc = bias ? bias[ch] : 0;
+
+                  for (int ky = ker_y_start; ky < ker_y_end; ky++)
+                    {
+                      const int32_t idx_y = base_idx_y + dilation_y * ky;
+
+                      for (int kx = ker_x_start; kx < ker_x_end; kx++)
+                        {
+                          const int32_t idx_x = base_idx_x + dilation_x * kx;
+
+                          acc += (input[(idx_y * input_x + idx_x) *
+                                        input_ch + in_ch] + input_offset) *
+                                 kernel[(ky * kernel_x + kx) * output_ch +
+                                        ch];
+                        }
+                    }
+
+                  *output++ = arm_dw_out_x86(acc, output_mult[ch],
+                                             output_shift[ch],
+                                             output_offset, act_min,
+                                             act_max);
+                }
+            }
+        }
+
+      /* Advance to the next batch */
+
+      input += (input_x * input_y * input_ch);
+    }
+
+  return ARM_CMSIS_NN_SUCCESS;
+}
+
+/* The optimized and 3x3 variants selected by arm_depthwise_conv_wrapper_s8()
+ * only differ from the basic function in their constraints.
+ */
+
+arm_cmsis_nn_status
+arm_depthwise_conv_s8_opt(const cmsis_nn_context *ctx,
+                          const cmsis_nn_dw_conv_params *dw_conv_params,
+                          const cmsis_nn_per_channel_quant_params
+                          *quant_params,
+                          const cmsis_nn_dims *input_dims,
+                          const int8_t *input,
+                          const cmsis_nn_dims *filter_dims,
+                          const int8_t *kernel,
+                          const cmsis_nn_dims *bias_dims,
+                          const int32_t *bias,
+                          const cmsis_nn_dims *output_dims,
+                          int8_t *output)
+{
+  if (dw_conv_params->ch_mult != 1)
+    {
+      return ARM_CMSIS_NN_ARG_ERROR;
+    }
+
+  return arm_depthwise_conv_s8(ctx, dw_conv_params, quant_params,
+                               input_dims, input, filter_dims, kernel,
+                               bias_dims, bias, output_dims, output);
+}
+
+arm_cmsis_nn_status
+arm_depthwise_conv_3x3_s8(const cmsis_nn_context *ctx,
+                          const cmsis_nn_dw_conv_params *dw_conv_params,
+                          const cmsis_nn_per_channel_quant_params
+                          *quant_params,
+                          const cmsis_nn_dims *input_dims,
+                          const int8_t *input,
+                          const cmsis_nn_dims *filter_dims,
+                          const int8_t *kernel,
+                          const cmsis_nn_dims *bias_dims,
+                          const int32_t *bias,
+                          const cmsis_nn_dims *output_dims,
+                          int8_t *output)
+{
+  if (input_dims->c != output_dims->c ||
+      dw_conv_params->padding.w > 1 || dw_conv_params->padding.h > 1)
+    {
+      return ARM_CMSIS_NN_ARG_ERROR;
+    }
+
+  return arm_depthwise_conv_s8(ctx, dw_conv_params, quant_params,
+                               input_dims, input, filter_dims, kernel,
+                               bias_dims, bias, output_dims, output);
+}
@@ -0,0 +1,112 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_elementwise_add_s8.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "arm_nnfunctions.h"
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Rescale four inputs to the common scale of the addition */
+
+static inline __m128i arm_add_input_x86(__m128i in, int32_t offset,
+                                        int32_t left_shift,
+                                        int32_t mult, int32_t shift)
+{
+  in = _mm_add_epi32(in, _mm_set1_epi32(offset));
+  in = _mm_sll_epi32(in, _mm_cvtsi32_si128(left_shift));
+  return arm_nn_x86_requantize(in, mult, shift);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+arm_cmsis_nn_status
+arm_elementwise_add_s8(const int8_t *input_1_vect,
+                       const int8_t *input_2_vect,
+                       const int32_t input_1_offset,
+                       const int32_t input_1_mult,
+                       const int32_t input_1_shift,
+                       const int32_t input_2_offset,
+                       const int32_t input_2_mult,
+                       const int32_t input_2_shift,
+                       const int32_t left_shift,
+                       int8_t *output,
+                       const int32_t out_offset,
+                       const int32_t out_mult,
+                       const int32_t out_shift,
+                       const int32_t out_activation_min,
+                       const int32_t out_activation_max,
+                       const int32_t block_size)
+{
+  int32_t i;
+
+  for (i = 0; i + 8 <= block_size; i += 8)
+    {
+      __m128i in1 = _mm_loadl_epi64((const __m128i *)(input_1_vect + i));
+      __m128i in2 = _mm_loadl_epi64((const __m128i *)(input_2_vect + i));
+      __m128i res[2];
+      int j;
+
+      for (j = 0; j < 2; j++)
+        {
+          __m128i a1 = arm_add_input_x86(_mm_cvtepi8_epi32(in1),
+                                         input_1_offset, left_shift,
+                                         input_1_mult, input_1_shift);
+          __m128i a2 = arm_add_input_x86(_mm_cvtepi8_epi32(in2),
+                                         input_2_offset, left_shift,
+                                         input_2_mult, input_2_shift);
+
+          res[j] = arm_nn_x86_requantize(_mm_add_epi32(a1, a2),
+                                         out_mult, out_shift);
+          in1 = _mm_srli_si128(in1, 4);
+          in2 = _mm_srli_si128(in2, 4);
+        }
+
+      arm_nn_x86_store_s8(output + i, res[0], res[1], out_offset,
+                          out_activation_min, out_activation_max);
+    }
+
+  for (; i < block_size; i++)
+    {
+      int32_t a1 = (input_1_vect[i] + input_1_offset) << left_shift;
+      int32_t a2 = (input_2_vect[i] + input_2_offset) << left_shift;
+      a1 = arm_nn_requantize(a1, input_1_mult, input_1_shift);
+      a2 = arm_nn_requantize(a2, input_2_mult, input_2_shift);
+
+      int32_t sum = a1 + a2;
+      sum = arm_nn_requantize(sum, out_mult, out_shift);
+      sum += out_offset;
+
+      sum = MAX(sum, out_activation_min);
+      sum = MIN(sum, out_activation_max);
+      output[i] = (int8_t)sum;
+    }
+
+  return ARM_CMSIS_NN_SUCCESS;
+}
@@ -0,0 +1,137 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_max_pool_s8.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "arm_nnfunctions.h"
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* s8 max pooling function, the channels of one output position are
+ * processed 16 at a time.  Refer header file for details.
+ */
+
+arm_cmsis_nn_status arm_max_pool_s8(const cmsis_nn_context *ctx,
+                                    const cmsis_nn_pool_params *pool_params,
+                                    const cmsis_nn_dims *input_dims,
+                                    const int8_t *src,
+                                    const cmsis_nn_dims *filter_dims,
+                                    const cmsis_nn_dims *output_dims,
+                                    int8_t *dst)
+{
+  (void)ctx;
+
+  const int32_t input_y = input_dims->h;
+  const int32_t input_x = input_dims->w;
+  const int32_t output_y = output_dims->h;
+  const int32_t output_x = output_dims->w;
+  const int32_t stride_y = pool_params->stride.h;
+  const int32_t stride_x = pool_params->stride.w;
+  const int32_t kernel_y = filter_dims->h;
+  const int32_t kernel_x = filter_dims->w;
+  const int32_t pad_y = pool_params->padding.h;
+  const int32_t pad_x = pool_params->padding.w;
+  const int32_t act_min = pool_params->activation.min;
+  const int32_t act_max = pool_params->activation.max;
+  const int32_t channel_in = input_dims->c;
+  const __m128i vmin = _mm_set1_epi8((int8_t)act_min);
+  const __m128i vmax = _mm_set1_epi8((int8_t)act_max);
+  int32_t batch_cnt = input_dims->n;
+
+  while (batch_cnt)
+    {
+      for (int i_y = 0; i_y < output_y; i_y++)
+        {
+          const int32_t base_y = i_y * stride_y - pad_y;
+          const int32_t k_y_start = MAX(0, base_y);
+          const int32_t k_y_end = MIN(base_y + kernel_y, input_y);
+
+          for (int i_x = 0; i_x < output_x; i_x++)
+            {
+              const int32_t base_x = i_x * stride_x - pad_x;
+              const int32_t k_x_start = MAX(0, base_x);
+              const int32_t k_x_end = MIN(base_x + kernel_x, input_x);
+              int32_t ch = 0;
+
+              /* An empty window leaves the output untouched, as the
+               * reference does before clamping it.
+               */
+
+              if (k_y_start >= k_y_end || k_x_start >= k_x_end)
+                {
+                  for (; ch < channel_in; ch++)
+                    {
+                      dst[ch] = MIN(MAX(dst[ch], act_min), act_max);
+                    }
+                }
+
+              for (; ch + 16 <= channel_in; ch += 16)
+                {
+                  __m128i max = _mm_set1_epi8(INT8_MIN);
+
+                  for (int k_y = k_y_start; k_y < k_y_end; k_y++)
+                    {
+                      for (int k_x = k_x_start; k_x < k_x_end; k_x++)
+                        {
+                          const int8_t *in = src + channel_in *
+                                             (k_x + k_y * input_x) + ch;
+
+                          max = _mm_max_epi8(max,
+                                  _mm_loadu_si128((const __m128i *)in));
+                        }
+                    }
+
+                  max = _mm_min_epi8(_mm_max_epi8(max, vmin), vmax);
+                  _mm_storeu_si128((__m128i *)(dst + ch), max);
+                }
+
+              for (; ch < channel_in; ch++)
+                {
+                  int32_t max = INT8_MIN;
+
+                  for (int k_y = k_y_start; k_y < k_y_end; k_y++)
+                    {
+                      for (int k_x = k_x_start; k_x < k_x_end; k_x++)
+                        {
+                          max = MAX(max, src[channel_in *
+                                             (k_x + k_y * input_x) + ch]);
+                        }
+                    }
+
+                  dst[ch] = MIN(MAX(max, act_min), act_max);
+                }
+
+              dst += channel_in;
+            }
+        }
+
+      src += channel_in * input_y * input_x;
+      batch_cnt--;
+    }
+
+  return ARM_CMSIS_NN_SUCCESS;
+}
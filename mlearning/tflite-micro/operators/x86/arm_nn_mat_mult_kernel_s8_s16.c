@@ -0,0 +1,97 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_nn_mat_mult_kernel_s8_s16.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "arm_nnfunctions.h"
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* Matrix-multiplication of the filters with two im2col columns, with
+ * per-channel requantization.  Refer header file for details.
+ */
+
+int8_t *arm_nn_mat_mult_kernel_s8_s16(const int8_t *input_a,
+                                      const int16_t *input_b,
+                                      const uint16_t output_ch,
+                                      const int32_t *out_shift,
+                                      const int32_t *out_mult,
+                                      const int32_t out_offset,
+                                      const int16_t activation_min,
+                                      const int16_t activation_max,
+                                      const int32_t num_col_a,
+                                      const int32_t aligned_num_col_a,
+                                      const int32_t *const output_bias,
+                                      int8_t *out_0)
+{
+  const int16_t *ip_b0 = input_b;
+  const int16_t *ip_b1 = input_b + aligned_num_col_a;
+  int8_t *out_1 = out_0 + output_ch;
+  int i;
+
+  for (i = 0; i < output_ch; i++)
+    {
+      const int8_t *ip_a = input_a + i * num_col_a;
+      int32_t ch_out[2] =
+        {
+          0
+        };
+
+      int32_t col;
+
+      if (output_bias)
+        {
+          ch_out[0] = output_bias[i];
+          ch_out[1] = output_bias[i];
+        }
+
+      col = arm_nn_x86_dot2_s8_s16(ip_a, ip_b0, ip_b1, num_col_a,
+                                   &ch_out[0], &ch_out[1]);
+
+      for (; col < num_col_a; col++)
+        {
+          ch_out[0] += ip_a[col] * ip_b0[col];
+          ch_out[1] += ip_a[col] * ip_b1[col];
+        }
+
+      for (int j = 0; j < 2; j++)
+        {
+          ch_out[j] = arm_nn_requantize(ch_out[j], out_mult[i],
+                                        out_shift[i]);
+          ch_out[j] += out_offset;
+          ch_out[j] = MAX(ch_out[j], activation_min);
+          ch_out[j] = MIN(ch_out[j], activation_max);
+        }
+
+      *out_0++ = (int8_t)ch_out[0];
+      *out_1++ = (int8_t)ch_out[1];
+    }
+
+  /* return the new output pointer with offset */
+
+  return out_1;
+}
@@ -0,0 +1,82 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_nn_vec_mat_mult_t_s8.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "arm_nnsupportfunctions.h"
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* s8 vector by transposed matrix multiplication, the kernel of the fully
+ * connected operator.  Refer header file for details.
+ */
+
+arm_cmsis_nn_status arm_nn_vec_mat_mult_t_s8(const int8_t *lhs,
+                                             const int8_t *rhs,
+                                             const int32_t *bias,
+                                             int8_t *dst,
+                                             const int32_t lhs_offset,
+                                             const int32_t dst_offset,
+                                             const int32_t dst_multiplier,
+                                             const int32_t dst_shift,
+                                             const int32_t rhs_cols,
+                                             const int32_t rhs_rows,
+                                             const int32_t activation_min,
+                                             const int32_t activation_max,
+                                             const int32_t address_offset)
+{
+  int32_t row;
+
+  for (row = 0; row < rhs_rows; row++)
+    {
+      int32_t res = 0;
+      int32_t col;
+
+      if (bias)
+        {
+          res = *bias++;
+        }
+
+      col = arm_nn_x86_dot_s8(lhs, (int16_t)lhs_offset, rhs, rhs_cols,
+                              &res);
+      for (; col < rhs_cols; col++)
+        {
+          res += (lhs[col] + lhs_offset) * rhs[col];
+        }
+
+      res = arm_nn_requantize(res, dst_multiplier, dst_shift);
+      res += dst_offset;
+      res = MAX(res, activation_min);
+      res = MIN(res, activation_max);
+
+      *dst = (int8_t)res;
+      dst += address_offset;
+      rhs += rhs_cols;
+    }
+
+  return ARM_CMSIS_NN_SUCCESS;
+}
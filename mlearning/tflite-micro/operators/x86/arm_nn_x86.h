@@ -0,0 +1,215 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_nn_x86.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_MLEARNING_TFLITE_MICRO_OPERATORS_X86_ARM_NN_X86_H
+#define __APPS_MLEARNING_TFLITE_MICRO_OPERATORS_X86_ARM_NN_X86_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+#include <smmintrin.h>
+
+#ifdef __AVX2__
+#  include <immintrin.h>
+#endif
+
+#include "arm_nnsupportfunctions.h"
+
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/* Load four int8 values, without alignment requirement */
+
+static inline __m128i arm_nn_x86_load4(const int8_t *src)
+{
+  int32_t val;
+
+  memcpy(&val, src, sizeof(val));
+  return _mm_cvtsi32_si128(val);
+}
+
+/* Horizontal sum of four int32 lanes */
+
+static inline int32_t arm_nn_x86_hsum_epi32(__m128i v)
+{
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+  v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(v);
+}
+
+#ifdef __AVX2__
+static inline int32_t arm_nn_x86_hsum256_epi32(__m256i v)
+{
+  return arm_nn_x86_hsum_epi32(_mm_add_epi32(_mm256_castsi256_si128(v),
+                                             _mm256_extracti128_si256(v, 1)));
+}
+#endif
+
+/* Dot product of n int8 values, each extended to int16 and offset by
+ * a_offset, with n int8 values.  The int16 products are summed pairwise
+ * into int32 lanes, which wrap exactly like the scalar accumulator of the
+ * reference kernels.  Returns the number of elements consumed, a multiple
+ * of the vector width; the caller finishes the tail.
+ */
+
+static inline int32_t arm_nn_x86_dot_s8(const int8_t *a, int16_t a_offset,
+                                        const int8_t *b, int32_t n,
+                                        int32_t *sum)
+{
+  int32_t i = 0;
+#ifdef __AVX2__
+  __m256i acc256 = _mm256_setzero_si256();
+  __m256i off256 = _mm256_set1_epi16(a_offset);
+
+  for (; i + 16 <= n; i += 16)
+    {
+      __m256i va = _mm256_cvtepi8_epi16(
+                     _mm_loadu_si128((const __m128i *)(a + i)));
+      __m256i vb = _mm256_cvtepi8_epi16(
+                     _mm_loadu_si128((const __m128i *)(b + i)));
+
+      va = _mm256_add_epi16(va, off256);
+      acc256 = _mm256_add_epi32(acc256, _mm256_madd_epi16(va, vb));
+    }
+
+  *sum += arm_nn_x86_hsum256_epi32(acc256);
+#endif
+
+  __m128i acc = _mm_setzero_si128();
+  __m128i off = _mm_set1_epi16(a_offset);
+
+  for (; i + 8 <= n; i += 8)
+    {
+      __m128i va = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)
+                                                      (a + i)));
+      __m128i vb = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)
+                                                      (b + i)));
+
+      va = _mm_add_epi16(va, off);
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(va, vb));
+    }
+
+  *sum += arm_nn_x86_hsum_epi32(acc);
+  return i;
+}
+
+/* Dot products of one int8 row with two int16 columns */
+
+static inline int32_t arm_nn_x86_dot2_s8_s16(const int8_t *a,
+                                             const int16_t *b0,
+                                             const int16_t *b1,
+                                             int32_t n,
+                                             int32_t *sum0, int32_t *sum1)
+{
+  int32_t i = 0;
+#ifdef __AVX2__
+  __m256i acc0 = _mm256_setzero_si256();
+  __m256i acc1 = _mm256_setzero_si256();
+
+  for (; i + 16 <= n; i += 16)
+    {
+      __m256i va = _mm256_cvtepi8_epi16(
+                     _mm_loadu_si128((const __m128i *)(a + i)));
+
+      acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(va,
+               _mm256_loadu_si256((const __m256i *)(b0 + i))));
+      acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(va,
+               _mm256_loadu_si256((const __m256i *)(b1 + i))));
+    }
+
+  *sum0 += arm_nn_x86_hsum256_epi32(acc0);
+  *sum1 += arm_nn_x86_hsum256_epi32(acc1);
+#endif
+
+  __m128i acc2 = _mm_setzero_si128();
+  __m128i acc3 = _mm_setzero_si128();
+
+  for (; i + 8 <= n; i += 8)
+    {
+      __m128i va = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)
+                                                      (a + i)));
+
+      acc2 = _mm_add_epi32(acc2, _mm_madd_epi16(va,
+               _mm_loadu_si128((const __m128i *)(b0 + i))));
+      acc3 = _mm_add_epi32(acc3, _mm_madd_epi16(va,
+               _mm_loadu_si128((const __m128i *)(b1 + i))));
+    }
+
+  *sum0 += arm_nn_x86_hsum_epi32(acc2);
+  *sum1 += arm_nn_x86_hsum_epi32(acc3);
+  return i;
+}
+
+/* Vector form of arm_nn_requantize() for one multiplier and shift.  The
+ * doubling high multiply adds 1 << 30 and keeps bits 31..62 of the 64-bit
+ * product, the divide rounds half away from zero, as the scalar version.
+ */
+
+static inline __m128i arm_nn_x86_requantize(__m128i val, int32_t multiplier,
+                                            int32_t shift)
+{
+  const __m128i mult  = _mm_set1_epi32(multiplier);
+  const __m128i round = _mm_set1_epi64x(1ll << 30);
+  const int32_t exp   = RIGHT_SHIFT(shift);
+  const __m128i mask  = _mm_set1_epi32((int32_t)((1u << exp) - 1));
+  __m128i even;
+  __m128i odd;
+  __m128i rem;
+  __m128i thr;
+
+  val  = _mm_sll_epi32(val, _mm_cvtsi32_si128(LEFT_SHIFT(shift)));
+
+  even = _mm_add_epi64(_mm_mul_epi32(val, mult), round);
+  odd  = _mm_add_epi64(_mm_mul_epi32(_mm_srli_epi64(val, 32), mult),
+                       round);
+  even = _mm_srli_epi64(even, 31);
+  odd  = _mm_slli_epi64(_mm_srli_epi64(odd, 31), 32);
+  val  = _mm_blend_epi16(even, odd, 0xcc);
+
+  rem  = _mm_and_si128(val, mask);
+  val  = _mm_sra_epi32(val, _mm_cvtsi32_si128(exp));
+  thr  = _mm_sub_epi32(_mm_srli_epi32(mask, 1),
+                       _mm_cmplt_epi32(val, _mm_setzero_si128()));
+  return _mm_sub_epi32(val, _mm_cmpgt_epi32(rem, thr));
+}
+
+/* Add offset, clamp and narrow 8 int32 values to int8 */
+
+static inline void arm_nn_x86_store_s8(int8_t *dst, __m128i lo, __m128i hi,
+                                       int32_t offset, int32_t act_min,
+                                       int32_t act_max)
+{
+  const __m128i off = _mm_set1_epi32(offset);
+  const __m128i min = _mm_set1_epi32(act_min);
+  const __m128i max = _mm_set1_epi32(act_max);
+
+  lo = _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(lo, off), min), max);
+  hi = _mm_min_epi32(_mm_max_epi32(_mm_add_epi32(hi, off), min), max);
+  lo = _mm_packs_epi32(lo, hi);
+  _mm_storel_epi64((__m128i *)dst, _mm_packs_epi16(lo, lo));
+}
+
+#endif /* __APPS_MLEARNING_TFLITE_MICRO_OPERATORS_X86_ARM_NN_X86_H */
@@ -0,0 +1,66 @@
+/****************************************************************************
+ * apps/mlearning/tflite-micro/operators/x86/arm_q7_to_q15_with_offset.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include "arm_nn_x86.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void arm_q7_to_q15_with_offset(const int8_t *src,
+                               int16_t *dst,
+                               int32_t block_size,
+                               int16_t offset)
+{
+  int32_t i = 0;
+#ifdef __AVX2__
+  const __m256i off256 = _mm256_set1_epi16(offset);
+
+  for (; i + 16 <= block_size; i += 16)
+    {
+      __m256i v = _mm256_cvtepi8_epi16(
+                    _mm_loadu_si128((const __m128i *)(src + i)));
+
+      _mm256_storeu_si256((__m256i *)(dst + i),
+                          _mm256_add_epi16(v, off256));
+    }
+#endif
+
+  const __m128i off = _mm_set1_epi16(offset);
+
+  for (; i + 8 <= block_size; i += 8)
+    {
+      __m128i v = _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)
+                                                     (src + i)));
+
+      _mm_storeu_si128((__m128i *)(dst + i), _mm_add_epi16(v, off));
+    }
+
+  for (; i < block_size; i++)
+    {
+      dst[i] = (int16_t)src[i] + offset;
+    }
+}
@@ -24,15 +24,115 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <unistd.h>
 
+#include <algorithm>
+#include <cinttypes>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 #include <memory>
+#include <new>
+#include <vector>
+
+#include <nuttx/clock.h>
 
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_profiler_interface.h"
+#include "tensorflow/lite/schema/schema_utils.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TFLM_ARENA_ALIGN  16
+#define TFLM_MAX_OPS      CONFIG_TFLITEMICRO_TOOL_MAX_OPS
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+typedef tflite::MicroMutableOpResolver<TFLM_MAX_OPS> tflm_resolver_t;
+
+/* Collects the latency of every operator of every timed Invoke().  The
+ * interpreter reports the operators in the same order on each Invoke(), so
+ * the n-th event of an invocation always belongs to the same operator.
+ */
+
+class tflm_bench_profiler : public tflite::MicroProfilerInterface
+{
+public:
+  uint32_t BeginEvent(const char *tag) override
+  {
+    uint32_t handle = event_++;
+
+    if (samples_ == nullptr)
+      {
+        tags_.push_back(tag);
+        start_.push_back(0);
+      }
+
+    if (handle < start_.size())
+      {
+        start_[handle] = perf_gettime();
+      }
+
+    return handle;
+  }
+
+  void EndEvent(uint32_t handle) override
+  {
+    if (samples_ != nullptr && handle < tags_.size())
+      {
+        samples_[handle * niters_ + iter_] =
+          (uint32_t)(perf_gettime() - start_[handle]);
+      }
+  }
+
+  /* Switch from the warm-up run, which discovers the events, to the timed
+   * runs.
+   */
+
+  bool Setup(int niters)
+  {
+    samples_.reset(new (std::nothrow) uint32_t[tags_.size() * niters]);
+    niters_ = niters;
+    return samples_ != nullptr;
+  }
+
+  void Start(int iter)
+  {
+    iter_  = iter;
+    event_ = 0;
+  }
+
+  size_t Events(void) const
+  {
+    return tags_.size();
+  }
+
+  const char *Tag(size_t event) const
+  {
+    return tags_[event];
+  }
+
+  uint32_t *Samples(size_t event) const
+  {
+    return &samples_[event * niters_];
+  }
+
+private:
+  std::vector<const char *> tags_;
+  std::vector<clock_t> start_;
+  std::unique_ptr<uint32_t[]> samples_;
+  uint32_t event_ = 0;
+  int niters_ = 0;
+  int iter_ = 0;
+};
 
 /****************************************************************************
  * Private Functions
@@ -43,11 +143,374 @@ static void usage(void)
   printf("\nUtility to use tflite micro on nuttx.\n"
     "[ -C       ] Compile tflite model into c++ codes.\n"
     "[ -E       ] Do once evaluation (for profiling).\n"
+    "[ -B       ] Benchmark: search the minimum arena, then time\n"
+    "             warm invocations per operator.\n"
+    "[ -n <int> ] Benchmark invocations, default %d.\n"
     "[ -i <str> ] Readable model file path.\n"
     "[ -o <str> ] Writable c++ file path.\n"
     "[ -p <str> ] Prefix of compiled code.\n"
-    "[ -a <int> ] Arena size (mempool).\n"
-    "[ -h       ] Print this message.\n");
+    "[ -a <int> ] Arena size (mempool), first guess with -B.\n"
+    "[ -h       ] Print this message.\n",
+    CONFIG_TFLITEMICRO_TOOL_ITERATIONS);
+}
+
+/* Return true if every operator using the opcode consumes int8 data (or
+ * quantizes float32 into int8), so the int8-only kernel can be registered.
+ */
+
+static bool tflm_int8_only(const tflite::Model *model, uint32_t opcode,
+                           tflite::BuiltinOperator code)
+{
+  for (auto subgraph : *model->subgraphs())
+    {
+      auto tensors = subgraph->tensors();
+
+      for (auto op : *subgraph->operators())
+        {
+          if (op->opcode_index() != opcode)
+            {
+              continue;
+            }
+
+          if (op->inputs() == nullptr || op->inputs()->size() == 0 ||
+              op->inputs()->Get(0) < 0 || op->outputs() == nullptr ||
+              op->outputs()->size() == 0)
+            {
+              return false;
+            }
+
+          auto in  = tensors->Get(op->inputs()->Get(0))->type();
+          auto out = tensors->Get(op->outputs()->Get(0))->type();
+
+          if (code == tflite::BuiltinOperator_QUANTIZE)
+            {
+              if (in != tflite::TensorType_FLOAT32 ||
+                  out != tflite::TensorType_INT8)
+                {
+                  return false;
+                }
+            }
+          else if (in != tflite::TensorType_INT8)
+            {
+              return false;
+            }
+        }
+    }
+
+  return true;
+}
+
+static TfLiteStatus tflm_add_op(tflm_resolver_t &resolver,
+                                tflite::BuiltinOperator code, bool int8)
+{
+#define TFLM_OP(op, add) \
+  case tflite::BuiltinOperator_##op: \
+    return resolver.add();
+#define TFLM_OP_INT8(op, add, reg) \
+  case tflite::BuiltinOperator_##op: \
+    return int8 ? resolver.add(tflite::reg()) : resolver.add();
+
+  switch (code)
+    {
+      TFLM_OP_INT8(CONV_2D, AddConv2D, Register_CONV_2D_INT8)
+      TFLM_OP_INT8(MAX_POOL_2D, AddMaxPool2D, Register_MAX_POOL_2D_INT8)
+      TFLM_OP_INT8(QUANTIZE, AddQuantize, Register_QUANTIZE_FLOAT32_INT8)
+      TFLM_OP_INT8(DEQUANTIZE, AddDequantize, Register_DEQUANTIZE_INT8)
+      TFLM_OP_INT8(MEAN, AddMean, Register_MEAN_INT8)
+      TFLM_OP_INT8(FULLY_CONNECTED, AddFullyConnected,
+                   Register_FULLY_CONNECTED_INT8)
+      TFLM_OP_INT8(SOFTMAX, AddSoftmax, Register_SOFTMAX_INT8)
+      TFLM_OP(ABS, AddAbs)
+      TFLM_OP(ADD, AddAdd)
+      TFLM_OP(ADD_N, AddAddN)
+      TFLM_OP(ARG_MAX, AddArgMax)
+      TFLM_OP(ARG_MIN, AddArgMin)
+      TFLM_OP(AVERAGE_POOL_2D, AddAveragePool2D)
+      TFLM_OP(BATCH_TO_SPACE_ND, AddBatchToSpaceNd)
+      TFLM_OP(CAST, AddCast)
+      TFLM_OP(CEIL, AddCeil)
+      TFLM_OP(CONCATENATION, AddConcatenation)
+      TFLM_OP(COS, AddCos)
+      TFLM_OP(DEPTH_TO_SPACE, AddDepthToSpace)
+      TFLM_OP(DEPTHWISE_CONV_2D, AddDepthwiseConv2D)
+      TFLM_OP(DIV, AddDiv)
+      TFLM_OP(ELU, AddElu)
+      TFLM_OP(EQUAL, AddEqual)
+      TFLM_OP(EXP, AddExp)
+      TFLM_OP(EXPAND_DIMS, AddExpandDims)
+      TFLM_OP(FILL, AddFill)
+      TFLM_OP(FLOOR, AddFloor)
+      TFLM_OP(FLOOR_DIV, AddFloorDiv)
+      TFLM_OP(FLOOR_MOD, AddFloorMod)
+      TFLM_OP(GATHER, AddGather)
+      TFLM_OP(GATHER_ND, AddGatherNd)
+      TFLM_OP(GREATER, AddGreater)
+      TFLM_OP(GREATER_EQUAL, AddGreaterEqual)
+      TFLM_OP(HARD_SWISH, AddHardSwish)
+      TFLM_OP(L2_NORMALIZATION, AddL2Normalization)
+      TFLM_OP(L2_POOL_2D, AddL2Pool2D)
+      TFLM_OP(LEAKY_RELU, AddLeakyRelu)
+      TFLM_OP(LESS, AddLess)
+      TFLM_OP(LESS_EQUAL, AddLessEqual)
+      TFLM_OP(LOG, AddLog)
+      TFLM_OP(LOGICAL_AND, AddLogicalAnd)
+      TFLM_OP(LOGICAL_NOT, AddLogicalNot)
+      TFLM_OP(LOGICAL_OR, AddLogicalOr)
+      TFLM_OP(LOGISTIC, AddLogistic)
+      TFLM_OP(LOG_SOFTMAX, AddLogSoftmax)
+      TFLM_OP(MAXIMUM, AddMaximum)
+      TFLM_OP(MINIMUM, AddMinimum)
+      TFLM_OP(MIRROR_PAD, AddMirrorPad)
+      TFLM_OP(MUL, AddMul)
+      TFLM_OP(NEG, AddNeg)
+      TFLM_OP(NOT_EQUAL, AddNotEqual)
+      TFLM_OP(PACK, AddPack)
+      TFLM_OP(PAD, AddPad)
+      TFLM_OP(PADV2, AddPadV2)
+      TFLM_OP(PRELU, AddPrelu)
+      TFLM_OP(REDUCE_MAX, AddReduceMax)
+      TFLM_OP(RELU, AddRelu)
+      TFLM_OP(RELU6, AddRelu6)
+      TFLM_OP(RESHAPE, AddReshape)
+      TFLM_OP(RESIZE_BILINEAR, AddResizeBilinear)
+      TFLM_OP(RESIZE_NEAREST_NEIGHBOR, AddResizeNearestNeighbor)
+      TFLM_OP(ROUND, AddRound)
+      TFLM_OP(RSQRT, AddRsqrt)
+      TFLM_OP(SELECT_V2, AddSelectV2)
+      TFLM_OP(SHAPE, AddShape)
+      TFLM_OP(SIN, AddSin)
+      TFLM_OP(SLICE, AddSlice)
+      TFLM_OP(SPACE_TO_BATCH_ND, AddSpaceToBatchNd)
+      TFLM_OP(SPACE_TO_DEPTH, AddSpaceToDepth)
+      TFLM_OP(SPLIT, AddSplit)
+      TFLM_OP(SPLIT_V, AddSplitV)
+      TFLM_OP(SQRT, AddSqrt)
+      TFLM_OP(SQUARE, AddSquare)
+      TFLM_OP(SQUARED_DIFFERENCE, AddSquaredDifference)
+      TFLM_OP(SQUEEZE, AddSqueeze)
+      TFLM_OP(STRIDED_SLICE, AddStridedSlice)
+      TFLM_OP(SUB, AddSub)
+      TFLM_OP(SUM, AddSum)
+      TFLM_OP(SVDF, AddSvdf)
+      TFLM_OP(TANH, AddTanh)
+      TFLM_OP(TRANSPOSE, AddTranspose)
+      TFLM_OP(TRANSPOSE_CONV, AddTransposeConv)
+      TFLM_OP(UNIDIRECTIONAL_SEQUENCE_LSTM, AddUnidirectionalSequenceLSTM)
+      TFLM_OP(UNPACK, AddUnpack)
+      TFLM_OP(ZEROS_LIKE, AddZerosLike)
+      default:
+        return kTfLiteError;
+    }
+
+#undef TFLM_OP
+#undef TFLM_OP_INT8
+}
+
+/* Register exactly the operators the model uses */
+
+static int tflm_resolver(const tflite::Model *model,
+                         tflm_resolver_t &resolver)
+{
+  auto opcodes = model->operator_codes();
+
+  for (uint32_t i = 0; opcodes != nullptr && i < opcodes->size(); i++)
+    {
+      tflite::BuiltinOperator code = tflite::GetBuiltinCode(opcodes->Get(i));
+      bool int8 = tflm_int8_only(model, i, code);
+
+      if (tflm_add_op(resolver, code, int8) != kTfLiteOk)
+        {
+          printf("Unsupported operator %s\n",
+                 tflite::EnumNameBuiltinOperator(code));
+          return -1;
+        }
+
+      printf("op %s%s\n", tflite::EnumNameBuiltinOperator(code),
+             int8 ? " (int8)" : "");
+    }
+
+  return 0;
+}
+
+/* Return true if the model can be planned into an arena of size bytes */
+
+static bool tflm_arena_fits(const tflite::Model *model,
+                            tflm_resolver_t &resolver,
+                            uint8_t *arena, size_t size, size_t *used)
+{
+  std::unique_ptr<tflite::MicroInterpreter> interpreter(
+    new (std::nothrow) tflite::MicroInterpreter(model, resolver, arena,
+                                                size));
+
+  if (interpreter == nullptr || interpreter->AllocateTensors() != kTfLiteOk)
+    {
+      return false;
+    }
+
+  if (used != nullptr)
+    {
+      *used = interpreter->arena_used_bytes();
+    }
+
+  return true;
+}
+
+/* Find the smallest arena that AllocateTensors() accepts, starting from the
+ * -a guess and doubling it up to the configured limit.  The search runs in
+ * one buffer, which is returned for the benchmark.
+ */
+
+static size_t tflm_arena_search(const tflite::Model *model,
+                                tflm_resolver_t &resolver, size_t guess,
+                                std::unique_ptr<uint8_t[]> &arena)
+{
+  size_t hi = std::max<size_t>(guess, TFLM_ARENA_ALIGN);
+  size_t lo = 0;
+  size_t used;
+
+  for (; ; )
+    {
+      arena.reset(new (std::nothrow) uint8_t[hi]);
+      if (arena == nullptr)
+        {
+          printf("No memory for %zu bytes arena\n", hi);
+          return 0;
+        }
+
+      if (tflm_arena_fits(model, resolver, arena.get(), hi, &used))
+        {
+          break;
+        }
+
+      if (hi >= CONFIG_TFLITEMICRO_TOOL_MAX_ARENA)
+        {
+          printf("Model does not fit in %d bytes arena\n",
+                 CONFIG_TFLITEMICRO_TOOL_MAX_ARENA);
+          return 0;
+        }
+
+      lo = hi;
+      hi = std::min<size_t>(hi * 2, CONFIG_TFLITEMICRO_TOOL_MAX_ARENA);
+    }
+
+  /* The reported usage is usually the answer, try it first */
+
+  used = (used + TFLM_ARENA_ALIGN - 1) & ~(size_t)(TFLM_ARENA_ALIGN - 1);
+  if (used > lo && used < hi &&
+      tflm_arena_fits(model, resolver, arena.get(), used, nullptr))
+    {
+      hi = used;
+    }
+
+  while (hi - lo > TFLM_ARENA_ALIGN)
+    {
+      size_t mid = ((lo + hi) / 2) & ~(size_t)(TFLM_ARENA_ALIGN - 1);
+
+      if (mid <= lo)
+        {
+          break;
+        }
+
+      if (tflm_arena_fits(model, resolver, arena.get(), mid, nullptr))
+        {
+          hi = mid;
+        }
+      else
+        {
+          lo = mid;
+        }
+    }
+
+  return hi;
+}
+
+static uint32_t tflm_percentile(const uint32_t *sorted, int n, int pct)
+{
+  return sorted[(size_t)(n - 1) * pct / 100];
+}
+
+static unsigned long tflm_usec(uint32_t ticks)
+{
+  struct timespec ts;
+
+  perf_convert(ticks, &ts);
+  return ts.tv_sec * 1000000ul + ts.tv_nsec / 1000;
+}
+
+static void tflm_report(const char *name, uint32_t *samples, int n)
+{
+  std::sort(samples, samples + n);
+  printf("%-24s %8lu %8lu %8lu %8lu %8lu\n", name,
+         tflm_usec(samples[0]),
+         tflm_usec(tflm_percentile(samples, n, 50)),
+         tflm_usec(tflm_percentile(samples, n, 90)),
+         tflm_usec(tflm_percentile(samples, n, 99)),
+         tflm_usec(samples[n - 1]));
+}
+
+static int tflm_benchmark(const tflite::Model *model,
+                          tflm_resolver_t &resolver, size_t guess,
+                          int niters)
+{
+  std::unique_ptr<uint8_t[]> arena;
+  std::unique_ptr<uint32_t[]> total(new (std::nothrow) uint32_t[niters]);
+  tflm_bench_profiler profiler;
+  size_t size;
+  int i;
+
+  size = tflm_arena_search(model, resolver, guess, arena);
+  if (size == 0 || total == nullptr)
+    {
+      return -1;
+    }
+
+  std::unique_ptr<tflite::MicroInterpreter> interpreter(
+    new (std::nothrow) tflite::MicroInterpreter(model, resolver,
+      arena.get(), size, nullptr,
+      reinterpret_cast<tflite::MicroProfilerInterface *>(&profiler)));
+
+  if (interpreter == nullptr || interpreter->AllocateTensors() != kTfLiteOk)
+    {
+      return -1;
+    }
+
+  for (i = 0; i < (int)interpreter->inputs_size(); i++)
+    {
+      TfLiteTensor *input = interpreter->input(i);
+      memset(input->data.raw, 0, input->bytes);
+    }
+
+  /* Warm-up run: touches the caches and discovers the operator events */
+
+  profiler.Start(0);
+  if (interpreter->Invoke() != kTfLiteOk || !profiler.Setup(niters))
+    {
+      printf("Warm-up invoke failed\n");
+      return -1;
+    }
+
+  for (i = 0; i < niters; i++)
+    {
+      clock_t start = perf_gettime();
+
+      profiler.Start(i);
+      interpreter->Invoke();
+      total[i] = (uint32_t)(perf_gettime() - start);
+    }
+
+  printf("arena: minimum %zu bytes, peak used %zu bytes\n",
+         size, interpreter->arena_used_bytes());
+  printf("%d invocations, latency in us\n", niters);
+  printf("%-24s %8s %8s %8s %8s %8s\n",
+         "operator", "min", "p50", "p90", "p99", "max");
+
+  for (size_t ev = 0; ev < profiler.Events(); ev++)
+    {
+      tflm_report(profiler.Tag(ev), profiler.Samples(ev), niters);
+    }
+
+  tflm_report("Invoke", total.get(), niters);
+  return 0;
 }
 
 /****************************************************************************
@@ -61,19 +524,27 @@ extern "C" int main(int argc, FAR char* argv[])
   const char* prefix = "NXAI";
   bool need_compile = false;
   bool need_invoke = false;
+  bool need_bench = false;
+  int iterations = CONFIG_TFLITEMICRO_TOOL_ITERATIONS;
   int arenaSize = 1024 * 8;
 
   int ch;
-  while ((ch = getopt(argc, argv, "CEhi:o:p:a:")) != EOF)
+  while ((ch = getopt(argc, argv, "BCEhi:n:o:p:a:")) != EOF)
     {
       switch (ch)
         {
+          case 'B':
+            need_bench = true;
+            break;
           case 'C':
             need_compile = true;
             break;
           case 'E':
             need_invoke = true;
             break;
+          case 'n':
+            iterations = strtol(optarg, NULL, 0);
+            break;
           case 'p':
             prefix = optarg;
             break;
@@ -93,13 +564,19 @@ extern "C" int main(int argc, FAR char* argv[])
         }
     }
 
-  if (!modelFileName || !codeFileName)
+  if (!modelFileName || (need_compile && !codeFileName) || iterations <= 0)
     {
       usage();
       return -1;
     }
 
   std::ifstream ifs(modelFileName, std::ios::binary);
+  if (!ifs)
+    {
+      printf("Failed to open %s\n", modelFileName);
+      return -1;
+    }
+
   ifs.seekg(0, std::ios::end);
   size_t modelSize = ifs.tellg();
   std::unique_ptr<uint8_t[]> pModel(new uint8_t[modelSize]);
@@ -108,23 +585,27 @@ extern "C" int main(int argc, FAR char* argv[])
   ifs.read(reinterpret_cast<char*>(pModel.get()), modelSize);
   ifs.close();
 
-  /* HACK: can change operators here. */
+  /* Register the operators found in the model */
 
-  tflite::MicroMutableOpResolver<8> resolver;
-  resolver.AddConv2D(tflite::Register_CONV_2D_INT8());
-  resolver.AddMaxPool2D(tflite::Register_MAX_POOL_2D_INT8());
-  resolver.AddQuantize(tflite::Register_QUANTIZE_FLOAT32_INT8());
-  resolver.AddDequantize(tflite::Register_DEQUANTIZE_INT8());
-  resolver.AddMean(tflite::Register_MEAN_INT8());
-  resolver.AddReshape();
-  resolver.AddFullyConnected(tflite::Register_FULLY_CONNECTED_INT8());
-  resolver.AddSoftmax(tflite::Register_SOFTMAX_INT8());
+  const tflite::Model* model = tflite::GetModel(pModel.get());
+  std::unique_ptr<tflm_resolver_t> resolver(new tflm_resolver_t());
+  if (tflm_resolver(model, *resolver) < 0)
+    {
+      return -1;
+    }
+
+  if (need_bench)
+    {
+      int ret = tflm_benchmark(model, *resolver, arenaSize, iterations);
+      printf("nxai done!\n");
+      return ret;
+    }
 
   std::unique_ptr<uint8_t[]> pArena(new uint8_t[arenaSize]);
 
   tflite::MicroProfiler profiler;
-  tflite::MicroInterpreter interpreter(tflite::GetModel(pModel.get()),
-    resolver, pArena.get(), arenaSize, nullptr,
+  tflite::MicroInterpreter interpreter(model,
+    *resolver, pArena.get(), arenaSize, nullptr,
     reinterpret_cast<tflite::MicroProfilerInterface*>(&profiler));
 
   /* HACK: can add testcases here. */
@@ -149,4 +630,4 @@ extern "C" int main(int argc, FAR char* argv[])
 
   printf("nxai done!\n");
   return 0;
-}
\ No newline at end of file
+}
@@ -89,6 +89,7 @@ static pvMBFrameClose pvMBFrameCloseCur;
 bool(*pxMBFrameCBByteReceived)(void);
 bool(*pxMBFrameCBTransmitterEmpty)(void);
 bool(*pxMBPortCBTimerExpired)(void);
+bool(*pxMBFrameCBBlockReceived)(const uint8_t *pucData, uint16_t usLen);
 
 bool(*pxMBFrameCBReceiveFSMCur)(void);
 bool(*pxMBFrameCBTransmitFSMCur)(void);
@@ -161,6 +162,7 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
           peMBFrameReceiveCur = eMBRTUReceive;
           pvMBFrameCloseCur = vMBPortClose;
           pxMBFrameCBByteReceived = xMBRTUReceiveFSM;
+          pxMBFrameCBBlockReceived = xMBRTUReceiveBlock;
           pxMBFrameCBTransmitterEmpty = xMBRTUTransmitFSM;
           pxMBPortCBTimerExpired = xMBRTUTimerT35Expired;
 
@@ -175,6 +177,7 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
           peMBFrameReceiveCur = eMBASCIIReceive;
           pvMBFrameCloseCur = vMBPortClose;
           pxMBFrameCBByteReceived = xMBASCIIReceiveFSM;
+          pxMBFrameCBBlockReceived = NULL;
           pxMBFrameCBTransmitterEmpty = xMBASCIITransmitFSM;
           pxMBPortCBTimerExpired = xMBASCIITimerT1SExpired;
 
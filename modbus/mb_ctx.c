@@ -0,0 +1,1056 @@
+/****************************************************************************
+ * apps/modbus/mb_ctx.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "port.h"
+#include "mbcrc.h"
+
+#include "modbus/mb.h"
+#include "modbus/mb_ctx.h"
+#include "modbus/mbframe.h"
+#include "modbus/mbproto.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_CTX_RTU_SIZE_MAX     256  /* Address + PDU + CRC */
+#define MB_CTX_RTU_SIZE_MIN     4    /* Address + function + CRC */
+#define MB_CTX_TCP_HDR_SIZE     7    /* TID, PID, LEN and UID */
+#define MB_CTX_TCP_SIZE_MAX     (MB_CTX_TCP_HDR_SIZE + MB_PDU_SIZE_MAX)
+#define MB_CTX_TCP_PID          2
+#define MB_CTX_TCP_LEN          4
+#define MB_CTX_TCP_DEFAULT_PORT 502
+
+/* Request limits, identical to the ones enforced by functions/ */
+
+#define MB_CTX_READ_BITS_MAX    0x07d0
+#define MB_CTX_WRITE_BITS_MAX   0x07b0
+#define MB_CTX_READ_REGS_MAX    0x007d
+#define MB_CTX_WRITE_REGS_MAX   0x0078
+#define MB_CTX_RW_WRITE_MAX     0x0079
+
+#define MB_CTX_GET16(p)         ((uint16_t)((p)[0] << 8 | (p)[1]))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct xMBCtxConn
+{
+  int      iFd;                            /* Connected socket or -1 */
+  uint16_t usRxLen;                        /* Bytes buffered */
+  time_t   xLastActive;                    /* Last receive time */
+  uint8_t  ucBuffer[MB_CTX_TCP_SIZE_MAX];  /* MBAP request/response */
+};
+
+struct xMBCtx
+{
+  eMBMode          eMode;
+  uint8_t          ucAddress;
+  xMBCtxCallbacks  xCB;
+  int              iFd;          /* Serial device or listening socket */
+
+  /* Positional map from the pollfd entries filled in by iMBCtxPollSetup()
+   * to connection slots (-1 for the serial device or listener).
+   */
+
+  int              iMap[MB_CTX_POLLFDS_MAX];
+  int              nMap;
+
+  /* RTU state */
+
+  struct termios   xOldTIO;
+  struct timespec  xLastRx;      /* Time the last byte was received */
+  uint32_t         ulT35Us;      /* Inter-frame gap */
+  uint16_t         usRxLen;
+  uint8_t          ucRtuBuf[MB_CTX_RTU_SIZE_MAX];
+
+  /* TCP state.  Requests are executed in ucTcpBuf rather than in the
+   * connection buffer because a response may be longer than its request
+   * and would otherwise overwrite pipelined requests behind it.
+   */
+
+  struct xMBCtxConn xConns[CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS];
+  uint8_t          ucTcpBuf[MB_CTX_TCP_SIZE_MAX];
+};
+
+/****************************************************************************
+ * External Function Prototypes
+ ****************************************************************************/
+
+eMBException prveMBError2Exception(eMBErrorCode eErrorCode);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint32_t prvulMBCtxElapsedUs(FAR const struct timespec *pxSince)
+{
+  struct timespec xNow;
+  int64_t llUs;
+
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  llUs = (int64_t)(xNow.tv_sec - pxSince->tv_sec) * 1000000 +
+         (xNow.tv_nsec - pxSince->tv_nsec) / 1000;
+
+  return llUs < 0 ? 0 : (llUs > UINT32_MAX ? UINT32_MAX : (uint32_t)llUs);
+}
+
+static time_t prvxMBCtxNow(void)
+{
+  struct timespec xNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  return xNow.tv_sec;
+}
+
+static eMBException prveMBCtxReadBits(FAR xMBCtx *pxCtx,
+                                      FAR uint8_t *pucPDU,
+                                      FAR uint16_t *pusLen, bool bCoils)
+{
+  uint16_t usAddress;
+  uint16_t usCount;
+  uint8_t  ucBytes;
+  eMBErrorCode eStatus;
+
+  if (*pusLen != 5)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  usAddress = MB_CTX_GET16(&pucPDU[1]) + 1;
+  usCount   = MB_CTX_GET16(&pucPDU[3]);
+  if (usCount < 1 || usCount > MB_CTX_READ_BITS_MAX)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  ucBytes = (uint8_t)((usCount + 7) / 8);
+  pucPDU[1] = ucBytes;
+  memset(&pucPDU[2], 0, ucBytes);
+
+  if (bCoils)
+    {
+      eStatus = pxCtx->xCB.peRegCoilsCB(pxCtx->xCB.pvArg, &pucPDU[2],
+                                        usAddress, usCount, MB_REG_READ);
+    }
+  else
+    {
+      eStatus = pxCtx->xCB.peRegDiscreteCB(pxCtx->xCB.pvArg, &pucPDU[2],
+                                           usAddress, usCount);
+    }
+
+  if (eStatus != MB_ENOERR)
+    {
+      return prveMBError2Exception(eStatus);
+    }
+
+  *pusLen = 2 + ucBytes;
+  return MB_EX_NONE;
+}
+
+static eMBException prveMBCtxReadRegs(FAR xMBCtx *pxCtx,
+                                      FAR uint8_t *pucPDU,
+                                      FAR uint16_t *pusLen, bool bHolding)
+{
+  uint16_t usAddress;
+  uint16_t usCount;
+  eMBErrorCode eStatus;
+
+  if (*pusLen != 5)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  usAddress = MB_CTX_GET16(&pucPDU[1]) + 1;
+  usCount   = MB_CTX_GET16(&pucPDU[3]);
+  if (usCount < 1 || usCount > MB_CTX_READ_REGS_MAX)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  pucPDU[1] = (uint8_t)(usCount * 2);
+
+  if (bHolding)
+    {
+      eStatus = pxCtx->xCB.peRegHoldingCB(pxCtx->xCB.pvArg, &pucPDU[2],
+                                          usAddress, usCount, MB_REG_READ);
+    }
+  else
+    {
+      eStatus = pxCtx->xCB.peRegInputCB(pxCtx->xCB.pvArg, &pucPDU[2],
+                                        usAddress, usCount);
+    }
+
+  if (eStatus != MB_ENOERR)
+    {
+      return prveMBError2Exception(eStatus);
+    }
+
+  *pusLen = 2 + usCount * 2;
+  return MB_EX_NONE;
+}
+
+static eMBException prveMBCtxWriteCoil(FAR xMBCtx *pxCtx,
+                                       FAR uint8_t *pucPDU,
+                                       FAR uint16_t *pusLen)
+{
+  uint8_t  ucBuf[2];
+  uint16_t usValue;
+  eMBErrorCode eStatus;
+
+  if (*pusLen != 5)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  usValue = MB_CTX_GET16(&pucPDU[3]);
+  if (usValue != 0xff00 && usValue != 0x0000)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  ucBuf[0] = usValue ? 1 : 0;
+  ucBuf[1] = 0;
+
+  eStatus = pxCtx->xCB.peRegCoilsCB(pxCtx->xCB.pvArg, ucBuf,
+                                    MB_CTX_GET16(&pucPDU[1]) + 1, 1,
+                                    MB_REG_WRITE);
+
+  /* The response echoes the request */
+
+  return eStatus != MB_ENOERR ? prveMBError2Exception(eStatus) : MB_EX_NONE;
+}
+
+static eMBException prveMBCtxWriteRegister(FAR xMBCtx *pxCtx,
+                                           FAR uint8_t *pucPDU,
+                                           FAR uint16_t *pusLen)
+{
+  eMBErrorCode eStatus;
+
+  if (*pusLen != 5)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  eStatus = pxCtx->xCB.peRegHoldingCB(pxCtx->xCB.pvArg, &pucPDU[3],
+                                      MB_CTX_GET16(&pucPDU[1]) + 1, 1,
+                                      MB_REG_WRITE);
+
+  return eStatus != MB_ENOERR ? prveMBError2Exception(eStatus) : MB_EX_NONE;
+}
+
+static eMBException prveMBCtxWriteMultiple(FAR xMBCtx *pxCtx,
+                                           FAR uint8_t *pucPDU,
+                                           FAR uint16_t *pusLen,
+                                           bool bCoils)
+{
+  uint16_t usAddress;
+  uint16_t usCount;
+  uint8_t  ucBytes;
+  eMBErrorCode eStatus;
+
+  if (*pusLen < 6)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  usAddress = MB_CTX_GET16(&pucPDU[1]) + 1;
+  usCount   = MB_CTX_GET16(&pucPDU[3]);
+  ucBytes   = pucPDU[5];
+
+  if (bCoils)
+    {
+      if (usCount < 1 || usCount > MB_CTX_WRITE_BITS_MAX ||
+          ucBytes != (usCount + 7) / 8)
+        {
+          return MB_EX_ILLEGAL_DATA_VALUE;
+        }
+    }
+  else if (usCount < 1 || usCount > MB_CTX_WRITE_REGS_MAX ||
+           ucBytes != usCount * 2)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  if (*pusLen != 6 + ucBytes)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  if (bCoils)
+    {
+      eStatus = pxCtx->xCB.peRegCoilsCB(pxCtx->xCB.pvArg, &pucPDU[6],
+                                        usAddress, usCount, MB_REG_WRITE);
+    }
+  else
+    {
+      eStatus = pxCtx->xCB.peRegHoldingCB(pxCtx->xCB.pvArg, &pucPDU[6],
+                                          usAddress, usCount, MB_REG_WRITE);
+    }
+
+  if (eStatus != MB_ENOERR)
+    {
+      return prveMBError2Exception(eStatus);
+    }
+
+  /* Function code, starting address and quantity are echoed back */
+
+  *pusLen = 5;
+  return MB_EX_NONE;
+}
+
+static eMBException prveMBCtxReadWriteRegs(FAR xMBCtx *pxCtx,
+                                           FAR uint8_t *pucPDU,
+                                           FAR uint16_t *pusLen)
+{
+  uint16_t usReadAddress;
+  uint16_t usReadCount;
+  uint16_t usWriteAddress;
+  uint16_t usWriteCount;
+  uint8_t  ucBytes;
+  eMBErrorCode eStatus;
+
+  if (*pusLen < 10)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  usReadAddress  = MB_CTX_GET16(&pucPDU[1]) + 1;
+  usReadCount    = MB_CTX_GET16(&pucPDU[3]);
+  usWriteAddress = MB_CTX_GET16(&pucPDU[5]) + 1;
+  usWriteCount   = MB_CTX_GET16(&pucPDU[7]);
+  ucBytes        = pucPDU[9];
+
+  if (usReadCount < 1 || usReadCount > MB_CTX_READ_REGS_MAX ||
+      usWriteCount < 1 || usWriteCount > MB_CTX_RW_WRITE_MAX ||
+      ucBytes != usWriteCount * 2 || *pusLen != 10 + ucBytes)
+    {
+      return MB_EX_ILLEGAL_DATA_VALUE;
+    }
+
+  /* The write happens before the read, so the read data may overwrite the
+   * request in place.
+   */
+
+  eStatus = pxCtx->xCB.peRegHoldingCB(pxCtx->xCB.pvArg, &pucPDU[10],
+                                      usWriteAddress, usWriteCount,
+                                      MB_REG_WRITE);
+  if (eStatus == MB_ENOERR)
+    {
+      pucPDU[1] = (uint8_t)(usReadCount * 2);
+      eStatus = pxCtx->xCB.peRegHoldingCB(pxCtx->xCB.pvArg, &pucPDU[2],
+                                          usReadAddress, usReadCount,
+                                          MB_REG_READ);
+    }
+
+  if (eStatus != MB_ENOERR)
+    {
+      return prveMBError2Exception(eStatus);
+    }
+
+  *pusLen = 2 + usReadCount * 2;
+  return MB_EX_NONE;
+}
+
+/* Execute the request PDU in place.  On return pucPDU/pusLen hold the
+ * response, which is an exception response if the request failed.
+ */
+
+static void prvvMBCtxExecute(FAR xMBCtx *pxCtx, FAR uint8_t *pucPDU,
+                             FAR uint16_t *pusLen)
+{
+  eMBException eException = MB_EX_ILLEGAL_FUNCTION;
+
+  switch (pucPDU[MB_PDU_FUNC_OFF])
+    {
+      case MB_FUNC_READ_COILS:
+        if (pxCtx->xCB.peRegCoilsCB != NULL)
+          {
+            eException = prveMBCtxReadBits(pxCtx, pucPDU, pusLen, true);
+          }
+        break;
+
+      case MB_FUNC_READ_DISCRETE_INPUTS:
+        if (pxCtx->xCB.peRegDiscreteCB != NULL)
+          {
+            eException = prveMBCtxReadBits(pxCtx, pucPDU, pusLen, false);
+          }
+        break;
+
+      case MB_FUNC_READ_HOLDING_REGISTER:
+        if (pxCtx->xCB.peRegHoldingCB != NULL)
+          {
+            eException = prveMBCtxReadRegs(pxCtx, pucPDU, pusLen, true);
+          }
+        break;
+
+      case MB_FUNC_READ_INPUT_REGISTER:
+        if (pxCtx->xCB.peRegInputCB != NULL)
+          {
+            eException = prveMBCtxReadRegs(pxCtx, pucPDU, pusLen, false);
+          }
+        break;
+
+      case MB_FUNC_WRITE_SINGLE_COIL:
+        if (pxCtx->xCB.peRegCoilsCB != NULL)
+          {
+            eException = prveMBCtxWriteCoil(pxCtx, pucPDU, pusLen);
+          }
+        break;
+
+      case MB_FUNC_WRITE_REGISTER:
+        if (pxCtx->xCB.peRegHoldingCB != NULL)
+          {
+            eException = prveMBCtxWriteRegister(pxCtx, pucPDU, pusLen);
+          }
+        break;
+
+      case MB_FUNC_WRITE_MULTIPLE_COILS:
+        if (pxCtx->xCB.peRegCoilsCB != NULL)
+          {
+            eException = prveMBCtxWriteMultiple(pxCtx, pucPDU, pusLen,
+                                                true);
+          }
+        break;
+
+      case MB_FUNC_WRITE_MULTIPLE_REGISTERS:
+        if (pxCtx->xCB.peRegHoldingCB != NULL)
+          {
+            eException = prveMBCtxWriteMultiple(pxCtx, pucPDU, pusLen,
+                                                false);
+          }
+        break;
+
+      case MB_FUNC_READWRITE_MULTIPLE_REGISTERS:
+        if (pxCtx->xCB.peRegHoldingCB != NULL)
+          {
+            eException = prveMBCtxReadWriteRegs(pxCtx, pucPDU, pusLen);
+          }
+        break;
+
+      default:
+        break;
+    }
+
+  if (eException != MB_EX_NONE)
+    {
+      pucPDU[MB_PDU_FUNC_OFF] |= MB_FUNC_ERROR;
+      pucPDU[MB_PDU_DATA_OFF] = (uint8_t)eException;
+      *pusLen = 2;
+    }
+}
+
+static bool prvbMBCtxWriteAll(int iFd, FAR const uint8_t *pucBuf,
+                              size_t nLen)
+{
+  struct pollfd xPfd;
+  ssize_t res;
+
+  while (nLen > 0)
+    {
+      res = write(iFd, pucBuf, nLen);
+      if (res > 0)
+        {
+          pucBuf += res;
+          nLen   -= res;
+          continue;
+        }
+
+      if (res < 0 && errno == EINTR)
+        {
+          continue;
+        }
+
+      if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+          xPfd.fd = iFd;
+          xPfd.events = POLLOUT;
+          if (poll(&xPfd, 1, CONFIG_MODBUS_CTX_SEND_TIMEOUT_MS) > 0)
+            {
+              continue;
+            }
+        }
+
+      return false;
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * RTU transport
+ ****************************************************************************/
+
+static void prvvMBCtxRTUFrame(FAR xMBCtx *pxCtx)
+{
+  FAR uint8_t *pucFrame = pxCtx->ucRtuBuf;
+  uint16_t usLen = pxCtx->usRxLen;
+  uint16_t usPDULen;
+  uint16_t usCRC;
+  uint8_t  ucAddress;
+
+  pxCtx->usRxLen = 0;
+
+  if (usLen < MB_CTX_RTU_SIZE_MIN || usMBCRC16(pucFrame, usLen) != 0)
+    {
+      return;
+    }
+
+  ucAddress = pucFrame[0];
+  if (ucAddress != pxCtx->ucAddress && ucAddress != MB_ADDRESS_BROADCAST)
+    {
+      return;
+    }
+
+  usPDULen = usLen - 3;
+  prvvMBCtxExecute(pxCtx, &pucFrame[1], &usPDULen);
+
+  /* Broadcast requests are executed but never answered */
+
+  if (ucAddress == MB_ADDRESS_BROADCAST)
+    {
+      return;
+    }
+
+  usLen = usPDULen + 1;
+  usCRC = usMBCRC16(pucFrame, usLen);
+  pucFrame[usLen++] = (uint8_t)(usCRC & 0xff);
+  pucFrame[usLen++] = (uint8_t)(usCRC >> 8);
+
+  if (!prvbMBCtxWriteAll(pxCtx->iFd, pucFrame, usLen))
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBCTX-RTU", "write failed: %d\n", errno);
+    }
+}
+
+static void prvvMBCtxRTURead(FAR xMBCtx *pxCtx)
+{
+  ssize_t res;
+
+  res = read(pxCtx->iFd, pxCtx->ucRtuBuf + pxCtx->usRxLen,
+             MB_CTX_RTU_SIZE_MAX - pxCtx->usRxLen);
+  if (res <= 0)
+    {
+      return;
+    }
+
+  pxCtx->usRxLen += res;
+  clock_gettime(CLOCK_MONOTONIC, &pxCtx->xLastRx);
+
+  if (pxCtx->usRxLen >= MB_CTX_RTU_SIZE_MAX)
+    {
+      /* Longer than any valid frame; try what we have and resync on the
+       * next gap.
+       */
+
+      prvvMBCtxRTUFrame(pxCtx);
+    }
+}
+
+/****************************************************************************
+ * TCP transport
+ ****************************************************************************/
+
+static void prvvMBCtxTCPCloseConn(FAR struct xMBCtxConn *pxConn)
+{
+  if (pxConn->iFd >= 0)
+    {
+      close(pxConn->iFd);
+    }
+
+  pxConn->iFd = -1;
+  pxConn->usRxLen = 0;
+}
+
+static void prvvMBCtxTCPAccept(FAR xMBCtx *pxCtx, time_t xNow)
+{
+  int iFd;
+  int i;
+
+  iFd = accept4(pxCtx->iFd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+  if (iFd < 0)
+    {
+      return;
+    }
+
+  for (i = 0; i < CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS; i++)
+    {
+      if (pxCtx->xConns[i].iFd < 0)
+        {
+          pxCtx->xConns[i].iFd = iFd;
+          pxCtx->xConns[i].usRxLen = 0;
+          pxCtx->xConns[i].xLastActive = xNow;
+          return;
+        }
+    }
+
+  vMBPortLog(MB_LOG_WARN, "MBCTX-TCP",
+             "too many clients, dropping connection\n");
+  close(iFd);
+}
+
+/* Answer every complete request buffered for the connection.  Returns
+ * false if the connection was closed.
+ */
+
+static bool prvbMBCtxTCPProcess(FAR xMBCtx *pxCtx,
+                                FAR struct xMBCtxConn *pxConn)
+{
+  FAR uint8_t *pucFrame = pxCtx->ucTcpBuf;
+  uint16_t usFrameLen;
+  uint16_t usLen;
+  uint16_t usPDULen;
+
+  while (pxConn->usRxLen >= MB_CTX_TCP_HDR_SIZE)
+    {
+      usLen = MB_CTX_GET16(&pxConn->ucBuffer[MB_CTX_TCP_LEN]);
+      if (usLen < 2 || usLen > MB_PDU_SIZE_MAX + 1)
+        {
+          vMBPortLog(MB_LOG_WARN, "MBCTX-TCP", "invalid MBAP header\n");
+          prvvMBCtxTCPCloseConn(pxConn);
+          return false;
+        }
+
+      usFrameLen = MB_CTX_TCP_HDR_SIZE - 1 + usLen;
+      if (pxConn->usRxLen < usFrameLen)
+        {
+          break;
+        }
+
+      memcpy(pucFrame, pxConn->ucBuffer, usFrameLen);
+      pxConn->usRxLen -= usFrameLen;
+      if (pxConn->usRxLen > 0)
+        {
+          memmove(pxConn->ucBuffer, pxConn->ucBuffer + usFrameLen,
+                  pxConn->usRxLen);
+        }
+
+      /* Requests with a foreign protocol identifier are silently dropped
+       * like eMBTCPReceive() does.
+       */
+
+      if (MB_CTX_GET16(&pucFrame[MB_CTX_TCP_PID]) != 0)
+        {
+          continue;
+        }
+
+      usPDULen = usLen - 1;
+      prvvMBCtxExecute(pxCtx, &pucFrame[MB_CTX_TCP_HDR_SIZE], &usPDULen);
+
+      pucFrame[MB_CTX_TCP_LEN]     = (uint8_t)((usPDULen + 1) >> 8);
+      pucFrame[MB_CTX_TCP_LEN + 1] = (uint8_t)((usPDULen + 1) & 0xff);
+
+      if (!prvbMBCtxWriteAll(pxConn->iFd, pucFrame,
+                             MB_CTX_TCP_HDR_SIZE + usPDULen))
+        {
+          prvvMBCtxTCPCloseConn(pxConn);
+          return false;
+        }
+    }
+
+  return true;
+}
+
+static void prvvMBCtxTCPRead(FAR xMBCtx *pxCtx,
+                             FAR struct xMBCtxConn *pxConn, time_t xNow)
+{
+  ssize_t res;
+
+  res = recv(pxConn->iFd, pxConn->ucBuffer + pxConn->usRxLen,
+             MB_CTX_TCP_SIZE_MAX - pxConn->usRxLen, 0);
+  if (res < 0)
+    {
+      if (errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+          prvvMBCtxTCPCloseConn(pxConn);
+        }
+
+      return;
+    }
+  else if (res == 0)
+    {
+      prvvMBCtxTCPCloseConn(pxConn);
+      return;
+    }
+
+  pxConn->usRxLen += res;
+  pxConn->xLastActive = xNow;
+  prvbMBCtxTCPProcess(pxCtx, pxConn);
+}
+
+static FAR xMBCtx *prvpxMBCtxAlloc(FAR const xMBCtxCallbacks *pxCallbacks)
+{
+  FAR xMBCtx *pxCtx;
+  int i;
+
+  pxCtx = calloc(1, sizeof(*pxCtx));
+  if (pxCtx == NULL)
+    {
+      return NULL;
+    }
+
+  pxCtx->iFd = -1;
+  for (i = 0; i < CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS; i++)
+    {
+      pxCtx->xConns[i].iFd = -1;
+    }
+
+  if (pxCallbacks != NULL)
+    {
+      pxCtx->xCB = *pxCallbacks;
+    }
+
+  return pxCtx;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+eMBErrorCode eMBCtxRTUInit(FAR xMBCtx **ppxCtx, uint8_t ucSlaveAddress,
+                           FAR const char *pcDevice, speed_t ulBaudRate,
+                           eMBParity eParity,
+                           FAR const xMBCtxCallbacks *pxCallbacks)
+{
+  struct termios xNewTIO;
+  FAR xMBCtx *pxCtx;
+
+  if (ppxCtx == NULL || pcDevice == NULL || ulBaudRate == 0 ||
+      ucSlaveAddress < MB_ADDRESS_MIN || ucSlaveAddress > MB_ADDRESS_MAX)
+    {
+      return MB_EINVAL;
+    }
+
+  pxCtx = prvpxMBCtxAlloc(pxCallbacks);
+  if (pxCtx == NULL)
+    {
+      return MB_ENORES;
+    }
+
+  pxCtx->eMode     = MB_RTU;
+  pxCtx->ucAddress = ucSlaveAddress;
+
+  /* t3.5 is 3.5 character times (11 bits each), fixed at 1750us above
+   * 19200 baud as recommended by the specification.
+   */
+
+  if (ulBaudRate > 19200)
+    {
+      pxCtx->ulT35Us = 1750;
+    }
+  else
+    {
+      pxCtx->ulT35Us = (uint32_t)(3500000ull * 11 / ulBaudRate);
+    }
+
+  pxCtx->iFd = open(pcDevice, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if (pxCtx->iFd < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBCTX-RTU", "Can't open %s: %d\n",
+                 pcDevice, errno);
+      free(pxCtx);
+      return MB_EPORTERR;
+    }
+
+  if (tcgetattr(pxCtx->iFd, &pxCtx->xOldTIO) != 0)
+    {
+      goto errout;
+    }
+
+  memset(&xNewTIO, 0, sizeof(xNewTIO));
+  xNewTIO.c_iflag |= IGNBRK | INPCK;
+  xNewTIO.c_cflag |= CREAD | CLOCAL | CS8;
+
+  switch (eParity)
+    {
+      case MB_PAR_NONE:
+        break;
+
+      case MB_PAR_EVEN:
+        xNewTIO.c_cflag |= PARENB;
+        break;
+
+      case MB_PAR_ODD:
+        xNewTIO.c_cflag |= PARENB | PARODD;
+        break;
+
+      default:
+        goto errout;
+    }
+
+  if (cfsetispeed(&xNewTIO, ulBaudRate) != 0 ||
+      tcsetattr(pxCtx->iFd, TCSANOW, &xNewTIO) != 0)
+    {
+      goto errout;
+    }
+
+  tcflush(pxCtx->iFd, TCIFLUSH);
+  *ppxCtx = pxCtx;
+  return MB_ENOERR;
+
+errout:
+  vMBPortLog(MB_LOG_ERROR, "MBCTX-RTU", "Can't configure %s: %d\n",
+             pcDevice, errno);
+  close(pxCtx->iFd);
+  free(pxCtx);
+  return MB_EPORTERR;
+}
+
+eMBErrorCode eMBCtxTCPInit(FAR xMBCtx **ppxCtx, uint16_t usTCPPort,
+                           FAR const xMBCtxCallbacks *pxCallbacks)
+{
+  struct sockaddr_in xAddr;
+  FAR xMBCtx *pxCtx;
+  int iOpt = 1;
+
+  if (ppxCtx == NULL)
+    {
+      return MB_EINVAL;
+    }
+
+  pxCtx = prvpxMBCtxAlloc(pxCallbacks);
+  if (pxCtx == NULL)
+    {
+      return MB_ENORES;
+    }
+
+  pxCtx->eMode = MB_TCP;
+
+  if (usTCPPort == MB_TCP_PORT_USE_DEFAULT)
+    {
+      usTCPPort = MB_CTX_TCP_DEFAULT_PORT;
+    }
+
+  pxCtx->iFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                      0);
+  if (pxCtx->iFd < 0)
+    {
+      free(pxCtx);
+      return MB_EPORTERR;
+    }
+
+  setsockopt(pxCtx->iFd, SOL_SOCKET, SO_REUSEADDR, &iOpt, sizeof(iOpt));
+
+  memset(&xAddr, 0, sizeof(xAddr));
+  xAddr.sin_family      = AF_INET;
+  xAddr.sin_port        = htons(usTCPPort);
+  xAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(pxCtx->iFd, (FAR struct sockaddr *)&xAddr, sizeof(xAddr)) < 0 ||
+      listen(pxCtx->iFd, CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS) < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBCTX-TCP",
+                 "Can't listen on port %u: %d\n", usTCPPort, errno);
+      close(pxCtx->iFd);
+      free(pxCtx);
+      return MB_EPORTERR;
+    }
+
+  *ppxCtx = pxCtx;
+  return MB_ENOERR;
+}
+
+eMBErrorCode eMBCtxClose(FAR xMBCtx *pxCtx)
+{
+  int i;
+
+  if (pxCtx == NULL)
+    {
+      return MB_EINVAL;
+    }
+
+  for (i = 0; i < CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS; i++)
+    {
+      prvvMBCtxTCPCloseConn(&pxCtx->xConns[i]);
+    }
+
+  if (pxCtx->iFd >= 0)
+    {
+      if (pxCtx->eMode == MB_RTU)
+        {
+          tcsetattr(pxCtx->iFd, TCSANOW, &pxCtx->xOldTIO);
+        }
+
+      close(pxCtx->iFd);
+    }
+
+  free(pxCtx);
+  return MB_ENOERR;
+}
+
+int iMBCtxPollSetup(FAR xMBCtx *pxCtx, FAR struct pollfd *pxFds,
+                    int iMaxFds, FAR int *piTimeoutMs)
+{
+  uint32_t ulElapsed;
+  int iWaitMs;
+  int n = 0;
+  int i;
+
+  if (iMaxFds < 1)
+    {
+      return 0;
+    }
+
+  pxFds[n].fd = pxCtx->iFd;
+  pxFds[n].events = POLLIN;
+  pxFds[n].revents = 0;
+  pxCtx->iMap[n++] = -1;
+
+  if (pxCtx->eMode == MB_RTU)
+    {
+      /* A partial frame completes when the line stays idle for t3.5, so
+       * don't sleep past that point.
+       */
+
+      if (pxCtx->usRxLen > 0 && piTimeoutMs != NULL)
+        {
+          ulElapsed = prvulMBCtxElapsedUs(&pxCtx->xLastRx);
+          iWaitMs = ulElapsed >= pxCtx->ulT35Us ? 0 :
+                    (int)((pxCtx->ulT35Us - ulElapsed + 999) / 1000);
+          if (*piTimeoutMs < 0 || iWaitMs < *piTimeoutMs)
+            {
+              *piTimeoutMs = iWaitMs;
+            }
+        }
+    }
+  else
+    {
+      for (i = 0; i < CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS && n < iMaxFds;
+           i++)
+        {
+          if (pxCtx->xConns[i].iFd >= 0)
+            {
+              pxFds[n].fd = pxCtx->xConns[i].iFd;
+              pxFds[n].events = POLLIN;
+              pxFds[n].revents = 0;
+              pxCtx->iMap[n++] = i;
+            }
+        }
+    }
+
+  pxCtx->nMap = n;
+  return n;
+}
+
+eMBErrorCode eMBCtxPollHandle(FAR xMBCtx *pxCtx,
+                              FAR const struct pollfd *pxFds, int nFds)
+{
+  FAR struct xMBCtxConn *pxConn;
+  time_t xNow;
+  int i;
+
+  if (pxCtx == NULL || nFds > pxCtx->nMap)
+    {
+      return MB_EINVAL;
+    }
+
+  if (pxCtx->eMode == MB_RTU)
+    {
+      if (nFds > 0 && (pxFds[0].revents & POLLIN) != 0)
+        {
+          prvvMBCtxRTURead(pxCtx);
+        }
+
+      if (pxCtx->usRxLen > 0 &&
+          prvulMBCtxElapsedUs(&pxCtx->xLastRx) >= pxCtx->ulT35Us)
+        {
+          prvvMBCtxRTUFrame(pxCtx);
+        }
+
+      return MB_ENOERR;
+    }
+
+  xNow = prvxMBCtxNow();
+
+  for (i = 1; i < nFds; i++)
+    {
+      pxConn = &pxCtx->xConns[pxCtx->iMap[i]];
+      if (pxConn->iFd == pxFds[i].fd &&
+          (pxFds[i].revents & (POLLIN | POLLHUP | POLLERR)) != 0)
+        {
+          prvvMBCtxTCPRead(pxCtx, pxConn, xNow);
+        }
+    }
+
+  if (nFds > 0 && (pxFds[0].revents & POLLIN) != 0)
+    {
+      prvvMBCtxTCPAccept(pxCtx, xNow);
+    }
+
+#if CONFIG_MODBUS_CTX_TCP_CLIENT_TIMEOUT_SEC > 0
+  for (i = 0; i < CONFIG_MODBUS_CTX_TCP_MAX_CLIENTS; i++)
+    {
+      pxConn = &pxCtx->xConns[i];
+      if (pxConn->iFd >= 0 && xNow - pxConn->xLastActive >
+          CONFIG_MODBUS_CTX_TCP_CLIENT_TIMEOUT_SEC)
+        {
+          prvvMBCtxTCPCloseConn(pxConn);
+        }
+    }
+#endif
+
+  return MB_ENOERR;
+}
+
+eMBErrorCode eMBCtxPoll(FAR xMBCtx *pxCtx, int iTimeoutMs)
+{
+  struct pollfd xFds[MB_CTX_POLLFDS_MAX];
+  int nFds;
+
+  if (pxCtx == NULL)
+    {
+      return MB_EINVAL;
+    }
+
+  nFds = iMBCtxPollSetup(pxCtx, xFds, MB_CTX_POLLFDS_MAX, &iTimeoutMs);
+  if (poll(xFds, nFds, iTimeoutMs) < 0)
+    {
+      if (errno == EINTR)
+        {
+          return MB_ENOERR;
+        }
+
+      return MB_EIO;
+    }
+
+  return eMBCtxPollHandle(pxCtx, xFds, nFds);
+}
@@ -87,7 +87,10 @@ void vMBPortLog(eMBPortLogLevel eLevel, const char *szModule,
 #endif
 void vMBPortTimerPoll(void);
 bool xMBPortSerialPoll(void);
-bool xMBPortSerialSetTimeout(uint32_t dwTimeoutMs);
+bool xMBPortSerialSetTimeout(uint32_t dwTimeoutUs);
+#ifdef CONFIG_MB_TCP_ENABLED
+bool xMBTCPPortPoll(void);
+#endif
 
 #if defined(CONFIG_MB_RTU_MASTER) || defined(CONFIG_MB_ASCII_MASTER)
   void vMBMasterPortEnterCritical(void);
@@ -82,6 +82,14 @@ bool xMBPortEventGet(eMBEventType * eEvent)
 
       xMBPortSerialPoll();
 
+#ifdef CONFIG_MB_TCP_ENABLED
+      /* Service the Modbus TCP listener and all connected clients. This
+       * is a no-op unless the stack was initialized with eMBTCPInit().
+       */
+
+      xMBTCPPortPoll();
+#endif
+
       /* Check if any of the timers have expired. */
 
       vMBPortTimerPoll();
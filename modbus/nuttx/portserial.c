@@ -69,7 +69,7 @@ static int      iSerialFd = -1;
 static bool     bRxEnabled;
 static bool     bTxEnabled;
 
-static uint32_t ulTimeoutMs;
+static uint32_t ulTimeoutUs;   /* t3.5 inter-frame gap */
 static uint8_t  ucBuffer[BUF_SIZE];
 static int      uiRxBufferPos;
 static int      uiTxBufferPos;
@@ -81,7 +81,8 @@ static struct termios xOldTIO;
  ****************************************************************************/
 
 static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead);
+                                 uint16_t *usNBytesRead,
+                                 uint32_t ulWaitUs);
 static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes);
 
 /****************************************************************************
@@ -89,15 +90,16 @@ static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes);
  ****************************************************************************/
 
 static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead)
+                                 uint16_t *usNBytesRead,
+                                 uint32_t ulWaitUs)
 {
   bool            bResult = true;
   ssize_t         res;
   fd_set          rfds;
   struct timeval  tv;
 
-  tv.tv_sec = 0;
-  tv.tv_usec = 50000;
+  tv.tv_sec = ulWaitUs / 1000000;
+  tv.tv_usec = ulWaitUs % 1000000;
   FD_ZERO(&rfds);
   FD_SET(iSerialFd, &rfds);
 
@@ -292,15 +294,15 @@ bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
   return bStatus;
 }
 
-bool xMBPortSerialSetTimeout(uint32_t ulNewTimeoutMs)
+bool xMBPortSerialSetTimeout(uint32_t ulNewTimeoutUs)
 {
-  if (ulNewTimeoutMs > 0)
+  if (ulNewTimeoutUs > 0)
     {
-      ulTimeoutMs = ulNewTimeoutMs;
+      ulTimeoutUs = ulNewTimeoutUs;
     }
   else
     {
-      ulTimeoutMs = 1;
+      ulTimeoutUs = 1;
     }
 
   return true;
@@ -320,11 +322,13 @@ bool xMBPortSerialPoll(void)
 {
   bool     bStatus = true;
   uint16_t usBytesRead;
+  uint32_t ulWaitUs = 50000;
   int      i;
 
   while (bRxEnabled)
     {
-      if (prvbMBPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead))
+      if (prvbMBPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead,
+                               ulWaitUs))
         {
           if (usBytesRead == 0)
             {
@@ -332,7 +336,18 @@ bool xMBPortSerialPoll(void)
 
               break;
             }
-          else if (usBytesRead > 0)
+          else if (pxMBFrameCBBlockReceived != NULL)
+            {
+              /* Hand the whole block to the stack at once.  Once a frame
+               * has started it ends when the line stays idle for t3.5, so
+               * stop waiting then and let the timer fire right away
+               * instead of after the idle poll period.
+               */
+
+              pxMBFrameCBBlockReceived(&ucBuffer[0], usBytesRead);
+              ulWaitUs = ulTimeoutUs;
+            }
+          else
             {
               for (i = 0; i < usBytesRead; i++)
                 {
@@ -0,0 +1,540 @@
+/****************************************************************************
+ * apps/modbus/nuttx/porttcp.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <netinet/in.h>
+
+#include "port.h"
+
+#include "modbus/mb.h"
+#include "modbus/mbport.h"
+
+#ifdef CONFIG_MB_TCP_ENABLED
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_TCP_DEFAULT_PORT     502
+#define MB_TCP_HDR_SIZE         7    /* TID, PID, LEN and UID */
+#define MB_TCP_LEN_OFF          4
+#define MB_TCP_BUF_SIZE         (MB_TCP_HDR_SIZE + 253)
+
+/* The largest valid value of the MBAP length field: UID + maximum PDU */
+
+#define MB_TCP_LEN_MAX          (1 + 253)
+
+#ifndef CONFIG_MB_TCP_MAX_CLIENTS
+#  define CONFIG_MB_TCP_MAX_CLIENTS 4
+#endif
+
+#ifndef CONFIG_MB_TCP_CLIENT_TIMEOUT_SEC
+#  define CONFIG_MB_TCP_CLIENT_TIMEOUT_SEC 60
+#endif
+
+#ifndef CONFIG_MB_TCP_POLL_TIMEOUT_MS
+#  define CONFIG_MB_TCP_POLL_TIMEOUT_MS 50
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One connected Modbus TCP master.  Each client reassembles its own MBAP
+ * frames so that a slow or fragmented sender never stalls the others.
+ */
+
+struct xMBTCPClient
+{
+  int      iFd;                        /* Connected socket or -1 */
+  uint16_t usRxLen;                    /* Bytes buffered in ucBuffer */
+  time_t   xLastActive;                /* Last time data was received */
+  uint8_t  ucBuffer[MB_TCP_BUF_SIZE];  /* Request and response buffer */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static int iListenFd = -1;
+static struct xMBTCPClient xClients[CONFIG_MB_TCP_MAX_CLIENTS];
+
+/* The client whose request is currently handed to the protocol stack, or
+ * -1 if no request is in flight.  Requests are served one at a time, so
+ * this is all the routing information the response needs.  The request is
+ * copied out of the client buffer because the stack builds the response in
+ * place and a response may be longer than the request, which would clobber
+ * pipelined requests queued behind it.
+ */
+
+static int iCurClient = -1;
+static uint16_t usCurFrameLen;
+static uint8_t ucFrame[MB_TCP_BUF_SIZE];
+
+/* Index to resume scanning from so that busy clients cannot starve the
+ * others.
+ */
+
+static int iNextClient;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static time_t prvxMBTCPPortNow(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+static void prvvMBTCPPortCloseClient(int i)
+{
+  if (xClients[i].iFd >= 0)
+    {
+      vMBPortLog(MB_LOG_DEBUG, "MBTCP-CLOSE", "closing client %d\n", i);
+      close(xClients[i].iFd);
+    }
+
+  xClients[i].iFd = -1;
+  xClients[i].usRxLen = 0;
+
+  if (iCurClient == i)
+    {
+      iCurClient = -1;
+    }
+}
+
+/* Return the size of a complete MBAP frame at the start of the client
+ * buffer, 0 if more data is needed or -1 if the header is invalid.
+ */
+
+static int prviMBTCPPortFrameLen(FAR const struct xMBTCPClient *pxClient)
+{
+  uint16_t usLen;
+
+  if (pxClient->usRxLen < MB_TCP_HDR_SIZE)
+    {
+      return 0;
+    }
+
+  usLen  = (uint16_t)pxClient->ucBuffer[MB_TCP_LEN_OFF] << 8;
+  usLen |= pxClient->ucBuffer[MB_TCP_LEN_OFF + 1];
+
+  /* The length counts the UID plus at least a function code. */
+
+  if (usLen < 2 || usLen > MB_TCP_LEN_MAX)
+    {
+      return -1;
+    }
+
+  if (pxClient->usRxLen < MB_TCP_HDR_SIZE - 1 + usLen)
+    {
+      return 0;
+    }
+
+  return MB_TCP_HDR_SIZE - 1 + usLen;
+}
+
+/* Hand the first frame of a client to the protocol stack and move any
+ * pipelined bytes that followed it to the start of the client buffer.
+ */
+
+static void prvvMBTCPPortTakeFrame(int i, uint16_t usLen)
+{
+  FAR struct xMBTCPClient *pxClient = &xClients[i];
+
+  memcpy(ucFrame, pxClient->ucBuffer, usLen);
+  pxClient->usRxLen -= usLen;
+  if (pxClient->usRxLen > 0)
+    {
+      memmove(pxClient->ucBuffer, pxClient->ucBuffer + usLen,
+              pxClient->usRxLen);
+    }
+
+  iCurClient = i;
+  usCurFrameLen = usLen;
+}
+
+static void prvvMBTCPPortAccept(time_t xNow)
+{
+  int iFd;
+  int i;
+
+  iFd = accept4(iListenFd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+  if (iFd < 0)
+    {
+      return;
+    }
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      if (xClients[i].iFd < 0)
+        {
+          xClients[i].iFd = iFd;
+          xClients[i].usRxLen = 0;
+          xClients[i].xLastActive = xNow;
+          vMBPortLog(MB_LOG_DEBUG, "MBTCP-ACCEPT", "client %d connected\n",
+                     i);
+          return;
+        }
+    }
+
+  vMBPortLog(MB_LOG_WARN, "MBTCP-ACCEPT",
+             "too many clients, dropping connection\n");
+  close(iFd);
+}
+
+/* Read whatever is available for one client.  Returns false if the client
+ * has gone away or sent garbage and was closed.
+ */
+
+static bool prvbMBTCPPortReceive(int i, time_t xNow)
+{
+  FAR struct xMBTCPClient *pxClient = &xClients[i];
+  ssize_t res;
+
+  if (pxClient->usRxLen >= MB_TCP_BUF_SIZE)
+    {
+      /* Buffer full of pipelined requests; parse those first. */
+
+      return true;
+    }
+
+  res = recv(pxClient->iFd, pxClient->ucBuffer + pxClient->usRxLen,
+             MB_TCP_BUF_SIZE - pxClient->usRxLen, 0);
+  if (res < 0)
+    {
+      if (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+          return true;
+        }
+
+      prvvMBTCPPortCloseClient(i);
+      return false;
+    }
+  else if (res == 0)
+    {
+      prvvMBTCPPortCloseClient(i);
+      return false;
+    }
+
+  pxClient->usRxLen += res;
+  pxClient->xLastActive = xNow;
+  return true;
+}
+
+/* Look for a client with a complete request, starting after the client
+ * served last.  On success the frame is handed to the protocol stack.
+ */
+
+static bool prvbMBTCPPortDispatch(void)
+{
+  int iFrameLen;
+  int i;
+  int n;
+
+  for (n = 0; n < CONFIG_MB_TCP_MAX_CLIENTS; n++)
+    {
+      i = (iNextClient + n) % CONFIG_MB_TCP_MAX_CLIENTS;
+      if (xClients[i].iFd < 0)
+        {
+          continue;
+        }
+
+      iFrameLen = prviMBTCPPortFrameLen(&xClients[i]);
+      if (iFrameLen < 0)
+        {
+          vMBPortLog(MB_LOG_WARN, "MBTCP-RECV",
+                     "invalid MBAP header from client %d\n", i);
+          prvvMBTCPPortCloseClient(i);
+        }
+      else if (iFrameLen > 0)
+        {
+          prvvMBTCPPortTakeFrame(i, (uint16_t)iFrameLen);
+          iNextClient = (i + 1) % CONFIG_MB_TCP_MAX_CLIENTS;
+          xMBPortEventPost(EV_FRAME_RECEIVED);
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+bool xMBTCPPortInit(uint16_t usTCPPort)
+{
+  struct sockaddr_in xAddr;
+  int iOpt = 1;
+  int i;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      xClients[i].iFd = -1;
+      xClients[i].usRxLen = 0;
+    }
+
+  iCurClient = -1;
+  iNextClient = 0;
+
+  if (usTCPPort == MB_TCP_PORT_USE_DEFAULT)
+    {
+      usTCPPort = MB_TCP_DEFAULT_PORT;
+    }
+
+  iListenFd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                     0);
+  if (iListenFd < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBTCP-INIT", "socket failed: %d\n", errno);
+      return false;
+    }
+
+  setsockopt(iListenFd, SOL_SOCKET, SO_REUSEADDR, &iOpt, sizeof(iOpt));
+
+  memset(&xAddr, 0, sizeof(xAddr));
+  xAddr.sin_family      = AF_INET;
+  xAddr.sin_port        = htons(usTCPPort);
+  xAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+  if (bind(iListenFd, (FAR struct sockaddr *)&xAddr, sizeof(xAddr)) < 0 ||
+      listen(iListenFd, CONFIG_MB_TCP_MAX_CLIENTS) < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBTCP-INIT",
+                 "can't listen on port %u: %d\n", usTCPPort, errno);
+      close(iListenFd);
+      iListenFd = -1;
+      return false;
+    }
+
+  return true;
+}
+
+void vMBTCPPortClose(void)
+{
+  vMBTCPPortDisable();
+
+  if (iListenFd >= 0)
+    {
+      close(iListenFd);
+      iListenFd = -1;
+    }
+}
+
+void vMBTCPPortDisable(void)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      prvvMBTCPPortCloseClient(i);
+    }
+
+  iCurClient = -1;
+}
+
+bool xMBTCPPortGetRequest(uint8_t **ppucMBTCPFrame, uint16_t *usTCPLength)
+{
+  if (iCurClient < 0)
+    {
+      return false;
+    }
+
+  *ppucMBTCPFrame = ucFrame;
+  *usTCPLength = usCurFrameLen;
+  return true;
+}
+
+bool xMBTCPPortSendResponse(const uint8_t *pucMBTCPFrame,
+                            uint16_t usTCPLength)
+{
+  FAR struct xMBTCPClient *pxClient;
+  struct pollfd xPfd;
+  size_t  done = 0;
+  ssize_t res;
+  int     i = iCurClient;
+
+  if (i < 0)
+    {
+      return false;
+    }
+
+  pxClient = &xClients[i];
+
+  while (done < usTCPLength)
+    {
+      res = send(pxClient->iFd, pucMBTCPFrame + done, usTCPLength - done,
+                 MSG_NOSIGNAL);
+      if (res > 0)
+        {
+          done += res;
+          continue;
+        }
+
+      if (res < 0 && (errno == EINTR))
+        {
+          continue;
+        }
+
+      if (res < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+          /* Responses are small, so a full send buffer means the peer
+           * stopped reading.  Give it one poll period before giving up.
+           */
+
+          xPfd.fd = pxClient->iFd;
+          xPfd.events = POLLOUT;
+          if (poll(&xPfd, 1, CONFIG_MB_TCP_POLL_TIMEOUT_MS) > 0)
+            {
+              continue;
+            }
+        }
+
+      vMBPortLog(MB_LOG_WARN, "MBTCP-SEND",
+                 "send to client %d failed: %d\n", i, errno);
+      prvvMBTCPPortCloseClient(i);
+      return false;
+    }
+
+  iCurClient = -1;
+  return true;
+}
+
+/****************************************************************************
+ * Name: xMBTCPPortPoll
+ *
+ * Description:
+ *   Wait for activity on the listening socket and all connected clients
+ *   with a single poll() call.  New connections are accepted, available
+ *   data is appended to the per-client reassembly buffers and the first
+ *   complete request found is posted to the protocol stack as
+ *   EV_FRAME_RECEIVED.  Clients that stay idle longer than
+ *   CONFIG_MB_TCP_CLIENT_TIMEOUT_SEC are disconnected.
+ *
+ ****************************************************************************/
+
+bool xMBTCPPortPoll(void)
+{
+  struct pollfd xFds[CONFIG_MB_TCP_MAX_CLIENTS + 1];
+  int    iMap[CONFIG_MB_TCP_MAX_CLIENTS + 1];
+  time_t xNow;
+  int    nFds = 0;
+  int    ret;
+  int    i;
+
+  if (iListenFd < 0)
+    {
+      return true;
+    }
+
+  /* A frame that is still current was rejected by the stack (e.g. wrong
+   * protocol id) and will never be answered; drop it.
+   */
+
+  iCurClient = -1;
+
+  /* Pipelined requests may already be buffered; serve them first. */
+
+  if (prvbMBTCPPortDispatch())
+    {
+      return true;
+    }
+
+  xFds[nFds].fd = iListenFd;
+  xFds[nFds].events = POLLIN;
+  iMap[nFds++] = -1;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      if (xClients[i].iFd >= 0)
+        {
+          xFds[nFds].fd = xClients[i].iFd;
+          xFds[nFds].events = POLLIN;
+          iMap[nFds++] = i;
+        }
+    }
+
+  ret = poll(xFds, nFds, CONFIG_MB_TCP_POLL_TIMEOUT_MS);
+  if (ret < 0)
+    {
+      if (errno == EINTR)
+        {
+          return true;
+        }
+
+      vMBPortLog(MB_LOG_ERROR, "MBTCP-POLL", "poll failed: %d\n", errno);
+      return false;
+    }
+
+  xNow = prvxMBTCPPortNow();
+
+  for (i = 1; i < nFds && ret > 0; i++)
+    {
+      if (xFds[i].revents != 0)
+        {
+          ret--;
+          if (xFds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+              prvbMBTCPPortReceive(iMap[i], xNow);
+            }
+        }
+    }
+
+  if (xFds[0].revents & POLLIN)
+    {
+      prvvMBTCPPortAccept(xNow);
+    }
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      if (xClients[i].iFd >= 0 && CONFIG_MB_TCP_CLIENT_TIMEOUT_SEC > 0 &&
+          xNow - xClients[i].xLastActive > CONFIG_MB_TCP_CLIENT_TIMEOUT_SEC)
+        {
+          vMBPortLog(MB_LOG_INFO, "MBTCP-POLL",
+                     "client %d idle, closing\n", i);
+          prvvMBTCPPortCloseClient(i);
+        }
+    }
+
+  prvbMBTCPPortDispatch();
+  return true;
+}
+
+#endif /* CONFIG_MB_TCP_ENABLED */
@@ -58,7 +58,11 @@ static struct timeval xTimeLast;
 
 bool xMBPortTimersInit(uint16_t usTim1Timerout50us)
 {
-  ulTimeOut = usTim1Timerout50us / 20U;
+  /* Keep the timeout in microseconds: at high baud rates t3.5 is only
+   * 1750us, which millisecond resolution cannot represent.
+   */
+
+  ulTimeOut = usTim1Timerout50us * 50U;
   if (ulTimeOut == 0)
     {
       ulTimeOut = 1;
@@ -74,7 +78,7 @@ void xMBPortTimersClose(void)
 
 void vMBPortTimerPoll(void)
 {
-  uint32_t       ulDeltaMS;
+  uint32_t       ulDeltaUs;
   struct timeval xTimeCur;
 
   /* Timers are called from the serial layer because we have no high
@@ -89,9 +93,9 @@ void vMBPortTimerPoll(void)
         }
       else
         {
-          ulDeltaMS = (xTimeCur.tv_sec - xTimeLast.tv_sec) * 1000L +
-                      (xTimeCur.tv_usec - xTimeLast.tv_usec) * 1000L;
-          if (ulDeltaMS > ulTimeOut)
+          ulDeltaUs = (xTimeCur.tv_sec - xTimeLast.tv_sec) * 1000000L +
+                      (xTimeCur.tv_usec - xTimeLast.tv_usec);
+          if (ulDeltaUs >= ulTimeOut)
             {
               bTimeoutEnable = false;
               pxMBPortCBTimerExpired();
@@ -314,6 +314,57 @@ bool xMBRTUReceiveFSM(void)
   return xTaskNeedSwitch;
 }
 
+/* Block variant of xMBRTUReceiveFSM(): append all characters of one read
+ * to the frame buffer at once and restart the t3.5 timer only once.  The
+ * end of the frame is still detected by the t3.5 timeout.
+ */
+
+bool xMBRTUReceiveBlock(const uint8_t *pucData, uint16_t usLen)
+{
+  uint16_t usCopy;
+
+  DEBUGASSERT(eSndState == STATE_TX_IDLE);
+
+  if (usLen == 0)
+    {
+      return false;
+    }
+
+  switch (eRcvState)
+    {
+      /* Wait until the bus is idle (startup) or the damaged frame has
+       * been transmitted completely.
+       */
+
+      case STATE_RX_INIT:
+      case STATE_RX_ERROR:
+        break;
+
+      case STATE_RX_IDLE:
+        usRcvBufferPos = 0;
+        eRcvState = STATE_RX_RCV;
+
+        /* Fall through */
+
+      case STATE_RX_RCV:
+        usCopy = MB_SER_PDU_SIZE_MAX - usRcvBufferPos;
+        if (usLen > usCopy)
+          {
+            /* Longer than any valid frame; ignore it. */
+
+            eRcvState = STATE_RX_ERROR;
+            break;
+          }
+
+        memcpy((uint8_t *)&ucRTUBuf[usRcvBufferPos], pucData, usLen);
+        usRcvBufferPos += usLen;
+        break;
+    }
+
+  vMBPortTimersEnable();
+  return false;
+}
+
 bool xMBRTUTransmitFSM(void)
 {
   bool xNeedPoll = false;
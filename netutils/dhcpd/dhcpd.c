@@ -49,11 +49,15 @@
 #include <sys/ioctl.h>
 #include <sys/wait.h>
 
+#include <fcntl.h>
 #include <inttypes.h>
+#include <limits.h>
 #include <sched.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <unistd.h>
 #include <time.h>
 #include <errno.h>
@@ -191,6 +195,44 @@
 #  define HAVE_LEASE_TIME 1
 #endif
 
+#ifndef CONFIG_NETUTILS_DHCPD_HASHSIZE
+#  define CONFIG_NETUTILS_DHCPD_HASHSIZE 16
+#endif
+
+#if CONFIG_NETUTILS_DHCPD_HASHSIZE < 1
+#  error CONFIG_NETUTILS_DHCPD_HASHSIZE must be at least 1
+#endif
+
+/* The lease journal needs lease expiration times to be meaningful */
+
+#undef HAVE_LEASEFILE
+#if defined(CONFIG_NETUTILS_DHCPD_LEASEFILE) && defined(HAVE_LEASE_TIME)
+#  define HAVE_LEASEFILE 1
+#endif
+
+/* Marks the end of a hash chain or an empty hash bucket */
+
+#define DHCPD_NOLEASE             0xffff
+
+/* Number of 32-bit words in the free address bitmap */
+
+#define DHCPD_FREEMAP_WORDS \
+  ((CONFIG_NETUTILS_DHCPD_MAXLEASES + 31) / 32)
+
+#ifdef HAVE_LEASEFILE
+/* Lease journal file header and record types */
+
+#  define DHCPD_JOURNAL_MAGIC     0x4c504844 /* "DHPL" in little endian */
+#  define DHCPD_JOURNAL_VERSION   1
+
+#  define DHCPD_JOURNAL_GRANT     1          /* Lease granted or renewed */
+#  define DHCPD_JOURNAL_RELEASE   2          /* Lease released or declined */
+
+/* Compact the journal when it holds this many records */
+
+#  define DHCPD_JOURNAL_MAXRECS   (4 * CONFIG_NETUTILS_DHCPD_MAXLEASES)
+#endif
+
 #define g_state  (*g_dhcpd_daemon.ds_data)
 
 /****************************************************************************
@@ -206,11 +248,35 @@ struct lease_s
 {
   uint8_t  mac[DHCP_HLEN_ETHERNET]; /* MAC address (network order) -- could be larger! */
   bool     allocated;               /* true: IP address is allocated */
+  uint16_t next;                    /* Next lease in the same MAC hash bucket */
 #ifdef HAVE_LEASE_TIME
   time_t   expiry;                  /* Lease expiration time (seconds past Epoch) */
 #endif
 };
 
+#ifdef HAVE_LEASEFILE
+/* On-disk layout of the lease journal.  The file starts with one header
+ * followed by any number of fixed-size records.  Records are replayed in
+ * order, so a later record for the same address supersedes earlier ones.
+ * The journal is only meant to be read back by the machine that wrote it.
+ */
+
+struct dhcpd_jheader_s
+{
+  uint32_t magic;                   /* DHCPD_JOURNAL_MAGIC */
+  uint32_t version;                 /* DHCPD_JOURNAL_VERSION */
+};
+
+struct dhcpd_jrecord_s
+{
+  int64_t  expiry;                  /* Lease expiration (seconds past Epoch) */
+  uint32_t ipaddr;                  /* Leased IP address (host order) */
+  uint8_t  op;                      /* DHCPD_JOURNAL_GRANT/RELEASE */
+  uint8_t  mac[DHCP_HLEN_ETHERNET]; /* Client MAC address */
+  uint8_t  reserved[5];             /* Pads the record to 24 bytes */
+};
+#endif
+
 struct dhcpmsg_s
 {
   uint8_t  op;
@@ -268,6 +334,25 @@ struct dhcpd_state_s
   /* Leases */
 
   struct lease_s   ds_leases[CONFIG_NETUTILS_DHCPD_MAXLEASES];
+
+  /* Index of the leases by MAC address.  Each bucket holds the index of
+   * the first lease in a chain linked through lease_s::next.
+   */
+
+  uint16_t         ds_machash[CONFIG_NETUTILS_DHCPD_HASHSIZE];
+
+  /* One bit per lease: set if the address has never been allocated or has
+   * been returned to the pool.  Expired leases are still reclaimed lazily.
+   */
+
+  uint32_t         ds_freemap[DHCPD_FREEMAP_WORDS];
+
+#ifdef HAVE_LEASEFILE
+  /* Lease journal */
+
+  int              ds_journalfd;    /* Journal opened for append, or -1 */
+  unsigned int     ds_journalrecs;  /* Number of records in the journal */
+#endif
 };
 
 /* This type describes the state of the DHCPD client daemon.  Only one
@@ -386,6 +471,171 @@ static time_t dhcpd_time(void)
 #  define dhcpd_time() (0)
 #endif
 
+/****************************************************************************
+ * Name: dhcp_leaseipaddr
+ ****************************************************************************/
+
+static inline in_addr_t dhcp_leaseipaddr(FAR struct lease_s *lease)
+{
+  /* Return IP address in host order */
+
+  return (in_addr_t)(lease - g_state.ds_leases) +
+         g_dhcpd_config.ds_startip;
+}
+
+/****************************************************************************
+ * Name: dhcpd_machash
+ ****************************************************************************/
+
+static unsigned int dhcpd_machash(FAR const uint8_t *mac)
+{
+  uint32_t hash = 2166136261u;
+  int i;
+
+  /* FNV-1a over the hardware address */
+
+  for (i = 0; i < DHCP_HLEN_ETHERNET; i++)
+    {
+      hash = (hash ^ mac[i]) * 16777619u;
+    }
+
+  return hash % CONFIG_NETUTILS_DHCPD_HASHSIZE;
+}
+
+/****************************************************************************
+ * Name: dhcpd_macvalid
+ ****************************************************************************/
+
+static bool dhcpd_macvalid(FAR const uint8_t *mac)
+{
+  int i;
+
+  for (i = 0; i < DHCP_HLEN_ETHERNET; i++)
+    {
+      if (mac[i] != 0)
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: dhcpd_hashadd
+ *
+ * Description:
+ *   Add a lease to the MAC address index.  Leases without a MAC address
+ *   (offers in progress, declined addresses) are not indexed.
+ *
+ ****************************************************************************/
+
+static void dhcpd_hashadd(FAR struct lease_s *lease)
+{
+  unsigned int bucket;
+
+  if (dhcpd_macvalid(lease->mac))
+    {
+      bucket = dhcpd_machash(lease->mac);
+      lease->next = g_state.ds_machash[bucket];
+      g_state.ds_machash[bucket] = lease - g_state.ds_leases;
+    }
+}
+
+/****************************************************************************
+ * Name: dhcpd_hashremove
+ *
+ * Description:
+ *   Remove a lease from the MAC address index.  This must be called before
+ *   the MAC address of an indexed lease is changed.
+ *
+ ****************************************************************************/
+
+static void dhcpd_hashremove(FAR struct lease_s *lease)
+{
+  FAR uint16_t *link;
+  uint16_t ndx = lease - g_state.ds_leases;
+
+  if (dhcpd_macvalid(lease->mac))
+    {
+      link = &g_state.ds_machash[dhcpd_machash(lease->mac)];
+      while (*link != DHCPD_NOLEASE)
+        {
+          if (*link == ndx)
+            {
+              *link = lease->next;
+              break;
+            }
+
+          link = &g_state.ds_leases[*link].next;
+        }
+    }
+
+  lease->next = DHCPD_NOLEASE;
+}
+
+/****************************************************************************
+ * Name: dhcpd_setfree
+ *
+ * Description:
+ *   Mark the address of a lease as free or in use in the free bitmap.
+ *   Addresses ending in 0 or 255 are never handed out and so never free.
+ *
+ ****************************************************************************/
+
+static void dhcpd_setfree(FAR struct lease_s *lease, bool isfree)
+{
+  int ndx = lease - g_state.ds_leases;
+  in_addr_t ipaddr = dhcp_leaseipaddr(lease);
+
+  if (isfree && (ipaddr & 0xff) != 0 && (ipaddr & 0xff) != 0xff)
+    {
+      g_state.ds_freemap[ndx >> 5] |= (uint32_t)1 << (ndx & 31);
+    }
+  else
+    {
+      g_state.ds_freemap[ndx >> 5] &= ~((uint32_t)1 << (ndx & 31));
+    }
+}
+
+/****************************************************************************
+ * Name: dhcpd_clearlease
+ *
+ * Description:
+ *   Return a lease to the pool.
+ *
+ ****************************************************************************/
+
+static void dhcpd_clearlease(FAR struct lease_s *lease)
+{
+  dhcpd_hashremove(lease);
+  memset(lease, 0, sizeof(struct lease_s));
+  lease->next = DHCPD_NOLEASE;
+  dhcpd_setfree(lease, true);
+}
+
+/****************************************************************************
+ * Name: dhcpd_initleases
+ *
+ * Description:
+ *   Initialize an empty lease table, hash index and free address bitmap.
+ *
+ ****************************************************************************/
+
+static void dhcpd_initleases(void)
+{
+  int i;
+
+  memset(g_state.ds_machash, 0xff, sizeof(g_state.ds_machash));
+  memset(g_state.ds_freemap, 0, sizeof(g_state.ds_freemap));
+
+  for (i = 0; i < CONFIG_NETUTILS_DHCPD_MAXLEASES; i++)
+    {
+      g_state.ds_leases[i].next = DHCPD_NOLEASE;
+      dhcpd_setfree(&g_state.ds_leases[i], true);
+    }
+}
+
 /****************************************************************************
  * Name: dhcpd_leaseexpired
  ****************************************************************************/
@@ -399,7 +649,7 @@ static inline bool dhcpd_leaseexpired(struct lease_s *lease)
     }
   else
     {
-      memset(lease, 0, sizeof(struct lease_s));
+      dhcpd_clearlease(lease);
       return true;
     }
 }
@@ -430,8 +680,15 @@ struct lease_s *dhcpd_setlease(const uint8_t *mac,
   if (ndx >= 0 && ndx < CONFIG_NETUTILS_DHCPD_MAXLEASES)
     {
        ret = &g_state.ds_leases[ndx];
-       memcpy(ret->mac, mac, DHCP_HLEN_ETHERNET);
+       if (memcmp(ret->mac, mac, DHCP_HLEN_ETHERNET) != 0)
+         {
+           dhcpd_hashremove(ret);
+           memcpy(ret->mac, mac, DHCP_HLEN_ETHERNET);
+           dhcpd_hashadd(ret);
+         }
+
        ret->allocated = true;
+       dhcpd_setfree(ret, false);
 #ifdef HAVE_LEASE_TIME
        ret->expiry = dhcpd_time() + expiry;
 #endif
@@ -440,32 +697,25 @@ struct lease_s *dhcpd_setlease(const uint8_t *mac,
   return ret;
 }
 
-/****************************************************************************
- * Name: dhcp_leaseipaddr
- ****************************************************************************/
-
-static inline in_addr_t dhcp_leaseipaddr(FAR struct lease_s *lease)
-{
-  /* Return IP address in host order */
-
-  return (in_addr_t)(lease - g_state.ds_leases) +
-         g_dhcpd_config.ds_startip;
-}
-
 /****************************************************************************
  * Name: dhcpd_findbymac
  ****************************************************************************/
 
 static FAR struct lease_s *dhcpd_findbymac(FAR const uint8_t *mac)
 {
-  int i;
+  FAR struct lease_s *lease;
+  uint16_t ndx;
 
-  for (i = 0; i < CONFIG_NETUTILS_DHCPD_MAXLEASES; i++)
+  ndx = g_state.ds_machash[dhcpd_machash(mac)];
+  while (ndx != DHCPD_NOLEASE)
     {
-      if (memcmp(g_state.ds_leases[i].mac, mac, DHCP_HLEN_ETHERNET) == 0)
+      lease = &g_state.ds_leases[ndx];
+      if (memcmp(lease->mac, mac, DHCP_HLEN_ETHERNET) == 0)
         {
-          return &(g_state.ds_leases[i]);
+          return lease;
         }
+
+      ndx = lease->next;
     }
 
   return NULL;
@@ -497,44 +747,357 @@ static FAR struct lease_s *dhcpd_findbyipaddr(in_addr_t ipaddr)
 
 static in_addr_t dhcpd_allocipaddr(void)
 {
-  struct lease_s *lease = NULL;
-  in_addr_t ipaddr, startaddr;
+  FAR struct lease_s *lease = NULL;
+  in_addr_t ipaddr;
+  int bit;
+  int i;
 
-  ipaddr = startaddr = g_dhcpd_config.ds_startip;
-  for (; ipaddr <= g_dhcpd_config.ds_endip; ipaddr++)
-    {
-      /* Skip over address ending in 0 or 255 */
+  /* First take a never used or released address from the free bitmap */
 
-      if ((ipaddr & 0xff) == 0 || (ipaddr & 0xff) == 0xff)
+  for (i = 0; i < DHCPD_FREEMAP_WORDS; i++)
+    {
+      bit = ffs(g_state.ds_freemap[i]);
+      if (bit > 0)
         {
-          continue;
+          lease = &g_state.ds_leases[(i << 5) + bit - 1];
+          break;
         }
+    }
 
-      /* Is there already a lease on this address?  If so, has it expired? */
+  /* Otherwise, reclaim the first lease that has expired */
 
-      lease = dhcpd_findbyipaddr(ipaddr);
-      if ((!lease || dhcpd_leaseexpired(lease)))
+  if (lease == NULL)
+    {
+      for (i = 0; i < CONFIG_NETUTILS_DHCPD_MAXLEASES; i++)
         {
+          ipaddr = g_dhcpd_config.ds_startip + i;
+
+          /* Skip over address ending in 0 or 255 */
+
+          if ((ipaddr & 0xff) == 0 || (ipaddr & 0xff) == 0xff)
+            {
+              continue;
+            }
+
+          /* Is there already a lease on this address?  If so, has it
+           * expired?
+           */
+
+          lease = dhcpd_findbyipaddr(ipaddr);
+          if (!lease || dhcpd_leaseexpired(lease))
+            {
+              lease = &g_state.ds_leases[i];
+              break;
+            }
+
+          lease = NULL;
+        }
+    }
+
+  if (lease != NULL)
+    {
 #ifdef CONFIG_CPP_HAVE_WARNING
 #  warning "FIXME: Should check if anything responds to an ARP request or ping"
 #  warning "       to verify that there is no other user of this IP address"
 #endif
-          memset(g_state.ds_leases[ipaddr - startaddr].mac,
-          0, DHCP_HLEN_ETHERNET);
-          g_state.ds_leases[ipaddr - startaddr].allocated = true;
+      dhcpd_hashremove(lease);
+      memset(lease->mac, 0, DHCP_HLEN_ETHERNET);
+      lease->allocated = true;
+      dhcpd_setfree(lease, false);
 #ifdef HAVE_LEASE_TIME
-          g_state.ds_leases[ipaddr - startaddr].expiry =
-            dhcpd_time() + CONFIG_NETUTILS_DHCPD_OFFERTIME;
+      lease->expiry = dhcpd_time() + CONFIG_NETUTILS_DHCPD_OFFERTIME;
 #endif
-          /* Return the address in host order */
+      /* Return the address in host order */
 
-          return ipaddr;
-        }
+      return dhcp_leaseipaddr(lease);
     }
 
   return 0;
 }
 
+#ifdef HAVE_LEASEFILE
+/****************************************************************************
+ * Name: dhcpd_journalwrite
+ *
+ * Description:
+ *   Write the complete buffer to the journal, retrying short writes.
+ *
+ ****************************************************************************/
+
+static int dhcpd_journalwrite(int fd, FAR const void *buf, size_t len)
+{
+  FAR const uint8_t *ptr = buf;
+  ssize_t nwritten;
+
+  while (len > 0)
+    {
+      nwritten = write(fd, ptr, len);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      ptr += nwritten;
+      len -= nwritten;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: dhcpd_journalcompact
+ *
+ * Description:
+ *   Rewrite the journal so that it contains exactly one record for each
+ *   live lease, then reopen it for appending.  The new journal is written
+ *   to a temporary file and renamed over the old one so that a crash during
+ *   compaction never loses the previous journal.
+ *
+ ****************************************************************************/
+
+static int dhcpd_journalcompact(void)
+{
+  FAR const char *path = CONFIG_NETUTILS_DHCPD_LEASEFILE_PATH;
+  struct dhcpd_jheader_s hdr;
+  struct dhcpd_jrecord_s rec;
+  FAR struct lease_s *lease;
+  char tmppath[PATH_MAX];
+  unsigned int nrecs = 0;
+  int ret = OK;
+  int fd;
+  int i;
+
+  if (g_state.ds_journalfd >= 0)
+    {
+      close(g_state.ds_journalfd);
+      g_state.ds_journalfd = -1;
+    }
+
+  snprintf(tmppath, sizeof(tmppath), "%s.tmp", path);
+  fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    {
+      nerr("ERROR: Failed to create %s: %d\n", tmppath, errno);
+      return -errno;
+    }
+
+  hdr.magic   = DHCPD_JOURNAL_MAGIC;
+  hdr.version = DHCPD_JOURNAL_VERSION;
+  ret = dhcpd_journalwrite(fd, &hdr, sizeof(hdr));
+
+  for (i = 0; ret >= 0 && i < CONFIG_NETUTILS_DHCPD_MAXLEASES; i++)
+    {
+      lease = &g_state.ds_leases[i];
+      if (!lease->allocated || !dhcpd_macvalid(lease->mac))
+        {
+          continue;
+        }
+
+      memset(&rec, 0, sizeof(rec));
+      rec.op     = DHCPD_JOURNAL_GRANT;
+      rec.ipaddr = dhcp_leaseipaddr(lease);
+      rec.expiry = lease->expiry;
+      memcpy(rec.mac, lease->mac, DHCP_HLEN_ETHERNET);
+
+      ret = dhcpd_journalwrite(fd, &rec, sizeof(rec));
+      nrecs++;
+    }
+
+  if (ret >= 0 && fsync(fd) < 0)
+    {
+      ret = -errno;
+    }
+
+  close(fd);
+
+  if (ret >= 0 && rename(tmppath, path) < 0)
+    {
+      ret = -errno;
+    }
+
+  if (ret < 0)
+    {
+      nerr("ERROR: Failed to compact lease journal: %d\n", ret);
+      unlink(tmppath);
+      return ret;
+    }
+
+  g_state.ds_journalfd = open(path, O_WRONLY | O_APPEND | O_CLOEXEC);
+  if (g_state.ds_journalfd < 0)
+    {
+      nerr("ERROR: Failed to open %s: %d\n", path, errno);
+      return -errno;
+    }
+
+  g_state.ds_journalrecs = nrecs;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: dhcpd_journalappend
+ *
+ * Description:
+ *   Append one record describing a change of the lease for 'ipaddr'.
+ *   Failures are logged but otherwise ignored:  the server keeps serving
+ *   from its in-memory table.
+ *
+ ****************************************************************************/
+
+static void dhcpd_journalappend(uint8_t op, FAR const uint8_t *mac,
+                                in_addr_t ipaddr, time_t expiry)
+{
+  struct dhcpd_jrecord_s rec;
+  int ret;
+
+  if (g_state.ds_journalfd < 0)
+    {
+      return;
+    }
+
+  if (g_state.ds_journalrecs >= DHCPD_JOURNAL_MAXRECS)
+    {
+      /* Callers update the in-memory table before appending, so the
+       * compacted journal already reflects this change.
+       */
+
+      dhcpd_journalcompact();
+      return;
+    }
+
+  memset(&rec, 0, sizeof(rec));
+  rec.op     = op;
+  rec.ipaddr = ipaddr;
+  rec.expiry = expiry;
+  memcpy(rec.mac, mac, DHCP_HLEN_ETHERNET);
+
+  ret = dhcpd_journalwrite(g_state.ds_journalfd, &rec, sizeof(rec));
+  if (ret < 0)
+    {
+      nerr("ERROR: Failed to append to lease journal: %d\n", ret);
+      return;
+    }
+
+#ifdef CONFIG_NETUTILS_DHCPD_LEASEFILE_SYNC
+  fsync(g_state.ds_journalfd);
+#endif
+
+  g_state.ds_journalrecs++;
+}
+
+/****************************************************************************
+ * Name: dhcpd_journalrestore
+ *
+ * Description:
+ *   Replay the lease journal into the (empty) lease table, discarding
+ *   expired leases and addresses outside of the current pool, and then
+ *   compact it.
+ *
+ ****************************************************************************/
+
+static void dhcpd_journalrestore(void)
+{
+  FAR const char *path = CONFIG_NETUTILS_DHCPD_LEASEFILE_PATH;
+  struct dhcpd_jheader_s hdr;
+  struct dhcpd_jrecord_s recs[8];
+  FAR struct dhcpd_jrecord_s *rec;
+  FAR struct lease_s *lease;
+  time_t now = dhcpd_time();
+  ssize_t nread;
+  int nrestored = 0;
+  int fd;
+  int i;
+
+  g_state.ds_journalfd = -1;
+
+  fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd >= 0)
+    {
+      nread = read(fd, &hdr, sizeof(hdr));
+      if (nread != sizeof(hdr) || hdr.magic != DHCPD_JOURNAL_MAGIC ||
+          hdr.version != DHCPD_JOURNAL_VERSION)
+        {
+          nerr("ERROR: Ignoring invalid lease journal %s\n", path);
+          nread = 0;
+        }
+
+      /* A truncated trailing record (e.g. power loss during a write) is
+       * silently dropped.
+       */
+
+      while (nread > 0 &&
+             (nread = read(fd, recs, sizeof(recs))) >=
+             (ssize_t)sizeof(recs[0]))
+        {
+          for (i = 0; i < nread / sizeof(recs[0]); i++)
+            {
+              rec = &recs[i];
+              if (rec->ipaddr < g_dhcpd_config.ds_startip ||
+                  rec->ipaddr > g_dhcpd_config.ds_endip)
+                {
+                  continue;
+                }
+
+              lease = &g_state.ds_leases[rec->ipaddr -
+                                         g_dhcpd_config.ds_startip];
+
+              if (rec->op == DHCPD_JOURNAL_RELEASE)
+                {
+                  if (memcmp(lease->mac, rec->mac,
+                             DHCP_HLEN_ETHERNET) == 0)
+                    {
+                      dhcpd_clearlease(lease);
+                    }
+
+                  continue;
+                }
+
+              /* A client holds at most one lease; drop any older one */
+
+              lease = dhcpd_findbymac(rec->mac);
+              if (lease != NULL)
+                {
+                  dhcpd_clearlease(lease);
+                }
+
+              lease = &g_state.ds_leases[rec->ipaddr -
+                                         g_dhcpd_config.ds_startip];
+              dhcpd_clearlease(lease);
+
+              if (rec->expiry > now)
+                {
+                  memcpy(lease->mac, rec->mac, DHCP_HLEN_ETHERNET);
+                  lease->allocated = true;
+                  lease->expiry    = rec->expiry;
+                  dhcpd_hashadd(lease);
+                  dhcpd_setfree(lease, false);
+                }
+            }
+        }
+
+      close(fd);
+    }
+
+  for (i = 0; i < CONFIG_NETUTILS_DHCPD_MAXLEASES; i++)
+    {
+      if (g_state.ds_leases[i].allocated)
+        {
+          nrestored++;
+        }
+    }
+
+  ninfo("Restored %d leases from %s\n", nrestored, path);
+
+  dhcpd_journalcompact();
+}
+#else
+#  define dhcpd_journalappend(op, mac, ipaddr, expiry)
+#endif
+
 /****************************************************************************
  * Name: dhcpd_parseoptions
  ****************************************************************************/
@@ -1105,6 +1668,9 @@ static int dhcpd_sendnak(int sockfd)
 int dhcpd_sendack(int sockfd, in_addr_t ipaddr)
 {
   uint32_t leasetime = CONFIG_NETUTILS_DHCPD_LEASETIME;
+#ifdef HAVE_LEASEFILE
+  FAR struct lease_s *lease;
+#endif
   in_addr_t netaddr;
 #ifdef HAVE_DNSIP
   uint32_t dnsaddr;
@@ -1149,7 +1715,17 @@ int dhcpd_sendack(int sockfd, in_addr_t ipaddr)
       return ERROR;
     }
 
+#ifdef HAVE_LEASEFILE
+  lease = dhcpd_setlease(g_state.ds_inpacket.chaddr, ipaddr, leasetime);
+  if (lease != NULL)
+    {
+      dhcpd_journalappend(DHCPD_JOURNAL_GRANT, lease->mac, ipaddr,
+                          lease->expiry);
+    }
+#else
   dhcpd_setlease(g_state.ds_inpacket.chaddr, ipaddr, leasetime);
+#endif
+
   return OK;
 }
 
@@ -1405,13 +1981,19 @@ static inline int dhcpd_decline(void)
   if (lease)
     {
       /* Disassociate the IP from the MAC, but prevent reused of this
-       * address for a period of time.
+       * address for a period of time.  The table is updated before the
+       * journal, as appending may compact the journal from the table.
        */
 
+      dhcpd_hashremove(lease);
       memset(lease->mac, 0, DHCP_HLEN_ETHERNET);
 #ifdef HAVE_LEASE_TIME
       lease->expiry = dhcpd_time() + CONFIG_NETUTILS_DHCPD_DECLINETIME;
 #endif
+
+      dhcpd_journalappend(DHCPD_JOURNAL_RELEASE,
+                          g_state.ds_inpacket.chaddr,
+                          dhcp_leaseipaddr(lease), 0);
     }
 
   return OK;
@@ -1426,9 +2008,15 @@ static inline int dhcpd_release(void)
   lease = dhcpd_findbymac(g_state.ds_inpacket.chaddr);
   if (lease)
     {
-      /* Release the IP address now */
+      /* Release the IP address now, before journaling it as in
+       * dhcpd_decline().
+       */
+
+      dhcpd_clearlease(lease);
 
-      memset(lease, 0, sizeof(struct lease_s));
+      dhcpd_journalappend(DHCPD_JOURNAL_RELEASE,
+                          g_state.ds_inpacket.chaddr,
+                          dhcp_leaseipaddr(lease), 0);
     }
 
   return OK;
@@ -1595,6 +2183,13 @@ int dhcpd_run(FAR const char *interface)
     }
 
   memset(g_dhcpd_daemon.ds_data, 0, sizeof(struct dhcpd_state_s));
+  dhcpd_initleases();
+
+#ifdef HAVE_LEASEFILE
+  /* Restore the leases that were granted before the last shutdown */
+
+  dhcpd_journalrestore();
+#endif
 
   /* Update the pid if running in daemon mode */
 
@@ -1693,6 +2288,13 @@ int dhcpd_run(FAR const char *interface)
         }
     }
 
+#ifdef HAVE_LEASEFILE
+  if (g_state.ds_journalfd >= 0)
+    {
+      close(g_state.ds_journalfd);
+    }
+#endif
+
   free(g_dhcpd_daemon.ds_data);
   g_dhcpd_daemon.ds_data = NULL;
   g_dhcpd_daemon.ds_pid   = -1;
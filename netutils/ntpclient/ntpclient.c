@@ -111,6 +111,29 @@
 #  define STR(x) STR2(x)
 #endif
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+/* The remaining offset is slewed out with a time constant of a quarter
+ * poll interval, so that it is mostly gone when the next poll happens.
+ */
+
+#  define NTPC_PHASE_TC_DIV    4
+
+/* Fraction of the offset per second that is added to the frequency
+ * estimate on every poll (1/2).
+ */
+
+#  define NTPC_FREQ_GAIN_DIV   2
+
+/* Poll interval is doubled after this many consecutive polls with
+ * offsets within NTPC_POLL_JITTER_MUL times the jitter.
+ */
+
+#  define NTPC_POLL_STABLE     4
+#  define NTPC_POLL_JITTER_MUL 4
+
+#  define NTPC_FREQ_LIMIT_PPB  (CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 1000)
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -174,6 +197,22 @@ struct ntp_servers_s
   FAR const char *ntp_servers;
 };
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+/* Clock discipline state.  All times in nanoseconds. */
+
+struct ntpc_discipline_s
+{
+  bool synced;                 /* Clock has been set or slewed once */
+  int64_t offset;              /* Latest measured offset */
+  int64_t residual;            /* Part of the offset not yet slewed out */
+  int64_t jitter;              /* Averaged offset prediction error */
+  int64_t freq_ppb;            /* Frequency error estimate */
+  unsigned int poll;           /* Current poll interval (seconds) */
+  int stable;                  /* Consecutive polls within the jitter */
+  struct timespec last_update; /* Time of latest poll (CLOCK_MONOTONIC) */
+};
+#endif
+
 /* KoD exclusion list. */
 
 struct ntp_kod_exclude_s
@@ -205,6 +244,10 @@ static struct ntp_sample_s g_last_samples
     [CONFIG_NETUTILS_NTPCLIENT_NUM_SAMPLES];
 unsigned int g_last_nsamples = 0;
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+static struct ntpc_discipline_s g_ntpc_discipline;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -622,6 +665,215 @@ static void ntpc_settime(int64_t offset, FAR struct timespec *start_realtime,
         ntp_nsecpart(int64abs(offset)) / NSEC_PER_MSEC);
 }
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+/****************************************************************************
+ * Name: ntp_to_nsec
+ *
+ * Description:
+ *   Convert a signed NTP time difference to nanoseconds.
+ *
+ ****************************************************************************/
+
+static int64_t ntp_to_nsec(int64_t offset)
+{
+  int64_t absoffset = int64abs(offset);
+  int64_t nsec;
+
+  nsec = (int64_t)ntp_secpart(absoffset) * NSEC_PER_SEC +
+         ntp_nsecpart(absoffset);
+
+  return offset < 0 ? -nsec : nsec;
+}
+
+/****************************************************************************
+ * Name: ntpc_discipline_update
+ *
+ * Description:
+ *   Feed a new offset measurement to the clock discipline.  On the first
+ *   poll the clock may be stepped; after that the frequency estimate is
+ *   updated from the offset that remained since the previous poll and the
+ *   new offset is handed to ntpc_discipline_wait() for slewing.
+ *
+ ****************************************************************************/
+
+static void ntpc_discipline_update(FAR struct ntpc_discipline_s *disc,
+                                   int64_t offset,
+                                   FAR struct timespec *start_realtime,
+                                   FAR struct timespec *start_monotonic)
+{
+  struct timespec now;
+  int64_t offset_ns = ntp_to_nsec(offset);
+  int64_t interval_s;
+  int64_t diff;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  if (!disc->synced)
+    {
+      if (int64abs(offset_ns) >
+          (int64_t)CONFIG_NETUTILS_NTPCLIENT_STEP_THRESHOLD_MS *
+          NSEC_PER_MSEC)
+        {
+          ntpc_settime(offset, start_realtime, start_monotonic);
+          offset_ns = 0;
+        }
+
+      disc->synced      = true;
+      disc->offset      = offset_ns;
+      disc->residual    = offset_ns;
+      disc->poll        = CONFIG_NETUTILS_NTPCLIENT_MINPOLL;
+      disc->last_update = now;
+      return;
+    }
+
+  interval_s = now.tv_sec - disc->last_update.tv_sec;
+  if (interval_s < 1)
+    {
+      interval_s = 1;
+    }
+
+  /* Without a frequency error the new offset would equal the part of the
+   * previous offset that has not been slewed out yet.  The difference is
+   * the error of the frequency estimate accumulated over the interval.
+   */
+
+  diff = offset_ns - disc->residual;
+  disc->freq_ppb += diff / interval_s / NTPC_FREQ_GAIN_DIV;
+  if (disc->freq_ppb > NTPC_FREQ_LIMIT_PPB)
+    {
+      disc->freq_ppb = NTPC_FREQ_LIMIT_PPB;
+    }
+  else if (disc->freq_ppb < -NTPC_FREQ_LIMIT_PPB)
+    {
+      disc->freq_ppb = -NTPC_FREQ_LIMIT_PPB;
+    }
+
+  /* Jitter is the exponential average of the prediction error */
+
+  disc->jitter += (int64abs(diff) - disc->jitter) / 4;
+
+  /* Poll less often while the clock stays within the jitter, more often
+   * when it does not.
+   */
+
+  if (int64abs(offset_ns) <= NTPC_POLL_JITTER_MUL * disc->jitter)
+    {
+      if (++disc->stable >= NTPC_POLL_STABLE &&
+          disc->poll < CONFIG_NETUTILS_NTPCLIENT_MAXPOLL)
+        {
+          disc->poll *= 2;
+          if (disc->poll > CONFIG_NETUTILS_NTPCLIENT_MAXPOLL)
+            {
+              disc->poll = CONFIG_NETUTILS_NTPCLIENT_MAXPOLL;
+            }
+
+          disc->stable = 0;
+        }
+    }
+  else
+    {
+      disc->poll /= 2;
+      if (disc->poll < CONFIG_NETUTILS_NTPCLIENT_MINPOLL)
+        {
+          disc->poll = CONFIG_NETUTILS_NTPCLIENT_MINPOLL;
+        }
+
+      disc->stable = 0;
+    }
+
+  disc->offset      = offset_ns;
+  disc->residual    = offset_ns;
+  disc->last_update = now;
+
+  ninfo("Offset %lld ns, jitter %lld ns, freq %lld ppb, poll %u s\n",
+        (long long)offset_ns, (long long)disc->jitter,
+        (long long)disc->freq_ppb, disc->poll);
+}
+
+/****************************************************************************
+ * Name: ntpc_discipline_wait
+ *
+ * Description:
+ *   Wait for the current poll interval, steering the clock with adjtime()
+ *   once every CONFIG_CLOCK_ADJTIME_PERIOD_MS.  Each adjustment applies the
+ *   estimated frequency error plus a share of the remaining offset.
+ *
+ ****************************************************************************/
+
+static void ntpc_discipline_wait(FAR struct ntpc_discipline_s *disc)
+{
+  const int64_t period_ms = CONFIG_CLOCK_ADJTIME_PERIOD_MS;
+  const int64_t limit_ns = CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * period_ms;
+  struct timeval delta;
+  int64_t elapsed_ms = 0;
+  int64_t freq_ns;
+  int64_t phase_ns;
+  int64_t total_ns;
+  int64_t poll_ms;
+  int64_t usec;
+
+  poll_ms = (int64_t)disc->poll * MSEC_PER_SEC;
+
+  while (elapsed_ms < poll_ms && g_ntpc_daemon.state == NTP_RUNNING)
+    {
+      /* The discipline state is also read by ntpc_status().  ntpc_stop()
+       * holds the lock while it signals the daemon, so give up when the
+       * wait is interrupted.
+       */
+
+      if (sem_wait(&g_ntpc_daemon.lock) < 0)
+        {
+          break;
+        }
+
+      freq_ns  = disc->freq_ppb * period_ms / MSEC_PER_SEC;
+      phase_ns = disc->residual * period_ms * NTPC_PHASE_TC_DIV / poll_ms;
+      if (phase_ns == 0)
+        {
+          phase_ns = disc->residual;
+        }
+
+      total_ns = freq_ns + phase_ns;
+      if (total_ns > limit_ns)
+        {
+          total_ns = limit_ns;
+        }
+      else if (total_ns < -limit_ns)
+        {
+          total_ns = -limit_ns;
+        }
+
+      /* adjtime() has microsecond resolution, carry the rest over */
+
+      total_ns -= total_ns % NSEC_PER_USEC;
+      disc->residual -= total_ns - freq_ns;
+
+      sem_post(&g_ntpc_daemon.lock);
+
+      /* A negative adjustment needs a negative tv_sec and a tv_usec in
+       * the [0, USEC_PER_SEC) range.
+       */
+
+      usec = total_ns / NSEC_PER_USEC;
+      delta.tv_sec  = usec / USEC_PER_SEC;
+      delta.tv_usec = usec % USEC_PER_SEC;
+      if (delta.tv_usec < 0)
+        {
+          delta.tv_sec  -= 1;
+          delta.tv_usec += USEC_PER_SEC;
+        }
+
+      if (adjtime(&delta, NULL) < 0)
+        {
+          nerr("ERROR: adjtime failed: %d\n", errno);
+        }
+
+      usleep(period_ms * USEC_PER_MSEC);
+      elapsed_ms += period_ms;
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: ntp_address_in_kod_list
  *
@@ -1258,6 +1510,10 @@ static int ntpc_daemon(int argc, FAR char **argv)
       return EXIT_FAILURE;
     }
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  memset(&g_ntpc_discipline, 0, sizeof(g_ntpc_discipline));
+#endif
+
   /* Indicate that we have started */
 
   g_ntpc_daemon.state = NTP_RUNNING;
@@ -1384,11 +1640,16 @@ static int ntpc_daemon(int argc, FAR char **argv)
 
           /* Adjust system time. */
 
+          sem_wait(&g_ntpc_daemon.lock);
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+          ntpc_discipline_update(&g_ntpc_discipline, offset,
+                                 &start_realtime, &start_monotonic);
+#else
           ntpc_settime(offset, &start_realtime, &start_monotonic);
+#endif
 
           /* Save samples for ntpc_status() */
 
-          sem_wait(&g_ntpc_daemon.lock);
           g_last_nsamples = nsamples;
           memcpy(&g_last_samples, samples, nsamples * sizeof(*samples));
           sem_post(&g_ntpc_daemon.lock);
@@ -1407,10 +1668,16 @@ static int ntpc_daemon(int argc, FAR char **argv)
 
           if (g_ntpc_daemon.state == NTP_RUNNING)
             {
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+              ninfo("Waiting for %u seconds\n", g_ntpc_discipline.poll);
+
+              ntpc_discipline_wait(&g_ntpc_discipline);
+#else
               ninfo("Waiting for %d seconds\n",
                     CONFIG_NETUTILS_NTPCLIENT_POLLDELAYSEC);
 
               sleep(CONFIG_NETUTILS_NTPCLIENT_POLLDELAYSEC);
+#endif
               retries = 0;
               retry_delay = 1;
             }
@@ -1621,6 +1888,13 @@ int ntpc_status(struct ntpc_status_s *statusp)
                                      &statusp->samples[i]._srv_addr_store;
     }
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  statusp->offset_ns     = g_ntpc_discipline.offset;
+  statusp->jitter_ns     = g_ntpc_discipline.jitter;
+  statusp->freq_ppb      = g_ntpc_discipline.freq_ppb;
+  statusp->poll_interval = g_ntpc_discipline.poll;
+#endif
+
   sem_post(&g_ntpc_daemon.lock);
   return OK;
 }
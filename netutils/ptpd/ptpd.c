@@ -60,6 +60,40 @@
 #include "netutils/netlib.h"
 #include "ptpv2.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER
+#  define CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER 1
+#endif
+
+/* Weight of a new sample in the running mean square of the clock error,
+ * as a power of two (1/16).
+ */
+
+#define PTP_OFFSET_MSQ_SHIFT       4
+
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+
+/* Servo states: the first measurement after start or step only records
+ * the offset, the second estimates the initial frequency error, and after
+ * that the PI controller is running.
+ */
+
+#  define PTP_SERVO_UNLOCKED       0
+#  define PTP_SERVO_ESTIMATING     1
+#  define PTP_SERVO_LOCKED         2
+
+/* Outlier rejection needs a few samples of RMS history to be meaningful,
+ * and gives up after a few consecutive rejections (the clock or the path
+ * really did change).
+ */
+
+#  define PTP_OUTLIER_MINSAMPLES   8
+#  define PTP_OUTLIER_MAXINROW     3
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -116,6 +150,23 @@ struct ptp_state_s
   long drift_avg_total_ms;
   long drift_ppb;
 
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+  /* PI servo state.  drift_ppb above holds the integral term. */
+
+  int servo_state;
+  int servo_outliers_inrow;
+#endif
+
+  /* Clock quality statistics, see struct ptpd_status_s */
+
+  int64_t offset_msq;
+  int64_t offset_rms_ns;
+  int64_t offset_max_ns;
+  uint32_t offset_samples;
+  uint32_t offset_outliers;
+  uint32_t clock_steps;
+  uint32_t path_delay_hist[PTPD_PATH_DELAY_HIST_BINS];
+
   /* Identity of currently selected clock source,
    * from the latest announcement message.
    *
@@ -146,6 +197,14 @@ struct ptp_state_s
   long path_delay_ns;
   long delayreq_interval;
 
+#if CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER > 1
+  /* Ring buffer of latest path delay samples for outlier filtering */
+
+  long path_delay_samples[CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER];
+  int path_delay_nsamples;
+  int path_delay_next;
+#endif
+
   /* Latest received packet and its timestamp (CLOCK_REALTIME) */
 
   struct timespec rxtime;
@@ -1014,6 +1073,9 @@ static int ptp_process_announce(FAR struct ptp_state_s *state,
           state->last_received_sync = state->last_received_announce;
           state->path_delay_avgcount = 0;
           state->path_delay_ns = 0;
+#if CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER > 1
+          state->path_delay_nsamples = 0;
+#endif
           state->delayreq_time.tv_sec = 0;
         }
     }
@@ -1021,6 +1083,286 @@ static int ptp_process_announce(FAR struct ptp_state_s *state,
   return OK;
 }
 
+/* Integer square root, used for the RMS clock error */
+
+static uint64_t ptp_isqrt(uint64_t value)
+{
+  uint64_t result = 0;
+  uint64_t bit = (uint64_t)1 << 62;
+
+  while (bit > value)
+    {
+      bit >>= 2;
+    }
+
+  while (bit != 0)
+    {
+      if (value >= result + bit)
+        {
+          value -= result + bit;
+          result = (result >> 1) + bit;
+        }
+      else
+        {
+          result >>= 1;
+        }
+
+      bit >>= 2;
+    }
+
+  return result;
+}
+
+/* Update clock error statistics with a new measurement */
+
+static void ptp_update_offset_stats(FAR struct ptp_state_s *state,
+                                    int64_t absdelta_ns)
+{
+  int64_t square = absdelta_ns * absdelta_ns;
+
+  /* Direct average for the first samples, then exponential average */
+
+  state->offset_samples++;
+  if (state->offset_samples < (1 << PTP_OFFSET_MSQ_SHIFT))
+    {
+      state->offset_msq += (square - state->offset_msq) /
+                           (int64_t)state->offset_samples;
+    }
+  else
+    {
+      state->offset_msq += (square - state->offset_msq) >>
+                           PTP_OFFSET_MSQ_SHIFT;
+    }
+
+  state->offset_rms_ns = ptp_isqrt(state->offset_msq);
+
+  if (absdelta_ns > state->offset_max_ns)
+    {
+      state->offset_max_ns = absdelta_ns;
+    }
+}
+
+/* Estimate clock drift from consecutive measurements and steer the clock
+ * to follow it.
+ */
+
+static int ptp_servo_drift(FAR struct ptp_state_s *state, int64_t delta_ns,
+                           FAR struct timespec *local_timestamp)
+{
+  /* Track drift rate based on two consecutive measurements and
+   * the adjustment that was made previously.
+   */
+
+  int64_t drift_ppb;
+  int64_t absdelta_ns;
+  struct timespec interval;
+  int interval_ms;
+  int max_avg_period_ms;
+  int64_t adjustment_ns;
+  int ret;
+
+  absdelta_ns = (delta_ns < 0) ? -delta_ns : delta_ns;
+
+  clock_timespec_subtract(local_timestamp,
+                          &state->last_delta_timestamp,
+                          &interval);
+  interval_ms = timespec_to_ms(&interval);
+
+  if (interval_ms > 0 && interval_ms < CONFIG_NETUTILS_PTPD_TIMEOUT_MS)
+    {
+      drift_ppb = (delta_ns - state->last_delta_ns) * MSEC_PER_SEC
+                  / interval_ms;
+    }
+  else
+    {
+      ptpwarn("Measurement interval out of range: %d ms\n", interval_ms);
+      drift_ppb = 0;
+      interval_ms = 1;
+    }
+
+  /* Account for the adjustment previously made */
+
+  drift_ppb += state->last_adjtime_ns * MSEC_PER_SEC
+              / CONFIG_CLOCK_ADJTIME_PERIOD_MS;
+
+  if (drift_ppb > CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 1000 ||
+      drift_ppb < -CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 1000)
+    {
+      ptpwarn("Drift estimate out of range: %lld\n",
+              (long long)drift_ppb);
+      drift_ppb = state->drift_ppb;
+    }
+
+  /* Take direct average of drift estimate for first measurements,
+   * after that update the exponential sliding average.
+   * Measurements are weighted according to the interval, because
+   * drift estimate is more accurate over longer timespan.
+   */
+
+  state->drift_avg_total_ms += interval_ms;
+  max_avg_period_ms = CONFIG_NETUTILS_PTPD_DRIFT_AVERAGE_S
+                      * MSEC_PER_SEC;
+  if (state->drift_avg_total_ms > max_avg_period_ms)
+    {
+      state->drift_avg_total_ms = max_avg_period_ms;
+    }
+
+  state->drift_ppb += (drift_ppb - state->drift_ppb) * interval_ms
+                    / state->drift_avg_total_ms;
+
+  /* Compute the value we need to give to adjtime() to match the
+   * drift rate.
+   */
+
+  adjustment_ns = state->drift_ppb * CONFIG_CLOCK_ADJTIME_PERIOD_MS
+                  / MSEC_PER_SEC;
+
+  /* Drift estimation ensures local clock runs at same rate as remote.
+   *
+   * Adding the current clock offset to adjustment brings the clocks
+   * to match. To avoid individual outliers from causing jitter, we
+   * take the larger signed value of two previous deltas. This is based
+   * on the logic that packets can get delayed in transit, but do not
+   * travel backwards in time.
+   *
+   * Clock offset is applied over ADJTIME_PERIOD. If there is significant
+   * noise in measurements, increasing ADJTIME_PERIOD will reduce its
+   * effect on the local clock run rate.
+   */
+
+  if (state->last_delta_ns > delta_ns)
+    {
+      adjustment_ns += state->last_delta_ns;
+    }
+  else
+    {
+      adjustment_ns += delta_ns;
+    }
+
+  /* Apply adjustment and store information for next time */
+
+  state->last_delta_ns = delta_ns;
+  state->last_delta_timestamp = *local_timestamp;
+  state->last_adjtime_ns = adjustment_ns;
+
+  ptpinfo("Delta: %+lld ns, adjustment %+lld ns, drift rate %+lld ppb\n",
+          (long long)delta_ns,
+          (long long)state->last_adjtime_ns,
+          (long long)state->drift_ppb);
+
+  if (absdelta_ns > CONFIG_NETUTILS_PTPD_ADJTIME_THRESHOLD_NS)
+    {
+      ret = ptp_adjtime(state, delta_ns, drift_ppb);
+    }
+  else
+    {
+      ret = ptp_adjtime(state, adjustment_ns, state->drift_ppb);
+    }
+
+  return ret;
+}
+
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+/* Steer the clock with a proportional-integral controller.
+ *
+ * The frequency correction is KP * offset / interval + I, where the
+ * integral term I (kept in state->drift_ppb) accumulates KI * offset /
+ * interval on every measurement and converges to the frequency error of
+ * the local oscillator.  Gains are normalized to the measurement interval
+ * so that the loop behaves the same for any sync rate.
+ */
+
+static int ptp_servo_pi(FAR struct ptp_state_s *state, int64_t delta_ns,
+                        FAR struct timespec *local_timestamp)
+{
+  const int64_t freq_limit = CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 1000;
+  struct timespec interval;
+  int64_t interval_ms;
+  int64_t freq_ppb;
+  int64_t adjustment_ns;
+
+  clock_timespec_subtract(local_timestamp,
+                          &state->last_delta_timestamp,
+                          &interval);
+  interval_ms = timespec_to_ms(&interval);
+
+  if (state->servo_state != PTP_SERVO_UNLOCKED &&
+      (interval_ms <= 0 || interval_ms >= CONFIG_NETUTILS_PTPD_TIMEOUT_MS))
+    {
+      ptpwarn("Measurement interval out of range: %lld ms\n",
+              (long long)interval_ms);
+      state->servo_state = PTP_SERVO_UNLOCKED;
+    }
+
+  switch (state->servo_state)
+    {
+      case PTP_SERVO_UNLOCKED:
+
+        /* Only record the first measurement */
+
+        state->servo_state = PTP_SERVO_ESTIMATING;
+        state->last_delta_ns = delta_ns;
+        state->last_delta_timestamp = *local_timestamp;
+        return OK;
+
+      case PTP_SERVO_ESTIMATING:
+
+        /* Initial frequency error from two measurements, accounting for
+         * any adjustment that was running in between.
+         */
+
+        state->drift_ppb = (delta_ns - state->last_delta_ns) * MSEC_PER_SEC
+                           / interval_ms;
+        state->drift_ppb += state->last_adjtime_ns * MSEC_PER_SEC
+                            / CONFIG_CLOCK_ADJTIME_PERIOD_MS;
+        state->servo_state = PTP_SERVO_LOCKED;
+        break;
+
+      default:
+        state->drift_ppb += CONFIG_NETUTILS_PTPD_SERVO_KI * delta_ns
+                            / interval_ms;
+        break;
+    }
+
+  /* Limit the integral term to the slew limit to avoid windup */
+
+  if (state->drift_ppb > freq_limit)
+    {
+      state->drift_ppb = freq_limit;
+    }
+  else if (state->drift_ppb < -freq_limit)
+    {
+      state->drift_ppb = -freq_limit;
+    }
+
+  freq_ppb = state->drift_ppb +
+             CONFIG_NETUTILS_PTPD_SERVO_KP * delta_ns / interval_ms;
+
+  if (freq_ppb > freq_limit)
+    {
+      freq_ppb = freq_limit;
+    }
+  else if (freq_ppb < -freq_limit)
+    {
+      freq_ppb = -freq_limit;
+    }
+
+  /* adjtime() applies the adjustment over CLOCK_ADJTIME_PERIOD */
+
+  adjustment_ns = freq_ppb * CONFIG_CLOCK_ADJTIME_PERIOD_MS / MSEC_PER_SEC;
+
+  state->last_delta_ns = delta_ns;
+  state->last_delta_timestamp = *local_timestamp;
+  state->last_adjtime_ns = adjustment_ns;
+
+  ptpinfo("Delta: %+lld ns, frequency %+lld ppb, integral %+lld ppb\n",
+          (long long)delta_ns, (long long)freq_ppb,
+          (long long)state->drift_ppb);
+
+  return ptp_adjtime(state, adjustment_ns, freq_ppb);
+}
+#endif
+
 /* Update local clock either by smooth adjustment or by jumping.
  * Remote time was remote_timestamp at local_timestamp.
  */
@@ -1064,6 +1406,17 @@ static int ptp_update_local_clock(FAR struct ptp_state_s *state,
       state->last_adjtime_ns = 0;
       state->drift_avg_total_ms = 0;
       state->drift_ppb = 0;
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+      state->servo_state = PTP_SERVO_UNLOCKED;
+#endif
+
+      /* Restart clock error statistics */
+
+      state->offset_msq = 0;
+      state->offset_rms_ns = 0;
+      state->offset_max_ns = 0;
+      state->offset_samples = 0;
+      state->clock_steps++;
 
       if (ret == OK)
         {
@@ -1077,111 +1430,35 @@ static int ptp_update_local_clock(FAR struct ptp_state_s *state,
     }
   else
     {
-      /* Track drift rate based on two consecutive measurements and
-       * the adjustment that was made previously.
-       */
-
-      int64_t drift_ppb;
-      struct timespec interval;
-      int interval_ms;
-      int max_avg_period_ms;
-      int64_t adjustment_ns;
-
-      clock_timespec_subtract(local_timestamp,
-                              &state->last_delta_timestamp,
-                              &interval);
-      interval_ms = timespec_to_ms(&interval);
-
-      if (interval_ms > 0 && interval_ms < CONFIG_NETUTILS_PTPD_TIMEOUT_MS)
-        {
-          drift_ppb = (delta_ns - state->last_delta_ns) * MSEC_PER_SEC
-                      / interval_ms;
-        }
-      else
-        {
-          ptpwarn("Measurement interval out of range: %d ms\n", interval_ms);
-          drift_ppb = 0;
-          interval_ms = 1;
-        }
-
-      /* Account for the adjustment previously made */
-
-      drift_ppb += state->last_adjtime_ns * MSEC_PER_SEC
-                  / CONFIG_CLOCK_ADJTIME_PERIOD_MS;
-
-      if (drift_ppb > CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 1000 ||
-          drift_ppb < -CONFIG_CLOCK_ADJTIME_SLEWLIMIT_PPM * 1000)
-        {
-          ptpwarn("Drift estimate out of range: %lld\n",
-                  (long long)drift_ppb);
-          drift_ppb = state->drift_ppb;
-        }
-
-      /* Take direct average of drift estimate for first measurements,
-       * after that update the exponential sliding average.
-       * Measurements are weighted according to the interval, because
-       * drift estimate is more accurate over longer timespan.
+#if defined(CONFIG_NETUTILS_PTPD_SERVO_PI) && \
+    CONFIG_NETUTILS_PTPD_SERVO_OUTLIER_FACTOR > 0
+      /* Ignore a measurement that is far off the recent clock error,
+       * unless this keeps happening.
        */
 
-      state->drift_avg_total_ms += interval_ms;
-      max_avg_period_ms = CONFIG_NETUTILS_PTPD_DRIFT_AVERAGE_S
-                          * MSEC_PER_SEC;
-      if (state->drift_avg_total_ms > max_avg_period_ms)
+      if (state->servo_state == PTP_SERVO_LOCKED &&
+          state->offset_samples >= PTP_OUTLIER_MINSAMPLES &&
+          state->servo_outliers_inrow < PTP_OUTLIER_MAXINROW &&
+          absdelta_ns > CONFIG_NETUTILS_PTPD_SERVO_OUTLIER_FACTOR *
+                        state->offset_rms_ns)
         {
-          state->drift_avg_total_ms = max_avg_period_ms;
+          ptpwarn("Ignoring outlier delta %lld ns (rms %lld ns)\n",
+                  (long long)delta_ns, (long long)state->offset_rms_ns);
+          state->servo_outliers_inrow++;
+          state->offset_outliers++;
+          return OK;
         }
 
-      state->drift_ppb += (drift_ppb - state->drift_ppb) * interval_ms
-                        / state->drift_avg_total_ms;
-
-      /* Compute the value we need to give to adjtime() to match the
-       * drift rate.
-       */
-
-      adjustment_ns = state->drift_ppb * CONFIG_CLOCK_ADJTIME_PERIOD_MS
-                      / MSEC_PER_SEC;
-
-      /* Drift estimation ensures local clock runs at same rate as remote.
-       *
-       * Adding the current clock offset to adjustment brings the clocks
-       * to match. To avoid individual outliers from causing jitter, we
-       * take the larger signed value of two previous deltas. This is based
-       * on the logic that packets can get delayed in transit, but do not
-       * travel backwards in time.
-       *
-       * Clock offset is applied over ADJTIME_PERIOD. If there is significant
-       * noise in measurements, increasing ADJTIME_PERIOD will reduce its
-       * effect on the local clock run rate.
-       */
-
-      if (state->last_delta_ns > delta_ns)
-        {
-          adjustment_ns += state->last_delta_ns;
-        }
-      else
-        {
-          adjustment_ns += delta_ns;
-        }
-
-      /* Apply adjustment and store information for next time */
-
-      state->last_delta_ns = delta_ns;
-      state->last_delta_timestamp = *local_timestamp;
-      state->last_adjtime_ns = adjustment_ns;
+      state->servo_outliers_inrow = 0;
+#endif
 
-      ptpinfo("Delta: %+lld ns, adjustment %+lld ns, drift rate %+lld ppb\n",
-              (long long)delta_ns,
-              (long long)state->last_adjtime_ns,
-              (long long)state->drift_ppb);
+      ptp_update_offset_stats(state, absdelta_ns);
 
-      if (absdelta_ns > CONFIG_NETUTILS_PTPD_ADJTIME_THRESHOLD_NS)
-        {
-          ret = ptp_adjtime(state, delta_ns, drift_ppb);
-        }
-      else
-        {
-          ret = ptp_adjtime(state, adjustment_ns, state->drift_ppb);
-        }
+#ifdef CONFIG_NETUTILS_PTPD_SERVO_PI
+      ret = ptp_servo_pi(state, delta_ns, local_timestamp);
+#else
+      ret = ptp_servo_drift(state, delta_ns, local_timestamp);
+#endif
 
       if (ret != OK)
         {
@@ -1345,6 +1622,81 @@ static int ptp_process_delay_req(FAR struct ptp_state_s *state,
   return ret;
 }
 
+/* Count a path delay measurement in the histogram */
+
+static void ptp_update_delay_hist(FAR struct ptp_state_s *state,
+                                  int64_t path_delay)
+{
+  int64_t limit = PTPD_PATH_DELAY_HIST_NS;
+  int bin = 0;
+
+  while (path_delay >= limit && bin < PTPD_PATH_DELAY_HIST_BINS - 1)
+    {
+      limit <<= 1;
+      bin++;
+    }
+
+  state->path_delay_hist[bin]++;
+}
+
+#if CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER > 1
+/* Add a path delay sample to the filter and return the filter output.
+ * Network queueing only ever delays packets, so the filter removes long
+ * outliers before the value enters the path delay average.
+ */
+
+static long ptp_filter_path_delay(FAR struct ptp_state_s *state,
+                                  long path_delay)
+{
+  long result;
+  int count;
+  int i;
+#ifdef CONFIG_NETUTILS_PTPD_PATH_DELAY_MEDIAN
+  long sorted[CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER];
+  long tmp;
+  int j;
+#endif
+
+  state->path_delay_samples[state->path_delay_next] = path_delay;
+  state->path_delay_next = (state->path_delay_next + 1) %
+                           CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER;
+  if (state->path_delay_nsamples < CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER)
+    {
+      state->path_delay_nsamples++;
+    }
+
+  count = state->path_delay_nsamples;
+
+#ifdef CONFIG_NETUTILS_PTPD_PATH_DELAY_MEDIAN
+  /* Insertion sort is plenty for at most 32 samples */
+
+  for (i = 0; i < count; i++)
+    {
+      tmp = state->path_delay_samples[i];
+      for (j = i; j > 0 && sorted[j - 1] > tmp; j--)
+        {
+          sorted[j] = sorted[j - 1];
+        }
+
+      sorted[j] = tmp;
+    }
+
+  result = sorted[count / 2];
+#else
+  result = state->path_delay_samples[0];
+  for (i = 1; i < count; i++)
+    {
+      if (state->path_delay_samples[i] < result)
+        {
+          result = state->path_delay_samples[i];
+        }
+    }
+#endif
+
+  return result;
+}
+#endif
+
 static int ptp_process_delay_resp(FAR struct ptp_state_s *state,
                                   FAR struct ptp_delay_resp_s *msg)
 {
@@ -1384,8 +1736,17 @@ static int ptp_process_delay_resp(FAR struct ptp_state_s *state,
   sync_delay = state->path_delay_ns - state->last_delta_ns;
   path_delay = (path_delay + sync_delay) / 2;
 
+  if (path_delay >= 0)
+    {
+      ptp_update_delay_hist(state, path_delay);
+    }
+
   if (path_delay >= 0 && path_delay < CONFIG_NETUTILS_PTPD_MAX_PATH_DELAY_NS)
     {
+#if CONFIG_NETUTILS_PTPD_PATH_DELAY_FILTER > 1
+      path_delay = ptp_filter_path_delay(state, path_delay);
+#endif
+
       if (state->path_delay_avgcount <
           CONFIG_NETUTILS_PTPD_DELAYREQ_AVGCOUNT)
         {
@@ -1573,6 +1934,16 @@ static void ptp_process_statusreq(FAR struct ptp_state_s *state)
   status->drift_ppb         = state->drift_ppb;
   status->path_delay_ns     = state->path_delay_ns;
 
+  /* Copy clock quality statistics */
+
+  status->offset_rms_ns     = state->offset_rms_ns;
+  status->offset_max_ns     = state->offset_max_ns;
+  status->offset_samples    = state->offset_samples;
+  status->offset_outliers   = state->offset_outliers;
+  status->clock_steps       = state->clock_steps;
+  memcpy(status->path_delay_hist, state->path_delay_hist,
+         sizeof(status->path_delay_hist));
+
   /* Copy timestamps */
 
   status->last_received_multicast    = state->last_received_multicast;
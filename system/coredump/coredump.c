@@ -35,6 +35,11 @@
 #include <fcntl.h>
 #include <getopt.h>
 #include <stdio.h>
+#include <string.h>
+
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+#  include <zlib.h>
+#endif
 
 #include <nuttx/binfmt/binfmt.h>
 #include <nuttx/streams.h>
@@ -53,6 +58,15 @@
 
 #define COREDUMP_FILE_SUFFIX_LEN (sizeof(COREDUMP_FILE_SUFFIX) - 1)
 
+/* Memory ranges that may be excluded with --exclude */
+
+#define COREDUMP_EXCLUDE_MAX     4
+
+#ifdef CONFIG_BOARD_MEMORY_RANGE
+#  define COREDUMP_REGION_NUM    (sizeof(g_memory_region) / \
+                                  sizeof(g_memory_region[0]))
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -60,6 +74,35 @@
 typedef CODE void (*dumpfile_cb_t)(FAR char *path, FAR const char *filename,
                                    FAR void *arg);
 
+/* Options of a live coredump */
+
+struct coredump_opt_s
+{
+  int pid;                    /* Thread to dump, all if invalid */
+  FAR char *filename;         /* Output file, stdout if NULL */
+  bool raw;                   /* Binary output even to stdout */
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  bool zlib;                  /* gzip compressed output */
+#endif
+#ifdef CONFIG_BOARD_MEMORY_RANGE
+  bool nomem;                 /* Skip all board memory regions */
+  int nexclude;
+  struct memory_region_s exclude[COREDUMP_EXCLUDE_MAX];
+#endif
+};
+
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+/* Streaming gzip compression in front of the output stream */
+
+struct coredump_zstream_s
+{
+  struct lib_outstream_s common;
+  FAR struct lib_outstream_s *backend;
+  z_stream zs;
+  uint8_t out[CONFIG_SYSTEM_COREDUMP_SWAPBUFFER_SIZE];
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -365,44 +408,277 @@ blkfd_err:
 
 #endif
 
+/****************************************************************************
+ * coredump_zstream
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+
+static int coredump_zdeflate(FAR struct coredump_zstream_s *stream,
+                             int flush)
+{
+  size_t len;
+  int ret;
+
+  do
+    {
+      stream->zs.next_out  = stream->out;
+      stream->zs.avail_out = sizeof(stream->out);
+
+      ret = deflate(&stream->zs, flush);
+      if (ret == Z_STREAM_ERROR)
+        {
+          return -EIO;
+        }
+      else if (ret == Z_BUF_ERROR)
+        {
+          /* No progress was possible, e.g. nothing left to flush */
+
+          ret = Z_OK;
+        }
+
+      len = sizeof(stream->out) - stream->zs.avail_out;
+      if (len > 0)
+        {
+          lib_stream_puts(stream->backend, stream->out, len);
+        }
+    }
+  while (stream->zs.avail_out == 0);
+
+  return ret;
+}
+
+static ssize_t coredump_zputs(FAR struct lib_outstream_s *self,
+                              FAR const void *buf, size_t len)
+{
+  FAR struct coredump_zstream_s *stream = (FAR void *)self;
+
+  stream->zs.next_in  = (FAR Bytef *)buf;
+  stream->zs.avail_in = len;
+  if (coredump_zdeflate(stream, Z_NO_FLUSH) < 0)
+    {
+      return -EIO;
+    }
+
+  self->nput += len;
+  return len;
+}
+
+static void coredump_zputc(FAR struct lib_outstream_s *self, int ch)
+{
+  uint8_t c = ch;
+
+  coredump_zputs(self, &c, 1);
+}
+
+static int coredump_zflush(FAR struct lib_outstream_s *self)
+{
+  FAR struct coredump_zstream_s *stream = (FAR void *)self;
+
+  stream->zs.avail_in = 0;
+  coredump_zdeflate(stream, Z_SYNC_FLUSH);
+  return lib_stream_flush(stream->backend);
+}
+
+static int coredump_zstream(FAR struct coredump_zstream_s *stream,
+                            FAR struct lib_outstream_s *backend)
+{
+  memset(stream, 0, sizeof(*stream));
+  stream->common.putc  = coredump_zputc;
+  stream->common.puts  = coredump_zputs;
+  stream->common.flush = coredump_zflush;
+  stream->backend      = backend;
+
+  /* windowBits + 16 selects the gzip wrapper, so the dump can be
+   * unpacked on the host with gunzip.
+   */
+
+  return deflateInit2(&stream->zs, CONFIG_SYSTEM_COREDUMP_ZLIB_LEVEL,
+                      Z_DEFLATED, CONFIG_SYSTEM_COREDUMP_ZLIB_WBITS + 16,
+                      CONFIG_SYSTEM_COREDUMP_ZLIB_MEMLEVEL,
+                      Z_DEFAULT_STRATEGY) == Z_OK ? 0 : -ENOMEM;
+}
+
+static void coredump_zfinish(FAR struct coredump_zstream_s *stream)
+{
+  stream->zs.avail_in = 0;
+  while (coredump_zdeflate(stream, Z_FINISH) == Z_OK);
+  deflateEnd(&stream->zs);
+  lib_stream_flush(stream->backend);
+}
+
+#endif
+
+/****************************************************************************
+ * coredump_regions
+ ****************************************************************************/
+
+#ifdef CONFIG_BOARD_MEMORY_RANGE
+
+/* Build the board memory regions minus the excluded ranges into regions,
+ * which is terminated by an empty region.  An exclusion may split one
+ * region into two.  The exclusions must be sorted by start address.
+ */
+
+static void coredump_regions(FAR const struct coredump_opt_s *opt,
+                             FAR struct memory_region_s *regions,
+                             size_t max)
+{
+  struct memory_region_s region;
+  size_t n = 0;
+  size_t i;
+  int j;
+
+  for (i = 0; !opt->nomem && i < COREDUMP_REGION_NUM; i++)
+    {
+      region = g_memory_region[i];
+      if (region.start >= region.end)
+        {
+          break;
+        }
+
+      for (j = 0; j < opt->nexclude && region.start < region.end; j++)
+        {
+          FAR const struct memory_region_s *ex = &opt->exclude[j];
+
+          if (ex->end <= region.start || ex->start >= region.end)
+            {
+              continue;
+            }
+
+          /* Keep the part below the exclusion, continue with the part
+           * above it.
+           */
+
+          if (ex->start > region.start && n + 1 < max)
+            {
+              regions[n] = region;
+              regions[n++].end = ex->start;
+            }
+
+          region.start = ex->end < region.end ? ex->end : region.end;
+        }
+
+      if (region.start < region.end && n + 1 < max)
+        {
+          regions[n++] = region;
+        }
+    }
+
+  memset(&regions[n], 0, sizeof(regions[n]));
+}
+
+/* Parse "<start>-<end>" or "<start>:<size>" */
+
+static int coredump_parse_range(FAR const char *arg,
+                                FAR struct memory_region_s *region)
+{
+  FAR char *endptr;
+
+  region->start = strtoul(arg, &endptr, 0);
+  if (*endptr == '-')
+    {
+      region->end = strtoul(endptr + 1, &endptr, 0);
+    }
+  else if (*endptr == ':')
+    {
+      region->end = region->start + strtoul(endptr + 1, &endptr, 0);
+    }
+  else
+    {
+      return -EINVAL;
+    }
+
+  return *endptr != '\0' || region->end <= region->start ? -EINVAL : 0;
+}
+
+/* Add one exclusion, keeping them sorted by start address as
+ * coredump_regions() walks each region upwards in a single pass.
+ */
+
+static int coredump_add_exclude(FAR struct coredump_opt_s *opt,
+                                FAR const char *arg)
+{
+  struct memory_region_s range;
+  int i;
+
+  if (opt->nexclude >= COREDUMP_EXCLUDE_MAX ||
+      coredump_parse_range(arg, &range) < 0)
+    {
+      return -EINVAL;
+    }
+
+  for (i = opt->nexclude; i > 0 && opt->exclude[i - 1].start > range.start;
+       i--)
+    {
+      opt->exclude[i] = opt->exclude[i - 1];
+    }
+
+  opt->exclude[i] = range;
+  opt->nexclude++;
+  return 0;
+}
+
+#endif
+
 /****************************************************************************
  * coredump_now
  ****************************************************************************/
 
-static int coredump_now(int pid, FAR char *filename)
+static int coredump_now(FAR const struct coredump_opt_s *opt)
 {
   FAR struct lib_stdoutstream_s *outstream;
   FAR struct lib_hexdumpstream_s *hstream;
 #ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
   FAR struct lib_lzfoutstream_s *lstream;
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  FAR struct coredump_zstream_s *zstream;
+#endif
+#ifdef CONFIG_BOARD_MEMORY_RANGE
+  struct memory_region_s regions[COREDUMP_REGION_NUM +
+                                 COREDUMP_EXCLUDE_MAX + 1];
 #endif
   FAR void *stream;
   FAR FILE *file;
+  FAR FILE *info;
+  FAR char *mem;
+  size_t size;
   int logmask;
 
-  if (filename != NULL)
+  if (opt->filename != NULL)
     {
-      file = fopen(filename, "w");
+      file = fopen(opt->filename, "w");
       if (file == NULL)
         {
           return -errno;
         }
+
+      /* Binary output to a file, written in large chunks */
+
+      setvbuf(file, NULL, _IOFBF, CONFIG_SYSTEM_COREDUMP_SWAPBUFFER_SIZE);
     }
   else
     {
       file = stdout;
     }
 
+  /* Keep the status lines out of a binary dump on stdout */
+
+  info = file == stdout && opt->raw ? stderr : stdout;
+
+  size = sizeof(*hstream) + sizeof(*outstream);
 #ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
-  hstream = malloc(sizeof(*hstream) + sizeof(*lstream) +
-                   sizeof(*outstream));
-#else
-  hstream = malloc(sizeof(*hstream) + sizeof(*outstream));
+  size += sizeof(*lstream);
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  size += sizeof(*zstream);
 #endif
 
-  if (hstream == NULL)
+  mem = malloc(size);
+  if (mem == NULL)
     {
-      if (filename != NULL)
+      if (opt->filename != NULL)
         {
           fclose(file);
         }
@@ -410,20 +686,24 @@ static int coredump_now(int pid, FAR char *filename)
       return -ENOMEM;
     }
 
-#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
-  lstream = (FAR void *)(hstream + 1);
-  outstream = (FAR void *)(lstream + 1);
-#else
+  hstream   = (FAR void *)mem;
   outstream = (FAR void *)(hstream + 1);
+  mem       = (FAR char *)(outstream + 1);
+#ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
+  lstream   = (FAR void *)mem;
+  mem      += sizeof(*lstream);
+#endif
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  zstream   = (FAR void *)mem;
 #endif
 
-  printf("Start coredump:\n");
+  fprintf(info, "Start coredump:\n");
   logmask = setlogmask(LOG_UPTO(LOG_ALERT));
 
-  /* Initialize hex output stream */
+  /* Initialize hex output stream, only the console needs it */
 
   lib_stdoutstream(outstream, file);
-  if (file == stdout)
+  if (file == stdout && !opt->raw)
     {
       lib_hexdumpstream(hstream, (FAR void *)outstream);
       stream = hstream;
@@ -433,32 +713,70 @@ static int coredump_now(int pid, FAR char *filename)
       stream = outstream;
     }
 
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  if (opt->zlib)
+    {
+      /* gzip compression replaces the LZF stream */
+
+      if (coredump_zstream(zstream, stream) < 0)
+        {
+          setlogmask(logmask);
+          fprintf(info, "Coredump zlib init fail\n");
+          goto out;
+        }
+
+      stream = zstream;
+    }
+  else
+#endif
+    {
 #ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
 
-  /* Initialize LZF compression stream */
+      /* Initialize LZF compression stream */
 
-  lib_lzfoutstream(lstream, stream);
-  stream = lstream;
+      lib_lzfoutstream(lstream, stream);
+      stream = lstream;
 
 #endif
+    }
 
   /* Do core dump */
 
 #ifdef CONFIG_BOARD_MEMORY_RANGE
-  coredump(g_memory_region, stream, pid);
+  coredump_regions(opt, regions, sizeof(regions) / sizeof(regions[0]));
+  coredump(regions, stream, opt->pid);
 #else
-  coredump(NULL, stream, pid);
+  coredump(NULL, stream, opt->pid);
+#endif
+
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  if (opt->zlib)
+    {
+      coredump_zfinish(zstream);
+    }
 #endif
 
   setlogmask(logmask);
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  if (opt->zlib)
+    {
+      fprintf(info, "Finish coredump (zlib Compression Enabled).\n");
+    }
+  else
+#endif
+    {
 #  ifdef CONFIG_BOARD_COREDUMP_COMPRESSION
-  printf("Finish coredump (Compression Enabled).\n");
+      fprintf(info, "Finish coredump (Compression Enabled).\n");
 #  else
-  printf("Finish coredump.\n");
+      fprintf(info, "Finish coredump.\n");
 #  endif
+    }
 
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+out:
+#endif
   free(hstream);
-  if (filename != NULL)
+  if (opt->filename != NULL)
     {
       fclose(file);
     }
@@ -476,6 +794,16 @@ static void usage(FAR const char *progname, int exitcode)
   fprintf(stderr, "Default usage, will coredump directly\n");
   fprintf(stderr, "\t -p, --pid <pid>, Default, all thread\n");
   fprintf(stderr, "\t -f, --filename <filename>, Default stdout\n");
+  fprintf(stderr, "\t -r, --raw, Binary output to stdout, "
+                  "Default hexdump\n");
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+  fprintf(stderr, "\t -z, --zlib, gzip compressed output\n");
+#endif
+#ifdef CONFIG_BOARD_MEMORY_RANGE
+  fprintf(stderr, "\t -n, --nomem, Skip the board memory regions\n");
+  fprintf(stderr, "\t -x, --exclude <start>-<end>|<start>:<size>,"
+                  " Skip a memory range (max %d)\n", COREDUMP_EXCLUDE_MAX);
+#endif
 
 #ifdef CONFIG_SYSTEM_COREDUMP_RESTORE
   fprintf(stderr, "Second usage, will restore coredump"
@@ -502,32 +830,63 @@ int main(int argc, FAR char *argv[])
   FAR char *savepath = NULL;
   size_t maxfile = 1;
 #endif
-  char *name = NULL;
-  int pid = INVALID_PROCESS_ID;
+  struct coredump_opt_s opt;
   int ret;
 
   struct option options[] =
     {
       {"pid", 1, NULL, 'p'},
       {"filename", 1, NULL, 'f'},
+      {"raw", 0, NULL, 'r'},
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+      {"zlib", 0, NULL, 'z'},
+#endif
+#ifdef CONFIG_BOARD_MEMORY_RANGE
+      {"nomem", 0, NULL, 'n'},
+      {"exclude", 1, NULL, 'x'},
+#endif
 #ifdef CONFIG_SYSTEM_COREDUMP_RESTORE
       {"savepath", 1, NULL, 's'},
       {"maxfile", 1, NULL, 'm'},
 #endif
-      {"help", 0, NULL, 'h'}
+      {"help", 0, NULL, 'h'},
+      {NULL, 0, NULL, 0}
     };
 
-  while ((ret = getopt_long(argc, argv, "p:f:s:m:h", options, NULL))
+  memset(&opt, 0, sizeof(opt));
+  opt.pid = INVALID_PROCESS_ID;
+
+  while ((ret = getopt_long(argc, argv, "p:f:rznx:s:m:h", options, NULL))
          != ERROR)
     {
       switch (ret)
         {
           case 'p':
-            pid = atoi(optarg);
+            opt.pid = atoi(optarg);
             break;
           case 'f':
-            name = optarg;
+            opt.filename = optarg;
+            break;
+          case 'r':
+            opt.raw = true;
+            break;
+#ifdef CONFIG_SYSTEM_COREDUMP_ZLIB
+          case 'z':
+            opt.zlib = true;
+            break;
+#endif
+#ifdef CONFIG_BOARD_MEMORY_RANGE
+          case 'n':
+            opt.nomem = true;
             break;
+          case 'x':
+            if (coredump_add_exclude(&opt, optarg) < 0)
+              {
+                usage(argv[0], EXIT_FAILURE);
+              }
+
+            break;
+#endif
 #ifdef CONFIG_SYSTEM_COREDUMP_RESTORE
           case 's':
             savepath = optarg;
@@ -551,7 +910,7 @@ int main(int argc, FAR char *argv[])
   else
 #endif
     {
-      coredump_now(pid, name);
+      coredump_now(&opt);
     }
 
   return 0;
@@ -49,6 +49,7 @@
 #include <getopt.h>
 #include <errno.h>
 #include <limits.h>
+#include <time.h>
 #include <lzf.h>
 
 /****************************************************************************
@@ -58,6 +59,16 @@
 #define BLOCKSIZE     ((1 << CONFIG_SYSTEM_LZF_BLOG) - 1)
 #define MAX_BLOCKSIZE BLOCKSIZE
 
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+/* Stride of one input block in a job: room for the header that
+ * lzf_compress() puts in front of incompressible data, then the data.
+ */
+
+#  define JOB_STRIDE    (LZF_MAX_HDR_SIZE + MAX_BLOCKSIZE)
+#  define JOB_BLOCKS    CONFIG_SYSTEM_LZF_PARALLEL_BLOCKS
+#  define MAX_THREADS   32
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -81,6 +92,54 @@ static lzf_state_t g_htab;
 static uint8_t g_buf1[MAX_BLOCKSIZE + LZF_MAX_HDR_SIZE + 16];
 static uint8_t g_buf2[MAX_BLOCKSIZE + LZF_MAX_HDR_SIZE + 16];
 
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+static int g_nthreads;
+
+/* A job is a run of up to JOB_BLOCKS consecutive blocks.  Jobs are read,
+ * compressed by any worker and written strictly in sequence order, so the
+ * output is identical to the single-threaded one.
+ */
+
+enum job_state_e
+{
+  JOB_EMPTY,     /* Owned by the main thread, free for reading */
+  JOB_FILLED,    /* Input read, waiting for a worker */
+  JOB_BUSY,      /* Being compressed */
+  JOB_DONE       /* Output ready to be written */
+};
+
+struct lzf_job_s
+{
+  enum job_state_e state;
+  unsigned long seq;          /* Sequence number of the job */
+  int nblocks;                /* Blocks in in[] */
+  size_t len[JOB_BLOCKS];     /* Uncompressed length of each block */
+  size_t outlen;              /* Bytes in out[] */
+  FAR uint8_t *in;            /* JOB_BLOCKS * JOB_STRIDE */
+  FAR uint8_t *out;           /* Compressed blocks with headers */
+};
+
+struct lzf_pool_s
+{
+  pthread_mutex_t lock;
+  pthread_cond_t work;        /* A job was filled or the pool stops */
+  pthread_cond_t done;        /* A job was compressed */
+  unsigned long next;         /* Sequence number of the next job to take */
+  int njobs;
+  bool stop;
+  FAR struct lzf_job_s *jobs;
+};
+
+/* Per-worker hash table and output buffer */
+
+struct lzf_worker_s
+{
+  FAR struct lzf_pool_s *pool;
+  lzf_state_t htab;
+  uint8_t buf[MAX_BLOCKSIZE + LZF_MAX_HDR_SIZE + 16];
+};
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -105,14 +164,21 @@ static void usage(int ret)
           " You can find more info at\n"
           "http://liblzf.plan9.de/\n"
           "\n"
-          "usage: lzf [-dufhvb] [file ...]\n\n"
+          "usage: lzf [-dufhvbj] [file ...]\n\n"
           "-c   Compress\n"
           "-d   Decompress\n"
           "-f   Force overwrite of output file\n"
           "-h   Give this help\n"
           "-v   Verbose mode\n"
           "-b # Set blocksize (max %lu)\n"
-          "\n", (unsigned long)MAX_BLOCKSIZE);
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+          "-j # Compress with # threads (max %d)\n"
+#endif
+          "\n", (unsigned long)MAX_BLOCKSIZE
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+          , MAX_THREADS
+#endif
+          );
 
   lzf_exit(ret);
 }
@@ -194,6 +260,264 @@ static int compress_fd(int from, int to)
   return 0;
 }
 
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+static FAR void *compress_worker(FAR void *arg)
+{
+  FAR struct lzf_worker_s *worker = arg;
+  FAR struct lzf_pool_s *pool = worker->pool;
+  FAR struct lzf_header_s *header;
+  FAR struct lzf_job_s *job;
+  FAR uint8_t *in;
+  size_t us;
+  ssize_t len;
+  int i;
+
+  pthread_mutex_lock(&pool->lock);
+  for (; ; )
+    {
+      /* Take jobs in sequence order, so the writer is never kept waiting
+       * for a job that nobody has started yet.
+       */
+
+      job = &pool->jobs[pool->next % pool->njobs];
+      while (!pool->stop &&
+             (job->state != JOB_FILLED || job->seq != pool->next))
+        {
+          pthread_cond_wait(&pool->work, &pool->lock);
+          job = &pool->jobs[pool->next % pool->njobs];
+        }
+
+      if (pool->stop)
+        {
+          break;
+        }
+
+      job->state = JOB_BUSY;
+      pool->next++;
+      pthread_mutex_unlock(&pool->lock);
+
+      job->outlen = 0;
+      for (i = 0; i < job->nblocks; i++)
+        {
+          in  = &job->in[i * JOB_STRIDE + LZF_MAX_HDR_SIZE];
+          us  = job->len[i];
+          len = lzf_compress(in, us, &worker->buf[LZF_MAX_HDR_SIZE],
+                             us > 4 ? us - 4 : us, worker->htab, &header);
+          memcpy(&job->out[job->outlen], header, len);
+          job->outlen += len;
+        }
+
+      pthread_mutex_lock(&pool->lock);
+      job->state = JOB_DONE;
+      pthread_cond_broadcast(&pool->done);
+    }
+
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+/* Read up to JOB_BLOCKS blocks into a job.  Returns the number of bytes
+ * read, 0 on end of file or -1 on read error.
+ */
+
+static ssize_t compress_fill(int from, FAR struct lzf_job_s *job)
+{
+  ssize_t total = 0;
+  ssize_t us;
+
+  for (job->nblocks = 0; job->nblocks < JOB_BLOCKS; job->nblocks++)
+    {
+      us = rread(from, &job->in[job->nblocks * JOB_STRIDE +
+                                LZF_MAX_HDR_SIZE], g_blocksize);
+      if (us < 0)
+        {
+          fprintf(stderr, "%s: read error: %d\n", g_imagename, errno);
+          return -1;
+        }
+      else if (us == 0)
+        {
+          break;
+        }
+
+      job->len[job->nblocks] = us;
+      total += us;
+    }
+
+  return total;
+}
+
+static int compress_fd_parallel(int from, int to)
+{
+  struct lzf_pool_s pool;
+  pthread_t threads[MAX_THREADS];
+  FAR struct lzf_worker_s *workers;
+  FAR struct lzf_job_s *job;
+  FAR uint8_t *mem;
+  unsigned long rseq = 0;
+  unsigned long wseq = 0;
+  size_t insize;
+  size_t outsize;
+  ssize_t nread = 1;
+  int nthreads = 0;
+  int ret = -1;
+  int i;
+
+  /* Two jobs per worker keep every worker busy while the main thread
+   * reads the next and writes the previous jobs.
+   */
+
+  memset(&pool, 0, sizeof(pool));
+  pool.njobs = 2 * g_nthreads;
+  insize     = JOB_BLOCKS * JOB_STRIDE;
+  outsize    = JOB_BLOCKS * (MAX_BLOCKSIZE + LZF_MAX_HDR_SIZE);
+
+  workers = malloc(g_nthreads * sizeof(*workers));
+  pool.jobs = malloc(pool.njobs * (sizeof(*job) + insize + outsize));
+  if (workers == NULL || pool.jobs == NULL)
+    {
+      fprintf(stderr, "%s: out of memory\n", g_imagename);
+      free(pool.jobs);
+      free(workers);
+      return -1;
+    }
+
+  mem = (FAR uint8_t *)&pool.jobs[pool.njobs];
+  for (i = 0; i < pool.njobs; i++)
+    {
+      job        = &pool.jobs[i];
+      job->state = JOB_EMPTY;
+      job->in    = mem;
+      job->out   = mem + insize;
+      mem       += insize + outsize;
+    }
+
+  pthread_mutex_init(&pool.lock, NULL);
+  pthread_cond_init(&pool.work, NULL);
+  pthread_cond_init(&pool.done, NULL);
+
+  for (; nthreads < g_nthreads; nthreads++)
+    {
+      workers[nthreads].pool = &pool;
+      if (pthread_create(&threads[nthreads], NULL,
+                         compress_worker, &workers[nthreads]) != 0)
+        {
+          fprintf(stderr, "%s: cannot create thread\n", g_imagename);
+          goto errout;
+        }
+    }
+
+  g_nread = g_nwritten = 0;
+  while (nread > 0 || wseq < rseq)
+    {
+      /* Keep all empty jobs filled, in order */
+
+      job = &pool.jobs[rseq % pool.njobs];
+      while (nread > 0 && job->state == JOB_EMPTY)
+        {
+          nread = compress_fill(from, job);
+          if (nread < 0)
+            {
+              goto errout;
+            }
+          else if (nread == 0)
+            {
+              break;
+            }
+
+          pthread_mutex_lock(&pool.lock);
+          job->seq   = rseq++;
+          job->state = JOB_FILLED;
+          pthread_cond_broadcast(&pool.work);
+          pthread_mutex_unlock(&pool.lock);
+
+          job = &pool.jobs[rseq % pool.njobs];
+        }
+
+      if (wseq == rseq)
+        {
+          continue;
+        }
+
+      /* Write the oldest job once it is compressed */
+
+      job = &pool.jobs[wseq % pool.njobs];
+      pthread_mutex_lock(&pool.lock);
+      while (job->state != JOB_DONE)
+        {
+          pthread_cond_wait(&pool.done, &pool.lock);
+        }
+
+      pthread_mutex_unlock(&pool.lock);
+
+      if (wwrite(to, job->out, job->outlen) == -1)
+        {
+          goto errout;
+        }
+
+      pthread_mutex_lock(&pool.lock);
+      job->state = JOB_EMPTY;
+      pthread_mutex_unlock(&pool.lock);
+      wseq++;
+    }
+
+  ret = 0;
+
+errout:
+  pthread_mutex_lock(&pool.lock);
+  pool.stop = true;
+  pthread_cond_broadcast(&pool.work);
+  pthread_mutex_unlock(&pool.lock);
+
+  while (nthreads > 0)
+    {
+      pthread_join(threads[--nthreads], NULL);
+    }
+
+  pthread_cond_destroy(&pool.done);
+  pthread_cond_destroy(&pool.work);
+  pthread_mutex_destroy(&pool.lock);
+  free(pool.jobs);
+  free(workers);
+  return ret;
+}
+#endif
+
+static int compress_run(int from, int to)
+{
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+  if (g_nthreads > 1)
+    {
+      return compress_fd_parallel(from, to);
+    }
+#endif
+
+  return compress_fd(from, to);
+}
+
+static void report(FAR const char *name, FAR const struct timespec *start)
+{
+  struct timespec now;
+  unsigned long long us;
+  off_t in = g_mode == COMPRESS ? g_nread : g_nwritten;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  us = (unsigned long long)(now.tv_sec - start->tv_sec) * 1000000 +
+       (now.tv_nsec - start->tv_nsec) / 1000;
+
+  fprintf(stderr, "%s: %llu bytes in %llu.%03llu s, %llu KiB/s",
+          name, (unsigned long long)in, us / 1000000, us / 1000 % 1000,
+          us ? (unsigned long long)in * 1000000 / 1024 / us : 0);
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+  if (g_mode == COMPRESS)
+    {
+      fprintf(stderr, ", %d thread%s", g_nthreads,
+              g_nthreads > 1 ? "s" : "");
+    }
+#endif
+
+  fprintf(stderr, "\n");
+}
+
 static int uncompress_fd(int from, int to)
 {
   uint8_t header[LZF_MAX_HDR_SIZE];
@@ -373,6 +697,7 @@ static int compose_name(FAR const char *fname, FAR char *oname, int namelen)
 static int run_file(FAR const char *fname)
 {
   struct stat mystat;
+  struct timespec start;
   char oname[PATH_MAX];
   int fd;
   int fd2;
@@ -407,9 +732,11 @@ static int run_file(FAR const char *fname)
       return -1;
     }
 
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
   if (g_mode == COMPRESS)
     {
-      ret = compress_fd(fd, fd2);
+      ret = compress_run(fd, fd2);
       if (!ret && g_verbose)
         {
           fprintf(stderr, "%s:  %5.1f%% -- replaced with %s\n",
@@ -428,6 +755,11 @@ static int run_file(FAR const char *fname)
         }
     }
 
+  if (!ret && g_verbose)
+    {
+      report(fname, &start);
+    }
+
   close(fd);
   close(fd2);
 
@@ -445,6 +777,7 @@ static int run_file(FAR const char *fname)
 
 int main(int argc, FAR char *argv[])
 {
+  struct timespec start;
   FAR char *p = argv[0];
   int optc;
   int ret = 0;
@@ -473,6 +806,9 @@ int main(int argc, FAR char *argv[])
   g_verbose   = false;
   g_force     = 0;
   g_blocksize = BLOCKSIZE;
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+  g_nthreads  = CONFIG_SYSTEM_LZF_PARALLEL_THREADS;
+#endif
 
 #ifndef CONFIG_DISABLE_ENVIRON
   /* Block size may be specified as an environment variable */
@@ -495,7 +831,7 @@ int main(int argc, FAR char *argv[])
 
   /* Handle command line options */
 
-  while ((optc = getopt(argc, argv, "cdfhvb:")) != -1)
+  while ((optc = getopt(argc, argv, "cdfhvb:j:")) != -1)
     {
       switch (optc)
         {
@@ -528,6 +864,17 @@ int main(int argc, FAR char *argv[])
 
             break;
 
+#ifdef CONFIG_SYSTEM_LZF_PARALLEL
+          case 'j':
+            g_nthreads = atoi(optarg);
+            if (g_nthreads < 1 || g_nthreads > MAX_THREADS)
+              {
+                g_nthreads = CONFIG_SYSTEM_LZF_PARALLEL_THREADS;
+              }
+
+            break;
+#endif
+
           default:
             usage(1);
             break;
@@ -557,15 +904,22 @@ int main(int argc, FAR char *argv[])
             }
         }
 
+      clock_gettime(CLOCK_MONOTONIC, &start);
+
       if (g_mode == COMPRESS)
         {
-          ret = compress_fd(0, 1);
+          ret = compress_run(0, 1);
         }
       else
         {
           ret = uncompress_fd(0, 1);
         }
 
+      if (!ret && g_verbose)
+        {
+          report(g_imagename, &start);
+        }
+
       lzf_exit(ret ? 1 : 0);
     }
 
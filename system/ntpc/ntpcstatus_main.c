@@ -126,5 +126,12 @@ int main(int argc, FAR char *argv[])
              i, name, offset_buf, delay_buf);
     }
 
+#ifdef CONFIG_NETUTILS_NTPCLIENT_DISCIPLINE
+  printf("Clock discipline: offset %lld ns jitter %lld ns "
+         "freq %lld ppb poll %u s\n",
+         (long long)status.offset_ns, (long long)status.jitter_ns,
+         (long long)status.freq_ppb, status.poll_interval);
+#endif
+
   return EXIT_SUCCESS;
 }
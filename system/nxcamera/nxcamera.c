@@ -37,6 +37,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <poll.h>
 
@@ -67,33 +68,65 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * nxcamera_now
+ ****************************************************************************/
+
+static uint32_t nxcamera_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)(ts.tv_sec * 1000000 + ts.tv_nsec / 1000);
+}
+
 /****************************************************************************
  * pan_display
+ *
+ *   Show the buffer that was just drawn.  With double buffering, the next
+ *   frame is drawn into the other half of the framebuffer while this one is
+ *   displayed.  Returns false if the display could not accept the pan yet;
+ *   the drawn buffer is then reused for the next frame.
+ *
  ****************************************************************************/
 
-static void pan_display(int fb_device, FAR struct fb_planeinfo_s *plane_info)
+static bool pan_display(FAR struct nxcamera_s *pcam)
 {
   struct pollfd pfd;
   int ret;
-  pfd.fd = fb_device;
+  pfd.fd = pcam->display_fd;
   pfd.events = POLLOUT;
 
   ret = poll(&pfd, 1, 0);
 
   if (ret > 0)
     {
-      ioctl(fb_device, FBIOPAN_DISPLAY, plane_info);
+      pcam->display_pinfo.yoffset = pcam->display_yoffset;
+      ioctl(pcam->display_fd, FBIOPAN_DISPLAY, &pcam->display_pinfo);
+
+      if (pcam->display_dblbuf)
+        {
+          pcam->display_yoffset = pcam->display_yoffset ?
+                                  0 : pcam->display_vinfo.yres;
+        }
+
+      return true;
     }
+
+  return false;
 }
 
 static int show_image(FAR struct nxcamera_s *pcam, FAR v4l2_buffer_t *buf)
 {
 #ifdef CONFIG_LIBYUV
+  FAR uint8_t *fbmem = (FAR uint8_t *)pcam->display_pinfo.fbmem +
+                       pcam->display_yoffset * pcam->display_pinfo.stride;
+
   if (pcam->display_vinfo.fmt == FB_FMT_RGB32)
     {
       return ConvertToARGB(pcam->bufs[buf->index],
                            pcam->buf_sizes[buf->index],
-                           pcam->display_pinfo.fbmem,
+                           fbmem,
                            pcam->display_pinfo.stride,
                            0,
                            0,
@@ -106,42 +139,26 @@ static int show_image(FAR struct nxcamera_s *pcam, FAR v4l2_buffer_t *buf)
     }
   else if (pcam->display_vinfo.fmt == FB_FMT_RGB16_565)
     {
-      if (pcam->fmt.fmt.pix.pixelformat == V4L2_PIX_FMT_YUV420)
-        {
-          return ConvertFromI420(pcam->bufs[buf->index],
-                                 pcam->fmt.fmt.pix.width,
-                                 &pcam->bufs[buf->index][
-                                            pcam->fmt.fmt.pix.width *
-                                            pcam->fmt.fmt.pix.height],
-                                 pcam->fmt.fmt.pix.width / 2,
-                                 &pcam->bufs[buf->index][
-                                      pcam->fmt.fmt.pix.width *
-                                      pcam->fmt.fmt.pix.height * 5 / 4],
-                                 pcam->fmt.fmt.pix.width / 2,
-                                 pcam->display_pinfo.fbmem,
-                                 pcam->display_pinfo.stride,
-                                 pcam->fmt.fmt.pix.width,
-                                 pcam->fmt.fmt.pix.height,
-                                 V4L2_PIX_FMT_RGB565);
-        }
-      else
+      FAR uint8_t *src = pcam->bufs[buf->index];
+      int ret;
+
+      /* Other formats are converted to I420 first, using the buffer that
+       * was allocated when the stream was started.
+       */
+
+      if (pcam->fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_YUV420)
         {
-          int ret;
-          FAR uint8_t *dst = malloc(pcam->fmt.fmt.pix.width *
-                                    pcam->fmt.fmt.pix.height * 3 / 2);
-          if (!dst)
-            {
-              return -ENOMEM;
-            }
+          DEBUGASSERT(pcam->convbuf != NULL);
 
+          src = pcam->convbuf;
           ret = ConvertToI420(pcam->bufs[buf->index],
                               pcam->buf_sizes[buf->index],
-                              dst,
+                              src,
                               pcam->fmt.fmt.pix.width,
-                              &dst[pcam->fmt.fmt.pix.width *
+                              &src[pcam->fmt.fmt.pix.width *
                                         pcam->fmt.fmt.pix.height],
                               pcam->fmt.fmt.pix.width / 2,
-                              &dst[pcam->fmt.fmt.pix.width *
+                              &src[pcam->fmt.fmt.pix.width *
                                         pcam->fmt.fmt.pix.height * 5 / 4],
                               pcam->fmt.fmt.pix.width / 2,
                               0,
@@ -154,31 +171,23 @@ static int show_image(FAR struct nxcamera_s *pcam, FAR v4l2_buffer_t *buf)
                               pcam->fmt.fmt.pix.pixelformat);
           if (ret < 0)
             {
-              goto err;
+              return ret;
             }
-
-          ret = ConvertFromI420(dst,
-                                pcam->fmt.fmt.pix.width,
-                                &dst[pcam->fmt.fmt.pix.width *
-                                            pcam->fmt.fmt.pix.height],
-                                pcam->fmt.fmt.pix.width / 2,
-                                &dst[pcam->fmt.fmt.pix.width *
-                                     pcam->fmt.fmt.pix.height * 5 / 4],
-                                pcam->fmt.fmt.pix.width / 2,
-                                pcam->display_pinfo.fbmem,
-                                pcam->display_pinfo.stride,
-                                pcam->fmt.fmt.pix.width,
-                                pcam->fmt.fmt.pix.height,
-                                V4L2_PIX_FMT_RGB565);
-          if (ret < 0)
-            {
-              goto err;
-            }
-
-err:
-          free(dst);
-          return ret;
         }
+
+      return ConvertFromI420(src,
+                             pcam->fmt.fmt.pix.width,
+                             &src[pcam->fmt.fmt.pix.width *
+                                  pcam->fmt.fmt.pix.height],
+                             pcam->fmt.fmt.pix.width / 2,
+                             &src[pcam->fmt.fmt.pix.width *
+                                  pcam->fmt.fmt.pix.height * 5 / 4],
+                             pcam->fmt.fmt.pix.width / 2,
+                             fbmem,
+                             pcam->display_pinfo.stride,
+                             pcam->fmt.fmt.pix.width,
+                             pcam->fmt.fmt.pix.height,
+                             V4L2_PIX_FMT_RGB565);
     }
 
   return 0;
@@ -314,6 +323,11 @@ static void *nxcamera_loopthread(pthread_addr_t pvarg)
   int                     ret;
   struct v4l2_buffer      buf;
   uint32_t                type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+  uint32_t                start;
+  uint32_t                dequeued;
+  uint32_t                converted;
+  uint32_t                end;
+  bool                    shown;
 
   vinfo("Entry\n");
   memset(&buf, 0, sizeof(buf));
@@ -389,6 +403,7 @@ static void *nxcamera_loopthread(pthread_addr_t pvarg)
             }
         }
 
+      start = nxcamera_now();
       ret = ioctl(pcam->capture_fd, VIDIOC_DQBUF, (uintptr_t)&buf);
       if (ret < 0)
         {
@@ -396,6 +411,7 @@ static void *nxcamera_loopthread(pthread_addr_t pvarg)
           goto err_out;
         }
 
+      dequeued = nxcamera_now();
       ret = show_image(pcam, &buf);
       if (ret < 0)
         {
@@ -403,11 +419,30 @@ static void *nxcamera_loopthread(pthread_addr_t pvarg)
           goto err_out;
         }
 
+      converted = nxcamera_now();
+      shown = true;
       if (pcam->display_pinfo.yres_virtual > pcam->display_vinfo.yres)
         {
-          pan_display(pcam->display_fd, &pcam->display_pinfo);
+          shown = pan_display(pcam) || !pcam->display_dblbuf;
+        }
+
+      end = nxcamera_now();
+
+      /* Account the time spent in each stage */
+
+      pthread_mutex_lock(&pcam->mutex);
+      pcam->stats.frames++;
+      pcam->stats.skipped    += !shown;
+      pcam->stats.dequeue_us += dequeued - start;
+      pcam->stats.convert_us += converted - dequeued;
+      pcam->stats.display_us += end - converted;
+      if (end - start > pcam->stats.max_frame_us)
+        {
+          pcam->stats.max_frame_us = end - start;
         }
 
+      pthread_mutex_unlock(&pcam->mutex);
+
       ret = ioctl(pcam->capture_fd, VIDIOC_QBUF, (uintptr_t)&buf);
       if (ret < 0)
         {
@@ -439,6 +474,8 @@ err_out:
 
   free(pcam->bufs);
   free(pcam->buf_sizes);
+  free(pcam->convbuf);
+  pcam->convbuf = NULL;
   pthread_mutex_unlock(&pcam->mutex);     /* Unlock the mutex */
 
   vinfo("Exit\n");
@@ -788,6 +825,36 @@ int nxcamera_stream(FAR struct nxcamera_s *pcam,
       pcam->buf_sizes[i] = buf.length;
     }
 
+#ifdef CONFIG_LIBYUV
+  /* Formats other than I420 are converted to I420 before they are shown
+   * on an RGB565 display.  Allocate the intermediate frame once here
+   * rather than for every frame.
+   */
+
+  if (pcam->display_vinfo.fmt == FB_FMT_RGB16_565 &&
+      pcam->fmt.fmt.pix.pixelformat != V4L2_PIX_FMT_YUV420)
+    {
+      pcam->convbuf = malloc(pcam->fmt.fmt.pix.width *
+                             pcam->fmt.fmt.pix.height * 3 / 2);
+      if (pcam->convbuf == NULL)
+        {
+          verr("Cannot allocate conversion buffer\n");
+          ret = -ENOMEM;
+          goto err_out;
+        }
+    }
+#endif
+
+  /* With room for two frames in the framebuffer, draw each frame into the
+   * half that is not displayed and pan to it when it is complete.
+   */
+
+  pcam->display_dblbuf  = pcam->display_pinfo.yres_virtual >=
+                          2 * pcam->display_vinfo.yres;
+  pcam->display_yoffset = pcam->display_dblbuf ?
+                          pcam->display_vinfo.yres : 0;
+  memset(&pcam->stats, 0, sizeof(pcam->stats));
+
   /* Create a message queue for the loopthread */
 
   memset(&attr, 0, sizeof(attr));
@@ -859,9 +926,31 @@ err_out:
       free(pcam->buf_sizes);
     }
 
+  free(pcam->convbuf);
+  pcam->bufs      = NULL;
+  pcam->buf_sizes = NULL;
+  pcam->convbuf   = NULL;
   return ret;
 }
 
+/****************************************************************************
+ * Name: nxcamera_getstats
+ *
+ *   nxcamera_getstats() returns the per-stage timing of the current or
+ *   last stream.
+ *
+ ****************************************************************************/
+
+void nxcamera_getstats(FAR struct nxcamera_s *pcam,
+                       FAR struct nxcamera_stats_s *stats)
+{
+  DEBUGASSERT(pcam != NULL && stats != NULL);
+
+  pthread_mutex_lock(&pcam->mutex);
+  *stats = pcam->stats;
+  pthread_mutex_unlock(&pcam->mutex);
+}
+
 /****************************************************************************
  * Name: nxcamera_create
  *
@@ -28,6 +28,7 @@
 #include <nuttx/video/video.h>
 
 #include <sys/types.h>
+#include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -74,6 +75,7 @@ static int nxcamera_cmd_stream(FAR struct nxcamera_s *pcam, FAR char *parg);
 static int nxcamera_cmd_input(FAR struct nxcamera_s *pcam, FAR char *parg);
 static int nxcamera_cmd_output(FAR struct nxcamera_s *pcam, FAR char *parg);
 static int nxcamera_cmd_stop(FAR struct nxcamera_s *pcam, FAR char *parg);
+static int nxcamera_cmd_stats(FAR struct nxcamera_s *pcam, FAR char *parg);
 #ifdef CONFIG_NXCAMERA_INCLUDE_HELP
 static int nxcamera_cmd_help(FAR struct nxcamera_s *pcam, FAR char *parg);
 #endif
@@ -122,6 +124,12 @@ static const struct nxcamera_cmd_s g_nxcamera_cmds[] =
     nxcamera_cmd_stop,
     NXCAMERA_HELP_TEXT("Stop stream")
   },
+  {
+    "stats",
+    "",
+    nxcamera_cmd_stats,
+    NXCAMERA_HELP_TEXT("Show per-stage frame timing")
+  },
   {
     "q",
     "",
@@ -214,6 +222,34 @@ static int nxcamera_cmd_stop(FAR struct nxcamera_s *pcam, FAR char *parg)
   return nxcamera_stop(pcam);
 }
 
+/****************************************************************************
+ * Name: nxcamera_cmd_stats
+ *
+ *   nxcamera_cmd_stats() shows the average time spent per frame in each
+ *   stage of the current or last stream.
+ *
+ ****************************************************************************/
+
+static int nxcamera_cmd_stats(FAR struct nxcamera_s *pcam, FAR char *parg)
+{
+  struct nxcamera_stats_s stats;
+
+  nxcamera_getstats(pcam, &stats);
+  if (stats.frames == 0)
+    {
+      printf("No frames streamed\n");
+      return OK;
+    }
+
+  printf("frames:  %" PRIu32 " (%" PRIu32 " not panned in)\n",
+         stats.frames, stats.skipped);
+  printf("dequeue: %" PRIu64 " us/frame\n", stats.dequeue_us / stats.frames);
+  printf("convert: %" PRIu64 " us/frame\n", stats.convert_us / stats.frames);
+  printf("display: %" PRIu64 " us/frame\n", stats.display_us / stats.frames);
+  printf("slowest: %" PRIu32 " us\n", stats.max_frame_us);
+  return OK;
+}
+
 /****************************************************************************
  * Name: nxcamera_cmd_input
  *
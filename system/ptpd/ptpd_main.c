@@ -56,6 +56,7 @@ static int do_ptpd_status(int pid)
   struct tm time_tm;
   struct timespec time_now;
   int ret;
+  int i;
 
   ret = ptpd_status(pid, &status);
   if (ret != OK)
@@ -103,6 +104,34 @@ static int do_ptpd_status(int pid)
   printf("- last_adjtime_ns: %lld\n", (long long)status.last_adjtime_ns);
   printf("- drift_ppb: %ld\n", status.drift_ppb);
   printf("- path_delay_ns: %ld\n", status.path_delay_ns);
+  printf("- offset_rms_ns: %lld\n", (long long)status.offset_rms_ns);
+  printf("- offset_max_ns: %lld\n", (long long)status.offset_max_ns);
+  printf("- offset_samples: %lu\n", (unsigned long)status.offset_samples);
+  printf("- offset_outliers: %lu\n",
+    (unsigned long)status.offset_outliers);
+  printf("- clock_steps: %lu\n", (unsigned long)status.clock_steps);
+
+  printf("- path_delay_hist:\n");
+  for (i = 0; i < PTPD_PATH_DELAY_HIST_BINS; i++)
+    {
+      if (status.path_delay_hist[i] == 0)
+        {
+          continue;
+        }
+
+      if (i < PTPD_PATH_DELAY_HIST_BINS - 1)
+        {
+          printf("|- < %ld ns: %lu\n",
+            (long)PTPD_PATH_DELAY_HIST_NS << i,
+            (unsigned long)status.path_delay_hist[i]);
+        }
+      else
+        {
+          printf("'- >= %ld ns: %lu\n",
+            (long)PTPD_PATH_DELAY_HIST_NS << (i - 1),
+            (unsigned long)status.path_delay_hist[i]);
+        }
+    }
 
   clock_gettime(CLOCK_MONOTONIC, &time_now);
 
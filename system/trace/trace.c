@@ -26,6 +26,8 @@
 
 #include <nuttx/config.h>
 
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -46,40 +48,6 @@
  * Private Functions
  ****************************************************************************/
 
-/****************************************************************************
- * Name: notectl_enable
- ****************************************************************************/
-
-static bool notectl_enable(FAR const char *name, int flag, int notectlfd)
-{
-  struct note_filter_named_mode_s mode;
-  int oldflag;
-
-  strlcpy(mode.name, name, NAME_MAX);
-  ioctl(notectlfd, NOTECTL_GETMODE, (unsigned long)&mode);
-
-  oldflag = (mode.mode.flag & NOTE_FILTER_MODE_FLAG_ENABLE) != 0;
-  if (flag == oldflag)
-    {
-      /* Already set */
-
-      return false;
-    }
-
-  if (flag)
-    {
-      mode.mode.flag |= NOTE_FILTER_MODE_FLAG_ENABLE;
-    }
-  else
-    {
-      mode.mode.flag &= ~NOTE_FILTER_MODE_FLAG_ENABLE;
-    }
-
-  ioctl(notectlfd, NOTECTL_SETMODE, (unsigned long)&mode);
-
-  return true;
-}
-
 /****************************************************************************
  * Name: trace_cmd_start
  ****************************************************************************/
@@ -148,9 +116,12 @@ static int trace_cmd_dump(FAR const char *name, int index, int argc,
   FAR FILE *out = stdout;
   bool changed = false;
   bool cont = false;
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  bool ctf = false;
+#endif
   int ret;
 
-  /* Usage: trace dump [-c][<filename>] */
+  /* Usage: trace dump [-c][-C <directory>|<filename>] */
 
   if (index < argc)
     {
@@ -161,6 +132,46 @@ static int trace_cmd_dump(FAR const char *name, int index, int argc,
         }
     }
 
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  if (index < argc)
+    {
+      if (strcmp(argv[index], "-C") == 0)
+        {
+          ctf = true;
+          index++;
+          if (index >= argc)
+            {
+              fprintf(stderr, "trace dump: no CTF directory\n");
+              return ERROR;
+            }
+        }
+    }
+
+  if (ctf)
+    {
+      if (!cont)
+        {
+          changed = notectl_enable(name, false, notectlfd);
+        }
+
+      ret = trace_dump_ctf(argv[index]);
+
+      if (changed)
+        {
+          notectl_enable(name, true, notectlfd);
+        }
+
+      if (ret < 0)
+        {
+          fprintf(stderr,
+                  "trace dump: dump failed\n");
+          return ERROR;
+        }
+
+      return index + 1;
+    }
+#endif
+
   /* If <filename> is '-' or not given, trace dump is displayed
    * to stdout.
    */
@@ -221,6 +232,182 @@ static int trace_cmd_dump(FAR const char *name, int index, int argc,
 }
 #endif
 
+/****************************************************************************
+ * Name: trace_cmd_record
+ ****************************************************************************/
+
+#ifdef CONFIG_SYSTEM_TRACE_RECORD
+static int trace_cmd_record(FAR const char *name, int index, int argc,
+                            FAR char **argv, int notectlfd)
+{
+  struct trace_record_s cfg;
+  unsigned long value;
+  FAR char *endptr;
+  FAR char *opt;
+  bool changed;
+  bool cont = false;
+  int ret;
+
+  /* Usage: trace record [-c][-C][-s <size>][-r <files>][-t <duration>]
+   *                     [-T <trigger>][-p <bytes>] <target>
+   */
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.nfiles = CONFIG_SYSTEM_TRACE_RECORD_NFILES;
+  cfg.name = name;
+  cfg.notectlfd = notectlfd;
+
+  while (index < argc && argv[index][0] == '-' && argv[index][1] != '\0')
+    {
+      opt = argv[index++];
+      if (strcmp(opt, "-c") == 0)
+        {
+          cont = true;
+          continue;
+        }
+
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+      if (strcmp(opt, "-C") == 0)
+        {
+          cfg.ctf = true;
+          continue;
+        }
+#endif
+
+      if (opt[2] != '\0' || index >= argc)
+        {
+          fprintf(stderr, "trace record: invalid option '%s'\n", opt);
+          return ERROR;
+        }
+
+      if (opt[1] == 'T')
+        {
+          cfg.trigger = argv[index++];
+          if (cfg.trigger[0] == '\0')
+            {
+              fprintf(stderr, "trace record: empty trigger\n");
+              return ERROR;
+            }
+
+          continue;
+        }
+
+      /* strtoul() quietly negates a leading '-' */
+
+      errno = 0;
+      value = strtoul(argv[index], &endptr, 0);
+      if (endptr == argv[index] || *endptr != '\0' || errno != 0 ||
+          strchr(argv[index], '-') != NULL)
+        {
+          fprintf(stderr,
+                  "trace record: invalid argument '%s'\n", argv[index]);
+          return ERROR;
+        }
+
+      index++;
+
+      /* A size, file count or duration of 0 is what leaving the option
+       * out means, so only -p accepts it (stop right at the trigger).
+       */
+
+      switch (opt[1])
+        {
+          case 's':
+            if (value == 0 || value > SIZE_MAX)
+              {
+                goto errout_range;
+              }
+
+            cfg.filesize = value;
+            break;
+
+          case 'r':
+            if (value == 0 || value > INT_MAX)
+              {
+                goto errout_range;
+              }
+
+            cfg.nfiles = value;
+            break;
+
+          case 't':
+            if (value == 0 || value > UINT_MAX)
+              {
+                goto errout_range;
+              }
+
+            cfg.duration = value;
+            break;
+
+          case 'p':
+            if (value > SIZE_MAX)
+              {
+                goto errout_range;
+              }
+
+            cfg.posttrigger = value;
+            break;
+
+          default:
+            fprintf(stderr, "trace record: invalid option '%s'\n", opt);
+            return ERROR;
+        }
+    }
+
+  if (index >= argc)
+    {
+      /* <target> parameter is mandatory. */
+
+      fprintf(stderr,
+              "trace record: no target\n");
+      return ERROR;
+    }
+
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  if (cfg.ctf && (cfg.filesize > 0 || strchr(argv[index], ':') != NULL))
+    {
+      /* A CTF trace is a directory with a single stream file */
+
+      fprintf(stderr,
+              "trace record: -C needs a directory and no -s\n");
+      return ERROR;
+    }
+#endif
+
+  /* Clear the trace buffer */
+
+  if (!cont)
+    {
+      trace_dump_clear();
+    }
+
+  /* Record until stopped, with tracing enabled */
+
+  changed = notectl_enable(name, true, notectlfd);
+
+  ret = trace_record(argv[index], &cfg);
+
+  if (changed)
+    {
+      notectl_enable(name, false, notectlfd);
+    }
+
+  if (ret < 0)
+    {
+      fprintf(stderr,
+              "trace record: record failed\n");
+      return ERROR;
+    }
+
+  return index + 1;
+
+errout_range:
+  fprintf(stderr, "trace record: %s %s is out of range\n",
+          opt, argv[index - 1]);
+  return ERROR;
+}
+#endif
+
 /****************************************************************************
  * Name: trace_cmd_cmd
  ****************************************************************************/
@@ -806,6 +993,22 @@ static void show_usage(void)
           " dump    [-a][-c][<filename>]        :"
                                 " Output the trace result\n"
           "                                       [-a] <Android SysTrace>\n"
+#endif
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+          " dump    [-c] -C <directory>         :"
+                                " Export the trace in CTF format\n"
+#endif
+#ifdef CONFIG_SYSTEM_TRACE_RECORD
+          " record  [-c][-s <size>][-r <files>] :"
+                                " Stream the trace to <target>\n"
+          "         [-t <duration>][-T <trigger>]\n"
+          "         [-p <bytes>] <target>\n"
+          "                                       "
+                                "<target>: <file>|{tcp|udp}:<ip>:<port>\n"
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+          "                                       "
+                                "[-C] <target> is a CTF directory\n"
+#endif
 #endif
           " mode    [{+|-}{o|w|s|a|i|d}...]     :"
                                 " Set task trace options\n"
@@ -834,6 +1037,40 @@ static void show_usage(void)
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: notectl_enable
+ ****************************************************************************/
+
+bool notectl_enable(FAR const char *name, int flag, int notectlfd)
+{
+  struct note_filter_named_mode_s mode;
+  int oldflag;
+
+  strlcpy(mode.name, name, NAME_MAX);
+  ioctl(notectlfd, NOTECTL_GETMODE, (unsigned long)&mode);
+
+  oldflag = (mode.mode.flag & NOTE_FILTER_MODE_FLAG_ENABLE) != 0;
+  if (flag == oldflag)
+    {
+      /* Already set */
+
+      return false;
+    }
+
+  if (flag)
+    {
+      mode.mode.flag |= NOTE_FILTER_MODE_FLAG_ENABLE;
+    }
+  else
+    {
+      mode.mode.flag &= ~NOTE_FILTER_MODE_FLAG_ENABLE;
+    }
+
+  ioctl(notectlfd, NOTECTL_SETMODE, (unsigned long)&mode);
+
+  return true;
+}
+
 int main(int argc, FAR char *argv[])
 {
   int notectlfd;
@@ -886,6 +1123,12 @@ int main(int argc, FAR char *argv[])
           i = trace_cmd_dump(name, i + 1, argc, argv, notectlfd);
         }
 #endif
+#ifdef CONFIG_SYSTEM_TRACE_RECORD
+      else if (strcmp(argv[i], "record") == 0)
+        {
+          i = trace_cmd_record(name, i + 1, argc, argv, notectlfd);
+        }
+#endif
 #ifdef CONFIG_SYSTEM_SYSTEM
       else if (strcmp(argv[i], "cmd") == 0)
         {
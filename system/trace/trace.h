@@ -29,6 +29,9 @@
 
 #include <nuttx/config.h>
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 
 #ifdef __cplusplus
@@ -43,6 +46,34 @@ extern "C"
  * Public Types
  ****************************************************************************/
 
+#ifdef CONFIG_SYSTEM_TRACE_RECORD
+
+/* Trace record options */
+
+struct trace_record_s
+{
+  size_t          filesize;     /* Rotate the file after this size, 0: no */
+  int             nfiles;       /* Number of rotated files kept */
+  unsigned int    duration;     /* Stop after seconds, 0: no limit */
+  FAR const char *trigger;      /* Stop when this string is recorded */
+  size_t          posttrigger;  /* Bytes still recorded after trigger */
+  FAR const char *name;         /* Note filter, to stop tracing at the end */
+  int             notectlfd;    /* Open /dev/notectl */
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  bool            ctf;          /* Export to a CTF trace directory */
+#endif
+};
+
+#endif
+
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+
+/* CTF export context, see trace_ctf.c */
+
+struct trace_ctf_s;
+
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -89,6 +120,90 @@ bool trace_dump_get_overwrite(void);
 
 void trace_dump_set_overwrite(bool mode);
 
+/****************************************************************************
+ * Name: notectl_enable
+ *
+ * Description:
+ *   Enable or disable note collection, returns true if the state changed.
+ *
+ ****************************************************************************/
+
+bool notectl_enable(FAR const char *name, int flag, int notectlfd);
+
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+
+/****************************************************************************
+ * Name: trace_ctf_open
+ *
+ * Description:
+ *   Create a Common Trace Format (CTF 1.8) trace directory with its
+ *   metadata and a binary stream file.
+ *
+ ****************************************************************************/
+
+FAR struct trace_ctf_s *trace_ctf_open(FAR const char *dir);
+
+/****************************************************************************
+ * Name: trace_ctf_write
+ *
+ * Description:
+ *   Convert a chunk of binary notes read from /dev/note/ram to CTF events.
+ *
+ ****************************************************************************/
+
+int trace_ctf_write(FAR struct trace_ctf_s *ctf,
+                    FAR const uint8_t *buf, size_t len);
+
+/****************************************************************************
+ * Name: trace_ctf_close
+ *
+ * Description:
+ *   Flush and close the CTF stream.  Returns the number of events written.
+ *
+ ****************************************************************************/
+
+int trace_ctf_close(FAR struct trace_ctf_s *ctf);
+
+/****************************************************************************
+ * Name: trace_ctf_readmode / trace_ctf_restore
+ *
+ * Description:
+ *   Switch the note driver on fd to binary reads and back.
+ *
+ ****************************************************************************/
+
+unsigned int trace_ctf_readmode(int fd);
+void trace_ctf_restore(int fd, unsigned int mode);
+
+/****************************************************************************
+ * Name: trace_dump_ctf
+ *
+ * Description:
+ *   Read all notes and export them as a CTF trace into <dir>.
+ *
+ ****************************************************************************/
+
+int trace_dump_ctf(FAR const char *dir);
+
+#endif
+
+#ifdef CONFIG_SYSTEM_TRACE_RECORD
+
+/****************************************************************************
+ * Name: trace_record
+ *
+ * Description:
+ *   Continuously drain the note buffer to a file (with rotation) or to a
+ *   "tcp:<addr>:<port>" or "udp:<addr>:<port>" socket, until stopped by
+ *   SIGINT/SIGTERM, the duration expires or the trigger string is seen.
+ *
+ ****************************************************************************/
+
+int trace_record(FAR const char *target,
+                 FAR const struct trace_record_s *cfg);
+
+#endif
+
 #else /* CONFIG_DRIVERS_NOTERAM */
 
 #define trace_dump(type,out)
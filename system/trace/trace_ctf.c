@@ -0,0 +1,751 @@
+/****************************************************************************
+ * apps/system/trace/trace_ctf.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+#include <nuttx/sched_note.h>
+#include <nuttx/note/noteram_driver.h>
+
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef NOTERAM_SETREADMODE
+#  error "CTF export requires the binary read mode of the note RAM driver"
+#endif
+
+/* Largest note, nc_length is a single byte */
+
+#define TRACE_CTF_NOTE_MAX    256
+
+/* Largest event: header, context and a string of TRACE_CTF_NOTE_MAX */
+
+#define TRACE_CTF_EVENT_MAX   (32 + TRACE_CTF_NOTE_MAX)
+
+#define TRACE_CTF_MAGIC       0xc1fc1fc1
+#define TRACE_CTF_COMM_LEN    16
+
+#ifdef CONFIG_SMP
+#  define TRACE_CTF_NCPUS     CONFIG_SMP_NCPUS
+#  define NOTE_CPU(n)         ((n)->nc_cpu)
+#else
+#  define TRACE_CTF_NCPUS     1
+#  define NOTE_CPU(n)         0
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* CTF event IDs, see the metadata written by trace_ctf_metadata() */
+
+enum trace_ctf_event_e
+{
+  TRACE_CTF_TASK_START = 0,
+  TRACE_CTF_TASK_STOP,
+  TRACE_CTF_SCHED_SWITCH,
+  TRACE_CTF_IRQ_ENTRY,
+  TRACE_CTF_IRQ_EXIT,
+  TRACE_CTF_SYSCALL_ENTRY,
+  TRACE_CTF_SYSCALL_EXIT,
+  TRACE_CTF_PRINT
+};
+
+/* Task name cache, notes only carry the name in NOTE_START */
+
+struct trace_ctf_task_s
+{
+  pid_t pid;
+  char  comm[TRACE_CTF_COMM_LEN];
+};
+
+/* Last task suspended on each CPU, paired with the next NOTE_RESUME to
+ * form a sched_switch event.
+ */
+
+struct trace_ctf_cpu_s
+{
+  pid_t   pid;
+  uint8_t prio;
+  uint8_t state;
+};
+
+struct trace_ctf_s
+{
+  int      fd;                               /* Stream file */
+  size_t   len;                              /* Bytes in out[] */
+  size_t   pending;                          /* Bytes in note[] */
+  uint64_t events;                           /* Events written */
+  struct trace_ctf_cpu_s  cpu[TRACE_CTF_NCPUS];
+  struct trace_ctf_task_s task[CONFIG_SYSTEM_TRACE_CTF_NTASKS];
+  union
+    {
+      struct note_common_s cmn;              /* Keeps note[] aligned */
+      uint8_t raw[TRACE_CTF_NOTE_MAX];
+    } note;
+  uint8_t  out[CONFIG_SYSTEM_TRACE_CTF_BUFSIZE];
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char g_trace_ctf_metadata[] =
+  "/* CTF 1.8 */\n"
+  "\n"
+  "typealias integer { size = 8; align = 8; signed = false; } := uint8_t;\n"
+  "typealias integer { size = 32; align = 8; signed = false; } "
+    ":= uint32_t;\n"
+  "typealias integer { size = 32; align = 8; signed = true; } := int32_t;\n"
+  "typealias integer { size = 64; align = 8; signed = true; } := int64_t;\n"
+  "typealias integer { size = 64; align = 8; signed = false; "
+    "map = clock.monotonic.value; } := uint64_clock_t;\n"
+  "typealias integer { size = 8; align = 8; signed = false; "
+    "encoding = UTF8; } := char_t;\n"
+  "\n"
+  "trace {\n"
+  "  major = 1;\n"
+  "  minor = 8;\n"
+  "  byte_order = %s;\n"
+  "  packet.header := struct { uint32_t magic; };\n"
+  "};\n"
+  "\n"
+  "env {\n"
+  "  sysname = \"NuttX\";\n"
+  "  domain = \"kernel\";\n"
+  "  tracer_name = \"nuttx-sched-note\";\n"
+  "};\n"
+  "\n"
+  "clock {\n"
+  "  name = monotonic;\n"
+  "  freq = 1000000000;\n"
+  "};\n"
+  "\n"
+  "stream {\n"
+  "  event.header := struct { uint64_clock_t timestamp; uint8_t id; };\n"
+  "  event.context := struct {\n"
+  "    uint8_t cpu_id;\n"
+  "    int32_t tid;\n"
+  "    uint8_t prio;\n"
+  "  };\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = task_start;\n"
+  "  id = 0;\n"
+  "  fields := struct { string comm; };\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = task_stop;\n"
+  "  id = 1;\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = sched_switch;\n"
+  "  id = 2;\n"
+  "  fields := struct {\n"
+  "    char_t prev_comm[16];\n"
+  "    int32_t prev_tid;\n"
+  "    uint8_t prev_prio;\n"
+  "    uint8_t prev_state;\n"
+  "    char_t next_comm[16];\n"
+  "    int32_t next_tid;\n"
+  "    uint8_t next_prio;\n"
+  "  };\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = irq_handler_entry;\n"
+  "  id = 3;\n"
+  "  fields := struct { int32_t irq; };\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = irq_handler_exit;\n"
+  "  id = 4;\n"
+  "  fields := struct { int32_t irq; };\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = syscall_entry;\n"
+  "  id = 5;\n"
+  "  fields := struct { int32_t id; };\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = syscall_exit;\n"
+  "  id = 6;\n"
+  "  fields := struct { int32_t id; int64_t ret; };\n"
+  "};\n"
+  "\n"
+  "event {\n"
+  "  name = trace_print;\n"
+  "  id = 7;\n"
+  "  fields := struct { string msg; };\n"
+  "};\n";
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trace_ctf_flush
+ ****************************************************************************/
+
+static int trace_ctf_flush(FAR struct trace_ctf_s *ctf)
+{
+  FAR const uint8_t *buf = ctf->out;
+  ssize_t ret;
+
+  while (ctf->len > 0)
+    {
+      ret = write(ctf->fd, buf, ctf->len);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          fprintf(stderr, "trace: CTF write error: %d\n", errno);
+          return ERROR;
+        }
+
+      buf += ret;
+      ctf->len -= ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trace_ctf_put
+ ****************************************************************************/
+
+static void trace_ctf_put(FAR struct trace_ctf_s *ctf,
+                          FAR const void *data, size_t len)
+{
+  memcpy(&ctf->out[ctf->len], data, len);
+  ctf->len += len;
+}
+
+/****************************************************************************
+ * Name: trace_ctf_put_u8 / trace_ctf_put_s32
+ ****************************************************************************/
+
+static void trace_ctf_put_u8(FAR struct trace_ctf_s *ctf, uint8_t val)
+{
+  ctf->out[ctf->len++] = val;
+}
+
+static void trace_ctf_put_s32(FAR struct trace_ctf_s *ctf, int32_t val)
+{
+  trace_ctf_put(ctf, &val, sizeof(val));
+}
+
+/****************************************************************************
+ * Name: trace_ctf_put_string
+ *
+ * Description:
+ *   Append a NUL terminated string of at most maxlen characters.
+ *
+ ****************************************************************************/
+
+static void trace_ctf_put_string(FAR struct trace_ctf_s *ctf,
+                                 FAR const char *str, size_t maxlen)
+{
+  size_t len = strnlen(str, maxlen);
+
+  trace_ctf_put(ctf, str, len);
+  trace_ctf_put_u8(ctf, '\0');
+}
+
+/****************************************************************************
+ * Name: trace_ctf_comm
+ ****************************************************************************/
+
+static FAR struct trace_ctf_task_s *
+trace_ctf_comm(FAR struct trace_ctf_s *ctf, pid_t pid)
+{
+  return &ctf->task[pid % CONFIG_SYSTEM_TRACE_CTF_NTASKS];
+}
+
+/****************************************************************************
+ * Name: trace_ctf_put_comm
+ *
+ * Description:
+ *   Append the fixed size task name field, "<pid>" for unknown tasks.
+ *
+ ****************************************************************************/
+
+static void trace_ctf_put_comm(FAR struct trace_ctf_s *ctf, pid_t pid)
+{
+  FAR struct trace_ctf_task_s *task = trace_ctf_comm(ctf, pid);
+  char comm[TRACE_CTF_COMM_LEN];
+
+  memset(comm, 0, sizeof(comm));
+  if (task->pid == pid && task->comm[0] != '\0')
+    {
+      strlcpy(comm, task->comm, sizeof(comm));
+    }
+  else
+    {
+      snprintf(comm, sizeof(comm), "<%d>", (int)pid);
+    }
+
+  trace_ctf_put(ctf, comm, sizeof(comm));
+}
+
+/****************************************************************************
+ * Name: trace_ctf_event
+ *
+ * Description:
+ *   Append the event header and the per-event context.
+ *
+ ****************************************************************************/
+
+static void trace_ctf_event(FAR struct trace_ctf_s *ctf,
+                            FAR struct note_common_s *note, uint8_t id)
+{
+  struct timespec ts;
+  uint64_t timestamp;
+
+  perf_convert(note->nc_systime, &ts);
+  timestamp = (uint64_t)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+
+  trace_ctf_put(ctf, &timestamp, sizeof(timestamp));
+  trace_ctf_put_u8(ctf, id);
+  trace_ctf_put_u8(ctf, NOTE_CPU(note));
+  trace_ctf_put_s32(ctf, note->nc_pid);
+  trace_ctf_put_u8(ctf, note->nc_priority);
+  ctf->events++;
+}
+
+/****************************************************************************
+ * Name: trace_ctf_note
+ *
+ * Description:
+ *   Convert one complete, aligned note into a CTF event.  Notes without a
+ *   CTF counterpart are skipped.
+ *
+ ****************************************************************************/
+
+static void trace_ctf_note(FAR struct trace_ctf_s *ctf,
+                           FAR struct note_common_s *note)
+{
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
+  FAR struct trace_ctf_cpu_s *cpu = &ctf->cpu[NOTE_CPU(note)];
+#endif
+
+  switch (note->nc_type)
+    {
+      case NOTE_START:
+        {
+          FAR struct note_start_s *nst = (FAR struct note_start_s *)note;
+          FAR struct trace_ctf_task_s *task;
+          size_t len = note->nc_length - offsetof(struct note_start_s,
+                                                  nst_name);
+
+          task = trace_ctf_comm(ctf, note->nc_pid);
+          task->pid = note->nc_pid;
+          memset(task->comm, 0, sizeof(task->comm));
+          memcpy(task->comm, nst->nst_name,
+                 len < sizeof(task->comm) - 1 ? len :
+                                                sizeof(task->comm) - 1);
+
+          trace_ctf_event(ctf, note, TRACE_CTF_TASK_START);
+          trace_ctf_put_string(ctf, task->comm, sizeof(task->comm));
+        }
+        break;
+
+      case NOTE_STOP:
+        trace_ctf_event(ctf, note, TRACE_CTF_TASK_STOP);
+        break;
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SWITCH
+      case NOTE_SUSPEND:
+        {
+          FAR struct note_suspend_s *nsu = (FAR struct note_suspend_s *)note;
+
+          cpu->pid   = note->nc_pid;
+          cpu->prio  = note->nc_priority;
+          cpu->state = nsu->nsu_state;
+        }
+        break;
+
+      case NOTE_RESUME:
+        trace_ctf_event(ctf, note, TRACE_CTF_SCHED_SWITCH);
+        trace_ctf_put_comm(ctf, cpu->pid);
+        trace_ctf_put_s32(ctf, cpu->pid);
+        trace_ctf_put_u8(ctf, cpu->prio);
+        trace_ctf_put_u8(ctf, cpu->state);
+        trace_ctf_put_comm(ctf, note->nc_pid);
+        trace_ctf_put_s32(ctf, note->nc_pid);
+        trace_ctf_put_u8(ctf, note->nc_priority);
+        break;
+#endif
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_IRQHANDLER
+      case NOTE_IRQ_ENTER:
+      case NOTE_IRQ_LEAVE:
+        {
+          FAR struct note_irqhandler_s *nih =
+            (FAR struct note_irqhandler_s *)note;
+
+          trace_ctf_event(ctf, note, note->nc_type == NOTE_IRQ_ENTER ?
+                          TRACE_CTF_IRQ_ENTRY : TRACE_CTF_IRQ_EXIT);
+          trace_ctf_put_s32(ctf, nih->nih_irq);
+        }
+        break;
+#endif
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_SYSCALL
+      case NOTE_SYSCALL_ENTER:
+        {
+          FAR struct note_syscall_enter_s *nsc =
+            (FAR struct note_syscall_enter_s *)note;
+
+          trace_ctf_event(ctf, note, TRACE_CTF_SYSCALL_ENTRY);
+          trace_ctf_put_s32(ctf, nsc->nsc_nr);
+        }
+        break;
+
+      case NOTE_SYSCALL_LEAVE:
+        {
+          FAR struct note_syscall_leave_s *nsc =
+            (FAR struct note_syscall_leave_s *)note;
+          int64_t result = (intptr_t)nsc->nsc_result;
+
+          trace_ctf_event(ctf, note, TRACE_CTF_SYSCALL_EXIT);
+          trace_ctf_put_s32(ctf, nsc->nsc_nr);
+          trace_ctf_put(ctf, &result, sizeof(result));
+        }
+        break;
+#endif
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_DUMP
+      case NOTE_DUMP_STRING:
+        {
+          FAR struct note_string_s *nst = (FAR struct note_string_s *)note;
+
+          trace_ctf_event(ctf, note, TRACE_CTF_PRINT);
+          trace_ctf_put_string(ctf, nst->nst_data, note->nc_length -
+                               offsetof(struct note_string_s, nst_data));
+        }
+        break;
+#endif
+
+      default:
+        break;
+    }
+}
+
+/****************************************************************************
+ * Name: trace_ctf_metadata
+ ****************************************************************************/
+
+static int trace_ctf_metadata(FAR const char *dir)
+{
+  static const uint16_t endian = 1;
+  char path[PATH_MAX];
+  FAR FILE *out;
+  int ret;
+
+  snprintf(path, sizeof(path), "%s/metadata", dir);
+  out = fopen(path, "w");
+  if (out == NULL)
+    {
+      fprintf(stderr, "trace: cannot open '%s'\n", path);
+      return ERROR;
+    }
+
+  ret = fprintf(out, g_trace_ctf_metadata,
+                *(FAR const uint8_t *)&endian ? "le" : "be");
+  if (fclose(out) < 0 || ret < 0)
+    {
+      fprintf(stderr, "trace: cannot write '%s'\n", path);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trace_ctf_open
+ *
+ * Description:
+ *   Create the CTF trace directory <dir> with its metadata and stream
+ *   files.
+ *
+ ****************************************************************************/
+
+FAR struct trace_ctf_s *trace_ctf_open(FAR const char *dir)
+{
+  FAR struct trace_ctf_s *ctf;
+  char path[PATH_MAX];
+  uint32_t magic = TRACE_CTF_MAGIC;
+
+  if (mkdir(dir, 0777) < 0 && errno != EEXIST)
+    {
+      fprintf(stderr, "trace: cannot create '%s'\n", dir);
+      return NULL;
+    }
+
+  if (trace_ctf_metadata(dir) < 0)
+    {
+      return NULL;
+    }
+
+  ctf = zalloc(sizeof(*ctf));
+  if (ctf == NULL)
+    {
+      fprintf(stderr, "trace: out of memory\n");
+      return NULL;
+    }
+
+  snprintf(path, sizeof(path), "%s/stream_0", dir);
+  ctf->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (ctf->fd < 0)
+    {
+      fprintf(stderr, "trace: cannot open '%s'\n", path);
+      free(ctf);
+      return NULL;
+    }
+
+  /* The whole stream file is a single packet */
+
+  trace_ctf_put(ctf, &magic, sizeof(magic));
+  return ctf;
+}
+
+/****************************************************************************
+ * Name: trace_ctf_write
+ *
+ * Description:
+ *   Convert a chunk of binary notes read from the note driver.  A note
+ *   split across two chunks is completed on the next call.
+ *
+ ****************************************************************************/
+
+int trace_ctf_write(FAR struct trace_ctf_s *ctf,
+                    FAR const uint8_t *buf, size_t len)
+{
+  size_t total;
+  size_t need;
+
+  while (len > 0)
+    {
+      /* The first byte of every note is its length */
+
+      if (ctf->pending == 0 && buf[0] < sizeof(struct note_common_s))
+        {
+          fprintf(stderr, "trace: corrupted note, length %u\n", buf[0]);
+          return ERROR;
+        }
+
+      total = ctf->pending ? ctf->note.cmn.nc_length : buf[0];
+      need  = total - ctf->pending;
+      if (need > len)
+        {
+          need = len;
+        }
+
+      /* Copy the note to the aligned buffer, completing it with the next
+       * chunk if it is split.
+       */
+
+      memcpy(&ctf->note.raw[ctf->pending], buf, need);
+      ctf->pending += need;
+      buf += need;
+      len -= need;
+
+      if (ctf->pending < total)
+        {
+          break;
+        }
+
+      if (ctf->len + TRACE_CTF_EVENT_MAX > sizeof(ctf->out) &&
+          trace_ctf_flush(ctf) < 0)
+        {
+          return ERROR;
+        }
+
+      trace_ctf_note(ctf, &ctf->note.cmn);
+      ctf->pending = 0;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trace_ctf_close
+ *
+ * Description:
+ *   Flush the remaining events, close the stream and free the context.
+ *   Returns the number of events written or a negated errno value.
+ *
+ ****************************************************************************/
+
+int trace_ctf_close(FAR struct trace_ctf_s *ctf)
+{
+  int ret;
+
+  ret = trace_ctf_flush(ctf);
+  if (close(ctf->fd) < 0)
+    {
+      ret = ERROR;
+    }
+
+  if (ret >= 0)
+    {
+      ret = ctf->events > INT_MAX ? INT_MAX : (int)ctf->events;
+    }
+
+  free(ctf);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: trace_ctf_readmode
+ *
+ * Description:
+ *   Switch the note driver to binary reads, returning the previous mode
+ *   for restoring it with trace_ctf_restore().
+ *
+ ****************************************************************************/
+
+unsigned int trace_ctf_readmode(int fd)
+{
+  unsigned int oldmode = NOTERAM_MODE_READ_ASCII;
+  unsigned int mode = NOTERAM_MODE_READ_BINARY;
+
+  ioctl(fd, NOTERAM_GETREADMODE, (unsigned long)&oldmode);
+  ioctl(fd, NOTERAM_SETREADMODE, (unsigned long)&mode);
+  return oldmode;
+}
+
+void trace_ctf_restore(int fd, unsigned int mode)
+{
+  ioctl(fd, NOTERAM_SETREADMODE, (unsigned long)&mode);
+}
+
+/****************************************************************************
+ * Name: trace_dump_ctf
+ *
+ * Description:
+ *   Read all notes and export them as a CTF trace into <dir>.
+ *
+ ****************************************************************************/
+
+int trace_dump_ctf(FAR const char *dir)
+{
+  FAR struct trace_ctf_s *ctf;
+  FAR uint8_t *buf;
+  unsigned int mode;
+  ssize_t nread;
+  int ret = ERROR;
+  int fd;
+
+  buf = malloc(CONFIG_SYSTEM_TRACE_CTF_BUFSIZE);
+  if (buf == NULL)
+    {
+      fprintf(stderr, "trace: out of memory\n");
+      return ERROR;
+    }
+
+  fd = open("/dev/note/ram", O_RDONLY);
+  if (fd < 0)
+    {
+      fprintf(stderr, "trace: cannot open /dev/note/ram\n");
+      goto errout_with_buf;
+    }
+
+  ctf = trace_ctf_open(dir);
+  if (ctf == NULL)
+    {
+      goto errout_with_fd;
+    }
+
+  mode = trace_ctf_readmode(fd);
+
+  while ((nread = read(fd, buf, CONFIG_SYSTEM_TRACE_CTF_BUFSIZE)) != 0)
+    {
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          fprintf(stderr, "trace: read error: %d\n", errno);
+          break;
+        }
+
+      if (trace_ctf_write(ctf, buf, nread) < 0)
+        {
+          break;
+        }
+    }
+
+  trace_ctf_restore(fd, mode);
+
+  ret = trace_ctf_close(ctf);
+  if (ret >= 0 && nread == 0)
+    {
+      printf("trace: %d events exported to '%s'\n", ret, dir);
+    }
+  else
+    {
+      ret = ERROR;
+    }
+
+errout_with_fd:
+  close(fd);
+
+errout_with_buf:
+  free(buf);
+  return ret < 0 ? ERROR : OK;
+}
@@ -0,0 +1,542 @@
+/****************************************************************************
+ * apps/system/trace/trace_record.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <nuttx/note/noteram_driver.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Largest UDP datagram sent, kept below a typical Ethernet MTU */
+
+#define TRACE_RECORD_UDP_MAX  1400
+
+/* Every output (file or stream) starts with the "trace dump" header */
+
+#define TRACE_RECORD_HEADER   "# tracer: nop\n#\n"
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct trace_record_out_s
+{
+  FAR const char *target;   /* File name or socket address */
+  int             fd;       /* Output file or socket */
+  bool            udp;      /* Output is a UDP socket */
+  bool            file;     /* Output is a (rotated) file */
+  size_t          written;  /* Bytes written to the current file */
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  FAR struct trace_ctf_s *ctf; /* CTF output, binary notes are read */
+#endif
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile bool g_trace_record_stop;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trace_record_sighandler
+ ****************************************************************************/
+
+static void trace_record_sighandler(int signo)
+{
+  g_trace_record_stop = true;
+}
+
+/****************************************************************************
+ * Name: trace_record_connect
+ *
+ * Description:
+ *   Connect to a "tcp:<ipv4 addr>:<port>" or "udp:<ipv4 addr>:<port>"
+ *   target.
+ *
+ ****************************************************************************/
+
+static int trace_record_connect(FAR struct trace_record_out_s *out)
+{
+  struct sockaddr_in addr;
+  char host[INET_ADDRSTRLEN];
+  FAR const char *port;
+  size_t len;
+
+  out->udp = strncmp(out->target, "udp:", 4) == 0;
+
+  port = strrchr(out->target + 4, ':');
+  len = port ? port - (out->target + 4) : 0;
+  if (len == 0 || len >= sizeof(host))
+    {
+      fprintf(stderr, "trace record: invalid address '%s'\n", out->target);
+      return ERROR;
+    }
+
+  memcpy(host, out->target + 4, len);
+  host[len] = '\0';
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_port   = htons(atoi(port + 1));
+  if (inet_pton(AF_INET, host, &addr.sin_addr) != 1)
+    {
+      fprintf(stderr, "trace record: invalid address '%s'\n", out->target);
+      return ERROR;
+    }
+
+  out->fd = socket(AF_INET, out->udp ? SOCK_DGRAM : SOCK_STREAM, 0);
+  if (out->fd < 0)
+    {
+      fprintf(stderr, "trace record: socket failed: %d\n", errno);
+      return ERROR;
+    }
+
+  if (connect(out->fd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+      fprintf(stderr, "trace record: cannot connect to '%s': %d\n",
+              out->target, errno);
+      close(out->fd);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trace_record_rotate
+ *
+ * Description:
+ *   Shift <file>.<n-1> to <file>.<n>, ..., <file> to <file>.1 and open a
+ *   new <file>.  The oldest file falls off the end.  Each file starts
+ *   with its own header, so every file can be loaded on its own.
+ *
+ ****************************************************************************/
+
+static int trace_record_rotate(FAR struct trace_record_out_s *out,
+                               int nfiles)
+{
+  char from[PATH_MAX];
+  char to[PATH_MAX];
+  int i;
+
+  if (out->fd >= 0)
+    {
+      close(out->fd);
+
+      for (i = nfiles - 1; i > 0; i--)
+        {
+          if (i > 1)
+            {
+              snprintf(from, sizeof(from), "%s.%d", out->target, i - 1);
+            }
+          else
+            {
+              strlcpy(from, out->target, sizeof(from));
+            }
+
+          snprintf(to, sizeof(to), "%s.%d", out->target, i);
+          rename(from, to);
+        }
+    }
+
+  out->fd = open(out->target, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (out->fd < 0)
+    {
+      fprintf(stderr, "trace record: cannot open '%s'\n", out->target);
+      return ERROR;
+    }
+
+  out->written = 0;
+  if (write(out->fd, TRACE_RECORD_HEADER,
+            sizeof(TRACE_RECORD_HEADER) - 1) < 0)
+    {
+      fprintf(stderr, "trace record: write error: %d\n", errno);
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trace_record_write
+ ****************************************************************************/
+
+static int trace_record_write(FAR struct trace_record_out_s *out,
+                              FAR const struct trace_record_s *cfg,
+                              FAR const uint8_t *buf, size_t len)
+{
+  ssize_t ret;
+  size_t chunk;
+
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  if (out->ctf != NULL)
+    {
+      out->written += len;
+      return trace_ctf_write(out->ctf, buf, len);
+    }
+#endif
+
+  if (out->file && cfg->filesize > 0 && out->written >= cfg->filesize &&
+      trace_record_rotate(out, cfg->nfiles) < 0)
+    {
+      return ERROR;
+    }
+
+  while (len > 0)
+    {
+      chunk = len;
+      if (out->udp && chunk > TRACE_RECORD_UDP_MAX)
+        {
+          chunk = TRACE_RECORD_UDP_MAX;
+        }
+
+      ret = write(out->fd, buf, chunk);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          fprintf(stderr, "trace record: write error: %d\n", errno);
+          return ERROR;
+        }
+
+      out->written += ret;
+      buf += ret;
+      len -= ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: trace_record_overflow
+ *
+ * Description:
+ *   Check whether the note buffer overflowed since the last call.  While
+ *   recording the buffer runs with overwrite disabled, so a full buffer
+ *   drops new notes and switches to the overflow mode instead of silently
+ *   overwriting notes that are not drained yet.  Re-arm it and report the
+ *   event.
+ *
+ ****************************************************************************/
+
+static bool trace_record_overflow(int fd)
+{
+  unsigned int mode = NOTERAM_MODE_OVERWRITE_DISABLE;
+
+  ioctl(fd, NOTERAM_GETMODE, (unsigned long)&mode);
+  if (mode != NOTERAM_MODE_OVERWRITE_OVERFLOW)
+    {
+      return false;
+    }
+
+  mode = NOTERAM_MODE_OVERWRITE_DISABLE;
+  ioctl(fd, NOTERAM_SETMODE, (unsigned long)&mode);
+  return true;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: trace_record
+ *
+ * Description:
+ *   Continuously drain the note buffer to a file or socket until stopped
+ *   by a signal, the duration expires or the trigger string is seen.
+ *
+ ****************************************************************************/
+
+int trace_record(FAR const char *target,
+                 FAR const struct trace_record_s *cfg)
+{
+  struct trace_record_out_s out;
+  struct timespec start;
+  struct timespec now;
+  FAR uint8_t *buf;
+  FAR uint8_t *data;
+  unsigned long overflows = 0;
+  unsigned long long total = 0;
+  unsigned int oldmode;
+  unsigned int mode;
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  unsigned int readmode = 0;
+#endif
+  size_t post = 0;
+  size_t keep = 0;
+  size_t room;
+  bool triggered = false;
+  bool enabled;
+  ssize_t nread;
+  int ret = ERROR;
+  int fd;
+
+  memset(&out, 0, sizeof(out));
+  out.target = target;
+  out.fd     = -1;
+
+  /* Keep the last strlen(trigger) - 1 bytes of each chunk in front of the
+   * buffer, so a trigger split across two reads is still found.
+   */
+
+  room = cfg->trigger ? strlen(cfg->trigger) - 1 : 0;
+  buf = malloc(room + CONFIG_SYSTEM_TRACE_RECORD_BUFSIZE);
+  if (buf == NULL)
+    {
+      fprintf(stderr, "trace record: out of memory\n");
+      return ERROR;
+    }
+
+  data = buf + room;
+
+  fd = open("/dev/note/ram", O_RDONLY);
+  if (fd < 0)
+    {
+      fprintf(stderr, "trace: cannot open /dev/note/ram\n");
+      goto errout_with_buf;
+    }
+
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  if (cfg->ctf)
+    {
+      /* <target> is the CTF trace directory, the notes are converted
+       * while they are drained.
+       */
+
+      out.ctf = trace_ctf_open(target);
+      if (out.ctf == NULL)
+        {
+          goto errout_with_fd;
+        }
+
+      readmode = trace_ctf_readmode(fd);
+      ret = OK;
+    }
+  else
+#endif
+  if (strncmp(target, "tcp:", 4) == 0 || strncmp(target, "udp:", 4) == 0)
+    {
+      ret = trace_record_connect(&out);
+      if (ret >= 0)
+        {
+          ret = trace_record_write(&out, cfg,
+                                   (FAR const uint8_t *)TRACE_RECORD_HEADER,
+                                   sizeof(TRACE_RECORD_HEADER) - 1);
+          if (ret < 0)
+            {
+              goto errout_with_out;
+            }
+        }
+    }
+  else
+    {
+      out.file = true;
+      ret = trace_record_rotate(&out, 0);
+    }
+
+  if (ret < 0)
+    {
+      goto errout_with_fd;
+    }
+
+  /* Disable overwriting, so that overflows become visible */
+
+  oldmode = NOTERAM_MODE_OVERWRITE_DISABLE;
+  ioctl(fd, NOTERAM_GETMODE, (unsigned long)&oldmode);
+  mode = NOTERAM_MODE_OVERWRITE_DISABLE;
+  ioctl(fd, NOTERAM_SETMODE, (unsigned long)&mode);
+
+  g_trace_record_stop = false;
+  signal(SIGINT, trace_record_sighandler);
+  signal(SIGTERM, trace_record_sighandler);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  while (!g_trace_record_stop)
+    {
+      if (cfg->duration > 0)
+        {
+          clock_gettime(CLOCK_MONOTONIC, &now);
+          if (now.tv_sec - start.tv_sec >= cfg->duration)
+            {
+              break;
+            }
+        }
+
+      nread = read(fd, data, CONFIG_SYSTEM_TRACE_RECORD_BUFSIZE);
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          fprintf(stderr, "trace record: read error: %d\n", errno);
+          ret = ERROR;
+          break;
+        }
+
+      if (trace_record_overflow(fd))
+        {
+          overflows++;
+        }
+
+      if (nread == 0)
+        {
+          /* Buffer drained, give it time to fill up again */
+
+          usleep(CONFIG_SYSTEM_TRACE_RECORD_INTERVAL * 1000);
+          continue;
+        }
+
+      ret = trace_record_write(&out, cfg, data, nread);
+      if (ret < 0)
+        {
+          break;
+        }
+
+      total += nread;
+
+      if (triggered)
+        {
+          post += nread;
+          if (post >= cfg->posttrigger)
+            {
+              break;
+            }
+        }
+      else if (cfg->trigger != NULL &&
+               memmem(data - keep, keep + nread, cfg->trigger,
+                      room + 1) != NULL)
+        {
+          fprintf(stderr, "trace record: trigger '%s' found\n",
+                  cfg->trigger);
+          triggered = true;
+          if (cfg->posttrigger == 0)
+            {
+              break;
+            }
+        }
+      else if (room > 0)
+        {
+          keep = (size_t)nread < room ? (size_t)nread : room;
+          memmove(data - keep, data + nread - keep, keep);
+        }
+    }
+
+  signal(SIGINT, SIG_DFL);
+  signal(SIGTERM, SIG_DFL);
+
+  /* Drain what was buffered when the stop condition hit.  Note collection
+   * is stopped first, otherwise writing the output keeps producing notes
+   * and the buffer never runs empty.
+   */
+
+  if (ret >= 0)
+    {
+      enabled = notectl_enable(cfg->name, false, cfg->notectlfd);
+
+      while (!(triggered && post >= cfg->posttrigger) &&
+             (nread = read(fd, data,
+                           CONFIG_SYSTEM_TRACE_RECORD_BUFSIZE)) > 0)
+        {
+          if (trace_record_write(&out, cfg, data, nread) < 0)
+            {
+              ret = ERROR;
+              break;
+            }
+
+          total += nread;
+          if (triggered)
+            {
+              post += nread;
+            }
+        }
+
+      if (trace_record_overflow(fd))
+        {
+          overflows++;
+        }
+
+      if (enabled)
+        {
+          notectl_enable(cfg->name, true, cfg->notectlfd);
+        }
+    }
+  ioctl(fd, NOTERAM_SETMODE, (unsigned long)&oldmode);
+
+  fprintf(stderr, "trace record: %llu bytes, %lu overflow%s%s\n",
+          total, overflows, overflows == 1 ? "" : "s",
+          overflows ? " (notes were dropped)" : "");
+
+errout_with_out:
+#ifdef CONFIG_SYSTEM_TRACE_CTF
+  if (out.ctf != NULL)
+    {
+      trace_ctf_restore(fd, readmode);
+      if (trace_ctf_close(out.ctf) < 0)
+        {
+          ret = ERROR;
+        }
+    }
+  else
+#endif
+    {
+      close(out.fd);
+    }
+
+errout_with_fd:
+  close(fd);
+
+errout_with_buf:
+  free(buf);
+  return ret < 0 ? ERROR : OK;
+}
@@ -0,0 +1,69 @@
+/****************************************************************************
+ * apps/testing/fs/fstest/fstest.h
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_TESTING_FS_FSTEST_FSTEST_H
+#define __APPS_TESTING_FS_FSTEST_FSTEST_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stddef.h>
+
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+struct fstest_bench_s
+{
+  FAR const char *mountdir;   /* Mount point, with trailing '/' */
+  FAR const char *label;      /* File system name for the CSV rows */
+  FAR const char *bsizes;     /* Comma separated I/O block sizes */
+  size_t filesize;            /* Size of the bandwidth test file */
+  int nfiles;                 /* Number of files for metadata tests */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fstest_bench
+ *
+ * Description:
+ *   Measure sequential and random read/write bandwidth for each block
+ *   size, then create/open/stat/unlink rates and the directory listing
+ *   time for bench->nfiles files.  Results are printed as CSV.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int fstest_bench(FAR const struct fstest_bench_s *bench);
+
+#endif /* CONFIG_TESTING_FSTEST_BENCH */
+#endif /* __APPS_TESTING_FS_FSTEST_FSTEST_H */
@@ -0,0 +1,658 @@
+/****************************************************************************
+ * apps/testing/fs/fstest/fstest_bench.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/stat.h>
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "fstest.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FSTEST_BENCH_DIR      "fstbench"
+#define FSTEST_BENCH_FILE     "bench.dat"
+#define FSTEST_BENCH_MAXBSIZE 8
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct fstest_benchctx_s
+{
+  FAR const struct fstest_bench_s *bench;
+  FAR uint8_t *buffer;
+  bool subdir;                /* dir is our own directory, not the mount */
+  char dir[PATH_MAX];         /* Where the test files go, with trailing '/' */
+  char path[PATH_MAX + 16];   /* dir plus a file name */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fstest_bench_now
+ ****************************************************************************/
+
+static uint64_t fstest_bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/****************************************************************************
+ * Name: fstest_bench_name
+ ****************************************************************************/
+
+static void fstest_bench_name(FAR struct fstest_benchctx_s *ctx, int i)
+{
+  snprintf(ctx->path, sizeof(ctx->path), "%sf%05d", ctx->dir, i);
+}
+
+/****************************************************************************
+ * Name: fstest_bench_isours
+ *
+ * Description:
+ *   Return true if a directory entry is one of the metadata test files.
+ *   Without a directory of our own the mount root may hold other files.
+ *
+ ****************************************************************************/
+
+static bool fstest_bench_isours(FAR const char *name)
+{
+  int i;
+
+  if (name[0] != 'f' || strlen(name) != 6)
+    {
+      return false;
+    }
+
+  for (i = 1; i < 6; i++)
+    {
+      if (!isdigit((unsigned char)name[i]))
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: fstest_bench_report
+ *
+ * Description:
+ *   Print one CSV row: fs,test,bsize,ops,bytes,usec,kib_per_sec,ops_per_sec
+ *
+ ****************************************************************************/
+
+static void fstest_bench_report(FAR struct fstest_benchctx_s *ctx,
+                                FAR const char *test, size_t bsize,
+                                unsigned long ops, uint64_t bytes,
+                                uint64_t usec)
+{
+  if (usec == 0)
+    {
+      usec = 1;
+    }
+
+  printf("%s,%s,%zu,%lu,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+         ctx->bench->label, test, bsize, ops, bytes, usec,
+         bytes * 1000000 / 1024 / usec, (uint64_t)ops * 1000000 / usec);
+}
+
+/****************************************************************************
+ * Name: fstest_bench_skipped
+ *
+ * Description:
+ *   Print a CSV row for a test the file system does not support.
+ *
+ ****************************************************************************/
+
+static void fstest_bench_skipped(FAR struct fstest_benchctx_s *ctx,
+                                 FAR const char *test, size_t bsize,
+                                 int errcode)
+{
+  printf("%s,%s,%zu,skipped,%d\n", ctx->bench->label, test, bsize,
+         errcode);
+}
+
+/****************************************************************************
+ * Name: fstest_bench_write / fstest_bench_read
+ *
+ * Description:
+ *   Transfer exactly len bytes, retrying short transfers.
+ *
+ ****************************************************************************/
+
+static int fstest_bench_write(int fd, FAR const uint8_t *buf, size_t len)
+{
+  ssize_t nwritten;
+
+  while (len > 0)
+    {
+      nwritten = write(fd, buf, len);
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+      else if (nwritten == 0)
+        {
+          return -ENOSPC;
+        }
+
+      buf += nwritten;
+      len -= nwritten;
+    }
+
+  return OK;
+}
+
+static int fstest_bench_read(int fd, FAR uint8_t *buf, size_t len)
+{
+  ssize_t nread;
+
+  while (len > 0)
+    {
+      nread = read(fd, buf, len);
+      if (nread < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+      else if (nread == 0)
+        {
+          return -ENODATA;
+        }
+
+      buf += nread;
+      len -= nread;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fstest_bench_seq
+ *
+ * Description:
+ *   Write (and fsync) or read the whole test file sequentially in bsize
+ *   chunks.  The open and close are part of the measurement so that
+ *   file systems which flush on close are not flattered.
+ *
+ ****************************************************************************/
+
+static int fstest_bench_seq(FAR struct fstest_benchctx_s *ctx,
+                            size_t bsize, bool wr)
+{
+  size_t filesize = ctx->bench->filesize;
+  unsigned long nblocks = filesize / bsize;
+  unsigned long i;
+  uint64_t start;
+  int ret = OK;
+  int fd;
+
+  start = fstest_bench_now();
+  fd = wr ? open(ctx->path, O_WRONLY | O_CREAT | O_TRUNC, 0666) :
+            open(ctx->path, O_RDONLY);
+  if (fd < 0)
+    {
+      printf("ERROR: Failed to open %s: %d\n", ctx->path, errno);
+      return -errno;
+    }
+
+  for (i = 0; i < nblocks && ret >= 0; i++)
+    {
+      ret = wr ? fstest_bench_write(fd, ctx->buffer, bsize) :
+                 fstest_bench_read(fd, ctx->buffer, bsize);
+    }
+
+  if (wr && ret >= 0 && fsync(fd) < 0)
+    {
+      ret = -errno;
+    }
+
+  close(fd);
+
+  if (ret < 0)
+    {
+      printf("ERROR: Sequential %s of %s failed: %d\n",
+             wr ? "write" : "read", ctx->path, ret);
+      return ret;
+    }
+
+  fstest_bench_report(ctx, wr ? "seq_write" : "seq_read", bsize,
+                      nblocks, (uint64_t)nblocks * bsize,
+                      fstest_bench_now() - start);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fstest_bench_rand
+ *
+ * Description:
+ *   Transfer filesize / bsize blocks at random block-aligned offsets
+ *   inside the file written by the sequential test.  Some file systems
+ *   (NXFFS) only write files sequentially from the start; the write test
+ *   is reported as skipped when the open or a seek is refused.
+ *
+ ****************************************************************************/
+
+static int fstest_bench_rand(FAR struct fstest_benchctx_s *ctx,
+                             size_t bsize, bool wr)
+{
+  size_t filesize = ctx->bench->filesize;
+  unsigned long nblocks = filesize / bsize;
+  unsigned long i;
+  uint64_t start;
+  off_t offset;
+  int ret = OK;
+  int fd;
+
+  fd = open(ctx->path, wr ? O_WRONLY : O_RDONLY);
+  if (fd < 0)
+    {
+      if (wr)
+        {
+          fstest_bench_skipped(ctx, "rand_write", bsize, errno);
+          return OK;
+        }
+
+      printf("ERROR: Failed to open %s: %d\n", ctx->path, errno);
+      return -errno;
+    }
+
+  start = fstest_bench_now();
+  for (i = 0; i < nblocks && ret >= 0; i++)
+    {
+      offset = (off_t)(rand() % nblocks) * bsize;
+      if (lseek(fd, offset, SEEK_SET) != offset)
+        {
+          ret = -errno;
+          if (wr)
+            {
+              close(fd);
+              fstest_bench_skipped(ctx, "rand_write", bsize, -ret);
+              return OK;
+            }
+
+          break;
+        }
+
+      ret = wr ? fstest_bench_write(fd, ctx->buffer, bsize) :
+                 fstest_bench_read(fd, ctx->buffer, bsize);
+    }
+
+  if (wr && ret >= 0 && fsync(fd) < 0)
+    {
+      ret = -errno;
+    }
+
+  close(fd);
+
+  if (ret < 0)
+    {
+      printf("ERROR: Random %s of %s failed: %d\n",
+             wr ? "write" : "read", ctx->path, ret);
+      return ret;
+    }
+
+  fstest_bench_report(ctx, wr ? "rand_write" : "rand_read", bsize,
+                      nblocks, (uint64_t)nblocks * bsize,
+                      fstest_bench_now() - start);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: fstest_bench_bandwidth
+ *
+ * Description:
+ *   Run the four bandwidth tests for one block size.  Only a failed
+ *   sequential write stops the others, as they need the file it leaves.
+ *   The first error is returned.
+ *
+ ****************************************************************************/
+
+static int fstest_bench_bandwidth(FAR struct fstest_benchctx_s *ctx,
+                                  size_t bsize)
+{
+  int ret;
+  int tmp;
+
+  if (bsize == 0 || bsize > ctx->bench->filesize)
+    {
+      printf("Skipping block size %zu\n", bsize);
+      return OK;
+    }
+
+  snprintf(ctx->path, sizeof(ctx->path), "%s" FSTEST_BENCH_FILE, ctx->dir);
+
+  ret = fstest_bench_seq(ctx, bsize, true);
+  if (ret >= 0)
+    {
+      ret = fstest_bench_seq(ctx, bsize, false);
+
+      tmp = fstest_bench_rand(ctx, bsize, true);
+      if (ret >= 0)
+        {
+          ret = tmp;
+        }
+
+      tmp = fstest_bench_rand(ctx, bsize, false);
+      if (ret >= 0)
+        {
+          ret = tmp;
+        }
+    }
+
+  unlink(ctx->path);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: fstest_bench_metadata
+ *
+ * Description:
+ *   Create nfiles empty files in the benchmark directory, then time
+ *   open/close, stat, a full directory listing and unlink over them.
+ *
+ ****************************************************************************/
+
+static int fstest_bench_metadata(FAR struct fstest_benchctx_s *ctx)
+{
+  FAR struct dirent *entry;
+  struct stat st;
+  uint64_t start;
+  FAR DIR *dirp;
+  int nfiles = ctx->bench->nfiles;
+  int ret = OK;
+  int fd;
+  int i;
+
+  /* Create */
+
+  start = fstest_bench_now();
+  for (i = 0; i < nfiles; i++)
+    {
+      fstest_bench_name(ctx, i);
+      fd = open(ctx->path, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if (fd < 0)
+        {
+          printf("ERROR: Failed to create %s: %d\n", ctx->path, errno);
+          nfiles = i;
+          ret = -errno;
+          goto out;
+        }
+
+      close(fd);
+    }
+
+  fstest_bench_report(ctx, "create", 0, nfiles, 0,
+                      fstest_bench_now() - start);
+
+  /* Open */
+
+  start = fstest_bench_now();
+  for (i = 0; i < nfiles; i++)
+    {
+      fstest_bench_name(ctx, i);
+      fd = open(ctx->path, O_RDONLY);
+      if (fd < 0)
+        {
+          printf("ERROR: Failed to open %s: %d\n", ctx->path, errno);
+          ret = -errno;
+          goto out;
+        }
+
+      close(fd);
+    }
+
+  fstest_bench_report(ctx, "open", 0, nfiles, 0,
+                      fstest_bench_now() - start);
+
+  /* Stat */
+
+  start = fstest_bench_now();
+  for (i = 0; i < nfiles; i++)
+    {
+      fstest_bench_name(ctx, i);
+      if (stat(ctx->path, &st) < 0)
+        {
+          printf("ERROR: Failed to stat %s: %d\n", ctx->path, errno);
+          ret = -errno;
+          goto out;
+        }
+    }
+
+  fstest_bench_report(ctx, "stat", 0, nfiles, 0,
+                      fstest_bench_now() - start);
+
+  /* Directory listing */
+
+  start = fstest_bench_now();
+  dirp = opendir(ctx->dir);
+  if (dirp == NULL)
+    {
+      printf("ERROR: Failed to open directory %s: %d\n", ctx->dir, errno);
+      ret = -errno;
+      goto out;
+    }
+
+  i = 0;
+  while ((entry = readdir(dirp)) != NULL)
+    {
+      if (fstest_bench_isours(entry->d_name))
+        {
+          i++;
+        }
+    }
+
+  closedir(dirp);
+  fstest_bench_report(ctx, "readdir", 0, i, 0,
+                      fstest_bench_now() - start);
+
+  if (i != nfiles)
+    {
+      printf("ERROR: Listed %d entries, expected %d\n", i, nfiles);
+      ret = -EIO;
+    }
+
+out:
+
+  /* Unlink, timed only when everything before succeeded */
+
+  start = fstest_bench_now();
+  for (i = 0; i < nfiles; i++)
+    {
+      fstest_bench_name(ctx, i);
+      if (unlink(ctx->path) < 0 && ret >= 0)
+        {
+          printf("ERROR: Failed to unlink %s: %d\n", ctx->path, errno);
+          ret = -errno;
+        }
+    }
+
+  if (ret >= 0)
+    {
+      fstest_bench_report(ctx, "unlink", 0, nfiles, 0,
+                          fstest_bench_now() - start);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: fstest_bench
+ ****************************************************************************/
+
+int fstest_bench(FAR const struct fstest_bench_s *bench)
+{
+  FAR struct fstest_benchctx_s *ctx;
+  size_t bsizes[FSTEST_BENCH_MAXBSIZE];
+  size_t maxbsize = 0;
+  FAR const char *str;
+  FAR char *end;
+  size_t len;
+  size_t j;
+  int nbsizes = 0;
+  int ret = OK;
+  int tmp;
+  int i;
+
+  /* Parse the block size list */
+
+  for (str = bench->bsizes; *str != '\0' && nbsizes < FSTEST_BENCH_MAXBSIZE;
+       str = end + (*end == ',' ? 1 : 0))
+    {
+      bsizes[nbsizes] = strtoul(str, &end, 0);
+      if (end == str || (*end != ',' && *end != '\0'))
+        {
+          printf("ERROR: Bad block size list '%s'\n", bench->bsizes);
+          return -EINVAL;
+        }
+
+      if (bsizes[nbsizes] > maxbsize)
+        {
+          maxbsize = bsizes[nbsizes];
+        }
+
+      nbsizes++;
+    }
+
+  ctx = calloc(1, sizeof(struct fstest_benchctx_s));
+  if (ctx == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  ctx->bench = bench;
+  if (maxbsize > 0)
+    {
+      ctx->buffer = malloc(maxbsize);
+      if (ctx->buffer == NULL)
+        {
+          printf("ERROR: Failed to allocate %zu byte buffer\n", maxbsize);
+          free(ctx);
+          return -ENOMEM;
+        }
+
+      /* Random content, so compressing file systems are not flattered */
+
+      for (j = 0; j < maxbsize; j++)
+        {
+          ctx->buffer[j] = rand();
+        }
+    }
+
+  /* File systems without directories (NXFFS) get the files in the mount
+   * root instead.
+   */
+
+  snprintf(ctx->dir, sizeof(ctx->dir), "%s" FSTEST_BENCH_DIR,
+           bench->mountdir);
+  if (mkdir(ctx->dir, 0777) >= 0 || errno == EEXIST)
+    {
+      ctx->subdir = true;
+      len = strlen(ctx->dir);
+      snprintf(&ctx->dir[len], sizeof(ctx->dir) - len, "/");
+    }
+  else if (errno == ENOSYS || errno == EPERM)
+    {
+      strlcpy(ctx->dir, bench->mountdir, sizeof(ctx->dir));
+    }
+  else
+    {
+      printf("ERROR: Failed to create %s: %d\n", ctx->dir, errno);
+      ret = -errno;
+      goto errout;
+    }
+
+  printf("fs,test,bsize,ops,bytes,usec,kib_per_sec,ops_per_sec\n");
+
+  /* Keep going after a failure so that one unsupported operation does not
+   * hide the remaining results.  The first error is returned.
+   */
+
+  for (i = 0; i < nbsizes; i++)
+    {
+      tmp = fstest_bench_bandwidth(ctx, bsizes[i]);
+      if (ret >= 0)
+        {
+          ret = tmp;
+        }
+    }
+
+  if (bench->nfiles > 0)
+    {
+      tmp = fstest_bench_metadata(ctx);
+      if (ret >= 0)
+        {
+          ret = tmp;
+        }
+    }
+
+  if (ctx->subdir)
+    {
+      ctx->dir[strlen(ctx->dir) - 1] = '\0';
+      rmdir(ctx->dir);
+    }
+
+errout:
+  free(ctx->buffer);
+  free(ctx);
+  return ret;
+}
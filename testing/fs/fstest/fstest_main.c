@@ -49,6 +49,8 @@
 #include <nuttx/compiler.h>
 #include <nuttx/crc32.h>
 
+#include "fstest.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -59,6 +61,12 @@
 #  define CONFIG_TESTING_FSTEST_VERBOSE 0
 #endif
 
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+#  define FSTEST_OPTSTRING ":m:hn:o:s:bB:F:N:L:"
+#else
+#  define FSTEST_OPTSTRING ":m:hn:o:s:"
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -959,6 +967,16 @@ static void show_useage(void)
          CONFIG_TESTING_FSTEST_MAXOPEN);
   printf("-s    size of every file e.g. [%d]\n",
          CONFIG_TESTING_FSTEST_MAXFILE);
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+  printf("-b    run the benchmark instead of the stress test\n");
+  printf("-B    benchmark block sizes e.g. [%s]\n",
+         CONFIG_TESTING_FSTEST_BENCH_BSIZES);
+  printf("-F    benchmark file size e.g. [%d]\n",
+         CONFIG_TESTING_FSTEST_BENCH_FILESIZE);
+  printf("-N    benchmark metadata file count e.g. [%d]\n",
+         CONFIG_TESTING_FSTEST_BENCH_NFILES);
+  printf("-L    file system label in the CSV output e.g. [fat]\n");
+#endif
 }
 
 /****************************************************************************
@@ -977,6 +995,10 @@ int main(int argc, FAR char *argv[])
   int ret;
   int loop_num;
   int option;
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+  struct fstest_bench_s bench;
+  bool benchmark = false;
+#endif
 
   tests_ok = tests_err = 0;
 
@@ -998,9 +1020,16 @@ int main(int argc, FAR char *argv[])
   strlcpy(ctx->mountdir, CONFIG_TESTING_FSTEST_MOUNTPT,
           sizeof(ctx->mountdir));
 
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+  memset(&bench, 0, sizeof(bench));
+  bench.bsizes = CONFIG_TESTING_FSTEST_BENCH_BSIZES;
+  bench.filesize = CONFIG_TESTING_FSTEST_BENCH_FILESIZE;
+  bench.nfiles = CONFIG_TESTING_FSTEST_BENCH_NFILES;
+#endif
+
   /* Opt Parse */
 
-  while ((option = getopt(argc, argv, ":m:hn:o:s:")) != -1)
+  while ((option = getopt(argc, argv, FSTEST_OPTSTRING)) != -1)
     {
       switch (option)
         {
@@ -1020,6 +1049,23 @@ int main(int argc, FAR char *argv[])
           case 's':
             ctx->max_file = atoi(optarg);
             break;
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+          case 'b':
+            benchmark = true;
+            break;
+          case 'B':
+            bench.bsizes = optarg;
+            break;
+          case 'F':
+            bench.filesize = strtoul(optarg, NULL, 0);
+            break;
+          case 'N':
+            bench.nfiles = atoi(optarg);
+            break;
+          case 'L':
+            bench.label = optarg;
+            break;
+#endif
           case ':':
             printf("Error: Missing required argument\n");
             free(ctx);
@@ -1036,6 +1082,21 @@ int main(int argc, FAR char *argv[])
       strlcat(ctx->mountdir, "/", sizeof(ctx->mountdir));
     }
 
+#ifdef CONFIG_TESTING_FSTEST_BENCH
+  if (benchmark)
+    {
+      bench.mountdir = ctx->mountdir;
+      if (bench.label == NULL)
+        {
+          bench.label = ctx->mountdir;
+        }
+
+      ret = fstest_bench(&bench);
+      free(ctx);
+      return ret < 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+    }
+#endif
+
   ctx->fileimage = calloc(ctx->max_file, 1);
   if (ctx->fileimage == NULL)
     {
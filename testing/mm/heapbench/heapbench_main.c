@@ -0,0 +1,837 @@
+/****************************************************************************
+ * apps/testing/mm/heapbench/heapbench_main.c
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/clock.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define HEAPBENCH_PREFIX    "HeapBench:"
+
+#define HEAPBENCH_MAXTHREADS CONFIG_TESTING_HEAPBENCH_MAXTHREADS
+#define HEAPBENCH_TRACE_OPS  CONFIG_TESTING_HEAPBENCH_TRACE_OPS
+
+/* Latency histogram: 8 linear buckets per power of two, so a percentile
+ * is reported with at most 12.5% error from a fixed 2 KiB table.
+ */
+
+#define HIST_SUBBITS        3
+#define HIST_SUB            (1 << HIST_SUBBITS)
+#define HIST_BUCKETS        ((32 - HIST_SUBBITS + 1) * HIST_SUB)
+
+#define OPTARG_TO_VALUE(value, type) \
+  do \
+  { \
+    FAR char *ptr; \
+    value = (type)strtoul(optarg, &ptr, 0); \
+    if (*ptr != '\0') \
+      { \
+        printf(HEAPBENCH_PREFIX "Parameter error -%c %s\n", ch, optarg); \
+        show_usage(argv[0]); \
+      } \
+  } while (0)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum heapbench_dist_e
+{
+  HEAPBENCH_FIXED,      /* Always the same size */
+  HEAPBENCH_POWER,      /* Density proportional to 1/size */
+  HEAPBENCH_TRACE       /* Replay of a recorded trace */
+};
+
+enum heapbench_op_e
+{
+  HEAPBENCH_MALLOC,
+  HEAPBENCH_FREE,
+  HEAPBENCH_REALLOC
+};
+
+struct heapbench_hist_s
+{
+  uint32_t count;
+  uint32_t max;
+  uint32_t bucket[HIST_BUCKETS];
+};
+
+struct heapbench_traceop_s
+{
+  uint8_t op;           /* enum heapbench_op_e */
+  uint16_t slot;
+  uint32_t size;
+};
+
+struct heapbench_global_s
+{
+  enum heapbench_dist_e dist;
+  size_t minsize;
+  size_t maxsize;
+  size_t nslots;
+  uint32_t nops;
+  uint32_t interval_ms;
+  int nthreads;
+  bool touch;
+
+  FAR struct heapbench_traceop_s *trace;
+  size_t ntrace;
+
+  pthread_barrier_t start;
+  pthread_barrier_t done;
+  pthread_mutex_t lock;
+  int finished;
+};
+
+struct heapbench_thread_s
+{
+  FAR struct heapbench_global_s *global;
+  FAR void **slots;
+  pthread_t thread;
+  uint32_t seed;
+  int cpu;
+
+  struct heapbench_hist_s malloc_hist;
+  struct heapbench_hist_s free_hist;
+  uint32_t nfail;
+  uint64_t elapsed_ns;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct heapbench_thread_s g_threads[HEAPBENCH_MAXTHREADS];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: show_usage
+ ****************************************************************************/
+
+static void show_usage(FAR const char *progname)
+{
+  printf("\nUsage: %s [-d fixed|power|trace] [-s min] [-m max] "
+         "[-f trace] [-n ops] [-l slots] [-t threads] [-i ms] [-w]\n",
+         progname);
+  printf("\nWhere:\n");
+  printf("  -d Size distribution, Default: power.\n"
+         "     fixed: always -s bytes\n"
+         "     power: -s..-m bytes, density proportional to 1/size\n"
+         "     trace: replay -f, lines \"m <slot> <size>\", "
+         "\"r <slot> <size>\" or \"f <slot>\"\n"
+         "            (\"r <slot> 0\" frees the slot)\n");
+  printf("  -s Minimum (or fixed) size, Default: 16.\n");
+  printf("  -m Maximum size, Default: 4096.\n");
+  printf("  -f Trace file for -d trace.\n");
+  printf("  -n Operations per thread, Default: 100000.\n");
+  printf("  -l Live allocation slots per thread, Default: 256.\n"
+         "     Ignored with -d trace, which uses the highest slot + 1.\n");
+  printf("  -t Number of threads (max %d), Default: 1.\n",
+         HEAPBENCH_MAXTHREADS);
+  printf("  -i Fragmentation sample interval in ms, Default: 100.\n");
+  printf("  -w Write to every allocated block.\n");
+  exit(EXIT_FAILURE);
+}
+
+/****************************************************************************
+ * Name: randnum
+ ****************************************************************************/
+
+static uint32_t randnum(uint32_t max, FAR uint32_t *seed)
+{
+  uint32_t x = *seed;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  *seed = x;
+  return x % max;
+}
+
+/****************************************************************************
+ * Name: ilog2
+ ****************************************************************************/
+
+static int ilog2(uint32_t value)
+{
+  int n = 0;
+
+  while (value >>= 1)
+    {
+      n++;
+    }
+
+  return n;
+}
+
+/****************************************************************************
+ * Name: hist_add / hist_value / hist_percentile
+ ****************************************************************************/
+
+static void hist_add(FAR struct heapbench_hist_s *hist, uint32_t value)
+{
+  int msb;
+  int idx;
+
+  if (value < HIST_SUB)
+    {
+      idx = value;
+    }
+  else
+    {
+      msb = ilog2(value);
+      idx = ((msb - HIST_SUBBITS + 1) << HIST_SUBBITS) |
+            ((value >> (msb - HIST_SUBBITS)) & (HIST_SUB - 1));
+    }
+
+  hist->bucket[idx]++;
+  hist->count++;
+  if (value > hist->max)
+    {
+      hist->max = value;
+    }
+}
+
+static uint32_t hist_value(int idx)
+{
+  int msb;
+
+  if (idx < HIST_SUB)
+    {
+      return idx;
+    }
+
+  msb = (idx >> HIST_SUBBITS) + HIST_SUBBITS - 1;
+  return (uint32_t)(HIST_SUB | (idx & (HIST_SUB - 1))) <<
+         (msb - HIST_SUBBITS);
+}
+
+/* pct is in tenths of percent, 999 is p99.9 */
+
+static uint32_t hist_percentile(FAR const struct heapbench_hist_s *hist,
+                                int pct)
+{
+  uint64_t target = ((uint64_t)hist->count * pct + 999) / 1000;
+  uint64_t sum = 0;
+  int i;
+
+  for (i = 0; i < HIST_BUCKETS; i++)
+    {
+      sum += hist->bucket[i];
+      if (sum >= target && sum > 0)
+        {
+          return hist_value(i);
+        }
+    }
+
+  return hist->max;
+}
+
+static void hist_merge(FAR struct heapbench_hist_s *dst,
+                       FAR const struct heapbench_hist_s *src)
+{
+  int i;
+
+  for (i = 0; i < HIST_BUCKETS; i++)
+    {
+      dst->bucket[i] += src->bucket[i];
+    }
+
+  dst->count += src->count;
+  if (src->max > dst->max)
+    {
+      dst->max = src->max;
+    }
+}
+
+/****************************************************************************
+ * Name: ticks_to_ns
+ ****************************************************************************/
+
+static unsigned long ticks_to_ns(clock_t ticks)
+{
+  struct timespec ts;
+
+  perf_convert(ticks, &ts);
+  return ts.tv_sec * 1000000000ul + ts.tv_nsec;
+}
+
+static uint64_t now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: gen_size
+ ****************************************************************************/
+
+static size_t gen_size(FAR struct heapbench_thread_s *ctx)
+{
+  FAR struct heapbench_global_s *global = ctx->global;
+  int lo;
+  int hi;
+  int exp;
+  size_t base;
+  size_t size;
+
+  if (global->dist == HEAPBENCH_FIXED)
+    {
+      return global->minsize;
+    }
+
+  /* Pick the power of two uniformly, then the size inside it, so the
+   * density falls off as 1/size: many small blocks, few large ones.
+   */
+
+  lo   = ilog2(global->minsize);
+  hi   = ilog2(global->maxsize);
+  exp  = lo + randnum(hi - lo + 1, &ctx->seed);
+  base = (size_t)1 << exp;
+  size = base + randnum(base, &ctx->seed);
+
+  if (size < global->minsize)
+    {
+      size = global->minsize;
+    }
+  else if (size > global->maxsize)
+    {
+      size = global->maxsize;
+    }
+
+  return size;
+}
+
+/****************************************************************************
+ * Name: bench_malloc / bench_free
+ ****************************************************************************/
+
+static void bench_malloc(FAR struct heapbench_thread_s *ctx, size_t slot,
+                         size_t size, bool isrealloc)
+{
+  FAR void *ptr;
+  clock_t start;
+
+  start = perf_gettime();
+  if (isrealloc)
+    {
+      ptr = realloc(ctx->slots[slot], size);
+    }
+  else
+    {
+      ptr = malloc(size);
+    }
+
+  hist_add(&ctx->malloc_hist, (uint32_t)(perf_gettime() - start));
+
+  if (ptr == NULL)
+    {
+      ctx->nfail++;
+      return;
+    }
+
+  if (ctx->global->touch)
+    {
+      memset(ptr, 0x5a, size);
+    }
+
+  ctx->slots[slot] = ptr;
+}
+
+static void bench_free(FAR struct heapbench_thread_s *ctx, size_t slot)
+{
+  clock_t start;
+
+  start = perf_gettime();
+  free(ctx->slots[slot]);
+  hist_add(&ctx->free_hist, (uint32_t)(perf_gettime() - start));
+
+  ctx->slots[slot] = NULL;
+}
+
+/****************************************************************************
+ * Name: bench_run
+ ****************************************************************************/
+
+static void bench_run(FAR struct heapbench_thread_s *ctx)
+{
+  FAR struct heapbench_global_s *global = ctx->global;
+  uint32_t i;
+
+  for (i = 0; i < global->nops; i++)
+    {
+      if (global->dist == HEAPBENCH_TRACE)
+        {
+          FAR struct heapbench_traceop_s *op =
+            &global->trace[i % global->ntrace];
+
+          if (op->op == HEAPBENCH_FREE)
+            {
+              if (ctx->slots[op->slot] != NULL)
+                {
+                  bench_free(ctx, op->slot);
+                }
+            }
+          else
+            {
+              if (op->op == HEAPBENCH_MALLOC && ctx->slots[op->slot])
+                {
+                  bench_free(ctx, op->slot);
+                }
+
+              bench_malloc(ctx, op->slot, op->size,
+                           op->op == HEAPBENCH_REALLOC);
+            }
+        }
+      else
+        {
+          /* Random slot: fill it if empty, release it otherwise, which
+           * keeps about half of the slots live.
+           */
+
+          size_t slot = randnum(global->nslots, &ctx->seed);
+
+          if (ctx->slots[slot] == NULL)
+            {
+              bench_malloc(ctx, slot, gen_size(ctx), false);
+            }
+          else
+            {
+              bench_free(ctx, slot);
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: heapbench_thread
+ ****************************************************************************/
+
+static FAR void *heapbench_thread(FAR void *arg)
+{
+  FAR struct heapbench_thread_s *ctx = arg;
+  FAR struct heapbench_global_s *global = ctx->global;
+  uint64_t start;
+  size_t i;
+
+  pthread_barrier_wait(&global->start);
+
+  start = now_ns();
+  bench_run(ctx);
+  ctx->elapsed_ns = now_ns() - start;
+
+  pthread_mutex_lock(&global->lock);
+  global->finished++;
+  pthread_mutex_unlock(&global->lock);
+
+  /* Keep the live set until the main thread sampled the final heap */
+
+  pthread_barrier_wait(&global->done);
+  pthread_barrier_wait(&global->done);
+
+  for (i = 0; i < global->nslots; i++)
+    {
+      free(ctx->slots[i]);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: sample_heap
+ ****************************************************************************/
+
+static void sample_heap(uint64_t start)
+{
+  struct mallinfo info = mallinfo();
+  unsigned long frag = 0;
+
+  /* Fragmentation: share of the free memory not usable by the largest
+   * single allocation.
+   */
+
+  if (info.fordblks > 0)
+    {
+      frag = 100 - (unsigned long)((uint64_t)info.mxordblk * 100 /
+                                   info.fordblks);
+    }
+
+  printf("%8" PRIu64 " %10lu %10lu %10lu %8lu %4lu%%\n",
+         (now_ns() - start) / 1000000,
+         (unsigned long)info.uordblks, (unsigned long)info.fordblks,
+         (unsigned long)info.mxordblk, (unsigned long)info.ordblks, frag);
+}
+
+/****************************************************************************
+ * Name: print_hist
+ ****************************************************************************/
+
+static void print_hist(FAR const char *name,
+                       FAR const struct heapbench_hist_s *hist)
+{
+  if (hist->count == 0)
+    {
+      return;
+    }
+
+  printf("%-6s %9" PRIu32 " %8lu %8lu %8lu %8lu %8lu\n", name,
+         hist->count,
+         ticks_to_ns(hist_percentile(hist, 500)),
+         ticks_to_ns(hist_percentile(hist, 900)),
+         ticks_to_ns(hist_percentile(hist, 990)),
+         ticks_to_ns(hist_percentile(hist, 999)),
+         ticks_to_ns(hist->max));
+}
+
+/****************************************************************************
+ * Name: load_trace
+ ****************************************************************************/
+
+static int load_trace(FAR struct heapbench_global_s *global,
+                      FAR const char *path)
+{
+  FAR struct heapbench_traceop_s *op;
+  unsigned long slot;
+  unsigned long size;
+  char line[64];
+  FAR FILE *file;
+  char cmd;
+  int n;
+
+  file = fopen(path, "r");
+  if (file == NULL)
+    {
+      printf(HEAPBENCH_PREFIX "Failed to open %s\n", path);
+      return -1;
+    }
+
+  global->trace = malloc(sizeof(*global->trace) * HEAPBENCH_TRACE_OPS);
+  if (global->trace == NULL)
+    {
+      fclose(file);
+      return -1;
+    }
+
+  global->nslots = 0;
+  while (fgets(line, sizeof(line), file) != NULL &&
+         global->ntrace < HEAPBENCH_TRACE_OPS)
+    {
+      size = 0;
+      n = sscanf(line, " %c %lu %lu", &cmd, &slot, &size);
+      if (n < 2 || cmd == '#' || slot > UINT16_MAX)
+        {
+          continue;
+        }
+
+      /* realloc(ptr, 0) frees ptr, but whether it then returns NULL or
+       * a new block is implementation defined.  Replay it as a free.
+       */
+
+      op = &global->trace[global->ntrace];
+      if (cmd == 'f' || (cmd == 'r' && n == 3 && size == 0))
+        {
+          op->op = HEAPBENCH_FREE;
+        }
+      else if ((cmd == 'm' || cmd == 'r') && n == 3)
+        {
+          op->op = cmd == 'm' ? HEAPBENCH_MALLOC : HEAPBENCH_REALLOC;
+        }
+      else
+        {
+          continue;
+        }
+
+      op->slot = slot;
+      op->size = size;
+      global->ntrace++;
+
+      if (slot >= global->nslots)
+        {
+          global->nslots = slot + 1;
+        }
+    }
+
+  fclose(file);
+
+  if (global->ntrace == 0)
+    {
+      printf(HEAPBENCH_PREFIX "No operations in %s\n", path);
+      return -1;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: global_init
+ ****************************************************************************/
+
+static void global_init(FAR struct heapbench_global_s *global, int argc,
+                        FAR char *argv[])
+{
+  FAR const char *trace = NULL;
+  int ch;
+
+  memset(global, 0, sizeof(struct heapbench_global_s));
+
+  global->dist = HEAPBENCH_POWER;
+  global->minsize = 16;
+  global->maxsize = 4096;
+  global->nslots = 256;
+  global->nops = 100000;
+  global->interval_ms = 100;
+  global->nthreads = 1;
+
+  while ((ch = getopt(argc, argv, "d:s:m:f:n:l:t:i:wh")) != ERROR)
+    {
+      switch (ch)
+        {
+          case 'd':
+            if (strcmp(optarg, "fixed") == 0)
+              {
+                global->dist = HEAPBENCH_FIXED;
+              }
+            else if (strcmp(optarg, "power") == 0)
+              {
+                global->dist = HEAPBENCH_POWER;
+              }
+            else if (strcmp(optarg, "trace") == 0)
+              {
+                global->dist = HEAPBENCH_TRACE;
+              }
+            else
+              {
+                show_usage(argv[0]);
+              }
+            break;
+          case 's':
+            OPTARG_TO_VALUE(global->minsize, size_t);
+            break;
+          case 'm':
+            OPTARG_TO_VALUE(global->maxsize, size_t);
+            break;
+          case 'f':
+            trace = optarg;
+            break;
+          case 'n':
+            OPTARG_TO_VALUE(global->nops, uint32_t);
+            break;
+          case 'l':
+            OPTARG_TO_VALUE(global->nslots, size_t);
+            break;
+          case 't':
+            OPTARG_TO_VALUE(global->nthreads, int);
+            break;
+          case 'i':
+            OPTARG_TO_VALUE(global->interval_ms, uint32_t);
+            break;
+          case 'w':
+            global->touch = true;
+            break;
+          default:
+            show_usage(argv[0]);
+            break;
+        }
+    }
+
+  if (global->nthreads < 1 || global->nthreads > HEAPBENCH_MAXTHREADS ||
+      global->minsize < 1 || global->maxsize < global->minsize ||
+      global->nslots < 1 || global->interval_ms < 1)
+    {
+      show_usage(argv[0]);
+    }
+
+  if (global->dist == HEAPBENCH_TRACE)
+    {
+      if (trace == NULL || load_trace(global, trace) < 0)
+        {
+          show_usage(argv[0]);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: thread_init
+ ****************************************************************************/
+
+static int thread_init(FAR struct heapbench_global_s *global, int i)
+{
+  FAR struct heapbench_thread_s *ctx = &g_threads[i];
+  pthread_attr_t attr;
+#ifdef CONFIG_SMP
+  cpu_set_t cpuset;
+#endif
+  int ret;
+
+  memset(ctx, 0, sizeof(*ctx));
+  ctx->global = global;
+  ctx->seed = 0x9e3779b9u * (i + 1);
+  ctx->slots = zalloc(sizeof(FAR void *) * global->nslots);
+  if (ctx->slots == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  pthread_attr_init(&attr);
+
+#ifdef CONFIG_SMP
+  /* Spread the threads over the CPUs to load the heap lock from each */
+
+  ctx->cpu = i % CONFIG_SMP_NCPUS;
+  CPU_ZERO(&cpuset);
+  CPU_SET(ctx->cpu, &cpuset);
+  pthread_attr_setaffinity_np(&attr, sizeof(cpu_set_t), &cpuset);
+#endif
+
+  ret = pthread_create(&ctx->thread, &attr, heapbench_thread, ctx);
+  pthread_attr_destroy(&attr);
+  return -ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct heapbench_global_s global;
+  struct heapbench_hist_s malloc_hist;
+  struct heapbench_hist_s free_hist;
+  uint64_t elapsed = 0;
+  uint64_t start;
+  uint32_t nfail = 0;
+  int i;
+
+  global_init(&global, argc, argv);
+
+  pthread_barrier_init(&global.start, NULL, global.nthreads + 1);
+  pthread_barrier_init(&global.done, NULL, global.nthreads + 1);
+  pthread_mutex_init(&global.lock, NULL);
+
+  for (i = 0; i < global.nthreads; i++)
+    {
+      if (thread_init(&global, i) < 0)
+        {
+          printf(HEAPBENCH_PREFIX "Failed to create thread %d\n", i);
+          exit(EXIT_FAILURE);
+        }
+    }
+
+  printf("%8s %10s %10s %10s %8s %5s\n",
+         "ms", "used", "free", "largest", "chunks", "frag");
+
+  start = now_ns();
+  sample_heap(start);
+  pthread_barrier_wait(&global.start);
+
+  /* Sample the heap while the workers run, until all of them finished
+   * their operations and wait with their live set.
+   */
+
+  for (; ; )
+    {
+      bool done;
+
+      usleep(global.interval_ms * 1000);
+
+      pthread_mutex_lock(&global.lock);
+      done = global.finished == global.nthreads;
+      pthread_mutex_unlock(&global.lock);
+
+      sample_heap(start);
+      if (done)
+        {
+          break;
+        }
+    }
+
+  pthread_barrier_wait(&global.done);
+  pthread_barrier_wait(&global.done);
+
+  memset(&malloc_hist, 0, sizeof(malloc_hist));
+  memset(&free_hist, 0, sizeof(free_hist));
+
+  for (i = 0; i < global.nthreads; i++)
+    {
+      FAR struct heapbench_thread_s *ctx = &g_threads[i];
+
+      pthread_join(ctx->thread, NULL);
+
+      printf("thread %d cpu %d: %" PRIu32 " ops in %" PRIu64 " us, "
+             "%" PRIu64 " ops/s, %" PRIu32 " failed\n", i, ctx->cpu,
+             global.nops, ctx->elapsed_ns / 1000,
+             (uint64_t)global.nops * 1000000000 /
+             (ctx->elapsed_ns ? ctx->elapsed_ns : 1), ctx->nfail);
+
+      hist_merge(&malloc_hist, &ctx->malloc_hist);
+      hist_merge(&free_hist, &ctx->free_hist);
+      nfail += ctx->nfail;
+      if (ctx->elapsed_ns > elapsed)
+        {
+          elapsed = ctx->elapsed_ns;
+        }
+
+      free(ctx->slots);
+    }
+
+  printf("total: %" PRIu64 " ops/s, %" PRIu32 " failed\n",
+         (uint64_t)global.nops * global.nthreads * 1000000000 /
+         (elapsed ? elapsed : 1), nfail);
+  printf("%-6s %9s %8s %8s %8s %8s %8s\n",
+         "op", "count", "p50 ns", "p90 ns", "p99 ns", "p99.9 ns", "max ns");
+  print_hist("malloc", &malloc_hist);
+  print_hist("free", &free_hist);
+
+  pthread_barrier_destroy(&global.start);
+  pthread_barrier_destroy(&global.done);
+  pthread_mutex_destroy(&global.lock);
+  free(global.trace);
+  return 0;
+}
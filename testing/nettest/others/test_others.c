@@ -39,6 +39,9 @@ int main(int argc, FAR char *argv[])
   const struct CMUnitTest others_tests[] =
     {
       cmocka_unit_test(test_others_bufpool),
+#ifdef CONFIG_TESTING_NET_DHCPD
+      cmocka_unit_test(test_others_dhcpd_journal),
+#endif
     };
 
   return cmocka_run_group_tests(others_tests, test_others_group_setup,
@@ -49,4 +49,12 @@ int test_others_group_teardown(FAR void **state);
 
 void test_others_bufpool(FAR void **state);
 
+#ifdef CONFIG_TESTING_NET_DHCPD
+/****************************************************************************
+ * Name: test_others_dhcpd_journal
+ ****************************************************************************/
+
+void test_others_dhcpd_journal(FAR void **state);
+#endif
+
 #endif /* __APPS_TESTING_NETTEST_OTHERS_TEST_OTHERS_H */
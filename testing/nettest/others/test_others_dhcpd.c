@@ -0,0 +1,160 @@
+/****************************************************************************
+ * apps/testing/nettest/others/test_others_dhcpd.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+/* The lease journal is internal to the DHCP server, so the server is built
+ * into the test.  Its public functions are renamed to stay clear of the
+ * netutils library, and the journal is written to the temporary directory
+ * so that the one of a running server is left alone.
+ */
+
+#define dhcpd_run          test_dhcpd_run
+#define dhcpd_start        test_dhcpd_start
+#define dhcpd_stop         test_dhcpd_stop
+#define dhcpd_set_startip  test_dhcpd_set_startip
+#define dhcpd_set_routerip test_dhcpd_set_routerip
+#define dhcpd_set_netmask  test_dhcpd_set_netmask
+#define dhcpd_set_dnsip    test_dhcpd_set_dnsip
+#define dhcpd_setlease     test_dhcpd_setlease
+#define dhcpd_sendack      test_dhcpd_sendack
+
+#undef  CONFIG_NETUTILS_DHCPD_LEASEFILE_PATH
+#define CONFIG_NETUTILS_DHCPD_LEASEFILE_PATH \
+  CONFIG_LIBC_TMPDIR "/test_dhcpd.leases"
+
+#include "../../../netutils/dhcpd/dhcpd.c"
+
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <cmocka.h>
+
+#include "test_others.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define TEST_LEASETIME  3600
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const uint8_t g_test_mac[DHCP_HLEN_ETHERNET] =
+{
+  0x02, 0x00, 0x00, 0x12, 0x34, 0x56
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: test_dhcpd_restart
+ *
+ * Description:
+ *   Throw the lease table away and rebuild it from the journal, as
+ *   dhcpd_run() does when the server starts.
+ *
+ ****************************************************************************/
+
+static void test_dhcpd_restart(void)
+{
+  if (g_state.ds_journalfd >= 0)
+    {
+      close(g_state.ds_journalfd);
+    }
+
+  memset(&g_state, 0, sizeof(g_state));
+  dhcpd_initleases();
+  dhcpd_journalrestore();
+  assert_true(g_state.ds_journalfd >= 0);
+}
+
+/****************************************************************************
+ * Name: test_dhcpd_threshold
+ *
+ * Description:
+ *   Grant a lease, then let release() or decline() drop it while the
+ *   journal is due for compaction.  The lease must stay gone after a
+ *   restart.
+ *
+ ****************************************************************************/
+
+static void test_dhcpd_threshold(CODE int (*drop)(void))
+{
+  FAR struct lease_s *lease;
+  in_addr_t ipaddr = g_dhcpd_config.ds_startip;
+
+  unlink(CONFIG_NETUTILS_DHCPD_LEASEFILE_PATH);
+  test_dhcpd_restart();
+
+  lease = dhcpd_setlease(g_test_mac, ipaddr, TEST_LEASETIME);
+  assert_non_null(lease);
+  dhcpd_journalappend(DHCPD_JOURNAL_GRANT, lease->mac, ipaddr,
+                      lease->expiry);
+
+  /* The granted lease survives a restart */
+
+  test_dhcpd_restart();
+  assert_non_null(dhcpd_findbymac(g_test_mac));
+
+  /* The next append compacts the journal instead of writing a record */
+
+  g_state.ds_journalrecs = DHCPD_JOURNAL_MAXRECS;
+  memcpy(g_state.ds_inpacket.chaddr, g_test_mac, DHCP_HLEN_ETHERNET);
+  assert_int_equal(drop(), OK);
+  assert_null(dhcpd_findbymac(g_test_mac));
+
+  test_dhcpd_restart();
+  assert_null(dhcpd_findbymac(g_test_mac));
+  assert_false(g_state.ds_leases[0].allocated);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: test_others_dhcpd_journal
+ ****************************************************************************/
+
+void test_others_dhcpd_journal(FAR void **state)
+{
+  g_dhcpd_daemon.ds_data = calloc(1, sizeof(struct dhcpd_state_s));
+  assert_non_null(g_dhcpd_daemon.ds_data);
+  g_state.ds_journalfd = -1;
+
+  test_dhcpd_threshold(dhcpd_release);
+  test_dhcpd_threshold(dhcpd_decline);
+
+  close(g_state.ds_journalfd);
+  unlink(CONFIG_NETUTILS_DHCPD_LEASEFILE_PATH);
+  free(g_dhcpd_daemon.ds_data);
+  g_dhcpd_daemon.ds_data = NULL;
+}